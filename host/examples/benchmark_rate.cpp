@@ -16,6 +16,7 @@
 //
 
 #include <uhd/utils/thread_priority.hpp>
+#include <uhd/utils/platform.hpp>
 #include <uhd/convert.hpp>
 #include <uhd/utils/safe_main.hpp>
 #include <uhd/usrp/multi_usrp.hpp>
@@ -25,6 +26,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include <iostream>
+#include <fstream>
 #include <complex>
 #include <cstdlib>
 
@@ -39,12 +41,15 @@ unsigned long long num_rx_samps = 0;
 unsigned long long num_tx_samps = 0;
 unsigned long long num_dropped_samps = 0;
 unsigned long long num_seq_errors = 0;
+double rx_thread_cpu_secs = 0;
+double tx_thread_cpu_secs = 0;
 
 /***********************************************************************
  * Benchmark RX Rate
  **********************************************************************/
 void benchmark_rx_rate(uhd::usrp::multi_usrp::sptr usrp, const std::string &rx_cpu, uhd::rx_streamer::sptr rx_stream){
     uhd::set_thread_priority_safe();
+    uhd::thread_cpu_timer cpu_timer(rx_thread_cpu_secs);
 
     //print pre-test summary
     std::cout << boost::format(
@@ -111,6 +116,7 @@ void benchmark_rx_rate(uhd::usrp::multi_usrp::sptr usrp, const std::string &rx_c
  **********************************************************************/
 void benchmark_tx_rate(uhd::usrp::multi_usrp::sptr usrp, const std::string &tx_cpu, uhd::tx_streamer::sptr tx_stream){
     uhd::set_thread_priority_safe();
+    uhd::thread_cpu_timer cpu_timer(tx_thread_cpu_secs);
 
     //print pre-test summary
     std::cout << boost::format(
@@ -168,6 +174,102 @@ void benchmark_tx_rate_async_helper(uhd::tx_streamer::sptr tx_stream){
     }
 }
 
+/***********************************************************************
+ * CPU cost accounting
+ **********************************************************************/
+struct cpu_cost_t{
+    std::string direction;
+    double thread_cpu_secs;
+    unsigned long long num_samps;
+    uhd::stream_stats_t stats;
+    size_t num_channels;
+
+    double get_samps_per_cpu_sec(void) const{
+        return (thread_cpu_secs > 0)? num_samps/thread_cpu_secs : 0;
+    }
+
+    //the histograms time a sample of the calls, scale the means by the call counts
+    double get_header_secs(void) const{
+        return stats.header_time.get_mean()*stats.num_packets;
+    }
+    double get_convert_secs(void) const{
+        return stats.convert_time.get_mean()*stats.num_packets/num_channels;
+    }
+};
+
+static cpu_cost_t make_cpu_cost(
+    const std::string &direction, const double thread_cpu_secs,
+    const unsigned long long num_samps, const uhd::stream_stats_t &stats, const size_t num_channels
+){
+    cpu_cost_t cost;
+    cost.direction = direction;
+    cost.thread_cpu_secs = thread_cpu_secs;
+    cost.num_samps = num_samps;
+    cost.stats = stats;
+    cost.num_channels = num_channels;
+    return cost;
+}
+
+static void print_cpu_cost(const cpu_cost_t &cost){
+    std::cout << boost::format(
+        "%s CPU cost:\n"
+        "  Thread CPU time:         %f s\n"
+        "  Samples per CPU second:  %f Msps\n"
+        "  Transport wait:          %f s\n"
+        "  Header processing:       %f s (estimated)\n"
+        "  Conversion:              %f s (estimated)\n"
+    ) % cost.direction % cost.thread_cpu_secs % (cost.get_samps_per_cpu_sec()/1e6)
+      % cost.stats.buff_wait_time.total_secs % cost.get_header_secs() % cost.get_convert_secs() << std::endl;
+}
+
+//! Quote a string for a JSON document
+static std::string json_string(const std::string &in){
+    std::string out = "\"";
+    for (size_t i = 0; i < in.size(); i++){
+        const char c = in[i];
+        switch (c){
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if ((unsigned char)(c) < 0x20) out += str(boost::format("\\u%04x") % int(c));
+            else out += c;
+        }
+    }
+    return out + "\"";
+}
+
+static void write_json_report(
+    const std::string &path, const std::string &args, const double duration,
+    const std::vector<cpu_cost_t> &costs, const double process_cpu_secs
+){
+    std::ofstream out(path.c_str());
+    if (not out.is_open()) throw std::runtime_error("cannot open the report file " + path);
+    out << "{\n";
+    out << boost::format("  \"args\": %s,\n") % json_string(args);
+    out << boost::format("  \"duration\": %f,\n") % duration;
+    out << boost::format("  \"process_cpu_secs\": %f,\n") % process_cpu_secs;
+    out << boost::format("  \"num_overflows\": %u,\n") % num_overflows;
+    out << boost::format("  \"num_underflows\": %u,\n") % num_underflows;
+    out << boost::format("  \"num_seq_errors\": %u,\n") % num_seq_errors;
+    out << boost::format("  \"num_dropped_samps\": %u,\n") % num_dropped_samps;
+    out << "  \"streams\": [";
+    for (size_t i = 0; i < costs.size(); i++){
+        const cpu_cost_t &cost = costs[i];
+        out << ((i == 0)? "\n" : ",\n");
+        out << boost::format(
+            "    {\"direction\": \"%s\", \"num_channels\": %u, \"num_samps\": %u, \"num_packets\": %u, "
+            "\"thread_cpu_secs\": %f, \"samps_per_cpu_sec\": %f, "
+            "\"wait_secs\": %f, \"header_secs\": %f, \"convert_secs\": %f}"
+        ) % cost.direction % cost.num_channels % cost.num_samps % cost.stats.num_packets
+          % cost.thread_cpu_secs % cost.get_samps_per_cpu_sec()
+          % cost.stats.buff_wait_time.total_secs % cost.get_header_secs() % cost.get_convert_secs();
+    }
+    out << "\n  ]\n}" << std::endl;
+}
+
 /***********************************************************************
  * Main code + dispatcher
  **********************************************************************/
@@ -182,6 +284,7 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
     std::string rx_cpu, tx_cpu;
     std::string mode;
     std::string channel_list;
+    std::string json_file;
 
     //setup the program options
     po::options_description desc("Allowed options");
@@ -197,6 +300,7 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
         ("tx_cpu", po::value<std::string>(&tx_cpu)->default_value("fc32"), "specify the host/cpu sample mode for TX")
         ("mode", po::value<std::string>(&mode)->default_value("none"), "multi-channel sync mode option: none, mimo")
         ("channels", po::value<std::string>(&channel_list)->default_value("0"), "which channel(s) to use (specify \"0\", \"1\", \"0,1\", etc)")
+        ("json", po::value<std::string>(&json_file), "also write the results and CPU cost to this JSON file")
     ;
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -244,23 +348,27 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
         else channel_nums.push_back(boost::lexical_cast<int>(channel_strings[ch]));
     }
 
+    const double process_cpu_start = uhd::get_process_cpu_time();
+
     //spawn the receive test thread
+    uhd::rx_streamer::sptr rx_stream;
     if (vm.count("rx_rate")){
         usrp->set_rx_rate(rx_rate);
         //create a receive streamer
         uhd::stream_args_t stream_args(rx_cpu, rx_otw);
         stream_args.channels = channel_nums;
-        uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
+        rx_stream = usrp->get_rx_stream(stream_args);
         thread_group.create_thread(boost::bind(&benchmark_rx_rate, usrp, rx_cpu, rx_stream));
     }
 
     //spawn the transmit test thread
+    uhd::tx_streamer::sptr tx_stream;
     if (vm.count("tx_rate")){
         usrp->set_tx_rate(tx_rate);
         //create a transmit streamer
         uhd::stream_args_t stream_args(tx_cpu, tx_otw);
         stream_args.channels = channel_nums;
-        uhd::tx_streamer::sptr tx_stream = usrp->get_tx_stream(stream_args);
+        tx_stream = usrp->get_tx_stream(stream_args);
         thread_group.create_thread(boost::bind(&benchmark_tx_rate, usrp, tx_cpu, tx_stream));
         thread_group.create_thread(boost::bind(&benchmark_tx_rate_async_helper, tx_stream));
     }
@@ -273,6 +381,7 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
     //interrupt and join the threads
     thread_group.interrupt_all();
     thread_group.join_all();
+    const double process_cpu_secs = uhd::get_process_cpu_time() - process_cpu_start;
 
     //print summary
     std::cout << std::endl << boost::format(
@@ -285,6 +394,17 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
         "  Num underflows detected: %u\n"
     ) % num_rx_samps % num_dropped_samps % num_overflows % num_tx_samps % num_seq_errors % num_underflows << std::endl;
 
+    //print where the streaming threads spent their time
+    std::vector<cpu_cost_t> costs;
+    if (rx_stream) costs.push_back(make_cpu_cost(
+        "RX", rx_thread_cpu_secs, num_rx_samps, rx_stream->get_stats(), rx_stream->get_num_channels()));
+    if (tx_stream) costs.push_back(make_cpu_cost(
+        "TX", tx_thread_cpu_secs, num_tx_samps, tx_stream->get_stats(), tx_stream->get_num_channels()));
+    for (size_t i = 0; i < costs.size(); i++) print_cpu_cost(costs[i]);
+    std::cout << boost::format("Process CPU time: %f s") % process_cpu_secs << std::endl;
+
+    if (vm.count("json")) write_json_report(json_file, args, duration, costs, process_cpu_secs);
+
     //finished
     std::cout << std::endl << "Done!" << std::endl << std::endl;
    
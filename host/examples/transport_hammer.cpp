@@ -16,6 +16,7 @@
 //
 
 #include <uhd/utils/thread_priority.hpp>
+#include <uhd/utils/platform.hpp>
 #include <uhd/convert.hpp>
 #include <uhd/utils/safe_main.hpp>
 #include <uhd/usrp/multi_usrp.hpp>
@@ -37,12 +38,15 @@ unsigned long long num_rx_samps = 0;
 unsigned long long num_tx_samps = 0;
 unsigned long long num_dropped_samps = 0;
 unsigned long long num_seq_errors = 0;
+double rx_thread_cpu_secs = 0;
+double tx_thread_cpu_secs = 0;
 
 /***********************************************************************
  * RX Hammer
  **********************************************************************/
 void rx_hammer(uhd::usrp::multi_usrp::sptr usrp, const std::string &rx_cpu, uhd::rx_streamer::sptr rx_stream){
     uhd::set_thread_priority_safe();
+    uhd::thread_cpu_timer cpu_timer(rx_thread_cpu_secs);
 
     //print pre-test summary
     std::cout << boost::format(
@@ -100,6 +104,7 @@ void rx_hammer(uhd::usrp::multi_usrp::sptr usrp, const std::string &rx_cpu, uhd:
  **********************************************************************/
 void tx_hammer(uhd::usrp::multi_usrp::sptr usrp, const std::string &tx_cpu, uhd::tx_streamer::sptr tx_stream){
     uhd::set_thread_priority_safe();
+    uhd::thread_cpu_timer cpu_timer(tx_thread_cpu_secs);
 
     uhd::tx_metadata_t md;
     const size_t max_samps_per_packet = tx_stream->get_max_num_samps();
@@ -165,6 +170,24 @@ void tx_hammer_async_helper(uhd::tx_streamer::sptr tx_stream){
     }
 }
 
+/***********************************************************************
+ * CPU cost summary
+ **********************************************************************/
+void print_cpu_cost(
+    const std::string &direction, const double thread_cpu_secs,
+    const unsigned long long num_samps, const uhd::stream_stats_t &stats
+){
+    std::cout << boost::format(
+        "%s CPU cost:\n"
+        "  Thread CPU time:         %f s\n"
+        "  Samples per CPU second:  %f Msps\n"
+        "  Transport wait:          %f s\n"
+        "  Mean header time:        %f us\n"
+        "  Mean conversion time:    %f us\n"
+    ) % direction % thread_cpu_secs % ((thread_cpu_secs > 0)? num_samps/thread_cpu_secs/1e6 : 0)
+      % stats.buff_wait_time.total_secs % (stats.header_time.get_mean()*1e6) % (stats.convert_time.get_mean()*1e6) << std::endl;
+}
+
 /***********************************************************************
  * Main code + dispatcher
  **********************************************************************/
@@ -231,24 +254,26 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
     boost::thread_group thread_group;
 
     //spawn the receive test thread
+    uhd::rx_streamer::sptr rx_stream;
     if (vm.count("rx_rate")){
         usrp->set_rx_rate(rx_rate);
         //create a receive streamer
         uhd::stream_args_t stream_args(rx_cpu, rx_otw);
         for (size_t ch = 0; ch < usrp->get_num_mboards(); ch++) //linear channel mapping
             stream_args.channels.push_back(ch);
-        uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
+        rx_stream = usrp->get_rx_stream(stream_args);
         thread_group.create_thread(boost::bind(&rx_hammer, usrp, rx_cpu, rx_stream));
     }
 
     //spawn the transmit test thread
+    uhd::tx_streamer::sptr tx_stream;
     if (vm.count("tx_rate")){
         usrp->set_tx_rate(tx_rate);
         //create a transmit streamer
         uhd::stream_args_t stream_args(tx_cpu, tx_otw);
         for (size_t ch = 0; ch < usrp->get_num_mboards(); ch++) //linear channel mapping
             stream_args.channels.push_back(ch);
-        uhd::tx_streamer::sptr tx_stream = usrp->get_tx_stream(stream_args);
+        tx_stream = usrp->get_tx_stream(stream_args);
         thread_group.create_thread(boost::bind(&tx_hammer, usrp, tx_cpu, tx_stream));
         thread_group.create_thread(boost::bind(&tx_hammer_async_helper, tx_stream));
     }
@@ -272,6 +297,8 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
         "  Num sequence errors:     %u\n"
         "  Num underflows detected: %u\n"
     ) % num_rx_samps % num_dropped_samps % num_overflows % num_tx_samps % num_seq_errors % num_underflows << std::endl;
+    if (rx_stream) print_cpu_cost("RX", rx_thread_cpu_secs, num_rx_samps, rx_stream->get_stats());
+    if (tx_stream) print_cpu_cost("TX", tx_thread_cpu_secs, num_tx_samps, tx_stream->get_stats());
 
     //finished
     std::cout << std::endl << "Done!" << std::endl << std::endl;
@@ -23,10 +23,48 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
 #include <boost/operators.hpp>
+#include <complex>
 #include <string>
+#include <vector>
 
 namespace uhd{ namespace convert{
 
+    /*!
+     * A 2x2 IQ correction matrix and DC offset for complex samples.
+     * The correction is applied in full-scale units (1.0 = full scale):
+     * I' = m[0]*I + m[1]*Q + offset.real(),
+     * Q' = m[2]*I + m[3]*Q + offset.imag().
+     */
+    struct UHD_API iq_correction_t{
+        double matrix[4];
+        std::complex<double> offset;
+
+        //! Create an identity correction (no change to the samples)
+        iq_correction_t(void);
+
+        /*!
+         * Make the correction applied by an RX frontend core:
+         * the DC offset is added first, then the IQ balance is applied.
+         * \param iq_balance the magnitude (real) and phase (imag) correction
+         * \param dc_offset the DC offset in full-scale units
+         */
+        static iq_correction_t make_rx(
+            const std::complex<double> &iq_balance,
+            const std::complex<double> &dc_offset
+        );
+
+        /*!
+         * Make the correction applied by a TX frontend core:
+         * the IQ balance is applied first, then the DC offset is added.
+         * \param iq_balance the magnitude (real) and phase (imag) correction
+         * \param dc_offset the DC offset in full-scale units
+         */
+        static iq_correction_t make_tx(
+            const std::complex<double> &iq_balance,
+            const std::complex<double> &dc_offset
+        );
+    };
+
     //! A conversion class that implements a conversion from inputs -> outputs.
     class converter{
     public:
@@ -39,6 +77,16 @@ namespace uhd{ namespace convert{
         //! Set the scale factor (used in floating point conversions)
         virtual void set_scalar(const double) = 0;
 
+        /*!
+         * Set the IQ correction applied while converting.
+         * Only converters registered for an "_iqcorr" wire format
+         * (ex: sc16_item32_le_iqcorr) implement this call.
+         * \param corr the correction matrix and DC offset
+         * \param which the index of the host-side input/output buffer
+         * \throws uhd::not_implemented_error for other converters
+         */
+        virtual void set_iq_correction(const iq_correction_t &corr, const size_t which = 0);
+
         //! The public conversion method to convert inputs -> outputs
         UHD_INLINE void conv(const input_type &in, const output_type &out, const size_t num){
             if (num != 0) (*this)(in, out, num);
@@ -90,6 +138,36 @@ namespace uhd{ namespace convert{
         const priority_type prio = -1
     );
 
+    //! Get the identifiers of all registered converters
+    UHD_API std::vector<id_type> get_converter_ids(void);
+
+    //! Get the priorities registered for a converter (empty when none)
+    UHD_API std::vector<priority_type> get_converter_prios(const id_type &id);
+
+    /*!
+     * Time every converter registered for an ID on this machine.
+     * The fastest one is kept for the rest of the process and stored in
+     * the autotune cache (~/.uhd/cache/convert_autotune.csv, or the file
+     * named by UHD_CONVERT_AUTOTUNE_CACHE), keyed by the CPU model.
+     * A choice already made is returned without timing.
+     * \param id identify the conversion
+     * \param num_samps the number of samples per conversion to time
+     * \return the priority of the fastest converter
+     */
+    UHD_API priority_type autotune_converter(
+        const id_type &id, const size_t num_samps = 2000
+    );
+
+    /*!
+     * Get the priority that get_converter() selects for prio -1.
+     * This is the highest registered priority, or the fastest one when
+     * the environment variable UHD_CONVERT_AUTOTUNE is set (and not 0),
+     * in which case the converter is autotuned at first use.
+     * \param id identify the conversion
+     * \return the selected priority
+     */
+    UHD_API priority_type get_selected_prio(const id_type &id);
+
     /*!
      * Register the size of a particular item.
      * \param format the item format
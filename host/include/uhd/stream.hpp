@@ -22,6 +22,7 @@
 #include <uhd/types/metadata.hpp>
 #include <uhd/types/device_addr.hpp>
 #include <uhd/types/stream_cmd.hpp>
+#include <uhd/types/stream_stats.hpp>
 #include <uhd/types/ref_vector.hpp>
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
@@ -101,6 +102,10 @@ struct UHD_API stream_args_t{
      * Users should specify this option to request smaller than default
      * packets, probably with the intention of reducing packet latency.
      *
+     * - soft_fe_corr: apply the frontend IQ balance and DC offset corrections
+     * in the host converters, for devices without hardware correction (USRP1).
+     * Set "soft_fe_corr" to 1 to enable; requires fc32 samples and the sc16 wire format.
+     *
      * The following are not implemented, but are listed for conceptual purposes:
      * - function: magnitude or phase/magnitude
      * - units: numeric units like counts or dBm
@@ -186,6 +191,15 @@ public:
      * \param stream_cmd the stream command to issue
      */
     virtual void issue_stream_cmd(const stream_cmd_t &stream_cmd) = 0;
+
+    /*!
+     * Get the streaming statistics of this streamer.
+     * The counters accumulate from the creation of the streamer
+     * and are summed over all of its transports.
+     * Streamers that do not keep statistics return zeroed counters.
+     * \return a snapshot of the counters
+     */
+    virtual stream_stats_t get_stats(void) const;
 };
 
 /*!
@@ -245,6 +259,15 @@ public:
     virtual bool recv_async_msg(
         async_metadata_t &async_metadata, double timeout = 0.1
     ) = 0;
+
+    /*!
+     * Get the streaming statistics of this streamer.
+     * The counters accumulate from the creation of the streamer
+     * and are summed over all of its transports.
+     * Streamers that do not keep statistics return zeroed counters.
+     * \return a snapshot of the counters
+     */
+    virtual stream_stats_t get_stats(void) const;
 };
 
 } //namespace uhd
@@ -26,6 +26,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/smart_ptr.hpp>
 #include <string>
+#include <algorithm>
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/thread/thread.hpp>
 
@@ -182,7 +182,7 @@ nirio_status nirio_fifo<data_t>::acquire(
             elements = static_cast<data_t*>(elements_buffer);
             elements_acquired = static_cast<size_t>(elements_acquired_u32);
             elements_remaining = static_cast<size_t>(elements_remaining_u32);
-            _acquired_pending = elements_acquired;
+            _acquired_pending += elements_acquired;    //Acquires may be outstanding until released
 
             if (UHD_NIRIO_RX_FIFO_XFER_CHECK_EN &&
                 _riok_proxy_ptr->get_rio_quirks().rx_fifo_xfer_check_en() &&
@@ -211,7 +211,7 @@ nirio_status nirio_fifo<data_t>::release(const size_t elements)
         status = _riok_proxy_ptr->grant_fifo(
             _fifo_channel,
             static_cast<uint32_t>(elements));
-        _acquired_pending = 0;
+        _acquired_pending -= std::min(elements, _acquired_pending);
     } else {
         status = NiRio_Status_ResourceNotInitialized;
     }
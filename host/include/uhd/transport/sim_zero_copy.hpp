@@ -0,0 +1,98 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_TRANSPORT_SIM_ZERO_COPY_HPP
+#define INCLUDED_UHD_TRANSPORT_SIM_ZERO_COPY_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/transport/zero_copy.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <uhd/types/metadata.hpp>
+#include <uhd/types/stream_cmd.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+
+namespace uhd{ namespace transport{
+
+/*!
+ * The simulated zero copy transport.
+ * This transport connects the host streaming code to an in-process
+ * model of a streaming device instead of a link to real hardware.
+ *
+ * Receive buffers hold sc16 data packets (CHDR or VRT, little endian)
+ * that are generated on demand after a stream command, paced at the
+ * simulated sample rate. When the host falls behind by more than the
+ * receive frames can hold, the model overflows like a real device:
+ * it sends an overflow message packet and skips ahead in time.
+ *
+ * Send buffers are parsed when released. The model checks sequence
+ * numbers and timestamps, plays the samples out of a device buffer
+ * at the sample rate, and holds back get_send_buff() while that
+ * buffer is full, which is the flow control a real device applies.
+ * Transmit events are reported through the async handler.
+ */
+struct UHD_API sim_zero_copy : public virtual zero_copy_if
+{
+    typedef boost::shared_ptr<sim_zero_copy> sptr;
+    typedef boost::function<time_spec_t(void)> get_time_type;
+    typedef boost::function<void(const async_metadata_t &)> async_handler_type;
+
+    virtual ~sim_zero_copy(void) = 0;
+
+    /*!
+     * Make a new simulated zero copy transport.
+     *
+     * Besides the frame sizes and counts, the hints may contain:
+     *  - sim_format: "chdr" (default) or "vrt" packets
+     *  - sim_throttle: 0 to generate and consume packets as fast as the host runs
+     *  - sim_seq_error_period: skip a receive sequence number every N packets
+     *  - sim_overflow_period: send an overflow message every N packets
+     *  - send_buff_size: the simulated device transmit buffer in bytes
+     *
+     * \param hints optional parameters to pass to the underlying transport
+     */
+    static sptr make(const device_addr_t &hints = device_addr_t());
+
+    //! Are packets CHDR (true) or VRT without a link layer (false)?
+    virtual bool is_chdr(void) const = 0;
+
+    //! Set the sample rate and the tick rate used for timestamps
+    virtual void set_rates(const double samp_rate, const double tick_rate) = 0;
+
+    //! Set the source of the device time (defaults to the host clock)
+    virtual void set_time_source(const get_time_type &get_time_now) = 0;
+
+    //! Set the number of samples in a generated receive packet
+    virtual void set_samps_per_packet(const size_t spp) = 0;
+
+    //! Set the stream ID written into generated receive packets
+    virtual void set_sid(const boost::uint32_t sid) = 0;
+
+    //! Start or stop the generation of receive packets
+    virtual void issue_stream_cmd(const stream_cmd_t &stream_cmd) = 0;
+
+    //! Set the handler for transmit events (burst ACK, underflow, errors)
+    virtual void set_async_handler(const async_handler_type &handler) = 0;
+
+    //! Get the packets the simulated device buffer can accept now
+    virtual size_t get_send_credit(void) = 0;
+};
+
+}} //namespace
+
+#endif /* INCLUDED_UHD_TRANSPORT_SIM_ZERO_COPY_HPP */
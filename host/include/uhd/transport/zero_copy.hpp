@@ -200,6 +200,15 @@ namespace uhd{ namespace transport{
          */
         virtual size_t get_send_frame_size(void) const = 0;
 
+        /*!
+         * Get a file descriptor that is readable when a receive buffer is ready.
+         * Event loops use it to wait on the transport without a thread of its own.
+         * \return the descriptor, or -1 when the transport has none
+         */
+        virtual int get_recv_fd(void) const{
+            return -1;
+        }
+
     };
 
 }} //namespace
@@ -180,6 +180,22 @@ namespace uhd{
             boost::uint32_t data,
             size_t num_bits
         );
+
+        /*!
+        * Write a sequence of words to the SPI bus, one transaction each.
+        * The default writes them one at a time; interfaces that can
+        * queue transactions send them together in one round trip.
+        * \param which_slave the slave device number
+        * \param config spi config args
+        * \param data the words to write, in order
+        * \param num_bits how many bits in each word
+        */
+        virtual void write_spi_burst(
+            int which_slave,
+            const spi_config_t &config,
+            const std::vector<boost::uint32_t> &data,
+            size_t num_bits
+        );
     };
 
     /*!
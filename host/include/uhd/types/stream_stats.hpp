@@ -0,0 +1,128 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_TYPES_STREAM_STATS_HPP
+#define INCLUDED_UHD_TYPES_STREAM_STATS_HPP
+
+#include <uhd/config.hpp>
+#include <boost/cstdint.hpp>
+#include <string>
+
+namespace uhd{
+
+    /*!
+     * A histogram of durations with power-of-two bins in microseconds.
+     * Bin 0 counts durations under 1 us, bin i counts durations
+     * in [2^(i-1), 2^i) us, and the last bin counts everything longer.
+     */
+    struct UHD_API time_histogram_t{
+        static const size_t NUM_BINS = 24;
+
+        //! The number of durations in each bin
+        boost::uint64_t bins[NUM_BINS];
+
+        //! The number of durations added
+        boost::uint64_t count;
+
+        //! The sum of all durations added in seconds
+        double total_secs;
+
+        //! Make an empty histogram
+        time_histogram_t(void);
+
+        //! Add a duration in seconds
+        UHD_INLINE void add(const double secs){
+            boost::uint64_t usecs = (secs > 0.0)? boost::uint64_t(secs*1e6) : 0;
+            size_t bin = 0;
+            while (usecs != 0 and bin < NUM_BINS-1){
+                usecs >>= 1;
+                bin++;
+            }
+            bins[bin]++;
+            count++;
+            total_secs += secs;
+        }
+
+        //! Get the lower edge of a bin in seconds
+        static double get_bin_start(const size_t bin);
+
+        //! Get the mean duration in seconds (zero when empty)
+        double get_mean(void) const;
+
+        //! Accumulate the counts of another histogram
+        time_histogram_t &operator+=(const time_histogram_t &other);
+
+        //! Reset all counts to zero
+        void reset(void);
+    };
+
+    /*!
+     * Counters describing the traffic of a streamer or one of its transports.
+     *
+     * The counters are always enabled and accumulate from the creation
+     * of the streamer. They are updated by the streaming thread without
+     * locking; a snapshot taken from another thread is read under a
+     * sequence count, so its counters belong together and never tear.
+     */
+    struct UHD_API stream_stats_t{
+        //! The number of packets received or sent
+        boost::uint64_t num_packets;
+
+        //! The number of transport bytes received or sent (headers included)
+        boost::uint64_t num_bytes;
+
+        //! The number of dropped packets detected by sequence number (RX, "D")
+        boost::uint64_t num_sequence_errors;
+
+        //! The number of overflows reported by the device (RX, "O")
+        boost::uint64_t num_overflows;
+
+        //! The number of calls that timed out waiting for a transport buffer
+        boost::uint64_t num_timeouts;
+
+        /*!
+         * The number of transport buffer fetches that had to wait:
+         * those that took longer than 10 microseconds or came back empty.
+         * On transmit, this is usually the device flow control holding back.
+         */
+        boost::uint64_t num_buff_stalls;
+
+        //! The time spent waiting for a transport buffer, per stall
+        time_histogram_t buff_wait_time;
+
+        //! The time spent in sample conversion, sampled over packets
+        time_histogram_t convert_time;
+
+        //! The time spent parsing (RX) or packing (TX) packet headers, sampled over packets
+        time_histogram_t header_time;
+
+        //! Make zeroed counters
+        stream_stats_t(void);
+
+        //! Accumulate the counters of another set of stats
+        stream_stats_t &operator+=(const stream_stats_t &other);
+
+        //! Reset all counters to zero
+        void reset(void);
+
+        //! Convert the counters to a printable string
+        std::string to_pp_string(void) const;
+    };
+
+} //namespace uhd
+
+#endif /* INCLUDED_UHD_TYPES_STREAM_STATS_HPP */
@@ -98,6 +98,12 @@ namespace uhd{
          * Default is fractional N on boards that support fractional N tuning.
          * Fractional N provides greater tuning accuracy at the expense of spurs.
          * Possible options for this key: "integer" or "fractional".
+         *
+         * - lo_grid: A step in Hz for the LO frequencies of boards with an
+         * ADF435x or MAX2870 synthesizer (WBX, SBX, CBX). The LO goes to the
+         * nearest point of the grid and the DSP tunes the remaining offset.
+         * A scan on a grid retunes faster, since the synthesizer settings of
+         * a grid point are computed once and only changed registers are written.
          */
         device_addr_t args;
 
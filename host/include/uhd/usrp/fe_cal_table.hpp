@@ -0,0 +1,104 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_USRP_FE_CAL_TABLE_HPP
+#define INCLUDED_UHD_USRP_FE_CAL_TABLE_HPP
+
+#include <uhd/config.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <complex>
+#include <string>
+#include <vector>
+
+namespace uhd{ namespace usrp{
+
+/*!
+ * One point of a frontend calibration table:
+ * the correction value measured at a given LO frequency.
+ */
+struct UHD_API fe_cal_point_t{
+    double lo_freq;
+    double corr_real;
+    double corr_imag;
+};
+
+/*!
+ * A frontend (IQ balance or DC offset) calibration table.
+ *
+ * The CSV files written by the uhd_cal_* utilities remain the
+ * interchange format. Alongside each CSV, the utilities also write a
+ * compact binary table (same path, ".bin" extension) which is memory
+ * mapped on load. The binary file is a fixed header followed by the
+ * points sorted by LO frequency, so lookups are a binary search.
+ *
+ * A loaded table is immutable; get_correction() may be called
+ * concurrently from any number of threads without locking.
+ */
+class UHD_API fe_cal_table : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<fe_cal_table> sptr;
+
+    //! The file extension used for binary calibration tables
+    static const std::string BIN_EXT;
+
+    virtual ~fe_cal_table(void) = 0;
+
+    /*!
+     * Make a table from a list of points held in memory.
+     * \param points the calibration points (any order)
+     * \return a new table sorted by LO frequency
+     */
+    static sptr make(const std::vector<fe_cal_point_t> &points);
+
+    /*!
+     * Memory map a binary calibration table from disk.
+     * \param path the path to a file written by write()
+     * \return a new table backed by the file mapping
+     * \throws uhd::io_error if the file is missing or malformed
+     */
+    static sptr load(const std::string &path);
+
+    /*!
+     * Write a binary calibration table to disk.
+     * The file is written to a temporary and then renamed over the
+     * destination so that readers never map a partial table.
+     * \param path the destination file path
+     * \param points the calibration points (any order)
+     */
+    static void write(const std::string &path, const std::vector<fe_cal_point_t> &points);
+
+    //! Get the number of points in this table
+    virtual size_t size(void) const = 0;
+
+    //! Get the point at index i (sorted by LO frequency)
+    virtual const fe_cal_point_t &operator[](const size_t i) const = 0;
+
+    /*!
+     * Get the correction for an LO frequency.
+     * Interpolates linearly between the two nearest points,
+     * and clips to the first/last point outside the table's range.
+     * \param lo_freq the actual LO frequency in Hz
+     * \return the complex correction value
+     * \throws uhd::runtime_error if the table is empty
+     */
+    virtual std::complex<double> get_correction(const double lo_freq) const = 0;
+};
+
+}} //namespace uhd::usrp
+
+#endif /* INCLUDED_UHD_USRP_FE_CAL_TABLE_HPP */
@@ -893,6 +893,37 @@ public:
      */
     virtual boost::uint32_t get_gpio_attr(const std::string &bank, const std::string &attr, const size_t mboard = 0) = 0;
 
+    /*******************************************************************
+     * Fast lock methods
+     * (not pure virtual: devices without profiles keep the default)
+     ******************************************************************/
+
+    /*!
+     * Store the current RX frontend frequency in a fast lock profile.
+     * Frontends with fast lock profiles (AD9361 based devices) keep
+     * the calibrated synthesizer state of each stored frequency.
+     * A later set_rx_freq() to the same frequency recalls the profile
+     * instead of calibrating again, which takes tens of microseconds.
+     * Storing to a profile in use replaces its frequency.
+     * \param profile the profile index 0 to 7
+     * \param chan the channel index 0 to N-1
+     * \throw uhd::not_implemented_error when the frontend has no profiles
+     */
+    virtual void store_rx_fast_lock_profile(size_t profile, size_t chan = 0);
+
+    /*!
+     * Store the current TX frontend frequency in a fast lock profile.
+     * Frontends with fast lock profiles (AD9361 based devices) keep
+     * the calibrated synthesizer state of each stored frequency.
+     * A later set_tx_freq() to the same frequency recalls the profile
+     * instead of calibrating again, which takes tens of microseconds.
+     * Storing to a profile in use replaces its frequency.
+     * \param profile the profile index 0 to 7
+     * \param chan the channel index 0 to N-1
+     * \throw uhd::not_implemented_error when the frontend has no profiles
+     */
+    virtual void store_tx_fast_lock_profile(size_t profile, size_t chan = 0);
+
 };
 
 }}
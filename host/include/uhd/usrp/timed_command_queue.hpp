@@ -0,0 +1,224 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_USRP_TIMED_COMMAND_QUEUE_HPP
+#define INCLUDED_UHD_USRP_TIMED_COMMAND_QUEUE_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <uhd/types/tune_request.hpp>
+#include <uhd/types/stream_cmd.hpp>
+#include <uhd/types/metadata.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <string>
+#include <vector>
+
+namespace uhd{ namespace usrp{
+
+/*!
+ * A batch of control operations that take effect at one time.
+ *
+ * The setters mirror their multi_usrp counterparts and are recorded,
+ * not executed. Once pushed into a timed_command_queue, the batch is
+ * issued by the queue's worker thread. Each operation sets the command
+ * time of its own motherboard to the batch's time spec, and clears it
+ * again when it returns.
+ */
+class UHD_API timed_command_batch_t{
+public:
+    //! An operation to run against the device
+    typedef boost::function<void(multi_usrp::sptr)> operation_t;
+
+    //! A recorded operation, called with the batch's time spec
+    typedef boost::function<void(multi_usrp::sptr, const time_spec_t &)> timed_operation_t;
+
+    /*!
+     * Make an empty batch.
+     * \param time_spec the time at which the operations take effect
+     * \param id a user-chosen identifier echoed in events for this batch
+     */
+    timed_command_batch_t(const time_spec_t &time_spec = time_spec_t(0.0), const size_t id = 0);
+
+    //! The time at which the operations take effect
+    time_spec_t time_spec;
+
+    //! A user-chosen identifier echoed in events for this batch
+    size_t id;
+
+    //! Record a multi_usrp::set_rx_gain() call
+    void set_rx_gain(double gain, const std::string &name, size_t chan = 0);
+
+    //! Record a multi_usrp::set_rx_gain() call on the overall gain
+    void set_rx_gain(double gain, size_t chan = 0){
+        return this->set_rx_gain(gain, multi_usrp::ALL_GAINS, chan);
+    }
+
+    //! Record a multi_usrp::set_tx_gain() call
+    void set_tx_gain(double gain, const std::string &name, size_t chan = 0);
+
+    //! Record a multi_usrp::set_tx_gain() call on the overall gain
+    void set_tx_gain(double gain, size_t chan = 0){
+        return this->set_tx_gain(gain, multi_usrp::ALL_GAINS, chan);
+    }
+
+    //! Record a multi_usrp::set_rx_freq() call
+    void set_rx_freq(const tune_request_t &tune_request, size_t chan = 0);
+
+    //! Record a multi_usrp::set_tx_freq() call
+    void set_tx_freq(const tune_request_t &tune_request, size_t chan = 0);
+
+    //! Record a multi_usrp::set_gpio_attr() call
+    void set_gpio_attr(
+        const std::string &bank, const std::string &attr,
+        const boost::uint32_t value, const boost::uint32_t mask = 0xffffffff,
+        const size_t mboard = 0
+    );
+
+    /*!
+     * Record a multi_usrp::issue_stream_cmd() call.
+     * Stream commands are timed by their own time spec:
+     * when stream_now is set, the command is issued for the batch time.
+     */
+    void issue_stream_cmd(const stream_cmd_t &stream_cmd, size_t chan = multi_usrp::ALL_CHANS);
+
+    /*!
+     * Record an arbitrary operation.
+     * \param operation the operation to run against the device
+     * \param mboard the motherboard whose command time is set around the call
+     */
+    void add_operation(const operation_t &operation, const size_t mboard = multi_usrp::ALL_MBOARDS);
+
+    //! Get the recorded operations in order
+    const std::vector<timed_operation_t> &get_operations(void) const;
+
+private:
+    std::vector<timed_operation_t> _operations;
+};
+
+/*!
+ * An event reported by a timed_command_queue for one batch.
+ *
+ * The events travel through the device's async message path: they are
+ * received with recv_async_msg() as EVENT_CODE_USER_PAYLOAD messages,
+ * and from_async_metadata() picks them out of the other messages.
+ */
+struct UHD_API timed_command_event_t{
+    //! Marks a timed command event in user_payload[0]
+    static const boost::uint32_t USER_PAYLOAD_TAG = 0x54434d44; //"TCMD"
+
+    //! The identifier of the batch
+    size_t id;
+
+    //! The time spec of the batch
+    time_spec_t time_spec;
+
+    //! The event code
+    enum event_code_t {
+        //! All operations were accepted by the device
+        EVENT_CODE_ISSUED = 0x1,
+        //! The batch time passed before the batch was issued; it was dropped
+        EVENT_CODE_LATE   = 0x2,
+        //! An operation threw; the remaining operations were skipped
+        EVENT_CODE_ERROR  = 0x4
+    } event_code;
+
+    //! Encode the event as an async message
+    async_metadata_t to_async_metadata(void) const;
+
+    /*!
+     * Decode the event from an async message.
+     * \param async_metadata a message from recv_async_msg()
+     * \return false when the message is not a timed command event
+     */
+    bool from_async_metadata(const async_metadata_t &async_metadata);
+};
+
+/*!
+ * Queue batches of timed control operations without blocking.
+ *
+ * A timed command back-pressures the control path until the device's
+ * command FIFO accepts it, so issuing far-future commands from an
+ * application thread blocks that thread. This queue hands batches to a
+ * worker thread that issues them in order, and reports the outcome of
+ * each batch as a timed_command_event_t in the device's async messages.
+ * Errors are also logged with their description.
+ *
+ * The worker sets and clears the command time of the device around each
+ * operation. A settings call made from another thread while a batch is
+ * issued would be timed as well, and a command time set by the
+ * application would be cleared. While a queue is in use, make other
+ * settings calls on the device through run_exclusive(), and do not leave
+ * a command time set: time those calls with a batch instead.
+ */
+class UHD_API timed_command_queue : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<timed_command_queue> sptr;
+
+    virtual ~timed_command_queue(void) = 0;
+
+    /*!
+     * Make a new command queue for a device.
+     * The device must take host side async messages (all USRP devices do).
+     * \param usrp the device to issue commands on
+     * \param capacity the maximum number of pending batches
+     * \param mboard the motherboard whose time is used for late checks
+     * \return a new command queue
+     */
+    static sptr make(multi_usrp::sptr usrp, const size_t capacity = 1024, const size_t mboard = 0);
+
+    /*!
+     * Push a batch into the queue.
+     * Batches must be pushed in order of non-decreasing time.
+     * \param batch the batch to issue
+     * \param timeout the time in seconds to wait for space in the queue
+     * \return true when the batch was queued, false on timeout
+     */
+    virtual bool push(const timed_command_batch_t &batch, const double timeout = 0.0) = 0;
+
+    //! Get the number of batches that have not been issued yet
+    virtual size_t get_num_pending(void) = 0;
+
+    //! Get the maximum number of pending batches
+    virtual size_t get_capacity(void) = 0;
+
+    /*!
+     * Wait until all pushed batches have been issued.
+     * \param timeout the time in seconds to wait
+     * \return true when the queue is empty, false on timeout
+     */
+    virtual bool wait_for_empty(const double timeout) = 0;
+
+    //! Drop all batches that have not been issued yet
+    virtual void clear(void) = 0;
+
+    /*!
+     * Run an operation on the device between batches.
+     * Waits until the batch being issued is done; no batch is issued
+     * while the operation runs. The operation must not leave a command
+     * time set on the device.
+     * \param operation the operation to run against the device
+     */
+    virtual void run_exclusive(const timed_command_batch_t::operation_t &operation) = 0;
+};
+
+}} //namespace uhd::usrp
+
+#endif /* INCLUDED_UHD_USRP_TIMED_COMMAND_QUEUE_HPP */
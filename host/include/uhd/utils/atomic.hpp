@@ -31,9 +31,27 @@
 #else
 #  define BOOST_IPC_DETAIL boost::interprocess::detail
 #endif
+#if BOOST_VERSION >= 105300
+#  include <boost/atomic.hpp>
+#endif
 
 namespace uhd{
 
+    /*!
+     * A full memory barrier: no load or store moves across it.
+     * Lock-free readers use it to order their copy of shared data
+     * before they check that the data did not change underneath them.
+     */
+    UHD_INLINE void atomic_fence(void){
+        #if BOOST_VERSION >= 105300
+        boost::atomic_thread_fence(boost::memory_order_seq_cst);
+        #else
+        //the interprocess atomics are full barriers
+        static volatile boost::uint32_t fence_word = 0;
+        BOOST_IPC_DETAIL::atomic_cas32(&fence_word, 0, 0);
+        #endif
+    }
+
     //! A 32-bit integer that can be atomically accessed
     class UHD_API atomic_uint32_t{
     public:
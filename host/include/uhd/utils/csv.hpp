@@ -22,14 +22,37 @@
 #include <vector>
 #include <string>
 #include <istream>
+#include <ostream>
 
 namespace uhd{ namespace csv{
     typedef std::vector<std::string> row_type;
     typedef std::vector<row_type> rows_type;
+    typedef std::vector<std::vector<double> > columns_type;
 
     //! Convert an input stream to csv rows.
     UHD_API rows_type to_rows(std::istream &input);
 
+    /*!
+     * Parse the numeric rows of an input stream into columns.
+     * The stream is read in blocks and each field is converted in place,
+     * without building intermediate row or field strings.
+     * Blank lines are skipped; columns past num_cols are ignored.
+     * \param input the input stream, positioned at the first numeric row
+     * \param num_cols the number of leading columns to parse
+     * \return one vector of values per column
+     * \throws uhd::value_error for a short row or a non-numeric field
+     */
+    UHD_API columns_type to_columns(std::istream &input, const size_t num_cols);
+
+    /*!
+     * Write numeric columns as csv rows.
+     * Values are written with enough digits to read back exactly.
+     * \param output the output stream
+     * \param columns the columns (all must have the same length)
+     * \throws uhd::value_error if the column lengths differ
+     */
+    UHD_API void write_columns(std::ostream &output, const columns_type &columns);
+
 }} //namespace uhd::csv
 
 #endif /* INCLUDED_UHD_UTILS_CSV_HPP */
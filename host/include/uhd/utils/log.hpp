@@ -22,6 +22,7 @@
 #include <uhd/utils/pimpl.hpp>
 #include <boost/current_function.hpp>
 #include <boost/format.hpp>
+#include <boost/cstdint.hpp>
 #include <ostream>
 #include <string>
 #include <sstream>
@@ -31,7 +32,11 @@
  *
  * The logger enables UHD library code to easily log events into a file.
  * Log entries are time-stamped and stored with file, line, and function.
- * Each call to the UHD_LOG macros is synchronous and thread-safe.
+ * Each call to the UHD_LOG macros is thread-safe and does not block:
+ * the message is queued in a lock-free ring owned by the calling thread,
+ * and a background thread formats the entries and writes the log file.
+ * A disabled log level costs a single comparison;
+ * the message arguments are not evaluated.
  *
  * The log file can be found in the path <temp-directory>/uhd.log,
  * where <temp-directory> is the user or system's temporary directory.
@@ -57,6 +62,8 @@
  * Usage: UHD_LOGV(very_rarely) << "the log message" << std::endl;
  */
 #define UHD_LOGV(verbosity) \
+    (boost::uint32_t(uhd::_log::verbosity) < uhd::_log::log_level)? (void)0 : \
+    uhd::_log::log_voidify() & \
     uhd::_log::log(uhd::_log::verbosity, __FILE__, __LINE__, BOOST_CURRENT_FUNCTION)
 
 /*!
@@ -79,6 +86,17 @@ namespace uhd{ namespace _log{
         never       = 6,
     };
 
+    /*!
+     * The current log level, read by the filter of the UHD_LOG macros.
+     * It is zero until the logger has read its settings: until then,
+     * every message goes on to the logger, which checks the level itself.
+     * Only the logger writes it, atomically.
+     */
+    UHD_API extern volatile boost::uint32_t log_level;
+
+    //! Get the current log level
+    UHD_API verbosity_t get_log_level(void);
+
     //! Internal logging object (called by UHD_LOG macros)
     class UHD_API log {
     public:
@@ -113,6 +131,11 @@ namespace uhd{ namespace _log{
         bool _log_it;
     };
 
+    //! Turns a log expression into void for the UHD_LOG macros
+    struct log_voidify{
+        void operator&(const log &){}
+    };
+
 }} //namespace uhd::_log
 
 #endif /* INCLUDED_UHD_UTILS_LOG_HPP */
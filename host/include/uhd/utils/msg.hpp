@@ -60,7 +60,9 @@ namespace uhd{ namespace msg{
      * Register the handler for uhd system messages.
      * Only one handler can be registered at once.
      * This replaces the default std::cout/cerr handler.
-     * \param handler a new handler callback function
+     * Fastpath messages are queued by the calling thread
+     * and passed to the handler from a background thread.
+     * \param handler a new handler callback function, NULL for the default
      */
     UHD_API void register_handler(const handler_t &handler);
 
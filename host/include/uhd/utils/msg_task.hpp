@@ -26,6 +26,7 @@
 #include <boost/optional/optional.hpp>
 #include <boost/cstdint.hpp>
 #include <vector>
+#include <string>
 
 namespace uhd{
 	class UHD_API msg_task : boost::noncopyable{
@@ -70,6 +71,17 @@ namespace uhd{
              * \return a new task object
              */
             static sptr make(const task_fcn_type &task_fcn);
+
+            /*!
+             * Create a new task object with function callback and a role.
+             * The thread is named after its role and placed as configured
+             * for the role (see thread_role.hpp).
+             *
+             * \param task_fcn the task callback function
+             * \param role the thread role, empty for none
+             * \return a new task object
+             */
+            static sptr make(const task_fcn_type &task_fcn, const std::string &role);
     };
 } //namespace uhd
 
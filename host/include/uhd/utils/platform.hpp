@@ -18,6 +18,7 @@
 #ifndef INCLUDED_UHD_UTILS_PLATFORM_HPP
 #define INCLUDED_UHD_UTILS_PLATFORM_HPP
 
+#include <uhd/config.hpp>
 #include <boost/cstdint.hpp>
 
 namespace uhd {
@@ -31,6 +32,22 @@ namespace uhd {
     /* Get a unique identifier for the current machine and process */
     boost::uint32_t get_process_hash();
 
+    /* Returns the CPU time (user + system) used by the calling thread in seconds */
+    UHD_API double get_thread_cpu_time();
+
+    /* Returns the CPU time (user + system) used by all threads of this process in seconds */
+    UHD_API double get_process_cpu_time();
+
+    /* Stores the CPU time used by the calling thread in a scope, also when it is left by an exception */
+    class thread_cpu_timer {
+    public:
+        thread_cpu_timer(double &result): _result(result), _start(get_thread_cpu_time()) {}
+        ~thread_cpu_timer() { _result = get_thread_cpu_time() - _start; }
+    private:
+        double &_result;
+        const double _start;
+    };
+
 } //namespace uhd
 
 #endif /* INCLUDED_UHD_UTILS_PLATFORM_HPP */
@@ -0,0 +1,126 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_UTILS_STATS_EXPORT_HPP
+#define INCLUDED_UHD_UTILS_STATS_EXPORT_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/device.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <string>
+#include <vector>
+
+namespace uhd{
+
+    //! A named numeric metric in an exported statistics segment
+    struct UHD_API stats_metric_t{
+        std::string name;
+        double value;
+    };
+
+    //! A consistent snapshot of an exported statistics segment
+    struct UHD_API stats_snapshot_t{
+        //! The process ID of the exporter
+        boost::uint32_t pid;
+
+        //! The number of updates the exporter has written
+        boost::uint64_t update_count;
+
+        //! The time of the last update in seconds since the Unix epoch
+        double update_time;
+
+        //! The number of metrics that did not fit into the segment
+        size_t num_dropped;
+
+        //! The metrics in the order they were written
+        std::vector<stats_metric_t> metrics;
+    };
+
+    /*!
+     * Publish UHD counters to a shared-memory segment for external monitoring.
+     *
+     * A background thread periodically reads the counters of each added
+     * device from its property tree: streamer and transport statistics,
+     * flow control credit, control round-trip times and numeric sensors.
+     * The values are written into a memory-mapped segment protected by a
+     * sequence lock, so readers in other processes never block the writer,
+     * and the streaming threads are not involved at all.
+     *
+     * Devices are added automatically when made with the "stats_export"
+     * device argument or with the UHD_STATS_EXPORT environment variable set.
+     * A non-empty value sets the update period in seconds.
+     */
+    class UHD_API stats_exporter : boost::noncopyable{
+    public:
+        typedef boost::shared_ptr<stats_exporter> sptr;
+
+        virtual ~stats_exporter(void) = 0;
+
+        /*!
+         * Get the exporter for this process.
+         * The segment is created on the first call.
+         */
+        static sptr get(void);
+
+        //! Get the segment name used by a process
+        static std::string get_segment_name(const boost::uint32_t pid);
+
+        /*!
+         * Add a device to scrape each period.
+         * The device is held weakly and dropped once destroyed.
+         * \param dev the device to scrape
+         * \return the metric prefix of this device (ex: "dev0")
+         */
+        virtual std::string add_device(device::sptr dev) = 0;
+
+        //! Set the update period in seconds
+        virtual void set_period(const double period) = 0;
+
+        //! Update the segment now instead of waiting for the period
+        virtual void update(void) = 0;
+    };
+
+    /*!
+     * Read the statistics segment of another (or this) process.
+     */
+    class UHD_API stats_reader : boost::noncopyable{
+    public:
+        typedef boost::shared_ptr<stats_reader> sptr;
+
+        virtual ~stats_reader(void) = 0;
+
+        /*!
+         * Open an existing statistics segment.
+         * \param segment_name the segment (see stats_exporter::get_segment_name)
+         * \throws uhd::io_error when the segment does not exist
+         */
+        static sptr make(const std::string &segment_name);
+
+        /*!
+         * Read a consistent snapshot of the segment.
+         * Retries while the exporter is in the middle of an update.
+         * \throws uhd::io_error when no update completes within a second,
+         * for example because the exporter died during an update
+         */
+        virtual stats_snapshot_t read(void) = 0;
+    };
+
+} //namespace uhd
+
+#endif /* INCLUDED_UHD_UTILS_STATS_EXPORT_HPP */
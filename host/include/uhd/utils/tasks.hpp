@@ -22,6 +22,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
 #include <boost/utility.hpp>
+#include <string>
 
 namespace uhd{
 
@@ -45,6 +46,47 @@ namespace uhd{
          */
         static sptr make(const task_fcn_type &task_fcn);
 
+        /*!
+         * Create a new task object with function callback and a role.
+         * The thread is named after its role and placed as configured
+         * for the role (see thread_role.hpp).
+         *
+         * \param task_fcn the task callback function
+         * \param role the thread role, empty for none
+         * \return a new task object
+         */
+        static sptr make(const task_fcn_type &task_fcn, const std::string &role);
+
+        /*!
+         * Create a task that calls the callback every period.
+         * The calls run on a thread of their own, so they may block
+         * on control transactions. The first call is one period from now.
+         * The task may be destroyed from within its own callback.
+         *
+         * \param task_fcn the task callback function
+         * \param period the time between calls in seconds
+         * \param role the thread role
+         * \return a new task object, the calls stop when it is destroyed
+         */
+        static sptr make_periodic(const task_fcn_type &task_fcn, double period, const std::string &role = "");
+
+        /*!
+         * Create a task that calls the callback when a descriptor is readable.
+         * The call runs on an event loop shared with the async message and
+         * flow control handlers of all devices, so it must handle what is
+         * ready and return without blocking; never make control transactions
+         * from it. The descriptor is not watched while the callback runs.
+         *
+         * Where the event loop cannot watch descriptors,
+         * the task gets a thread of its own that waits on the descriptor.
+         *
+         * \param fd the file descriptor or socket to watch
+         * \param task_fcn the task callback function
+         * \param role the thread role
+         * \return a new task object, the calls stop when it is destroyed
+         */
+        static sptr make_readable(int fd, const task_fcn_type &task_fcn, const std::string &role = "");
+
     };
 } //namespace uhd
 
@@ -19,6 +19,8 @@
 #define INCLUDED_UHD_UTILS_THREAD_PRIORITY_HPP
 
 #include <uhd/config.hpp>
+#include <string>
+#include <vector>
 
 namespace uhd{
 
@@ -53,6 +55,34 @@ namespace uhd{
         bool realtime = true
     );
 
+    /*!
+     * Set the scheduling policy and priority on the current thread.
+     * The priority is scaled into the priority range of the policy.
+     * \param policy "other" (normal), "rr" or "fifo" (realtime)
+     * \param priority a value between -1 and 1
+     * \throw exception on unknown policy or failure
+     */
+    UHD_API void set_thread_policy(
+        const std::string &policy,
+        float priority = default_thread_priority
+    );
+
+    /*!
+     * Restrict the current thread to a set of CPUs.
+     * An empty set allows every CPU.
+     * \param cpus the CPU indexes
+     * \throw exception on failure or when not supported
+     */
+    UHD_API void set_thread_affinity(const std::vector<size_t> &cpus);
+
+    /*!
+     * Name the current thread for tools like top, ps and gdb.
+     * Linux truncates the name to 15 characters.
+     * Does nothing when the platform cannot name threads.
+     * \param name the new thread name
+     */
+    UHD_API void set_thread_name(const std::string &name);
+
 } //namespace uhd
 
 #endif /* INCLUDED_UHD_UTILS_THREAD_PRIORITY_HPP */
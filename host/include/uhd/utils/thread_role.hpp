@@ -0,0 +1,107 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_UTILS_THREAD_ROLE_HPP
+#define INCLUDED_UHD_UTILS_THREAD_ROLE_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <string>
+#include <vector>
+
+namespace uhd{
+
+    /*!
+     * The placement of the threads that UHD starts for one role.
+     *
+     * Every internal thread has a role (for example "x300_tx_async" or
+     * "uhd_reactor") and is named after it. Roles without a
+     * configuration of their own use the configuration of the role
+     * "default"; when that has none either, the thread is left alone.
+     */
+    struct UHD_API thread_role_config_t{
+        thread_role_config_t(void);
+
+        //! The CPUs the threads may run on, empty for any CPU
+        std::vector<size_t> cpus;
+
+        //! The scheduling policy ("other", "rr" or "fifo"), empty to keep the policy
+        std::string policy;
+
+        //! The priority within the policy, between -1 and 1
+        float priority;
+
+        //! Is there anything to apply?
+        bool empty(void) const;
+    };
+
+    /*!
+     * Set the configuration of a role.
+     * Threads started afterwards with this role use it;
+     * threads that are already running keep their placement.
+     * \param role the role name or "default"
+     * \param config the placement for the role
+     */
+    UHD_API void set_thread_role_config(const std::string &role, const thread_role_config_t &config);
+
+    /*!
+     * Get the configuration that applies to a role,
+     * falling back on the "default" role.
+     * \param role the role name
+     * \return the configuration (empty when nothing is set)
+     */
+    UHD_API thread_role_config_t get_thread_role_config(const std::string &role);
+
+    /*!
+     * Role configurations set from device address arguments:
+     *  - thread_<role>_cpus: CPU list, items separated by ':' with ranges as 2-5
+     *  - thread_<role>_sched: the scheduling policy (other, rr or fifo)
+     *  - thread_<role>_prio: the priority between -1 and 1 (default 0.5)
+     *
+     * Example: thread_default_cpus=2-3,thread_x300_tx_async_sched=fifo
+     *
+     * The configurations apply while the object lives and take precedence
+     * over those set with set_thread_role_config(); the most recent object
+     * wins. Destroying it removes its configurations again.
+     */
+    class UHD_API thread_role_args : boost::noncopyable{
+    public:
+        typedef boost::shared_ptr<thread_role_args> sptr;
+
+        virtual ~thread_role_args(void) = 0;
+
+        /*!
+         * Set role configurations from device address arguments.
+         * \param args device address arguments, other keys are ignored
+         * \return the configurations, they are removed when it is destroyed
+         * \throw uhd::value_error on a malformed value
+         */
+        static sptr make(const device_addr_t &args);
+    };
+
+    /*!
+     * Name the calling thread after its role and apply the role configuration.
+     * Failures are reported as warnings, the thread keeps running.
+     * \param role the role name
+     */
+    UHD_API void apply_thread_role(const std::string &role);
+
+} //namespace uhd
+
+#endif /* INCLUDED_UHD_UTILS_THREAD_ROLE_HPP */
@@ -0,0 +1,235 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/convert.hpp>
+#include <uhd/utils/paths.hpp>
+#include <uhd/utils/csv.hpp>
+#include <uhd/utils/log.hpp>
+#include <uhd/utils/msg.hpp>
+#include <uhd/utils/static.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <uhd/types/dict.hpp>
+#include <uhd/exception.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/format.hpp>
+#include <boost/foreach.hpp>
+#include <algorithm>
+#include <fstream>
+#include <cstdlib>
+
+using namespace uhd;
+
+namespace fs = boost::filesystem;
+
+static const size_t AUTOTUNE_NUM_REPS = 5;
+static const double AUTOTUNE_REP_TIME = 1e-3; //seconds
+
+/***********************************************************************
+ * The autotune cache:
+ * The choices are kept per process and in a csv file with the rows
+ * cpu model, input format, num inputs, output format, num outputs,
+ * num samps, priority. The cpu model is part of the key so machines
+ * that share a home directory keep their own choices. The file is
+ * ~/.uhd/cache/convert_autotune.csv unless UHD_CONVERT_AUTOTUNE_CACHE
+ * names another one. Rows with a damaged field are skipped.
+ **********************************************************************/
+struct autotune_cache_t{
+    autotune_cache_t(void): loaded(false){}
+    boost::mutex mutex;
+    bool loaded;
+    std::string cpu_model;
+    uhd::dict<std::string, convert::priority_type> choices;
+};
+
+UHD_SINGLETON_FCN(autotune_cache_t, get_cache);
+
+static fs::path get_cache_path(void){
+    const char *env = std::getenv("UHD_CONVERT_AUTOTUNE_CACHE");
+    if (env != NULL and env[0] != '\0') return fs::path(env);
+    return fs::path(uhd::get_app_path()) / ".uhd" / "cache" / "convert_autotune.csv";
+}
+
+static std::string get_cpu_model(void){
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)){
+        //x86 uses "model name", older ARM kernels "Processor"
+        if (not boost::starts_with(line, "model name") and not boost::starts_with(line, "Processor")) continue;
+        const size_t pos = line.find(':');
+        if (pos == std::string::npos) continue;
+        std::string model = boost::trim_copy(line.substr(pos + 1));
+        std::replace(model.begin(), model.end(), ',', ' ');
+        if (not model.empty()) return model;
+    }
+    return "unknown";
+}
+
+static std::string make_key(const convert::id_type &id, const size_t num_samps){
+    return str(boost::format("%s,%u,%s,%u,%u")
+        % id.input_format % id.num_inputs % id.output_format % id.num_outputs % num_samps);
+}
+
+//! Parse a format name field, throws on a damaged field
+static std::string parse_format(const std::string &field){
+    const std::string format = boost::trim_copy(field);
+    if (format.empty() or format.find_first_not_of(
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_"
+    ) != std::string::npos) throw boost::bad_lexical_cast();
+    return format;
+}
+
+//! Parse a decimal count field, throws on a damaged field
+static size_t parse_count(const std::string &field){
+    const std::string count = boost::trim_copy(field);
+    //lexical_cast alone would take a sign or wrap a long number
+    if (count.empty() or count.size() > 9 or count.find_first_not_of("0123456789") != std::string::npos){
+        throw boost::bad_lexical_cast();
+    }
+    return boost::lexical_cast<size_t>(count);
+}
+
+static void load_cache(autotune_cache_t &cache){
+    cache.loaded = true;
+    cache.cpu_model = get_cpu_model();
+    std::ifstream cache_file(get_cache_path().string().c_str());
+    if (not cache_file.is_open()) return;
+    BOOST_FOREACH(const csv::row_type &row, csv::to_rows(cache_file)){
+        if (row.size() != 7 or boost::trim_copy(row[0]) != cache.cpu_model) continue;
+        try{
+            convert::id_type id;
+            id.input_format = parse_format(row[1]);
+            id.num_inputs = parse_count(row[2]);
+            id.output_format = parse_format(row[3]);
+            id.num_outputs = parse_count(row[4]);
+            const size_t num_samps = parse_count(row[5]);
+            const std::string prio_field = boost::trim_copy(row[6]);
+            const bool negative = boost::starts_with(prio_field, "-");
+            const convert::priority_type prio = convert::priority_type(parse_count(prio_field.substr(negative? 1 : 0)));
+            if (id.num_inputs == 0 or id.num_outputs == 0 or num_samps == 0) continue;
+            cache.choices[make_key(id, num_samps)] = negative? -prio : prio;
+        }
+        catch(const boost::bad_lexical_cast &){
+            //skip a damaged row, it gets tuned again
+        }
+    }
+}
+
+static void store_choice(const autotune_cache_t &cache, const std::string &key, const convert::priority_type prio){
+    try{
+        const fs::path cache_path = get_cache_path();
+        fs::create_directories(cache_path.parent_path());
+        std::ofstream cache_file(cache_path.string().c_str(), std::ios::app);
+        cache_file << cache.cpu_model << "," << key << "," << prio << std::endl;
+    }
+    catch(const std::exception &e){
+        UHD_LOG << "convert autotune: cannot store the choice: " << e.what() << std::endl;
+    }
+}
+
+/***********************************************************************
+ * Timing a converter
+ **********************************************************************/
+//! Get the best time per sample over a few repetitions
+static double time_converter(const convert::id_type &id, const convert::priority_type prio, const size_t num_samps){
+    convert::converter::sptr conv = convert::get_converter(id, prio)();
+    //floats are scaled to the integer range and integers to +/-1.0
+    conv->set_scalar((id.input_format[0] == 'f')? 32767. : 1./32767.);
+
+    //sized for the largest item (fc64) so no format can overrun
+    std::vector<std::vector<char> > in_mem(id.num_inputs, std::vector<char>(num_samps*16));
+    std::vector<std::vector<char> > out_mem(id.num_outputs, std::vector<char>(num_samps*16));
+    std::vector<const void *> ins;
+    std::vector<void *> outs;
+    for (size_t i = 0; i < id.num_inputs; i++) ins.push_back(&in_mem[i].front());
+    for (size_t i = 0; i < id.num_outputs; i++) outs.push_back(&out_mem[i].front());
+
+    conv->conv(ins, outs, num_samps); //warm up
+    double best = 0;
+    for (size_t rep = 0; rep < AUTOTUNE_NUM_REPS; rep++){
+        const time_spec_t start = time_spec_t::get_system_time();
+        size_t num_convs = 0;
+        double elapsed = 0;
+        do{
+            conv->conv(ins, outs, num_samps);
+            num_convs++;
+            elapsed = (time_spec_t::get_system_time() - start).get_real_secs();
+        } while (elapsed < AUTOTUNE_REP_TIME);
+        const double secs_per_samp = elapsed/(num_convs*num_samps);
+        if (rep == 0 or secs_per_samp < best) best = secs_per_samp;
+    }
+    return best;
+}
+
+/***********************************************************************
+ * The autotune functions
+ **********************************************************************/
+convert::priority_type convert::autotune_converter(const id_type &id, const size_t num_samps){
+    const std::vector<priority_type> prios = get_converter_prios(id);
+    if (prios.empty()) throw uhd::key_error(
+        "Cannot find a conversion routine for " + id.to_pp_string());
+    if (num_samps == 0) throw uhd::value_error("convert autotune needs num_samps > 0");
+
+    autotune_cache_t &cache = get_cache();
+    boost::mutex::scoped_lock lock(cache.mutex);
+    if (not cache.loaded) load_cache(cache);
+
+    //a choice made earlier (in this process or stored) if still registered
+    const std::string key = make_key(id, num_samps);
+    if (cache.choices.has_key(key) and std::count(prios.begin(), prios.end(), cache.choices[key]) != 0){
+        return cache.choices[key];
+    }
+
+    priority_type best_prio = prios.front();
+    double best_time = 0;
+    BOOST_FOREACH(const priority_type prio, prios){
+        double secs_per_samp = 0;
+        try{
+            secs_per_samp = time_converter(id, prio, num_samps);
+        }
+        catch(const std::exception &e){
+            UHD_LOG << boost::format("convert autotune: %s prio %d failed: %s") % key % prio % e.what() << std::endl;
+            continue;
+        }
+        UHD_LOG << boost::format("convert autotune: %s prio %d: %.3f ns/sample") % key % prio % (secs_per_samp*1e9) << std::endl;
+        if (best_time == 0 or secs_per_samp < best_time){
+            best_time = secs_per_samp;
+            best_prio = prio;
+        }
+    }
+
+    UHD_MSG(status) << boost::format("Autotuned converter %s -> %s: priority %d")
+        % id.input_format % id.output_format % best_prio << std::endl;
+    cache.choices[key] = best_prio;
+    store_choice(cache, key, best_prio);
+    return best_prio;
+}
+
+static bool autotune_enabled(void){
+    const char *env = std::getenv("UHD_CONVERT_AUTOTUNE");
+    return env != NULL and std::string(env) != "0";
+}
+
+convert::priority_type convert::get_selected_prio(const id_type &id){
+    const std::vector<priority_type> prios = get_converter_prios(id);
+    if (prios.empty()) throw uhd::key_error(
+        "Cannot find a conversion routine for " + id.to_pp_string());
+    if (prios.size() > 1 and autotune_enabled()) return autotune_converter(id);
+    return *std::max_element(prios.begin(), prios.end());
+}
@@ -19,17 +19,15 @@
 #define INCLUDED_LIBUHD_CONVERT_COMMON_HPP
 
 #include <uhd/convert.hpp>
+#include <uhd/exception.hpp>
 #include <uhd/utils/static.hpp>
+#include <uhd/utils/atomic.hpp>
 #include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
 #include <complex>
 
-#define _DECLARE_CONVERTER(name, in_form, num_in, out_form, num_out, prio) \
-    struct name : public uhd::convert::converter{ \
-        static sptr make(void){return sptr(new name());} \
-        double scale_factor; \
-        void set_scalar(const double s){scale_factor = s;} \
-        void operator()(const input_type&, const output_type&, const size_t); \
-    }; \
+#define _REGISTER_CONVERTER_ID(name, in_form, num_in, out_form, num_out, prio) \
     UHD_STATIC_BLOCK(__register_##name##_##prio){ \
         uhd::convert::id_type id; \
         id.input_format = #in_form; \
@@ -37,14 +35,132 @@
         id.output_format = #out_form; \
         id.num_outputs = num_out; \
         uhd::convert::register_converter(id, &name::make, prio); \
-    } \
+    }
+
+#define _REGISTER_CONVERTER(name, in_form, num_in, out_form, num_out, prio) \
+    _REGISTER_CONVERTER_ID(name, in_form, num_in, out_form, num_out, prio) \
     void name::operator()( \
         const input_type &inputs, const output_type &outputs, const size_t nsamps \
     )
 
+#define _DECLARE_CONVERTER(name, in_form, num_in, out_form, num_out, prio) \
+    struct name : public uhd::convert::converter{ \
+        static sptr make(void){return sptr(new name());} \
+        double scale_factor; \
+        void set_scalar(const double s){scale_factor = s;} \
+        void operator()(const input_type&, const output_type&, const size_t); \
+    }; \
+    _REGISTER_CONVERTER(name, in_form, num_in, out_form, num_out, prio)
+
 #define DECLARE_CONVERTER(in_form, num_in, out_form, num_out, prio) \
     _DECLARE_CONVERTER(__convert_##in_form##_##num_in##_##out_form##_##num_out##_##prio, in_form, num_in, out_form, num_out, prio)
 
+/***********************************************************************
+ * Converters that apply an IQ correction while converting:
+ * The correction is kept as per-buffer coefficients premultiplied by
+ * the scale factor, so each sample costs two multiply-adds per rail.
+ * RX corrections are applied after scaling, TX corrections before.
+ *
+ * The coefficients are guarded by a sequence that is odd while an update
+ * writes them. Each conversion copies them once, and copies again when
+ * the sequence shows that an update ran meanwhile, so a correction set
+ * while streaming never tears.
+ **********************************************************************/
+struct iq_corr_coeffs_t{
+    float m[4];
+    float off_i, off_q;
+};
+
+class iq_corr_converter : public uhd::convert::converter{
+public:
+    iq_corr_converter(const bool is_rx):
+        scale_factor(1.0), _is_rx(is_rx)
+    {
+        this->publish();
+    }
+
+    void set_scalar(const double s){
+        boost::mutex::scoped_lock lock(_update_mutex);
+        scale_factor = s;
+        this->publish();
+    }
+
+    void set_iq_correction(const uhd::convert::iq_correction_t &corr, const size_t which){
+        if (which >= MAX_BUFFS) throw uhd::index_error("IQ correction buffer index out of range");
+        boost::mutex::scoped_lock lock(_update_mutex);
+        _corr[which] = corr;
+        this->publish();
+    }
+
+protected:
+    static const size_t MAX_BUFFS = 4; //max interleave
+    double scale_factor;
+
+    //! Copy the coefficients in use, once per conversion
+    UHD_INLINE void get_coeffs(iq_corr_coeffs_t *coeffs) const{
+        while (true){
+            const boost::uint32_t seq = _seq.read();
+            uhd::atomic_fence();
+            if ((seq & 0x1) == 0){
+                std::copy(_coeffs, _coeffs + MAX_BUFFS, coeffs);
+                uhd::atomic_fence();
+                if (_seq.read() == seq) return;
+            }
+        }
+    }
+
+private:
+    const bool _is_rx;
+    uhd::convert::iq_correction_t _corr[MAX_BUFFS];
+    iq_corr_coeffs_t _coeffs[MAX_BUFFS];
+    mutable uhd::atomic_uint32_t _seq;
+    boost::mutex _update_mutex;
+
+    //! Compute the coefficients from the corrections (update mutex held)
+    void publish(void){
+        //offsets are in full-scale units, convert them to output units
+        const double off_scale = _is_rx? scale_factor*32767 : 32767;
+        iq_corr_coeffs_t next[MAX_BUFFS];
+        for (size_t i = 0; i < MAX_BUFFS; i++){
+            const uhd::convert::iq_correction_t &corr = _corr[i];
+            for (size_t j = 0; j < 4; j++) next[i].m[j] = float(corr.matrix[j]*scale_factor);
+            next[i].off_i = float(corr.offset.real()*off_scale);
+            next[i].off_q = float(corr.offset.imag()*off_scale);
+        }
+        _seq.inc(); //odd: readers retry
+        uhd::atomic_fence();
+        std::copy(next, next + MAX_BUFFS, _coeffs);
+        uhd::atomic_fence();
+        _seq.inc(); //even: the coefficients are whole again
+    }
+};
+
+//! The body that follows is the conversion, given the coefficients of this call
+#define _DECLARE_IQ_CORR_CONVERTER(name, in_form, num_in, out_form, num_out, prio, is_rx) \
+    struct name : public iq_corr_converter{ \
+        name(void): iq_corr_converter(is_rx){} \
+        static sptr make(void){return sptr(new name());} \
+        void operator()(const input_type &inputs, const output_type &outputs, const size_t nsamps){ \
+            iq_corr_coeffs_t coeffs[MAX_BUFFS]; \
+            this->get_coeffs(coeffs); \
+            this->convert(inputs, outputs, nsamps, coeffs); \
+        } \
+        void convert(const input_type&, const output_type&, const size_t, const iq_corr_coeffs_t *); \
+    }; \
+    _REGISTER_CONVERTER_ID(name, in_form, num_in, out_form, num_out, prio) \
+    void name::convert( \
+        const input_type &inputs, const output_type &outputs, const size_t nsamps, \
+        const iq_corr_coeffs_t *coeffs \
+    )
+
+//! Declare a wire -> host converter that applies coeffs[] after scaling
+#define DECLARE_RX_IQ_CORR_CONVERTER(in_form, num_in, out_form, num_out, prio) \
+    _DECLARE_IQ_CORR_CONVERTER(__convert_##in_form##_##num_in##_##out_form##_##num_out##_##prio, in_form, num_in, out_form, num_out, prio, true)
+
+//! Declare a host -> wire converter that applies coeffs[] before scaling
+#define DECLARE_TX_IQ_CORR_CONVERTER(in_form, num_in, out_form, num_out, prio) \
+    _DECLARE_IQ_CORR_CONVERTER(__convert_##in_form##_##num_in##_##out_form##_##num_out##_##prio, in_form, num_in, out_form, num_out, prio, false)
+
 /***********************************************************************
  * Setup priorities
  **********************************************************************/
@@ -276,4 +392,54 @@ UHD_INLINE void item32_sc8_to_xx(
     }
 }
 
+/***********************************************************************
+ * Convert items32 sc16 buffer to fc32 with IQ correction
+ **********************************************************************/
+UHD_INLINE fc32_t iq_corr_x1(
+    const iq_corr_coeffs_t &c, const float i, const float q
+){
+    return fc32_t(
+        c.m[0]*i + c.m[1]*q + c.off_i,
+        c.m[2]*i + c.m[3]*q + c.off_q
+    );
+}
+
+//! Saturate a corrected sample to the sc16 range, as the SIMD packs do
+UHD_INLINE boost::int16_t iq_corr_to_sc16(const float x){
+    if (x >= 32767.f) return 32767;
+    if (x <= -32768.f) return -32768;
+    return boost::int16_t(x);
+}
+
+template <xtox_t to_host>
+UHD_INLINE void item32_sc16_to_fc32_iq_corr(
+    const item32_t *input,
+    fc32_t *output,
+    const size_t nsamps,
+    const iq_corr_coeffs_t &coeffs
+){
+    for (size_t i = 0; i < nsamps; i++){
+        const item32_t item_i = to_host(input[i]);
+        output[i] = iq_corr_x1(coeffs, boost::int16_t(item_i >> 16), boost::int16_t(item_i >> 0));
+    }
+}
+
+/***********************************************************************
+ * Convert fc32 to items32 sc16 buffer with IQ correction
+ **********************************************************************/
+template <xtox_t to_wire>
+UHD_INLINE void fc32_to_item32_sc16_iq_corr(
+    const fc32_t *input,
+    item32_t *output,
+    const size_t nsamps,
+    const iq_corr_coeffs_t &coeffs
+){
+    for (size_t i = 0; i < nsamps; i++){
+        const fc32_t corr = iq_corr_x1(coeffs, input[i].real(), input[i].imag());
+        boost::uint16_t real = iq_corr_to_sc16(corr.real());
+        boost::uint16_t imag = iq_corr_to_sc16(corr.imag());
+        output[i] = to_wire((item32_t(real) << 16) | (item32_t(imag) << 0));
+    }
+}
+
 #endif /* INCLUDED_LIBUHD_CONVERT_COMMON_HPP */
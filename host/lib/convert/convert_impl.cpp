@@ -31,6 +31,50 @@ convert::converter::~converter(void){
     /* NOP */
 }
 
+void convert::converter::set_iq_correction(const iq_correction_t &, const size_t){
+    throw uhd::not_implemented_error("this converter does not support IQ correction");
+}
+
+/***********************************************************************
+ * IQ correction helpers
+ **********************************************************************/
+convert::iq_correction_t::iq_correction_t(void):
+    offset(0.0, 0.0)
+{
+    matrix[0] = 1.0; matrix[1] = 0.0;
+    matrix[2] = 0.0; matrix[3] = 1.0;
+}
+
+/*
+ * The frontend cores correct the IQ balance from the I channel:
+ * I' = I + mag*I, Q' = Q + phase*I.
+ */
+convert::iq_correction_t convert::iq_correction_t::make_rx(
+    const std::complex<double> &iq_balance,
+    const std::complex<double> &dc_offset
+){
+    iq_correction_t corr;
+    corr.matrix[0] = 1.0 + iq_balance.real();
+    corr.matrix[2] = iq_balance.imag();
+    //the offset is added before the balance, so it goes through the matrix
+    corr.offset = std::complex<double>(
+        corr.matrix[0]*dc_offset.real(),
+        corr.matrix[2]*dc_offset.real() + dc_offset.imag()
+    );
+    return corr;
+}
+
+convert::iq_correction_t convert::iq_correction_t::make_tx(
+    const std::complex<double> &iq_balance,
+    const std::complex<double> &dc_offset
+){
+    iq_correction_t corr;
+    corr.matrix[0] = 1.0 + iq_balance.real();
+    corr.matrix[2] = iq_balance.imag();
+    corr.offset = dc_offset;
+    return corr;
+}
+
 bool convert::operator==(const convert::id_type &lhs, const convert::id_type &rhs){
     return true
         and (lhs.input_format  == rhs.input_format)
@@ -89,19 +133,24 @@ convert::function_type convert::get_converter(
     if (not get_table().has_key(id)) throw uhd::key_error(
         "Cannot find a conversion routine for " + id.to_pp_string());
 
+    //the best prio: highest or autotuned
+    if (prio == -1) return get_table()[id][get_selected_prio(id)];
+
     //find a matching priority
-    priority_type best_prio = -1;
-    BOOST_FOREACH(priority_type prio_i, get_table()[id].keys()){
-        if (prio_i == prio) return get_table()[id][prio];
-        best_prio = std::max(best_prio, prio_i);
-    }
+    if (get_table()[id].has_key(prio)) return get_table()[id][prio];
 
     //wanted a specific prio, didnt find
-    if (prio != -1) throw uhd::key_error(
+    throw uhd::key_error(
         "Cannot find a conversion routine [with prio] for " + id.to_pp_string());
+}
+
+std::vector<convert::id_type> convert::get_converter_ids(void){
+    return get_table().keys();
+}
 
-    //otherwise, return best prio
-    return get_table()[id][best_prio];
+std::vector<convert::priority_type> convert::get_converter_prios(const id_type &id){
+    if (not get_table().has_key(id)) return std::vector<priority_type>();
+    return get_table()[id].keys();
 }
 
 /***********************************************************************
@@ -0,0 +1,89 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_common.hpp"
+#include <uhd/utils/byteswap.hpp>
+
+/***********************************************************************
+ * Generic IQ correcting converters for the item32 sc16 formats
+ **********************************************************************/
+#define __DECLARE_ITEM32_IQ_CORR_CONVERTER(xe, htoxx, xxtoh) \
+    DECLARE_TX_IQ_CORR_CONVERTER(fc32, 1, sc16_item32_ ## xe ## _iqcorr, 1, PRIORITY_GENERAL){ \
+        const fc32_t *input = reinterpret_cast<const fc32_t *>(inputs[0]); \
+        item32_t *output = reinterpret_cast<item32_t *>(outputs[0]); \
+        fc32_to_item32_sc16_iq_corr<htoxx>(input, output, nsamps, coeffs[0]); \
+    } \
+    DECLARE_RX_IQ_CORR_CONVERTER(sc16_item32_ ## xe ## _iqcorr, 1, fc32, 1, PRIORITY_GENERAL){ \
+        const item32_t *input = reinterpret_cast<const item32_t *>(inputs[0]); \
+        fc32_t *output = reinterpret_cast<fc32_t *>(outputs[0]); \
+        item32_sc16_to_fc32_iq_corr<xxtoh>(input, output, nsamps, coeffs[0]); \
+    }
+
+__DECLARE_ITEM32_IQ_CORR_CONVERTER(be, uhd::htonx, uhd::ntohx)
+__DECLARE_ITEM32_IQ_CORR_CONVERTER(le, uhd::htowx, uhd::wtohx)
+
+/***********************************************************************
+ * Generic IQ correcting converters for the usrp1 interleaved format
+ **********************************************************************/
+template <size_t width>
+UHD_INLINE void fc32_to_item16_usrp1_iq_corr(
+    const uhd::convert::converter::input_type &inputs,
+    boost::uint16_t *output,
+    const size_t nsamps,
+    const iq_corr_coeffs_t *coeffs
+){
+    for (size_t i = 0, j = 0; i < nsamps; i++){
+        for (size_t w = 0; w < width; w++){
+            const fc32_t in = reinterpret_cast<const fc32_t *>(inputs[w])[i];
+            const fc32_t corr = iq_corr_x1(coeffs[w], in.real(), in.imag());
+            output[j++] = uhd::htowx(boost::uint16_t(iq_corr_to_sc16(corr.real())));
+            output[j++] = uhd::htowx(boost::uint16_t(iq_corr_to_sc16(corr.imag())));
+        }
+    }
+}
+
+template <size_t width>
+UHD_INLINE void item16_usrp1_to_fc32_iq_corr(
+    const boost::uint16_t *input,
+    const uhd::convert::converter::output_type &outputs,
+    const size_t nsamps,
+    const iq_corr_coeffs_t *coeffs
+){
+    for (size_t i = 0, j = 0; i < nsamps; i++){
+        for (size_t w = 0; w < width; w++){
+            reinterpret_cast<fc32_t *>(outputs[w])[i] = iq_corr_x1(coeffs[w],
+                boost::int16_t(uhd::wtohx(input[j+0])),
+                boost::int16_t(uhd::wtohx(input[j+1]))
+            );
+            j += 2;
+        }
+    }
+}
+
+#define DECLARE_USRP1_IQ_CORR_CONVERTER(width) \
+    DECLARE_TX_IQ_CORR_CONVERTER(fc32, width, sc16_item16_usrp1_iqcorr, 1, PRIORITY_GENERAL){ \
+        boost::uint16_t *output = reinterpret_cast<boost::uint16_t *>(outputs[0]); \
+        fc32_to_item16_usrp1_iq_corr<width>(inputs, output, nsamps, coeffs); \
+    } \
+    DECLARE_RX_IQ_CORR_CONVERTER(sc16_item16_usrp1_iqcorr, 1, fc32, width, PRIORITY_GENERAL){ \
+        const boost::uint16_t *input = reinterpret_cast<const boost::uint16_t *>(inputs[0]); \
+        item16_usrp1_to_fc32_iq_corr<width>(input, outputs, nsamps, coeffs); \
+    }
+
+DECLARE_USRP1_IQ_CORR_CONVERTER(1)
+DECLARE_USRP1_IQ_CORR_CONVERTER(2)
+DECLARE_USRP1_IQ_CORR_CONVERTER(4)
@@ -0,0 +1,90 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_common.hpp"
+#include <uhd/utils/byteswap.hpp>
+#include <emmintrin.h>
+
+using namespace uhd::convert;
+
+/*
+ * With v = [I0 Q0 I1 Q1] and the I/Q swapped copy s = [Q0 I0 Q1 I1],
+ * the corrected wire samples are v*diag + s*cross + offset,
+ * where the scale factor is already folded into diag and cross.
+ */
+#define convert_fc32_1_to_item32_1_iq_corr_guts(_al_, _pack_)           \
+    for (; i+3 < nsamps; i+=4){                                         \
+        /* load from input */                                           \
+        __m128 tmplo = _mm_load ## _al_ ## ps(reinterpret_cast<const float *>(input+i+0)); \
+        __m128 tmphi = _mm_load ## _al_ ## ps(reinterpret_cast<const float *>(input+i+2)); \
+                                                                        \
+        /* apply the correction matrix, scale and offset */             \
+        tmplo = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tmplo, diag),          \
+            _mm_mul_ps(_mm_shuffle_ps(tmplo, tmplo, _MM_SHUFFLE(2, 3, 0, 1)), cross)), offset); \
+        tmphi = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tmphi, diag),          \
+            _mm_mul_ps(_mm_shuffle_ps(tmphi, tmphi, _MM_SHUFFLE(2, 3, 0, 1)), cross)), offset); \
+                                                                        \
+        /* convert, pack and swap into wire order */                    \
+        __m128i tmpi = _mm_packs_epi32(_mm_cvtps_epi32(tmplo), _mm_cvtps_epi32(tmphi)); \
+        tmpi = _pack_(tmpi);                                            \
+                                                                        \
+        /* store to output */                                           \
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output+i), tmpi);  \
+    }                                                                   \
+
+static UHD_INLINE __m128i pack_nswap(const __m128i tmpi){
+    //swap 16-bit pairs
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(tmpi, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static UHD_INLINE __m128i pack_bswap(const __m128i tmpi){
+    //byteswap 16 bit words
+    return _mm_or_si128(_mm_srli_epi16(tmpi, 8), _mm_slli_epi16(tmpi, 8));
+}
+
+#define DECLARE_SSE2_TX_IQ_CORR_CONVERTER(xe, _pack_, htoxx)            \
+DECLARE_TX_IQ_CORR_CONVERTER(fc32, 1, sc16_item32_ ## xe ## _iqcorr, 1, PRIORITY_SIMD){ \
+    const fc32_t *input = reinterpret_cast<const fc32_t *>(inputs[0]);  \
+    item32_t *output = reinterpret_cast<item32_t *>(outputs[0]);        \
+                                                                        \
+    const iq_corr_coeffs_t &c = coeffs[0];                              \
+    const __m128 diag = _mm_setr_ps(c.m[0], c.m[3], c.m[0], c.m[3]);    \
+    const __m128 cross = _mm_setr_ps(c.m[1], c.m[2], c.m[1], c.m[2]);   \
+    const __m128 offset = _mm_setr_ps(c.off_i, c.off_q, c.off_i, c.off_q); \
+                                                                        \
+    size_t i = 0;                                                       \
+                                                                        \
+    /* need to dispatch according to alignment for fastest conversion */ \
+    switch (size_t(input) & 0xf){                                       \
+    case 0x0:                                                           \
+        convert_fc32_1_to_item32_1_iq_corr_guts(_, _pack_)              \
+        break;                                                          \
+    case 0x8:                                                           \
+        fc32_to_item32_sc16_iq_corr<htoxx>(input, output, 1, c);        \
+        i++;                                                            \
+        convert_fc32_1_to_item32_1_iq_corr_guts(_, _pack_)              \
+        break;                                                          \
+    default:                                                            \
+        convert_fc32_1_to_item32_1_iq_corr_guts(u_, _pack_)             \
+    }                                                                   \
+                                                                        \
+    /* convert any remaining samples */                                 \
+    fc32_to_item32_sc16_iq_corr<htoxx>(input+i, output+i, nsamps-i, c); \
+}
+
+DECLARE_SSE2_TX_IQ_CORR_CONVERTER(le, pack_nswap, uhd::htowx)
+DECLARE_SSE2_TX_IQ_CORR_CONVERTER(be, pack_bswap, uhd::htonx)
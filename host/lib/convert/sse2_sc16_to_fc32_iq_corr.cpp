@@ -0,0 +1,96 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_common.hpp"
+#include <uhd/utils/byteswap.hpp>
+#include <emmintrin.h>
+
+using namespace uhd::convert;
+
+/*
+ * With v = [I0 Q0 I1 Q1] and the I/Q swapped copy s = [Q0 I0 Q1 I1],
+ * the corrected samples are v*diag + s*cross + offset.
+ * The unpacked values sit in the upper 16 bits of each 32-bit lane,
+ * so the 1/(1 << 16) is folded into the matrix coefficients.
+ */
+#define convert_item32_1_to_fc32_1_iq_corr_guts(_al_, _unpack_)         \
+    for (; i+3 < nsamps; i+=4){                                         \
+        /* load from input */                                           \
+        __m128i tmpi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input+i)); \
+                                                                        \
+        /* swap into host order and unpack */                           \
+        tmpi = _unpack_(tmpi);                                          \
+        __m128i tmpilo = _mm_unpacklo_epi16(zeroi, tmpi); /* value in upper 16 bits */ \
+        __m128i tmpihi = _mm_unpackhi_epi16(zeroi, tmpi);               \
+        __m128 tmplo = _mm_cvtepi32_ps(tmpilo);                         \
+        __m128 tmphi = _mm_cvtepi32_ps(tmpihi);                         \
+                                                                        \
+        /* apply the correction matrix and offset */                    \
+        tmplo = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tmplo, diag),          \
+            _mm_mul_ps(_mm_shuffle_ps(tmplo, tmplo, _MM_SHUFFLE(2, 3, 0, 1)), cross)), offset); \
+        tmphi = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tmphi, diag),          \
+            _mm_mul_ps(_mm_shuffle_ps(tmphi, tmphi, _MM_SHUFFLE(2, 3, 0, 1)), cross)), offset); \
+                                                                        \
+        /* store to output */                                           \
+        _mm_store ## _al_ ## ps(reinterpret_cast<float *>(output+i+0), tmplo); \
+        _mm_store ## _al_ ## ps(reinterpret_cast<float *>(output+i+2), tmphi); \
+    }                                                                   \
+
+static UHD_INLINE __m128i unpack_nswap(const __m128i tmpi){
+    //swap 16-bit pairs
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(tmpi, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static UHD_INLINE __m128i unpack_bswap(const __m128i tmpi){
+    //byteswap 16 bit words
+    return _mm_or_si128(_mm_srli_epi16(tmpi, 8), _mm_slli_epi16(tmpi, 8));
+}
+
+#define DECLARE_SSE2_RX_IQ_CORR_CONVERTER(xe, _unpack_, xxtoh)          \
+DECLARE_RX_IQ_CORR_CONVERTER(sc16_item32_ ## xe ## _iqcorr, 1, fc32, 1, PRIORITY_SIMD){ \
+    const item32_t *input = reinterpret_cast<const item32_t *>(inputs[0]); \
+    fc32_t *output = reinterpret_cast<fc32_t *>(outputs[0]);           \
+                                                                        \
+    const iq_corr_coeffs_t &c = coeffs[0];                              \
+    const float unshift = 1.0f/(1 << 16);                               \
+    const __m128 diag = _mm_setr_ps(c.m[0]*unshift, c.m[3]*unshift, c.m[0]*unshift, c.m[3]*unshift); \
+    const __m128 cross = _mm_setr_ps(c.m[1]*unshift, c.m[2]*unshift, c.m[1]*unshift, c.m[2]*unshift); \
+    const __m128 offset = _mm_setr_ps(c.off_i, c.off_q, c.off_i, c.off_q); \
+    const __m128i zeroi = _mm_setzero_si128();                          \
+                                                                        \
+    size_t i = 0;                                                       \
+                                                                        \
+    /* need to dispatch according to alignment for fastest conversion */ \
+    switch (size_t(output) & 0xf){                                      \
+    case 0x0:                                                           \
+        convert_item32_1_to_fc32_1_iq_corr_guts(_, _unpack_)            \
+        break;                                                          \
+    case 0x8:                                                           \
+        item32_sc16_to_fc32_iq_corr<xxtoh>(input, output, 1, c);        \
+        i++;                                                            \
+        convert_item32_1_to_fc32_1_iq_corr_guts(_, _unpack_)            \
+        break;                                                          \
+    default:                                                            \
+        convert_item32_1_to_fc32_1_iq_corr_guts(u_, _unpack_)           \
+    }                                                                   \
+                                                                        \
+    /* convert any remaining samples */                                 \
+    item32_sc16_to_fc32_iq_corr<xxtoh>(input+i, output+i, nsamps-i, c); \
+}
+
+DECLARE_SSE2_RX_IQ_CORR_CONVERTER(le, unpack_nswap, uhd::wtohx)
+DECLARE_SSE2_RX_IQ_CORR_CONVERTER(be, unpack_bswap, uhd::ntohx)
@@ -21,13 +21,17 @@
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/static.hpp>
+#include <uhd/utils/thread_role.hpp>
 #include <uhd/utils/algorithm.hpp>
+#include <uhd/utils/stats_export.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
 #include <boost/weak_ptr.hpp>
 #include <boost/functional/hash.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/lexical_cast.hpp>
+#include <cstdlib>
 
 using namespace uhd;
 
@@ -61,6 +65,46 @@ static size_t hash_device_addr(
     return hash;
 }
 
+/*!
+ * Add a new device to the statistics exporter when requested
+ * by the "stats_export" device argument or UHD_STATS_EXPORT.
+ * A non-empty value sets the update period in seconds.
+ */
+static void export_device_stats(device::sptr dev, const device_addr_t &dev_addr){
+    const char *env = std::getenv("UHD_STATS_EXPORT");
+    if (not dev_addr.has_key("stats_export") and env == NULL) return;
+    const std::string period = dev_addr.has_key("stats_export")? dev_addr["stats_export"] : std::string(env);
+    try{
+        stats_exporter::sptr exporter = stats_exporter::get();
+        if (not period.empty()) exporter->set_period(boost::lexical_cast<double>(period));
+        const std::string prefix = exporter->add_device(dev);
+        UHD_LOG << "Exporting device statistics as " << prefix << std::endl;
+    }
+    catch(const std::exception &ex){
+        UHD_MSG(warning) << "Cannot export device statistics: " << ex.what() << std::endl;
+    }
+}
+
+/***********************************************************************
+ * Thread placement from the device arguments
+ **********************************************************************/
+//! Releases the device before the thread role configurations it was made with
+struct device_roles_deleter{
+    device::sptr dev;
+    thread_role_args::sptr thread_roles;
+    void operator()(device *){
+        dev.reset();
+        thread_roles.reset();
+    }
+};
+
+static device::sptr keep_with_device(device::sptr dev, thread_role_args::sptr thread_roles){
+    device_roles_deleter deleter;
+    deleter.dev = dev;
+    deleter.thread_roles = thread_roles;
+    return device::sptr(dev.get(), deleter);
+}
+
 /***********************************************************************
  * Registration
  **********************************************************************/
@@ -164,8 +208,12 @@ device::sptr device::make(const device_addr_t &hint, device_filter_t filter, siz
     }
     //create and register a new device
     catch(const uhd::assertion_error &){
-        device::sptr dev = maker(dev_addr);
+        //place the threads before the device starts them,
+        //the placement is dropped again with the device
+        thread_role_args::sptr thread_roles = thread_role_args::make(dev_addr);
+        device::sptr dev = keep_with_device(maker(dev_addr), thread_roles);
         hash_to_device[dev_hash] = dev;
+        export_device_stats(dev, dev_addr);
         return dev;
     }
 }
@@ -24,7 +24,17 @@ rx_streamer::~rx_streamer(void)
     //empty
 }
 
+stream_stats_t rx_streamer::get_stats(void) const
+{
+    return stream_stats_t();
+}
+
 tx_streamer::~tx_streamer(void)
 {
     //empty
 }
+
+stream_stats_t tx_streamer::get_stats(void) const
+{
+    return stream_stats_t();
+}
@@ -44,7 +44,7 @@ public:
     libusb_session_impl(void){
         UHD_ASSERT_THROW(libusb_init(&_context) == 0);
         libusb_set_debug(_context, debug_level);
-        task_handler = task::make(boost::bind(&libusb_session_impl::libusb_event_handler_task, this, _context));
+        task_handler = task::make(boost::bind(&libusb_session_impl::libusb_event_handler_task, this, _context), "uhd_libusb");
     }
 
     ~libusb_session_impl(void){
@@ -16,6 +16,7 @@
 //
 
 #include <uhd/transport/nirio/rpc/rpc_client.hpp>
+#include <uhd/utils/thread_role.hpp>
 #include <boost/bind.hpp>
 #include <boost/version.hpp>
 #include <boost/format.hpp>
@@ -32,6 +33,12 @@ namespace uhd { namespace usrprio_rpc {
 
 using boost::asio::ip::tcp;
 
+static void run_io_service(boost::asio::io_service *io_service)
+{
+    uhd::apply_thread_role("nirio_rpc");
+    io_service->run();
+}
+
 rpc_client::rpc_client (
     const std::string& server,
     const std::string& port,
@@ -94,7 +101,7 @@ rpc_client::rpc_client (
                 _wait_for_next_response_header();
 
                 //Spawn a thread for the io_service callback handler. This thread will run until rpc_client is destroyed.
-                _io_service_thread.reset(new boost::thread(boost::bind(&boost::asio::io_service::run, &_io_service)));
+                _io_service_thread.reset(new boost::thread(boost::bind(&run_io_service, &_io_service)));
             } else {
                 UHD_LOG << "rpc_client handshake failed." << std::endl;
                 _exec_err.assign(boost::asio::error::connection_refused, boost::asio::error::get_system_category());
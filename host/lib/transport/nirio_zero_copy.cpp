@@ -24,6 +24,8 @@
 #include <uhd/utils/atomic.hpp>
 #include <boost/format.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/utility.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/thread/thread.hpp> //sleep
 #include <vector>
@@ -37,31 +39,158 @@ using namespace uhd::niusrprio;
 
 typedef uint64_t fifo_data_t;
 
+/*!
+ * The frames of one DMA FIFO, handed out in ring order.
+ *
+ * Acquiring from the FIFO is a call into the kernel driver. Every acquire
+ * reports how many elements remain available, so the ring asks for all the
+ * frames it knows to be ready (up to a batch, and not past the end of the
+ * buffer) in one call and hands them out one at a time. Releases are
+ * counted and granted back in batches; they are all granted before the
+ * ring waits on the FIFO, so held releases never starve the DMA engine.
+ *
+ * In busy poll mode, the ring spins on the available element count of the
+ * FIFO instead of sleeping in the driver until the DMA interrupt arrives.
+ */
+class nirio_frame_ring : boost::noncopyable
+{
+public:
+    nirio_frame_ring(
+        nirio_fifo<fifo_data_t>& fifo,
+        const size_t frame_size,
+        const size_t num_frames,
+        const size_t max_batch,
+        const size_t max_release_batch,
+        const bool busy_poll
+    ):
+        _fifo(fifo),
+        _frame_elems(frame_size / sizeof(fifo_data_t)),
+        _num_frames(std::max<size_t>(num_frames, 1)),
+        _max_batch(std::max<size_t>(max_batch, 1)),
+        _max_release_batch(std::max<size_t>(max_release_batch, 1)),
+        _busy_poll(busy_poll),
+        _index(0), _num_held(0), _num_ready(0), _next(NULL)
+    { }
+
+    //! Get the next frame, NULL on timeout or error
+    fifo_data_t* get(const double timeout, nirio_status& status)
+    {
+        if (_num_held == 0) {
+            status = _acquire(timeout);
+            if (nirio_status_fatal(status) or _num_held == 0) return NULL;
+        }
+        fifo_data_t* frame = _next;
+        _next += _frame_elems;
+        _num_held--;
+        if (++_index == _num_frames) _index = 0;
+        return frame;
+    }
+
+    //! Give a frame back to the FIFO, granted with the batch it belongs to
+    void release(void)
+    {
+        //inc returns the count before this release
+        if (_num_released.inc() + 1 >= _max_release_batch) flush();
+    }
+
+    //! Grant every released frame to the FIFO
+    void flush(void)
+    {
+        boost::uint32_t num_released = _num_released.read();
+        while (num_released != 0) {
+            const boost::uint32_t prev = _num_released.cas(0, num_released);
+            if (prev == num_released) {
+                _fifo.release(num_released * _frame_elems);
+                return;
+            }
+            num_released = prev;
+        }
+    }
+
+private:
+    nirio_status _acquire(const double timeout)
+    {
+        nirio_status status = NiRio_Status_Success;
+        uint32_t timeout_ms = static_cast<uint32_t>(timeout*1000);
+
+        //Nothing known to be ready: the ring may have to wait for the DMA engine
+        if (_num_ready == 0) {
+            flush();
+            if (_busy_poll) {
+                nirio_status_chain(_poll(timeout), status);
+                if (nirio_status_fatal(status)) return status;
+                timeout_ms = 0;
+            }
+        }
+
+        const size_t num_frames = std::max<size_t>(1,
+            std::min(std::min(_num_ready, _max_batch), _num_frames - _index));
+        size_t elems_acquired = 0, elems_remaining = 0;
+        fifo_data_t* elems = NULL;
+        nirio_status_chain(_fifo.acquire(
+            elems, num_frames * _frame_elems, timeout_ms,
+            elems_acquired, elems_remaining), status);
+        if (nirio_status_fatal(status)) return status;
+
+        _next = elems;
+        _num_held = elems_acquired / _frame_elems;
+        _num_ready = elems_remaining / _frame_elems;
+        return status;
+    }
+
+    nirio_status _poll(const double timeout)
+    {
+        const boost::posix_time::ptime deadline =
+            boost::posix_time::microsec_clock::universal_time() +
+            boost::posix_time::microseconds(long(timeout*1e6));
+        while (true) {
+            //Acquiring zero elements does not wait; it reports the available count
+            size_t elems_acquired = 0, elems_remaining = 0;
+            fifo_data_t* elems = NULL;
+            nirio_status status = _fifo.acquire(elems, 0, 0, elems_acquired, elems_remaining);
+            if (nirio_status_fatal(status)) return status;
+            if (elems_remaining >= _frame_elems) {
+                _num_ready = elems_remaining / _frame_elems;
+                return status;
+            }
+            if (boost::posix_time::microsec_clock::universal_time() > deadline) {
+                return NiRio_Status_FifoTimeout;
+            }
+        }
+    }
+
+    nirio_fifo<fifo_data_t>&    _fifo;
+    const size_t                _frame_elems;
+    const size_t                _num_frames;
+    const size_t                _max_batch;
+    const size_t                _max_release_batch;
+    const bool                  _busy_poll;
+    size_t                      _index;         //Ring position of the next frame
+    size_t                      _num_held;      //Acquired frames not handed out yet
+    size_t                      _num_ready;     //Frames known to be available in the FIFO
+    fifo_data_t*                _next;
+    uhd::atomic_uint32_t        _num_released;  //Released frames not granted yet
+};
+
 class nirio_zero_copy_mrb : public managed_recv_buffer
 {
 public:
-    nirio_zero_copy_mrb(nirio_fifo<fifo_data_t>& fifo, const size_t frame_size):
-        _fifo(fifo), _frame_size(frame_size) { }
+    nirio_zero_copy_mrb(nirio_frame_ring& ring, const size_t frame_size):
+        _ring(ring), _frame_size(frame_size) { }
 
     void release(void)
     {
-        _fifo.release(_frame_size / sizeof(fifo_data_t));
+        _ring.release();
     }
 
     UHD_INLINE sptr get_new(const double timeout, size_t &index)
     {
         nirio_status status = 0;
-        size_t elems_acquired, elems_remaining;
-        nirio_status_chain(_fifo.acquire(
-            _typed_buffer, _frame_size / sizeof(fifo_data_t),
-            static_cast<uint32_t>(timeout*1000),
-            elems_acquired, elems_remaining), status);
-        _length = elems_acquired * sizeof(fifo_data_t);
-        _buffer = static_cast<void*>(_typed_buffer);
+        _buffer = static_cast<void*>(_ring.get(timeout, status));
 
-        if (nirio_status_not_fatal(status)) {
+        if (_buffer != NULL) {
             index++;        //Advances the caller's buffer
-            return make(this, _buffer, _length);
+            return make(this, _buffer, _frame_size);
         } else if (status == NiRio_Status_CommunicationTimeout) {
             nirio_status_to_exception(status, "NI-RIO PCIe data transfer failed.");
             return sptr();
@@ -71,37 +200,29 @@ public:
     }
 
 private:
-    nirio_fifo<fifo_data_t>&    _fifo;
-    fifo_data_t*                _typed_buffer;
+    nirio_frame_ring&           _ring;
     const size_t                _frame_size;
-    size_t                      _num_frames;
 };
 
 class nirio_zero_copy_msb : public managed_send_buffer
 {
 public:
-    nirio_zero_copy_msb(nirio_fifo<fifo_data_t>& fifo, const size_t frame_size):
-        _fifo(fifo), _frame_size(frame_size) { }
+    nirio_zero_copy_msb(nirio_frame_ring& ring, const size_t frame_size):
+        _ring(ring), _frame_size(frame_size) { }
 
     void release(void)
     {
-        _fifo.release(_frame_size / sizeof(fifo_data_t));
+        _ring.release();
     }
 
     UHD_INLINE sptr get_new(const double timeout, size_t &index)
     {
         nirio_status status = 0;
-        size_t elems_acquired, elems_remaining;
-        nirio_status_chain(_fifo.acquire(
-            _typed_buffer, _frame_size / sizeof(fifo_data_t),
-            static_cast<uint32_t>(timeout*1000),
-            elems_acquired, elems_remaining), status);
-        _length = elems_acquired * sizeof(fifo_data_t);
-        _buffer = static_cast<void*>(_typed_buffer);
+        _buffer = static_cast<void*>(_ring.get(timeout, status));
 
-        if (nirio_status_not_fatal(status)) {
+        if (_buffer != NULL) {
             index++;        //Advances the caller's buffer
-            return make(this, _buffer, _length);
+            return make(this, _buffer, _frame_size);
         } else if (status == NiRio_Status_CommunicationTimeout) {
             nirio_status_to_exception(status, "NI-RIO PCIe data transfer failed.");
             return sptr();
@@ -111,10 +232,8 @@ public:
     }
 
 private:
-    nirio_fifo<fifo_data_t>&    _fifo;
-    fifo_data_t*                _typed_buffer;
+    nirio_frame_ring&           _ring;
     const size_t                _frame_size;
-    size_t                      _num_frames;
 };
 
 class nirio_zero_copy_impl : public nirio_zero_copy {
@@ -124,7 +243,9 @@ public:
     nirio_zero_copy_impl(
         uhd::niusrprio::niusrprio_session::sptr fpga_session,
         uint32_t instance,
-        const zero_copy_xport_params& xport_params
+        const zero_copy_xport_params& xport_params,
+        const size_t max_batch,
+        const bool busy_poll
     ):
         _fpga_session(fpga_session),
         _fifo_instance(instance),
@@ -141,8 +262,11 @@ public:
         _recv_buffer_pool = buffer_pool::make(_xport_params.num_recv_frames, _xport_params.recv_frame_size);
         _send_buffer_pool = buffer_pool::make(_xport_params.num_send_frames, _xport_params.send_frame_size);
 
+        UHD_LOG << boost::format("nirio zero-copy transport acquires up to %u frames per call%s\n")
+                    % max_batch % (busy_poll? ", busy polling" : "");
+
         nirio_status status = 0;
-        size_t actual_depth = 0, actual_size = 0;
+        size_t recv_depth = 0, send_depth = 0, actual_size = 0;
 
         //Disable DMA streams in case last shutdown was unclean (cleanup, so don't status chain)
         _proxy()->poke(PCIE_TX_DMA_REG(DMA_CTRL_STATUS_REG, _fifo_instance), DMA_CTRL_DISABLED);
@@ -182,12 +306,12 @@ public:
             nirio_status_chain(
                 _recv_fifo->initialize(
                     (_xport_params.recv_frame_size*_xport_params.num_recv_frames)/sizeof(fifo_data_t),
-                    actual_depth, actual_size),
+                    recv_depth, actual_size),
                 status);
             nirio_status_chain(
                 _send_fifo->initialize(
                     (_xport_params.send_frame_size*_xport_params.num_send_frames)/sizeof(fifo_data_t),
-                    actual_depth, actual_size),
+                    send_depth, actual_size),
                 status);
 
             _proxy()->get_rio_quirks().add_tx_fifo(_fifo_instance);
@@ -196,16 +320,27 @@ public:
             nirio_status_chain(_send_fifo->start(), status);
 
             if (nirio_status_not_fatal(status)) {
+                //Received frames are granted back in batches; a sent frame
+                //is granted at once, since that is what sends it.
+                _recv_ring.reset(new nirio_frame_ring(
+                    *_recv_fifo, get_recv_frame_size(),
+                    (recv_depth*sizeof(fifo_data_t))/get_recv_frame_size(),
+                    max_batch, max_batch, busy_poll));
+                _send_ring.reset(new nirio_frame_ring(
+                    *_send_fifo, get_send_frame_size(),
+                    (send_depth*sizeof(fifo_data_t))/get_send_frame_size(),
+                    max_batch, 1, busy_poll));
+
                 //allocate re-usable managed receive buffers
                 for (size_t i = 0; i < get_num_recv_frames(); i++){
                     _mrb_pool.push_back(boost::shared_ptr<nirio_zero_copy_mrb>(new nirio_zero_copy_mrb(
-                        *_recv_fifo, get_recv_frame_size())));
+                        *_recv_ring, get_recv_frame_size())));
                 }
 
                 //allocate re-usable managed send buffers
                 for (size_t i = 0; i < get_num_send_frames(); i++){
                     _msb_pool.push_back(boost::shared_ptr<nirio_zero_copy_msb>(new nirio_zero_copy_msb(
-                        *_send_fifo, get_send_frame_size())));
+                        *_send_ring, get_send_frame_size())));
                 }
             }
         } else {
@@ -223,6 +358,8 @@ public:
         _proxy()->poke(PCIE_TX_DMA_REG(DMA_CTRL_STATUS_REG, _fifo_instance), DMA_CTRL_DISABLED);
         _proxy()->poke(PCIE_RX_DMA_REG(DMA_CTRL_STATUS_REG, _fifo_instance), DMA_CTRL_DISABLED);
 
+        //Grant the received frames that are still held back
+        if (_recv_ring) _recv_ring->flush();
         _flush_rx_buff();
 
         //Stop DMA channels. Stop is called in the fifo dtor but
@@ -334,6 +471,7 @@ private:
     nirio_fifo<fifo_data_t>::sptr _recv_fifo, _send_fifo;
     const zero_copy_xport_params _xport_params;
     buffer_pool::sptr _recv_buffer_pool, _send_buffer_pool;
+    boost::scoped_ptr<nirio_frame_ring> _recv_ring, _send_ring;
     std::vector<boost::shared_ptr<nirio_zero_copy_msb> > _msb_pool;
     std::vector<boost::shared_ptr<nirio_zero_copy_mrb> > _mrb_pool;
     size_t _next_recv_buff_index, _next_send_buff_index;
@@ -398,6 +536,14 @@ nirio_zero_copy::sptr nirio_zero_copy::make(
         xport_params.num_send_frames = usr_num_send_frames;
     }
 
-    return nirio_zero_copy::sptr(new nirio_zero_copy_impl(fpga_session, instance, xport_params));
+    //DMA batching: frames per acquire and releases held back, 0 picks a size from the ring
+    size_t max_batch = size_t(hints.cast<double>("dma_batch_frames", 0));
+    if (max_batch == 0) {
+        max_batch = std::min<size_t>(std::max<size_t>(1,
+            std::min(xport_params.num_recv_frames, xport_params.num_send_frames)/8), 32);
+    }
+    const bool busy_poll = hints.cast<int>("busy_poll", 0) != 0;
+
+    return nirio_zero_copy::sptr(new nirio_zero_copy_impl(fpga_session, instance, xport_params, max_batch, busy_poll));
 }
 
@@ -0,0 +1,518 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/transport/sim_zero_copy.hpp>
+#include <uhd/transport/buffer_pool.hpp>
+#include <uhd/transport/vrt_if_packet.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <uhd/utils/msg.hpp>
+#include <uhd/utils/log.hpp>
+#include <uhd/exception.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/math/special_functions/round.hpp>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+using namespace uhd;
+using namespace uhd::transport;
+
+static const size_t DEFAULT_NUM_FRAMES = 32;
+static const size_t DEFAULT_FRAME_SIZE = 8000;
+static const size_t DEFAULT_SEND_BUFF_SIZE = 512*1024;
+static const size_t HDR_WORDS32 = 4; //header, sid and tsf (CHDR or VRT)
+
+sim_zero_copy::~sim_zero_copy(void){
+    /* NOP */
+}
+
+/***********************************************************************
+ * Reusable managed receiver buffer:
+ *  - the packet is generated into the buffer before it is handed out
+ **********************************************************************/
+class sim_zero_copy_mrb : public managed_recv_buffer{
+public:
+    sim_zero_copy_mrb(void *mem): _mem(mem) { /*NOP*/ }
+
+    void release(void){
+        _claimer.release();
+    }
+
+    UHD_INLINE bool claim(const double timeout){
+        return _claimer.claim_with_wait(timeout);
+    }
+
+    UHD_INLINE boost::uint32_t *mem(void){
+        return static_cast<boost::uint32_t *>(_mem);
+    }
+
+    UHD_INLINE sptr get_new(const size_t len){
+        return make(this, _mem, len);
+    }
+
+private:
+    void *_mem;
+    simple_claimer _claimer;
+};
+
+/***********************************************************************
+ * Reusable managed send buffer:
+ *  - commit hands the packet to the simulated device
+ **********************************************************************/
+class sim_zero_copy_msb : public managed_send_buffer{
+public:
+    typedef boost::function<void(const boost::uint32_t *, const size_t)> consume_type;
+
+    sim_zero_copy_msb(void *mem, const size_t frame_size, const consume_type &consume):
+        _mem(mem), _frame_size(frame_size), _consume(consume) { /*NOP*/ }
+
+    void release(void){
+        _consume(static_cast<const boost::uint32_t *>(_mem), size());
+        _claimer.release();
+    }
+
+    UHD_INLINE sptr get_new(const double timeout, size_t &index){
+        if (not _claimer.claim_with_wait(timeout)) return sptr();
+        index++; //advances the caller's buffer
+        return make(this, _mem, _frame_size);
+    }
+
+private:
+    void *_mem;
+    size_t _frame_size;
+    consume_type _consume;
+    simple_claimer _claimer;
+};
+
+/***********************************************************************
+ * Simulated zero copy implementation:
+ *   The receive side generates packets in the caller's thread,
+ *   the send side consumes them in the caller's thread;
+ *   there are no threads of its own, so the costs measured through
+ *   this transport are the costs of the host streaming code.
+ **********************************************************************/
+class sim_zero_copy_impl : public sim_zero_copy{
+public:
+    sim_zero_copy_impl(const device_addr_t &hints):
+        _recv_frame_size(size_t(hints.cast<double>("recv_frame_size", DEFAULT_FRAME_SIZE)) & ~size_t(0x3)),
+        _num_recv_frames(size_t(hints.cast<double>("num_recv_frames", DEFAULT_NUM_FRAMES))),
+        _send_frame_size(size_t(hints.cast<double>("send_frame_size", DEFAULT_FRAME_SIZE)) & ~size_t(0x3)),
+        _num_send_frames(size_t(hints.cast<double>("num_send_frames", DEFAULT_NUM_FRAMES))),
+        _recv_buffer_pool(buffer_pool::make(_num_recv_frames, _recv_frame_size)),
+        _send_buffer_pool(buffer_pool::make(_num_send_frames, _send_frame_size)),
+        _next_recv_buff_index(0), _next_send_buff_index(0),
+        _chdr(hints.get("sim_format", "chdr") == "chdr"),
+        _throttle(hints.cast<int>("sim_throttle", 1) != 0),
+        _seq_error_period(size_t(hints.cast<double>("sim_seq_error_period", 0))),
+        _overflow_period(size_t(hints.cast<double>("sim_overflow_period", 0))),
+        _send_window(size_t(hints.cast<double>("send_buff_size", DEFAULT_SEND_BUFF_SIZE))/_send_frame_size),
+        _get_time_now(&time_spec_t::get_system_time),
+        _tick_rate(1.0), _ticks_per_samp(1),
+        _sid(0), _spp(0),
+        _rx_active(false), _rx_continuous(false), _rx_eob(false),
+        _rx_remaining(0), _rx_next_ticks(0), _rx_start_ticks(0),
+        _rx_seq(0), _rx_num_packets(0), _rx_msg_code(0), _rx_msg_ticks(0),
+        _tx_seq(0), _tx_in_burst(false), _tx_dropping(false), _tx_cursor(0)
+    {
+        const std::string format = hints.get("sim_format", "chdr");
+        if (format != "chdr" and format != "vrt"){
+            throw uhd::value_error("sim_format must be chdr or vrt, not " + format);
+        }
+        if (_send_window == 0){
+            throw uhd::value_error("send_buff_size must be larger than the send_frame_size.");
+        }
+        UHD_LOG << boost::format("Creating simulated %s transport") % format << std::endl;
+
+        //max samples that fit after the largest header this transport writes
+        _spp = _recv_frame_size/sizeof(boost::uint32_t) - HDR_WORDS32;
+
+        //allocate re-usable managed receive buffers
+        //fill with a ramp once; packets only write their header over it
+        for (size_t i = 0; i < get_num_recv_frames(); i++){
+            boost::uint32_t *mem = static_cast<boost::uint32_t *>(_recv_buffer_pool->at(i));
+            for (size_t j = 0; j < _recv_frame_size/sizeof(boost::uint32_t); j++) mem[j] = boost::uint32_t(j);
+            _mrb_pool.push_back(boost::make_shared<sim_zero_copy_mrb>(mem));
+        }
+
+        //allocate re-usable managed send buffers
+        for (size_t i = 0; i < get_num_send_frames(); i++){
+            _msb_pool.push_back(boost::make_shared<sim_zero_copy_msb>(
+                _send_buffer_pool->at(i), get_send_frame_size(),
+                boost::bind(&sim_zero_copy_impl::consume, this, _1, _2)
+            ));
+        }
+    }
+
+    /*******************************************************************
+     * Receive implementation:
+     * Claim the next buffer and generate a packet into it.
+     ******************************************************************/
+    managed_recv_buffer::sptr get_recv_buff(double timeout){
+        if (_next_recv_buff_index == _num_recv_frames) _next_recv_buff_index = 0;
+        sim_zero_copy_mrb &mrb = *_mrb_pool[_next_recv_buff_index];
+        if (not mrb.claim(timeout)) return managed_recv_buffer::sptr();
+
+        const size_t num_words32 = this->generate(mrb.mem(), timeout);
+        if (num_words32 == 0){
+            mrb.release(); //undo claim
+            return managed_recv_buffer::sptr(); //null for timeout
+        }
+        _next_recv_buff_index++;
+        return mrb.get_new(num_words32*sizeof(boost::uint32_t));
+    }
+
+    size_t get_num_recv_frames(void) const {return _num_recv_frames;}
+    size_t get_recv_frame_size(void) const {return _recv_frame_size;}
+
+    /*******************************************************************
+     * Send implementation:
+     * Wait for room in the device buffer, then claim the next buffer.
+     ******************************************************************/
+    managed_send_buffer::sptr get_send_buff(double timeout){
+        if (not this->wait_for_send_credit(timeout)) return managed_send_buffer::sptr();
+        if (_next_send_buff_index == _num_send_frames) _next_send_buff_index = 0;
+        return _msb_pool[_next_send_buff_index]->get_new(timeout, _next_send_buff_index);
+    }
+
+    size_t get_num_send_frames(void) const {return _num_send_frames;}
+    size_t get_send_frame_size(void) const {return _send_frame_size;}
+
+    /*******************************************************************
+     * Device controls
+     ******************************************************************/
+    bool is_chdr(void) const{
+        return _chdr;
+    }
+
+    void set_rates(const double samp_rate, const double tick_rate){
+        boost::mutex::scoped_lock rx_lock(_rx_mutex);
+        boost::mutex::scoped_lock tx_lock(_tx_mutex);
+        _tick_rate = tick_rate;
+        _ticks_per_samp = std::max<long long>(1, boost::math::llround(tick_rate/samp_rate));
+    }
+
+    void set_time_source(const get_time_type &get_time_now){
+        boost::mutex::scoped_lock rx_lock(_rx_mutex);
+        boost::mutex::scoped_lock tx_lock(_tx_mutex);
+        _get_time_now = get_time_now;
+    }
+
+    void set_samps_per_packet(const size_t spp){
+        boost::mutex::scoped_lock lock(_rx_mutex);
+        _spp = std::min(spp, _recv_frame_size/sizeof(boost::uint32_t) - HDR_WORDS32);
+    }
+
+    void set_sid(const boost::uint32_t sid){
+        boost::mutex::scoped_lock lock(_rx_mutex);
+        _sid = sid;
+    }
+
+    void issue_stream_cmd(const stream_cmd_t &stream_cmd){
+        boost::mutex::scoped_lock lock(_rx_mutex);
+        if (stream_cmd.stream_mode == stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS){
+            _rx_active = false;
+            return;
+        }
+
+        const long long now_ticks = this->get_ticks_now();
+        long long start_ticks = now_ticks;
+        if (not stream_cmd.stream_now){
+            start_ticks = stream_cmd.time_spec.to_ticks(_tick_rate);
+            if (start_ticks < now_ticks){
+                this->post_rx_message(rx_metadata_t::ERROR_CODE_LATE_COMMAND, now_ticks);
+                _rx_active = false;
+                return;
+            }
+        }
+
+        _rx_continuous = stream_cmd.stream_mode == stream_cmd_t::STREAM_MODE_START_CONTINUOUS;
+        _rx_eob = stream_cmd.stream_mode == stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE;
+        _rx_remaining = stream_cmd.num_samps;
+        _rx_start_ticks = start_ticks;
+        _rx_next_ticks = start_ticks;
+        _rx_active = _rx_continuous or _rx_remaining != 0;
+        _rx_cond.notify_all();
+    }
+
+    void set_async_handler(const async_handler_type &handler){
+        boost::mutex::scoped_lock lock(_tx_mutex);
+        _async_handler = handler;
+    }
+
+    size_t get_send_credit(void){
+        boost::mutex::scoped_lock lock(_tx_mutex);
+        this->drain_send_queue(this->get_ticks_now());
+        return _send_window - std::min(_send_window, _tx_queue.size());
+    }
+
+private:
+    UHD_INLINE long long get_ticks_now(void){
+        return _get_time_now().to_ticks(_tick_rate);
+    }
+
+    UHD_INLINE size_t get_seq_mask(void) const{
+        return _chdr? 0xfff : 0xf;
+    }
+
+    //! Wait on a condition until woken or the exit time (false on exit time)
+    bool wait_until(boost::condition_variable &cond, boost::mutex::scoped_lock &lock, const time_spec_t &wake_time, const time_spec_t &exit_time){
+        const time_spec_t now = time_spec_t::get_system_time();
+        if (now >= exit_time) return false;
+        const double secs = (std::min(wake_time, exit_time) - now).get_real_secs();
+        cond.timed_wait(lock, boost::posix_time::microseconds(long(secs*1e6)));
+        return true;
+    }
+
+    /*******************************************************************
+     * Receive packet generation
+     ******************************************************************/
+    void post_rx_message(const rx_metadata_t::error_code_t code, const long long ticks){
+        _rx_msg_code = boost::uint32_t(code);
+        _rx_msg_ticks = ticks;
+        _rx_cond.notify_all();
+    }
+
+    size_t pack_header(boost::uint32_t *buff, vrt::if_packet_info_t &ifpi){
+        ifpi.link_type = _chdr? vrt::if_packet_info_t::LINK_TYPE_CHDR : vrt::if_packet_info_t::LINK_TYPE_NONE;
+        ifpi.has_sid = true;
+        ifpi.sid = _sid;
+        ifpi.has_tsf = true;
+        ifpi.packet_count = _rx_seq;
+        vrt::if_hdr_pack_le(buff, ifpi);
+        return ifpi.num_header_words32;
+    }
+
+    size_t generate(boost::uint32_t *buff, const double timeout){
+        boost::mutex::scoped_lock lock(_rx_mutex);
+        const time_spec_t exit_time = time_spec_t::get_system_time() + time_spec_t(timeout);
+
+        while (true){
+            //an inline message is waiting (overflow, late command)
+            //messages do not advance the sequence like on the device
+            if (_rx_msg_code != 0){
+                vrt::if_packet_info_t ifpi;
+                ifpi.packet_type = vrt::if_packet_info_t::PACKET_TYPE_CONTEXT;
+                ifpi.num_payload_words32 = 1;
+                ifpi.num_payload_bytes = sizeof(boost::uint32_t);
+                ifpi.tsf = _rx_msg_ticks;
+                const size_t hdr_words32 = this->pack_header(buff, ifpi);
+                buff[hdr_words32] = uhd::htowx(_rx_msg_code);
+                _rx_msg_code = 0;
+                return ifpi.num_packet_words32;
+            }
+
+            if (not _rx_active){
+                if (not this->wait_until(_rx_cond, lock, exit_time, exit_time)) return 0;
+                continue;
+            }
+
+            const size_t nsamps = _rx_continuous? _spp : size_t(std::min<boost::uint64_t>(_spp, _rx_remaining));
+            const long long pkt_ticks = nsamps*_ticks_per_samp;
+
+            if (_throttle){
+                //the packet is ready when its last sample has been captured
+                const long long now_ticks = this->get_ticks_now();
+                const long long ready_ticks = _rx_next_ticks + pkt_ticks;
+                if (ready_ticks > now_ticks){
+                    const time_spec_t wake_time = time_spec_t::get_system_time() +
+                        time_spec_t::from_ticks(ready_ticks - now_ticks, _tick_rate);
+                    if (not this->wait_until(_rx_cond, lock, wake_time, exit_time)) return 0;
+                    continue;
+                }
+
+                //the host fell behind by more than the device buffers:
+                //drop whole packets (keeps channels on the same time grid)
+                const long long buffer_ticks = (long long)(_num_recv_frames)*pkt_ticks;
+                //the message time is the first dropped sample
+                if (_rx_continuous and now_ticks - ready_ticks > buffer_ticks){
+                    this->post_rx_message(rx_metadata_t::ERROR_CODE_OVERFLOW, _rx_next_ticks);
+                    _rx_next_ticks += ((now_ticks - _rx_next_ticks)/pkt_ticks)*pkt_ticks;
+                    continue;
+                }
+            }
+
+            //injected faults
+            _rx_num_packets++;
+            if (_overflow_period != 0 and _rx_continuous and (_rx_num_packets % _overflow_period) == 0){
+                this->post_rx_message(rx_metadata_t::ERROR_CODE_OVERFLOW, _rx_next_ticks);
+                _rx_next_ticks += pkt_ticks; //the dropped packet
+                continue;
+            }
+            if (_seq_error_period != 0 and (_rx_num_packets % _seq_error_period) == 0){
+                _rx_seq = (_rx_seq + 1) & this->get_seq_mask();
+            }
+
+            //data packet: the header goes over the ramp the buffer was filled with
+            vrt::if_packet_info_t ifpi;
+            ifpi.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
+            ifpi.num_payload_words32 = nsamps;
+            ifpi.num_payload_bytes = nsamps*sizeof(boost::uint32_t);
+            ifpi.tsf = _rx_next_ticks;
+            ifpi.sob = _rx_next_ticks == _rx_start_ticks;
+            ifpi.eob = _rx_eob and not _rx_continuous and _rx_remaining == nsamps;
+            const size_t hdr_words32 = this->pack_header(buff, ifpi);
+            buff[hdr_words32] = boost::uint32_t(hdr_words32); //where a message code may have been
+
+            _rx_seq = (_rx_seq + 1) & this->get_seq_mask();
+            _rx_next_ticks += pkt_ticks;
+            if (not _rx_continuous){
+                _rx_remaining -= nsamps;
+                if (_rx_remaining == 0) _rx_active = false;
+            }
+            return ifpi.num_packet_words32;
+        }
+    }
+
+    /*******************************************************************
+     * Send packet consumption
+     ******************************************************************/
+    UHD_INLINE void drain_send_queue(const long long now_ticks){
+        while (not _tx_queue.empty() and _tx_queue.front() <= now_ticks) _tx_queue.pop_front();
+    }
+
+    bool wait_for_send_credit(const double timeout){
+        if (not _throttle) return true;
+        boost::mutex::scoped_lock lock(_tx_mutex);
+        const time_spec_t exit_time = time_spec_t::get_system_time() + time_spec_t(timeout);
+        while (true){
+            const long long now_ticks = this->get_ticks_now();
+            this->drain_send_queue(now_ticks);
+            if (_tx_queue.size() < _send_window) return true;
+            const time_spec_t wake_time = time_spec_t::get_system_time() +
+                time_spec_t::from_ticks(_tx_queue.front() - now_ticks, _tick_rate);
+            if (not this->wait_until(_tx_cond, lock, wake_time, exit_time)) return false;
+        }
+    }
+
+    void post_async(const async_metadata_t::event_code_t code, const long long ticks){
+        if (not _async_handler) return;
+        async_metadata_t metadata;
+        metadata.channel = 0;
+        metadata.has_time_spec = true;
+        metadata.time_spec = time_spec_t::from_ticks(ticks, _tick_rate);
+        metadata.event_code = code;
+        std::fill(metadata.user_payload, metadata.user_payload + 4, 0);
+        _async_handler(metadata);
+    }
+
+    void consume(const boost::uint32_t *buff, const size_t len){
+        vrt::if_packet_info_t ifpi;
+        ifpi.link_type = _chdr? vrt::if_packet_info_t::LINK_TYPE_CHDR : vrt::if_packet_info_t::LINK_TYPE_NONE;
+        ifpi.num_packet_words32 = len/sizeof(boost::uint32_t);
+        try{
+            vrt::if_hdr_unpack_le(buff, ifpi);
+        }
+        catch(const std::exception &ex){
+            UHD_MSG(error) << "Simulated device got a bad packet: " << ex.what() << std::endl;
+            return;
+        }
+
+        boost::mutex::scoped_lock lock(_tx_mutex);
+        const long long now_ticks = this->get_ticks_now();
+
+        //sequence check
+        if (ifpi.packet_count != _tx_seq){
+            this->post_async(_tx_in_burst?
+                async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST :
+                async_metadata_t::EVENT_CODE_SEQ_ERROR, now_ticks);
+        }
+        _tx_seq = (ifpi.packet_count + 1) & this->get_seq_mask();
+
+        //the rest of a late burst is dropped
+        if (_tx_dropping){
+            if (ifpi.eob) _tx_dropping = false;
+            return;
+        }
+
+        long long start_ticks = std::max(_tx_cursor, now_ticks);
+        if (not _tx_in_burst){
+            if (ifpi.has_tsf){
+                if ((long long)(ifpi.tsf) < now_ticks){
+                    this->post_async(async_metadata_t::EVENT_CODE_TIME_ERROR, now_ticks);
+                    _tx_dropping = not ifpi.eob;
+                    return;
+                }
+                start_ticks = std::max((long long)(ifpi.tsf), _tx_cursor);
+            }
+            _tx_in_burst = true;
+        }
+        else if (_throttle and _tx_cursor < now_ticks){
+            //the device buffer ran dry in the middle of a burst
+            this->post_async(async_metadata_t::EVENT_CODE_UNDERFLOW, _tx_cursor);
+        }
+
+        _tx_cursor = start_ticks + (long long)(ifpi.num_payload_words32)*_ticks_per_samp;
+        if (_throttle) _tx_queue.push_back(_tx_cursor);
+
+        if (ifpi.eob){
+            this->post_async(async_metadata_t::EVENT_CODE_BURST_ACK, _tx_cursor);
+            _tx_in_burst = false;
+        }
+    }
+
+    //memory management -> buffers and fifos
+    const size_t _recv_frame_size, _num_recv_frames;
+    const size_t _send_frame_size, _num_send_frames;
+    buffer_pool::sptr _recv_buffer_pool, _send_buffer_pool;
+    std::vector<boost::shared_ptr<sim_zero_copy_msb> > _msb_pool;
+    std::vector<boost::shared_ptr<sim_zero_copy_mrb> > _mrb_pool;
+    size_t _next_recv_buff_index, _next_send_buff_index;
+
+    //simulation parameters
+    const bool _chdr;
+    const bool _throttle;
+    const size_t _seq_error_period;
+    const size_t _overflow_period;
+    const size_t _send_window;
+    get_time_type _get_time_now;
+    double _tick_rate;
+    long long _ticks_per_samp;
+
+    //receive state
+    boost::mutex _rx_mutex;
+    boost::condition_variable _rx_cond;
+    boost::uint32_t _sid;
+    size_t _spp;
+    bool _rx_active, _rx_continuous, _rx_eob;
+    boost::uint64_t _rx_remaining;
+    long long _rx_next_ticks, _rx_start_ticks;
+    size_t _rx_seq;
+    boost::uint64_t _rx_num_packets;
+    boost::uint32_t _rx_msg_code;
+    long long _rx_msg_ticks;
+
+    //send state
+    boost::mutex _tx_mutex;
+    boost::condition_variable _tx_cond;
+    async_handler_type _async_handler;
+    size_t _tx_seq;
+    bool _tx_in_burst, _tx_dropping;
+    long long _tx_cursor;
+    std::deque<long long> _tx_queue; //end time of each packet in the device buffer
+};
+
+/***********************************************************************
+ * The make function
+ **********************************************************************/
+sim_zero_copy::sptr sim_zero_copy::make(const device_addr_t &hints){
+    return sim_zero_copy::sptr(new sim_zero_copy_impl(hints));
+}
@@ -0,0 +1,194 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_TRANSPORT_STREAM_STATS_BLOCK_HPP
+#define INCLUDED_LIBUHD_TRANSPORT_STREAM_STATS_BLOCK_HPP
+
+#include <uhd/types/stream_stats.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/utility.hpp>
+#include <boost/version.hpp>
+#include <vector>
+
+namespace uhd{ namespace transport{ namespace sph{
+
+//! Time one conversion in this many; reading the clock costs about as much as a short packet
+static const size_t CONVERT_TIME_SAMPLE_PERIOD = 16;
+
+//! Time one header in this many; a header takes less time than reading the clock
+static const size_t HEADER_TIME_SAMPLE_PERIOD = 16;
+
+//! A buffer fetch that takes longer than this (seconds) waited on the transport or flow control
+static const double BUFF_STALL_THRESHOLD = 10e-6;
+
+/*!
+ * One set of counters, written by one streaming thread.
+ *
+ * The writer brackets its updates with a sequence that is odd while it
+ * writes, so another thread copies the counters without a lock and
+ * without torn 64-bit values (which 32-bit platforms would otherwise give).
+ */
+class stream_stats_cell{
+public:
+    stream_stats_cell(void){
+        this->set_seq(0);
+    }
+
+    //! Copies are made while the streamer is set up, never while it streams
+    stream_stats_cell(const stream_stats_cell &other): _stats(other.get()){
+        this->set_seq(0);
+    }
+
+    stream_stats_cell &operator=(const stream_stats_cell &other){
+        _stats = other.get();
+        return *this;
+    }
+
+    //! Start an update (writer thread only)
+    UHD_INLINE stream_stats_t &begin_update(void){
+        #if BOOST_VERSION >= 105300
+        _seq.store(_seq.load(boost::memory_order_relaxed) + 1, boost::memory_order_relaxed);
+        boost::atomic_thread_fence(boost::memory_order_release);
+        #else
+        _seq.write(_seq.read() + 1);
+        uhd::atomic_fence();
+        #endif
+        return _stats;
+    }
+
+    //! Finish an update (writer thread only)
+    UHD_INLINE void end_update(void){
+        #if BOOST_VERSION >= 105300
+        _seq.store(_seq.load(boost::memory_order_relaxed) + 1, boost::memory_order_release);
+        #else
+        uhd::atomic_fence();
+        _seq.write(_seq.read() + 1);
+        #endif
+    }
+
+    //! Read the counters without an update (writer thread only)
+    UHD_INLINE const stream_stats_t &peek(void) const{
+        return _stats;
+    }
+
+    //! Copy the counters from any thread
+    stream_stats_t get(void) const{
+        while (true){
+            const boost::uint32_t seq = this->get_seq();
+            if ((seq & 0x1) == 0){
+                const stream_stats_t stats = _stats;
+                #if BOOST_VERSION >= 105300
+                boost::atomic_thread_fence(boost::memory_order_acquire);
+                #else
+                uhd::atomic_fence();
+                #endif
+                if (this->get_seq() == seq) return stats;
+            }
+            boost::this_thread::yield();
+        }
+    }
+
+private:
+    #if BOOST_VERSION >= 105300
+    void set_seq(const boost::uint32_t seq){_seq.store(seq);}
+    boost::uint32_t get_seq(void) const{return _seq.load(boost::memory_order_acquire);}
+    boost::atomic<boost::uint32_t> _seq;
+    #else
+    void set_seq(const boost::uint32_t seq){_seq.write(seq);}
+    boost::uint32_t get_seq(void) const{
+        const boost::uint32_t seq = _seq.read();
+        uhd::atomic_fence();
+        return seq;
+    }
+    mutable uhd::atomic_uint32_t _seq;
+    #endif
+    stream_stats_t _stats;
+};
+
+//! A scoped update of a stream stats cell; keep the scope short, readers spin on it
+class stream_stats_update : boost::noncopyable{
+public:
+    UHD_INLINE stream_stats_update(stream_stats_cell &cell):
+        _cell(cell), _stats(cell.begin_update())
+    {
+        /* NOP */
+    }
+
+    UHD_INLINE ~stream_stats_update(void){
+        _cell.end_update();
+    }
+
+    UHD_INLINE stream_stats_t *operator->(void){
+        return &_stats;
+    }
+
+private:
+    stream_stats_cell &_cell;
+    stream_stats_t &_stats;
+};
+
+/*!
+ * The statistics of one packet handler.
+ *
+ * Transport counters are kept per transport channel (one zero_copy_if
+ * or demuxed stream each); conversion time is kept for the streamer.
+ * Each cell has one writer: the streaming thread, or the converter
+ * thread of that transport channel.
+ * The block is shared so that getters bound into the property tree
+ * stay valid after the streamer is destroyed.
+ */
+struct stream_stats_block{
+    typedef boost::shared_ptr<stream_stats_block> sptr;
+
+    //! Counters that belong to the streamer as a whole
+    stream_stats_cell streamer;
+
+    //! Counters for each transport channel
+    std::vector<stream_stats_cell> xports;
+
+    //! Optional flow control credit getters for each transport channel
+    std::vector<boost::function<size_t(void)> > fc_credits;
+
+    //! Get the counters summed over the streamer and all transports
+    stream_stats_t get_total(void) const{
+        stream_stats_t total = streamer.get();
+        for (size_t i = 0; i < xports.size(); i++) total += xports[i].get();
+        return total;
+    }
+
+    //! Get the counters of one transport channel
+    stream_stats_t get_xport(const size_t xport_chan) const{
+        return xports.at(xport_chan).get();
+    }
+
+    //! Does this transport channel report flow control credit?
+    bool has_fc_credit(const size_t xport_chan) const{
+        return xport_chan < fc_credits.size() and bool(fc_credits[xport_chan]);
+    }
+
+    //! Get the packets the transport channel may send before flow control holds back
+    size_t get_fc_credit(const size_t xport_chan) const{
+        return this->has_fc_credit(xport_chan)? fc_credits[xport_chan]() : 0;
+    }
+};
+
+}}} //namespace uhd::transport::sph
+
+#endif /* INCLUDED_LIBUHD_TRANSPORT_STREAM_STATS_BLOCK_HPP */
@@ -18,6 +18,8 @@
 #ifndef INCLUDED_LIBUHD_TRANSPORT_SUPER_RECV_PACKET_HANDLER_HPP
 #define INCLUDED_LIBUHD_TRANSPORT_SUPER_RECV_PACKET_HANDLER_HPP
 
+#include "tick_converter.hpp"
+#include "stream_stats_block.hpp"
 #include <uhd/config.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/convert.hpp>
@@ -27,6 +29,7 @@
 #include <uhd/utils/atomic.hpp>
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/metadata.hpp>
+#include <uhd/types/time_spec.hpp>
 #include <uhd/transport/vrt_if_packet.hpp>
 #include <uhd/transport/zero_copy.hpp>
 #include <boost/dynamic_bitset.hpp>
@@ -81,6 +84,8 @@ public:
      */
     recv_packet_handler(const size_t size = 1):
         _queue_error_for_next_call(false),
+        _stats(new stream_stats_block()),
+        _num_converts(0),
         _buffers_infos_index(0)
     {
         #ifdef  ERROR_INJECT_DROPPED_PACKETS
@@ -101,12 +106,13 @@ public:
         if (this->size() == size) return;
         _task_handlers.clear();
         _props.resize(size);
+        _stats->xports.resize(size);
         //re-initialize all buffers infos by re-creating the vector
         _buffers_infos = std::vector<buffers_info_type>(4, buffers_info_type(size));
         _task_barrier.resize(size);
         _task_handlers.resize(size);
         for (size_t i = 1/*skip 0*/; i < size; i++){
-            _task_handlers[i] = task::make(boost::bind(&recv_packet_handler::converter_thread_task, this, i));
+            _task_handlers[i] = task::make(boost::bind(&recv_packet_handler::converter_thread_task, this, i), "uhd_rx_convert");
         };
     }
 
@@ -132,12 +138,12 @@ public:
 
     //! Set the rate of ticks per second
     void set_tick_rate(const double rate){
-        _tick_rate = rate;
+        _ticks.set_tick_rate(rate);
     }
 
     //! Set the rate of samples per second
     void set_samp_rate(const double rate){
-        _samp_rate = rate;
+        _ticks.set_samp_rate(rate);
     }
 
     /*!
@@ -194,6 +200,16 @@ public:
         _converter->set_scalar(scale_factor);
     }
 
+    /*!
+     * Set the IQ correction applied in the converter.
+     * Requires a converter registered for an "_iqcorr" wire format.
+     * \param corr the correction matrix and DC offset
+     * \param which the converter output index (ex: USRP1 channel)
+     */
+    void set_iq_correction(const uhd::convert::iq_correction_t &corr, const size_t which = 0){
+        _converter->set_iq_correction(corr, which);
+    }
+
     //! Set the callback to issue stream commands
     void set_issue_stream_cmd(const size_t xport_chan, const issue_stream_cmd_type &issue_stream_cmd)
     {
@@ -209,6 +225,16 @@ public:
         }
     }
 
+    //! Get the statistics summed over all transport channels
+    stream_stats_t get_stats(void) const{
+        return _stats->get_total();
+    }
+
+    //! Get the statistics block shared with the property tree
+    stream_stats_block::sptr get_stats_block(void) const{
+        return _stats;
+    }
+
     /*******************************************************************
      * Receive:
      * The entry point for the fast-path receive calls.
@@ -267,8 +293,10 @@ public:
 private:
     vrt_unpacker_type _vrt_unpacker;
     size_t _header_offset_words32;
-    double _tick_rate, _samp_rate;
+    tick_converter _ticks;
     bool _queue_error_for_next_call;
+    stream_stats_block::sptr _stats;
+    size_t _num_converts;
     size_t _alignment_faulure_threshold;
     rx_metadata_t _queue_metadata;
     struct xport_chan_props_type{
@@ -296,13 +324,13 @@ private:
         {
             buff.reset();
             vrt_hdr = NULL;
-            time = time_spec_t(0.0);
+            time = 0;
             copy_buff = NULL;
         }
         managed_recv_buffer::sptr buff;
         const boost::uint32_t *vrt_hdr;
         vrt::if_packet_info_t ifpi;
-        time_spec_t time;
+        long long time; //in ticks
         const char *copy_buff;
     };
 
@@ -311,15 +339,18 @@ private:
         buffers_info_type(const size_t size):
             std::vector<per_buffer_info_type>(size),
             indexes_todo(size, true),
+            alignment_time(0),
             alignment_time_valid(false),
             data_bytes_to_copy(0),
-            fragment_offset_in_samps(0)
+            fragment_offset_in_samps(0),
+            time_ticks(0)
         {/* NOP */}
         void reset()
         {
             indexes_todo.set();
-            alignment_time = time_spec_t(0.0);
+            alignment_time = 0;
             alignment_time_valid = false;
+            time_ticks = 0;
             data_bytes_to_copy = 0;
             fragment_offset_in_samps = 0;
             metadata.reset();
@@ -327,10 +358,11 @@ private:
                 at(i).reset();
         }
         boost::dynamic_bitset<> indexes_todo; //used in alignment logic
-        time_spec_t alignment_time; //used in alignment logic
+        long long alignment_time; //used in alignment logic (ticks)
         bool alignment_time_valid; //used in alignment logic
         size_t data_bytes_to_copy; //keeps track of state
         size_t fragment_offset_in_samps; //keeps track of state
+        long long time_ticks; //metadata time before conversion to a time spec
         rx_metadata_t metadata; //packet description
     };
 
@@ -367,9 +399,25 @@ private:
         per_buffer_info_type &curr_buffer_info,
         double timeout
     ){
-        //get a single packet from the transport layer
+        //get a single packet from the transport layer,
+        //a fetch that takes longer than the stall threshold had to wait,
+        //as did a blocking fetch that came back empty
+        stream_stats_cell &stats_cell = _stats->xports[index];
         managed_recv_buffer::sptr &buff = curr_buffer_info.buff;
+        const time_spec_t fetch_start = time_spec_t::get_system_time();
         buff = _props[index].get_buff(timeout);
+        const double fetch_secs = (time_spec_t::get_system_time() - fetch_start).get_real_secs();
+        {
+            stream_stats_update stats(stats_cell);
+            if (fetch_secs > BUFF_STALL_THRESHOLD or (buff.get() == NULL and timeout > 0.0)){
+                stats->num_buff_stalls++;
+                stats->buff_wait_time.add(fetch_secs);
+            }
+            if (buff.get() != NULL){
+                stats->num_packets++;
+                stats->num_bytes += buff->size();
+            }
+        }
         if (buff.get() == NULL) return PACKET_TIMEOUT_ERROR;
 
         #ifdef  ERROR_INJECT_DROPPED_PACKETS
@@ -392,8 +440,14 @@ private:
         per_buffer_info_type &info = curr_buffer_info;
         info.ifpi.num_packet_words32 = num_packet_words32 - _header_offset_words32;
         info.vrt_hdr = buff->cast<const boost::uint32_t *>() + _header_offset_words32;
-        _vrt_unpacker(info.vrt_hdr, info.ifpi);
-        info.time = time_spec_t::from_ticks(info.ifpi.tsf, _tick_rate); //assumes has_tsf is true
+        if ((stats_cell.peek().num_packets % HEADER_TIME_SAMPLE_PERIOD) == 0){
+            const time_spec_t header_start = time_spec_t::get_system_time();
+            _vrt_unpacker(info.vrt_hdr, info.ifpi);
+            const double header_secs = (time_spec_t::get_system_time() - header_start).get_real_secs();
+            stream_stats_update(stats_cell)->header_time.add(header_secs);
+        }
+        else _vrt_unpacker(info.vrt_hdr, info.ifpi);
+        info.time = (long long)(info.ifpi.tsf); //assumes has_tsf is true
         info.copy_buff = reinterpret_cast<const char *>(info.vrt_hdr + info.ifpi.num_header_words32);
 
         //handle flow control
@@ -553,9 +607,10 @@ private:
             case PACKET_INLINE_MESSAGE:
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = next_info[index].ifpi.has_tsf;
-                curr_info.metadata.time_spec = next_info[index].time;
+                curr_info.time_ticks = next_info[index].time;
                 curr_info.metadata.error_code = rx_metadata_t::error_code_t(get_context_code(next_info[index].vrt_hdr, next_info[index].ifpi));
                 if (curr_info.metadata.error_code == rx_metadata_t::ERROR_CODE_OVERFLOW){
+                    stream_stats_update(_stats->xports[index])->num_overflows++;
                     rx_metadata_t metadata = curr_info.metadata;
                     _props[index].handle_overflow();
                     curr_info.metadata = metadata;
@@ -564,16 +619,18 @@ private:
                 return;
 
             case PACKET_TIMEOUT_ERROR:
+                stream_stats_update(_stats->xports[index])->num_timeouts++;
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_TIMEOUT;
                 return;
 
             case PACKET_SEQUENCE_ERROR:
+                stream_stats_update(_stats->xports[index])->num_sequence_errors++;
                 alignment_check(index, curr_info);
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = prev_info.metadata.has_time_spec;
-                curr_info.metadata.time_spec = prev_info.metadata.time_spec + time_spec_t::from_ticks(
-                    prev_info[index].ifpi.num_payload_words32*sizeof(boost::uint32_t)/_bytes_per_otw_item, _samp_rate);
+                curr_info.time_ticks = prev_info.time_ticks + _ticks.samps_to_ticks(
+                    prev_info[index].ifpi.num_payload_words32*sizeof(boost::uint32_t)/_bytes_per_otw_item);
                 curr_info.metadata.out_of_sequence = true;
                 curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_OVERFLOW;
                 UHD_MSG(fastpath) << "D";
@@ -598,7 +655,7 @@ private:
 
         //set the metadata from the buffer information at index zero
         curr_info.metadata.has_time_spec = curr_info[0].ifpi.has_tsf;
-        curr_info.metadata.time_spec = curr_info[0].time;
+        curr_info.time_ticks = curr_info[0].time;
         curr_info.metadata.more_fragments = false;
         curr_info.metadata.fragment_offset = 0;
         curr_info.metadata.start_of_burst = curr_info[0].ifpi.sob;
@@ -630,8 +687,8 @@ private:
         buffers_info_type &info = get_curr_buffer_info();
         metadata = info.metadata;
 
-        //interpolate the time spec (useful when this is a fragment)
-        metadata.time_spec += time_spec_t::from_ticks(info.fragment_offset_in_samps, _samp_rate);
+        //convert to a time spec, interpolated in ticks (useful when this is a fragment)
+        metadata.time_spec = _ticks.to_time_spec(info.time_ticks + _ticks.samps_to_ticks(info.fragment_offset_in_samps));
 
         //extract the number of samples available to copy
         const size_t nsamps_available = info.data_bytes_to_copy/_bytes_per_otw_item;
@@ -645,8 +702,14 @@ private:
         _convert_buffer_offset_bytes = buffer_offset_bytes;
         _convert_bytes_to_copy = bytes_to_copy;
 
-        //perform N channels of conversion
-        converter_thread_task(0);
+        //perform N channels of conversion (timing a sample of the calls)
+        if ((_num_converts++ % CONVERT_TIME_SAMPLE_PERIOD) == 0){
+            const time_spec_t convert_start = time_spec_t::get_system_time();
+            converter_thread_task(0);
+            const double convert_secs = (time_spec_t::get_system_time() - convert_start).get_real_secs();
+            stream_stats_update(_stats->streamer)->convert_time.add(convert_secs);
+        }
+        else converter_thread_task(0);
 
         //update the copy buffer's availability
         info.data_bytes_to_copy -= bytes_to_copy;
@@ -747,7 +810,7 @@ private:
                 metadata,
                 timeout,
                 one_packet,
-                _samp_rate
+                _ticks.get_samp_rate()
             );
         if(dbg_print_directly) {
             dbg_print_err(data.print_line());
@@ -793,6 +856,11 @@ public:
         return recv_packet_handler::issue_stream_cmd(stream_cmd);
     }
 
+    stream_stats_t get_stats(void) const
+    {
+        return recv_packet_handler::get_stats();
+    }
+
 private:
     size_t _max_num_samps;
 };
@@ -18,6 +18,8 @@
 #ifndef INCLUDED_LIBUHD_TRANSPORT_SUPER_SEND_PACKET_HANDLER_HPP
 #define INCLUDED_LIBUHD_TRANSPORT_SUPER_SEND_PACKET_HANDLER_HPP
 
+#include "tick_converter.hpp"
+#include "stream_stats_block.hpp"
 #include <uhd/config.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/convert.hpp>
@@ -27,6 +29,7 @@
 #include <uhd/utils/atomic.hpp>
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/metadata.hpp>
+#include <uhd/types/time_spec.hpp>
 #include <uhd/transport/vrt_if_packet.hpp>
 #include <uhd/transport/zero_copy.hpp>
 #include <boost/thread/thread_time.hpp>
@@ -67,7 +70,8 @@ public:
      * \param size the number of transport channels
      */
     send_packet_handler(const size_t size = 1):
-        _next_packet_seq(0), _cached_metadata(false)
+        _next_packet_seq(0), _cached_metadata(false),
+        _stats(new stream_stats_block()), _num_converts(0)
     {
         this->set_enable_trailer(true);
         this->resize(size);
@@ -83,12 +87,14 @@ public:
         if (this->size() == size) return;
         _task_handlers.clear();
         _props.resize(size);
+        _stats->xports.resize(size);
+        _stats->fc_credits.resize(size);
         static const boost::uint64_t zero = 0;
         _zero_buffs.resize(size, &zero);
         _task_barrier.resize(size);
         _task_handlers.resize(size);
         for (size_t i = 1/*skip 0*/; i < size; i++){
-            _task_handlers[i] = task::make(boost::bind(&send_packet_handler::converter_thread_task, this, i));
+            _task_handlers[i] = task::make(boost::bind(&send_packet_handler::converter_thread_task, this, i), "uhd_tx_convert");
         };
     }
 
@@ -116,12 +122,12 @@ public:
 
     //! Set the rate of ticks per second
     void set_tick_rate(const double rate){
-        _tick_rate = rate;
+        _ticks.set_tick_rate(rate);
     }
 
     //! Set the rate of samples per second
     void set_samp_rate(const double rate){
-        _samp_rate = rate;
+        _ticks.set_samp_rate(rate);
     }
 
     /*!
@@ -156,6 +162,36 @@ public:
         _converter->set_scalar(scale_factor);
     }
 
+    /*!
+     * Set the IQ correction applied in the converter.
+     * Requires a converter registered for an "_iqcorr" wire format.
+     * \param corr the correction matrix and DC offset
+     * \param which the converter input index (ex: USRP1 channel)
+     */
+    void set_iq_correction(const uhd::convert::iq_correction_t &corr, const size_t which = 0){
+        _converter->set_iq_correction(corr, which);
+    }
+
+    /*!
+     * Set the function that reports flow control credit.
+     * The credit is only read for statistics.
+     * \param xport_chan which transport channel
+     * \param get_credit returns the packets that may be sent before flow control holds back
+     */
+    void set_xport_chan_fc_credit(const size_t xport_chan, const boost::function<size_t(void)> &get_credit){
+        _stats->fc_credits.at(xport_chan) = get_credit;
+    }
+
+    //! Get the statistics summed over all transport channels
+    stream_stats_t get_stats(void) const{
+        return _stats->get_total();
+    }
+
+    //! Get the statistics block shared with the property tree
+    stream_stats_block::sptr get_stats_block(void) const{
+        return _stats;
+    }
+
     //! Set the callback to get async messages
     void set_async_receiver(const async_receiver_type &async_receiver)
     {
@@ -190,7 +226,7 @@ public:
         if_packet_info.has_tlr = _has_tlr;
         if_packet_info.has_tsi = false;
         if_packet_info.has_tsf = metadata.has_time_spec;
-        if_packet_info.tsf     = metadata.time_spec.to_ticks(_tick_rate);
+        if_packet_info.tsf     = _ticks.to_ticks(metadata.time_spec);
         if_packet_info.sob     = metadata.start_of_burst;
         if_packet_info.eob     = metadata.end_of_burst;
 
@@ -204,7 +240,7 @@ public:
             if (!metadata.has_time_spec)
             {
                 if_packet_info.has_tsf = _metadata_cache.has_time_spec;
-                if_packet_info.tsf     = _metadata_cache.time_spec.to_ticks(_tick_rate);
+                if_packet_info.tsf     = _ticks.to_ticks(_metadata_cache.time_spec);
             }
             if_packet_info.sob     = _metadata_cache.start_of_burst;
             if_packet_info.eob     = _metadata_cache.end_of_burst;
@@ -240,6 +276,7 @@ public:
 #endif
 			return nsamps_sent;        }
         size_t total_num_samps_sent = 0;
+        const boost::uint64_t first_tsf = if_packet_info.tsf;
 
         //false until final fragment
         if_packet_info.eob = false;
@@ -259,9 +296,8 @@ public:
             total_num_samps_sent += num_samps_sent;
             if (num_samps_sent == 0) return total_num_samps_sent;
 
-            //setup metadata for the next fragment
-            const time_spec_t time_spec = metadata.time_spec + time_spec_t::from_ticks(total_num_samps_sent, _samp_rate);
-            if_packet_info.tsf = time_spec.to_ticks(_tick_rate);
+            //setup metadata for the next fragment (offset in ticks)
+            if_packet_info.tsf = first_tsf + _ticks.samps_to_ticks(total_num_samps_sent);
             if_packet_info.sob = false;
 
         }
@@ -282,7 +318,7 @@ private:
 
     vrt_packer_type _vrt_packer;
     size_t _header_offset_words32;
-    double _tick_rate, _samp_rate;
+    tick_converter _ticks;
     struct xport_chan_props_type{
         xport_chan_props_type(void):has_sid(false),sid(0){}
         get_buff_type get_buff;
@@ -302,6 +338,8 @@ private:
     async_receiver_type _async_receiver;
     bool _cached_metadata;
     uhd::tx_metadata_t _metadata_cache;
+    stream_stats_block::sptr _stats;
+    size_t _num_converts;
 
 #ifdef UHD_TXRX_DEBUG_PRINTS
     struct dbg_send_stat_t {
@@ -334,7 +372,7 @@ private:
             nsamps_sent,
             metadata,
             timeout,
-            _samp_rate
+            _ticks.get_samp_rate()
         );
         if(dbg_print_directly){
             dbg_print_err(data.print_line());
@@ -364,9 +402,23 @@ private:
         if_packet_info.num_payload_words32 = (if_packet_info.num_payload_bytes + 3/*round up*/)/sizeof(boost::uint32_t);
         if_packet_info.packet_count = _next_packet_seq;
 
-        //get a buffer for each channel or timeout
-        BOOST_FOREACH(xport_chan_props_type &props, _props){
-            if (not props.buff) props.buff = props.get_buff(timeout);
+        //get a buffer for each channel or timeout,
+        //a fetch that takes longer than the stall threshold was held back (usually flow control),
+        //as was a blocking fetch that came back empty
+        for (size_t i = 0; i < _props.size(); i++){
+            xport_chan_props_type &props = _props[i];
+            if (props.buff) continue;
+            const time_spec_t fetch_start = time_spec_t::get_system_time();
+            props.buff = props.get_buff(timeout);
+            const double fetch_secs = (time_spec_t::get_system_time() - fetch_start).get_real_secs();
+            if (fetch_secs > BUFF_STALL_THRESHOLD or not props.buff){
+                stream_stats_update stats(_stats->xports[i]);
+                if (fetch_secs > BUFF_STALL_THRESHOLD or timeout > 0.0){
+                    stats->num_buff_stalls++;
+                    stats->buff_wait_time.add(fetch_secs);
+                }
+                if (not props.buff) stats->num_timeouts++;
+            }
             if (not props.buff) return 0; //timeout
         }
 
@@ -376,8 +428,14 @@ private:
         _convert_buffer_offset_bytes = buffer_offset_bytes;
         _convert_if_packet_info = &if_packet_info;
 
-        //perform N channels of conversion
-        converter_thread_task(0);
+        //perform N channels of conversion (timing a sample of the calls)
+        if ((_num_converts++ % CONVERT_TIME_SAMPLE_PERIOD) == 0){
+            const time_spec_t convert_start = time_spec_t::get_system_time();
+            converter_thread_task(0);
+            const double convert_secs = (time_spec_t::get_system_time() - convert_start).get_real_secs();
+            stream_stats_update(_stats->streamer)->convert_time.add(convert_secs);
+        }
+        else converter_thread_task(0);
 
         _next_packet_seq++; //increment sequence after commits
         return nsamps_per_buff;
@@ -409,7 +467,14 @@ private:
         boost::uint32_t *otw_mem = buff->cast<boost::uint32_t *>() + _header_offset_words32;
         if_packet_info.has_sid = _props[index].has_sid;
         if_packet_info.sid = _props[index].sid;
-        _vrt_packer(otw_mem, if_packet_info);
+        stream_stats_cell &stats_cell = _stats->xports[index];
+        double header_secs = -1.0;
+        if ((stats_cell.peek().num_packets % HEADER_TIME_SAMPLE_PERIOD) == 0){
+            const time_spec_t header_start = time_spec_t::get_system_time();
+            _vrt_packer(otw_mem, if_packet_info);
+            header_secs = (time_spec_t::get_system_time() - header_start).get_real_secs();
+        }
+        else _vrt_packer(otw_mem, if_packet_info);
         otw_mem += if_packet_info.num_header_words32;
 
         //perform the conversion operation
@@ -420,6 +485,13 @@ private:
         buff->commit(num_vita_words32*sizeof(boost::uint32_t));
         buff.reset(); //effectively a release
 
+        {
+            stream_stats_update stats(stats_cell);
+            if (header_secs >= 0.0) stats->header_time.add(header_secs);
+            stats->num_packets++;
+            stats->num_bytes += num_vita_words32*sizeof(boost::uint32_t);
+        }
+
         if (index == 0) _task_barrier.wait_others();
     }
 
@@ -463,6 +535,10 @@ public:
         return send_packet_handler::recv_async_msg(async_metadata, timeout);
     }
 
+    stream_stats_t get_stats(void) const{
+        return send_packet_handler::get_stats();
+    }
+
 private:
     size_t _max_num_samps;
 };
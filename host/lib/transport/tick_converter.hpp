@@ -0,0 +1,98 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_TRANSPORT_TICK_CONVERTER_HPP
+#define INCLUDED_LIBUHD_TRANSPORT_TICK_CONVERTER_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <cmath>
+
+namespace uhd{ namespace transport{
+
+/*!
+ * Integer tick timestamps for the streaming path.
+ *
+ * The packet handlers keep timestamps as integer counts of device ticks,
+ * the unit of the VRT fractional timestamp, so comparing and offsetting
+ * them is exact for any uptime. Conversion to and from time_spec_t only
+ * happens at the API boundary, once per send() or recv() call.
+ *
+ * Sample offsets are converted to ticks with an integer multiply when the
+ * tick rate is a whole multiple of the sample rate (the usual case), and
+ * are rounded to the nearest tick otherwise.
+ */
+class tick_converter{
+public:
+    tick_converter(void):
+        _tick_rate(1.0), _samp_rate(1.0)
+    {
+        this->update();
+    }
+
+    //! Set the rate of ticks per second
+    void set_tick_rate(const double rate){
+        _tick_rate = rate;
+        this->update();
+    }
+
+    //! Set the rate of samples per second
+    void set_samp_rate(const double rate){
+        _samp_rate = rate;
+        this->update();
+    }
+
+    double get_tick_rate(void) const{
+        return _tick_rate;
+    }
+
+    double get_samp_rate(void) const{
+        return _samp_rate;
+    }
+
+    //! Get the number of ticks spanned by a number of samples
+    UHD_INLINE long long samps_to_ticks(const size_t nsamps) const{
+        if (_ticks_per_samp_int != 0) return (long long)(nsamps)*_ticks_per_samp_int;
+        return (long long)(std::floor(nsamps*_ticks_per_samp + 0.5));
+    }
+
+    //! Convert a tick count into a time spec (API boundary)
+    UHD_INLINE time_spec_t to_time_spec(const long long ticks) const{
+        return time_spec_t::from_ticks(ticks, _tick_rate);
+    }
+
+    //! Convert a time spec into a tick count (API boundary)
+    UHD_INLINE long long to_ticks(const time_spec_t &time_spec) const{
+        return time_spec.to_ticks(_tick_rate);
+    }
+
+private:
+    void update(void){
+        _ticks_per_samp = _tick_rate/_samp_rate;
+        const double rounded = std::floor(_ticks_per_samp + 0.5);
+        const bool is_integer = rounded >= 1.0 and std::abs(_ticks_per_samp - rounded) < 1e-9*rounded;
+        _ticks_per_samp_int = is_integer? (long long)(rounded) : 0;
+    }
+
+    double _tick_rate, _samp_rate;
+    double _ticks_per_samp;
+    long long _ticks_per_samp_int;
+};
+
+}} //namespace uhd::transport
+
+#endif /* INCLUDED_LIBUHD_TRANSPORT_TICK_CONVERTER_HPP */
@@ -0,0 +1,294 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_TRANSPORT_UDP_TUNNEL_HPP
+#define INCLUDED_LIBUHD_TRANSPORT_UDP_TUNNEL_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/transport/zero_copy.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <uhd/exception.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/utility.hpp>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <poll.h>
+
+//recvmmsg and sendmmsg come with MSG_WAITFORONE (Linux, glibc 2.14)
+#ifdef MSG_WAITFORONE
+    #define UDP_TUNNEL_HAVE_MMSG
+#endif
+
+namespace uhd{ namespace transport{
+
+/*!
+ * The address of the client of a UDP tunnel.
+ *
+ * The tunnel that receives from the socket learns the address from the
+ * packets of the client; the tunnel that sends to the socket picks it up.
+ * Both only take the lock when the address changes, not per packet.
+ */
+class udp_tunnel_endpoint : boost::noncopyable{
+public:
+    udp_tunnel_endpoint(void): _len(0){
+        std::memset(&_addr, 0, sizeof(_addr));
+    }
+
+    //! Set a new client address
+    void update(const sockaddr_storage &addr, const socklen_t len){
+        boost::mutex::scoped_lock lock(_mutex);
+        std::memcpy(&_addr, &addr, sizeof(_addr));
+        _len = len;
+        _generation.inc();
+    }
+
+    //! Get the address if it changed since the given generation
+    bool get_if_changed(boost::uint32_t &generation, sockaddr_storage &addr, socklen_t &len){
+        if (_generation.read() == generation) return false;
+        boost::mutex::scoped_lock lock(_mutex);
+        std::memcpy(&addr, &_addr, sizeof(addr));
+        len = _len;
+        generation = _generation.read();
+        return true;
+    }
+
+private:
+    uhd::atomic_uint32_t _generation;
+    boost::mutex _mutex;
+    sockaddr_storage _addr;
+    socklen_t _len;
+};
+
+/*!
+ * Forwards the packets of a zero copy interface to a UDP socket.
+ * A call takes the packets that are ready, up to a burst,
+ * and sends them to the client with one system call.
+ */
+class udp_tunnel_to_socket : boost::noncopyable{
+public:
+    udp_tunnel_to_socket(
+        zero_copy_if::sptr recver, const int sock_fd,
+        udp_tunnel_endpoint &endpoint, const size_t max_burst
+    ):
+        _recver(recver), _sock_fd(sock_fd), _endpoint(endpoint),
+        _max_burst(std::max<size_t>(max_burst, 1)),
+        _generation(0), _len(0), _iovs(_max_burst)
+    {
+        std::memset(&_addr, 0, sizeof(_addr));
+        #ifdef UDP_TUNNEL_HAVE_MMSG
+        _msgs.resize(_max_burst);
+        #endif
+    }
+
+    /*!
+     * Forward a burst of packets.
+     * Packets are dropped until the client is known.
+     * \param timeout the time to wait for the first packet in seconds
+     * \return the number of packets taken from the interface
+     */
+    size_t forward(const double timeout){
+        managed_recv_buffer::sptr buff = _recver->get_recv_buff(timeout);
+        if (not buff) return 0;
+        do{
+            _buffs.push_back(buff);
+        } while (_buffs.size() < _max_burst and (buff = _recver->get_recv_buff(0.0)));
+        const size_t num_packets = _buffs.size();
+
+        _endpoint.get_if_changed(_generation, _addr, _len);
+        if (_len != 0) this->send_all();
+        _buffs.clear(); //release the buffers to the interface
+        return num_packets;
+    }
+
+private:
+    void send_all(void){
+        for (size_t i = 0; i < _buffs.size(); i++){
+            _iovs[i].iov_base = const_cast<void *>(_buffs[i]->cast<const void *>());
+            _iovs[i].iov_len = _buffs[i]->size();
+        }
+        #ifdef UDP_TUNNEL_HAVE_MMSG
+        for (size_t i = 0; i < _buffs.size(); i++){
+            std::memset(&_msgs[i], 0, sizeof(_msgs[i]));
+            _msgs[i].msg_hdr.msg_name = &_addr;
+            _msgs[i].msg_hdr.msg_namelen = _len;
+            _msgs[i].msg_hdr.msg_iov = &_iovs[i];
+            _msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        size_t num_sent = 0;
+        while (num_sent < _buffs.size()){
+            const int ret = ::sendmmsg(_sock_fd, &_msgs[num_sent], _buffs.size() - num_sent, 0);
+            if (ret < 0 and errno == EINTR) continue;
+            if (ret < 0) throw uhd::os_error("udp tunnel: error in sendmmsg");
+            num_sent += size_t(ret);
+        }
+        #else
+        size_t num_sent = 0;
+        while (num_sent < _buffs.size()){
+            const ssize_t ret = ::sendto(_sock_fd, _iovs[num_sent].iov_base, _iovs[num_sent].iov_len, 0,
+                reinterpret_cast<const sockaddr *>(&_addr), _len);
+            if (ret < 0 and errno == EINTR) continue;
+            if (ret < 0) throw uhd::os_error("udp tunnel: error in sendto");
+            num_sent++;
+        }
+        #endif
+    }
+
+    zero_copy_if::sptr _recver;
+    const int _sock_fd;
+    udp_tunnel_endpoint &_endpoint;
+    const size_t _max_burst;
+    boost::uint32_t _generation;
+    sockaddr_storage _addr;
+    socklen_t _len;
+    std::vector<managed_recv_buffer::sptr> _buffs;
+    std::vector<iovec> _iovs;
+    #ifdef UDP_TUNNEL_HAVE_MMSG
+    std::vector<mmsghdr> _msgs;
+    #endif
+};
+
+/*!
+ * Forwards the packets of a UDP socket to a zero copy interface.
+ * The tunnel receives a burst of packets into staging memory with one
+ * system call, then copies each one into a send buffer and commits it.
+ * Send buffers are only taken for packets that arrived: a send buffer
+ * released without a commit would still go out as a full frame.
+ * Packets without a free send buffer wait for the next call, in order.
+ */
+class udp_tunnel_from_socket : boost::noncopyable{
+public:
+    udp_tunnel_from_socket(
+        const int sock_fd, zero_copy_if::sptr sender,
+        udp_tunnel_endpoint &endpoint, const size_t max_burst
+    ):
+        _sock_fd(sock_fd), _sender(sender), _endpoint(endpoint),
+        _max_burst(std::max<size_t>(std::min(max_burst, sender->get_num_send_frames()/2), 1)),
+        _frame_size(sender->get_send_frame_size()),
+        _len(0), _num_staged(0), _next_staged(0),
+        _staging(_max_burst*_frame_size), _lens(_max_burst),
+        _iovs(_max_burst), _addrs(_max_burst), _addr_lens(_max_burst)
+    {
+        std::memset(&_addr, 0, sizeof(_addr));
+        #ifdef UDP_TUNNEL_HAVE_MMSG
+        _msgs.resize(_max_burst);
+        #endif
+    }
+
+    /*!
+     * Forward a burst of packets.
+     * \param timeout the time to wait for the first packet and for a send buffer in seconds
+     * \return the number of packets committed to the interface
+     */
+    size_t forward(const double timeout){
+        if (_next_staged == _num_staged){
+            pollfd pfd;
+            pfd.fd = _sock_fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (::poll(&pfd, 1, int(timeout*1000)) <= 0) return 0;
+            _num_staged = this->recv_all();
+            _next_staged = 0;
+            if (_num_staged != 0) this->update_client(_num_staged-1);
+        }
+
+        size_t num_packets = 0;
+        while (_next_staged < _num_staged){
+            managed_send_buffer::sptr buff = _sender->get_send_buff((num_packets == 0)? timeout : 0.0);
+            if (not buff) break;
+            const size_t len = std::min(_lens[_next_staged], buff->size());
+            std::memcpy(buff->cast<void *>(), &_staging[_next_staged*_frame_size], len);
+            buff->commit(len);
+            _next_staged++;
+            num_packets++;
+        }
+        return num_packets;
+    }
+
+private:
+    //! The client may have moved, the last packet tells
+    void update_client(const size_t i){
+        const sockaddr_storage &addr = _addrs[i];
+        const socklen_t len = _addr_lens[i];
+        if (len == _len and std::memcmp(&addr, &_addr, len) == 0) return;
+        std::memcpy(&_addr, &addr, sizeof(_addr));
+        _len = len;
+        _endpoint.update(_addr, _len);
+    }
+
+    size_t recv_all(void){
+        for (size_t i = 0; i < _max_burst; i++){
+            _iovs[i].iov_base = &_staging[i*_frame_size];
+            _iovs[i].iov_len = _frame_size;
+        }
+        #ifdef UDP_TUNNEL_HAVE_MMSG
+        for (size_t i = 0; i < _max_burst; i++){
+            std::memset(&_msgs[i], 0, sizeof(_msgs[i]));
+            _msgs[i].msg_hdr.msg_name = &_addrs[i];
+            _msgs[i].msg_hdr.msg_namelen = sizeof(_addrs[i]);
+            _msgs[i].msg_hdr.msg_iov = &_iovs[i];
+            _msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        const int ret = ::recvmmsg(_sock_fd, &_msgs.front(), _max_burst, MSG_DONTWAIT, NULL);
+        if (ret < 0 and (errno == EAGAIN or errno == EWOULDBLOCK or errno == EINTR)) return 0;
+        if (ret < 0) throw uhd::os_error("udp tunnel: error in recvmmsg");
+        for (int i = 0; i < ret; i++){
+            _lens[i] = _msgs[i].msg_len;
+            _addr_lens[i] = _msgs[i].msg_hdr.msg_namelen;
+        }
+        return size_t(ret);
+        #else
+        size_t num_packets = 0;
+        while (num_packets < _max_burst){
+            socklen_t addr_len = sizeof(_addrs[num_packets]);
+            const ssize_t ret = ::recvfrom(_sock_fd, _iovs[num_packets].iov_base, _iovs[num_packets].iov_len,
+                MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&_addrs[num_packets]), &addr_len);
+            if (ret < 0 and (errno == EAGAIN or errno == EWOULDBLOCK or errno == EINTR)) break;
+            if (ret < 0) throw uhd::os_error("udp tunnel: error in recvfrom");
+            _lens[num_packets] = size_t(ret);
+            _addr_lens[num_packets] = addr_len;
+            num_packets++;
+        }
+        return num_packets;
+        #endif
+    }
+
+    const int _sock_fd;
+    zero_copy_if::sptr _sender;
+    udp_tunnel_endpoint &_endpoint;
+    const size_t _max_burst;
+    const size_t _frame_size;
+    sockaddr_storage _addr;
+    socklen_t _len;
+    size_t _num_staged, _next_staged;
+    std::vector<char> _staging;
+    std::vector<size_t> _lens;
+    std::vector<iovec> _iovs;
+    std::vector<sockaddr_storage> _addrs;
+    std::vector<socklen_t> _addr_lens;
+    #ifdef UDP_TUNNEL_HAVE_MMSG
+    std::vector<mmsghdr> _msgs;
+    #endif
+};
+
+}} //namespace uhd::transport
+
+#endif /* INCLUDED_LIBUHD_TRANSPORT_UDP_TUNNEL_HPP */
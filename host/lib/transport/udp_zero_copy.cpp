@@ -225,6 +225,7 @@ public:
 
     size_t get_num_recv_frames(void) const {return _num_recv_frames;}
     size_t get_recv_frame_size(void) const {return _recv_frame_size;}
+    int get_recv_fd(void) const {return _sock_fd;}
 
     /*******************************************************************
      * Send implementation:
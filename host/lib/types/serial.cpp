@@ -144,3 +144,14 @@ void spi_iface::write_spi(
         which_slave, config, data, num_bits, false
     );
 }
+
+void spi_iface::write_spi_burst(
+    int which_slave,
+    const spi_config_t &config,
+    const std::vector<boost::uint32_t> &data,
+    size_t num_bits
+){
+    for (size_t i = 0; i < data.size(); i++){
+        this->write_spi(which_slave, config, data[i], num_bits);
+    }
+}
@@ -0,0 +1,110 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/types/stream_stats.hpp>
+#include <boost/format.hpp>
+#include <sstream>
+#include <cmath>
+
+using namespace uhd;
+
+/***********************************************************************
+ * time histogram
+ **********************************************************************/
+const size_t time_histogram_t::NUM_BINS;
+
+time_histogram_t::time_histogram_t(void){
+    this->reset();
+}
+
+double time_histogram_t::get_bin_start(const size_t bin){
+    if (bin == 0) return 0.0;
+    return std::ldexp(1e-6, int(bin) - 1);
+}
+
+double time_histogram_t::get_mean(void) const{
+    if (count == 0) return 0.0;
+    return total_secs/count;
+}
+
+time_histogram_t &time_histogram_t::operator+=(const time_histogram_t &other){
+    for (size_t i = 0; i < NUM_BINS; i++) bins[i] += other.bins[i];
+    count += other.count;
+    total_secs += other.total_secs;
+    return *this;
+}
+
+void time_histogram_t::reset(void){
+    for (size_t i = 0; i < NUM_BINS; i++) bins[i] = 0;
+    count = 0;
+    total_secs = 0.0;
+}
+
+static void pp_histogram(std::stringstream &ss, const std::string &name, const time_histogram_t &hist){
+    ss << boost::format("  %s: %u samples, mean %f us") % name % hist.count % (hist.get_mean()*1e6) << std::endl;
+    for (size_t i = 0; i < time_histogram_t::NUM_BINS; i++){
+        if (hist.bins[i] == 0) continue;
+        ss << boost::format("    >= %g us: %u") % (time_histogram_t::get_bin_start(i)*1e6) % hist.bins[i] << std::endl;
+    }
+}
+
+/***********************************************************************
+ * stream stats
+ **********************************************************************/
+stream_stats_t::stream_stats_t(void){
+    this->reset();
+}
+
+stream_stats_t &stream_stats_t::operator+=(const stream_stats_t &other){
+    num_packets += other.num_packets;
+    num_bytes += other.num_bytes;
+    num_sequence_errors += other.num_sequence_errors;
+    num_overflows += other.num_overflows;
+    num_timeouts += other.num_timeouts;
+    num_buff_stalls += other.num_buff_stalls;
+    buff_wait_time += other.buff_wait_time;
+    convert_time += other.convert_time;
+    header_time += other.header_time;
+    return *this;
+}
+
+void stream_stats_t::reset(void){
+    num_packets = 0;
+    num_bytes = 0;
+    num_sequence_errors = 0;
+    num_overflows = 0;
+    num_timeouts = 0;
+    num_buff_stalls = 0;
+    buff_wait_time.reset();
+    convert_time.reset();
+    header_time.reset();
+}
+
+std::string stream_stats_t::to_pp_string(void) const{
+    std::stringstream ss;
+    ss << boost::format("Packets: %u") % num_packets << std::endl;
+    ss << boost::format("Bytes: %u") % num_bytes << std::endl;
+    ss << boost::format("Sequence errors: %u") % num_sequence_errors << std::endl;
+    ss << boost::format("Overflows: %u") % num_overflows << std::endl;
+    ss << boost::format("Timeouts: %u") % num_timeouts << std::endl;
+    ss << boost::format("Buffer stalls: %u") % num_buff_stalls << std::endl;
+    ss << "Histograms:" << std::endl;
+    pp_histogram(ss, "Buffer wait time", buff_wait_time);
+    pp_histogram(ss, "Conversion time", convert_time);
+    pp_histogram(ss, "Header time", header_time);
+    return ss.str();
+}
@@ -86,7 +86,7 @@ public:
         _internal(internal), _fragmentation_size(fragmentation_size)
     {
         _ok_to_auto_flush = false;
-        _task = uhd::task::make(boost::bind(&usb_zero_copy_wrapper_msb::auto_flush, this));
+        _task = uhd::task::make(boost::bind(&usb_zero_copy_wrapper_msb::auto_flush, this), "b100_flush");
     }
 
     ~usb_zero_copy_wrapper_msb(void)
@@ -302,7 +302,7 @@ b200_impl::b200_impl(const device_addr_t &device_addr)
     ////////////////////////////////////////////////////////////////////
     _async_task_data.reset(new AsyncTaskData());
     _async_task_data->async_md.reset(new async_md_type(1000/*messages deep*/));
-    _async_task = uhd::msg_task::make(boost::bind(&b200_impl::handle_async_task, this, _ctrl_transport, _async_task_data));
+    _async_task = uhd::msg_task::make(boost::bind(&b200_impl::handle_async_task, this, _ctrl_transport, _async_task_data), "b200_async");
 
     ////////////////////////////////////////////////////////////////////
     // Local control endpoint
@@ -310,6 +310,8 @@ b200_impl::b200_impl(const device_addr_t &device_addr)
     _local_ctrl = radio_ctrl_core_3000::make(false/*lilE*/, _ctrl_transport, zero_copy_if::sptr()/*null*/, B200_LOCAL_CTRL_SID);
     _local_ctrl->hold_task(_async_task);
     _async_task_data->local_ctrl = _local_ctrl; //weak
+    _tree->create<time_histogram_t>(mb_path / "radio_ctrl" / "local" / "rtt")
+        .publish(boost::bind(&radio_ctrl_core_3000::get_rtt_stats, _local_ctrl));
     this->check_fpga_compat();
 
     /* Initialize the GPIOs, set the default bandsels to the lower range. Note
@@ -392,6 +394,8 @@ b200_impl::b200_impl(const device_addr_t &device_addr)
     UHD_MSG(status) << "Initialize CODEC control..." << std::endl;
     ad9361_params::sptr client_settings = boost::make_shared<b200_ad9361_client_t>();
     _codec_ctrl = ad9361_ctrl::make_spi(client_settings, _spi_iface, AD9361_SLAVENO);
+    if (device_addr.has_key("codec_cal_cache"))
+        _codec_ctrl->set_calibration_cache_file(ad9361_ctrl::get_calibration_cache_file(mb_eeprom["serial"]));
     this->reset_codec_dcm();
 
     ////////////////////////////////////////////////////////////////////
@@ -401,6 +405,9 @@ b200_impl::b200_impl(const device_addr_t &device_addr)
         const fs_path codec_path = mb_path / ("rx_codecs") / "A";
         _tree->create<std::string>(codec_path / "name").set(product_name+" RX dual ADC");
         _tree->create<int>(codec_path / "gains"); //empty cuz gains are in frontend
+        //one cache for the RX and TX calibrations of the codec
+        _tree->create<bool>(codec_path / "cal_cache" / "invalidate")
+            .subscribe(boost::bind(&ad9361_ctrl::invalidate_calibration_cache, _codec_ctrl));
     }
     {
         const fs_path codec_path = mb_path / ("tx_codecs") / "A";
@@ -417,6 +424,10 @@ b200_impl::b200_impl(const device_addr_t &device_addr)
         .subscribe(boost::bind(&b200_impl::update_tick_rate, this, _1));
     _tree->create<time_spec_t>(mb_path / "time" / "cmd");
 
+    //host side messages for recv_async_msg()
+    _tree->create<async_metadata_t>(mb_path / "async_msg")
+        .subscribe(boost::bind(&async_md_type::push_with_pop_on_full, _async_task_data->async_md, _1));
+
     ////////////////////////////////////////////////////////////////////
     // and do the misc mboard sensors
     ////////////////////////////////////////////////////////////////////
@@ -563,6 +574,8 @@ void b200_impl::setup_radio(const size_t dspno)
     _tree->access<double>(mb_path / "tick_rate")
         .subscribe(boost::bind(&radio_ctrl_core_3000::set_tick_rate, perif.ctrl, _1));
     this->register_loopback_self_test(perif.ctrl);
+    _tree->create<time_histogram_t>(mb_path / "radio_ctrl" / boost::lexical_cast<std::string>(dspno) / "rtt")
+        .publish(boost::bind(&radio_ctrl_core_3000::get_rtt_stats, perif.ctrl));
     perif.atr = gpio_core_200_32wo::make(perif.ctrl, TOREG(SR_ATR));
 
     ////////////////////////////////////////////////////////////////////
@@ -654,6 +667,8 @@ void b200_impl::setup_radio(const size_t dspno)
             .set(B200_DEFAULT_FREQ);
         _tree->create<meta_range_t>(rf_fe_path / "freq" / "range")
             .publish(boost::bind(&ad9361_ctrl::get_rf_freq_range));
+        _tree->create<size_t>(rf_fe_path / "fast_lock" / "store")
+            .subscribe(boost::bind(&ad9361_ctrl::store_fastlock_profile, _codec_ctrl, key, _1));
 
         //setup antenna stuff
         if (key[0] == 'R')
@@ -18,6 +18,7 @@
 #include "b200_regs.hpp"
 #include "b200_impl.hpp"
 #include "validate_subdev_spec.hpp"
+#include "publish_stream_stats.hpp"
 #include "../../transport/super_recv_packet_handler.hpp"
 #include "../../transport/super_send_packet_handler.hpp"
 #include "async_packet_handler.hpp"
@@ -326,6 +327,9 @@ rx_streamer::sptr b200_impl::get_rx_stream(const uhd::stream_args_t &args_)
     }
     this->update_enables();
 
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "rx", args.channels, std::vector<std::string>(), my_streamer->get_stats_block());
+
     return my_streamer;
 }
 
@@ -425,5 +429,8 @@ tx_streamer::sptr b200_impl::get_tx_stream(const uhd::stream_args_t &args_)
     }
     this->update_enables();
 
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "tx", args.channels, std::vector<std::string>(), my_streamer->get_stats_block());
+
     return my_streamer;
 }
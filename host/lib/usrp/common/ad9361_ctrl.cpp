@@ -20,12 +20,22 @@
 #include <uhd/types/ranges.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/types/serial.hpp>
+#include <uhd/utils/csv.hpp>
+#include <uhd/utils/log.hpp>
+#include <uhd/utils/paths.hpp>
 #include <cstring>
+#include <cstdlib>
+#include <vector>
 #include <boost/format.hpp>
 #include <boost/utility.hpp>
 #include <boost/function.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/thread.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/foreach.hpp>
+#include <boost/algorithm/string.hpp>
+#include <fstream>
 
 using namespace uhd;
 using namespace uhd::usrp;
@@ -38,13 +48,14 @@ class ad9361_io_spi : public ad9361_io
 {
 public:
     ad9361_io_spi(uhd::spi_iface::sptr spi_iface, boost::uint32_t slave_num) :
-        _spi_iface(spi_iface), _slave_num(slave_num) { }
+        _spi_iface(spi_iface), _slave_num(slave_num), _burst_depth(0) { }
 
     virtual ~ad9361_io_spi() { }
 
     virtual boost::uint8_t peek8(boost::uint32_t reg)
     {
         boost::lock_guard<boost::mutex> lock(_mutex);
+        _flush(); //reads see the held back writes
 
         uhd::spi_config_t config;
         config.mosi_edge = uhd::spi_config_t::EDGE_FALL;
@@ -62,6 +73,11 @@ public:
     virtual void poke8(boost::uint32_t reg, boost::uint8_t val)
     {
         boost::lock_guard<boost::mutex> lock(_mutex);
+        if (_burst_depth > 0) {
+            _pending.push_back(std::make_pair(reg, val));
+            if (_pending.size() >= AD9361_MAX_PENDING_WRITES) _flush();
+            return;
+        }
 
         uhd::spi_config_t config;
         config.mosi_edge = uhd::spi_config_t::EDGE_FALL;
@@ -73,10 +89,70 @@ public:
         _spi_iface->write_spi(_slave_num, config, wr_word, AD9361_SPI_NUM_BITS);
     }
 
+    virtual void begin_burst()
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _burst_depth++;
+    }
+
+    virtual void end_burst()
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        if (_burst_depth > 0 and --_burst_depth == 0) _flush();
+    }
+
 private:
+    /*!
+     * Send the held back writes (called with the mutex held).
+     * A write followed by a write to the next lower register becomes one
+     * two byte instruction (the address decrements in MSB first mode).
+     * Runs of instructions with the same length go out as one SPI burst.
+     */
+    void _flush()
+    {
+        if (_pending.empty()) return;
+
+        uhd::spi_config_t config;
+        config.mosi_edge = uhd::spi_config_t::EDGE_FALL;
+        config.miso_edge = uhd::spi_config_t::EDGE_FALL;    //TODO (Ashish): FPGA SPI workaround. This should be EDGE_RISE
+
+        std::vector<boost::uint32_t> words;
+        size_t words_num_bits = 0;
+        for (size_t i = 0; i < _pending.size(); i++) {
+            const boost::uint32_t reg = _pending[i].first;
+            boost::uint32_t word;
+            size_t num_bits;
+            if (i + 1 < _pending.size() and _pending[i + 1].first + 1 == reg) {
+                word = AD9361_SPI_WRITE2_CMD |
+                       ((reg << AD9361_SPI_ADDR2_SHIFT) & AD9361_SPI_ADDR2_MASK) |
+                       (boost::uint32_t(_pending[i].second) << 8) |
+                       boost::uint32_t(_pending[i + 1].second);
+                num_bits = AD9361_SPI_NUM_BITS2;
+                i++;
+            } else {
+                word = AD9361_SPI_WRITE_CMD |
+                       ((reg << AD9361_SPI_ADDR_SHIFT) & AD9361_SPI_ADDR_MASK) |
+                       ((boost::uint32_t(_pending[i].second) << AD9361_SPI_DATA_SHIFT) & AD9361_SPI_DATA_MASK);
+                num_bits = AD9361_SPI_NUM_BITS;
+            }
+            if (num_bits != words_num_bits and not words.empty()) {
+                _spi_iface->write_spi_burst(_slave_num, config, words, words_num_bits);
+                words.clear();
+            }
+            words_num_bits = num_bits;
+            words.push_back(word);
+        }
+        _pending.clear(); //cleared before the last write, a failed burst is not sent again
+        _spi_iface->write_spi_burst(_slave_num, config, words, words_num_bits);
+    }
+
     uhd::spi_iface::sptr    _spi_iface;
     boost::uint32_t         _slave_num;
     boost::mutex            _mutex;
+    size_t                  _burst_depth;
+    std::vector<std::pair<boost::uint32_t, boost::uint8_t> > _pending;
+
+    static const size_t AD9361_MAX_PENDING_WRITES = 256;
 
     static const boost::uint32_t AD9361_SPI_WRITE_CMD  = 0x00800000;
     static const boost::uint32_t AD9361_SPI_READ_CMD   = 0x00000000;
@@ -85,6 +161,11 @@ private:
     static const boost::uint32_t AD9361_SPI_DATA_MASK  = 0x000000FF;
     static const boost::uint32_t AD9361_SPI_DATA_SHIFT = 0;
     static const boost::uint32_t AD9361_SPI_NUM_BITS   = 24;
+    //two byte write: 16 bit instruction with byte count 2, then the two bytes
+    static const boost::uint32_t AD9361_SPI_WRITE2_CMD = 0x90000000;
+    static const boost::uint32_t AD9361_SPI_ADDR2_MASK = 0x03FF0000;
+    static const boost::uint32_t AD9361_SPI_ADDR2_SHIFT = 16;
+    static const boost::uint32_t AD9361_SPI_NUM_BITS2  = 32;
 };
 
 /***********************************************************************
@@ -123,7 +204,12 @@ public:
         const meta_range_t clock_rate_range = ad9361_ctrl::get_clock_rate_range();
         const double clipped_rate = clock_rate_range.clip(rate);
 
-        return _device.set_clock_rate(clipped_rate);
+        const size_t num_cals = _device.get_num_stored_calibrations();
+        const double actual_rate = _device.set_clock_rate(clipped_rate);
+        if (not _cal_file.empty() and _device.get_num_stored_calibrations() != num_cals) {
+            _store_calibration_cache();
+        }
+        return actual_rate;
     }
 
     //! set which RX and TX chains/antennas are active
@@ -148,6 +234,15 @@ public:
         return _device.tune(direction, value);
     }
 
+    //! store the current tune of the given frontend in a fast lock profile
+    void store_fastlock_profile(const std::string &which, const size_t profile)
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+
+        ad9361_device_t::direction_t direction = _get_direction_from_antenna(which);
+        _device.store_fastlock_profile(direction, profile);
+    }
+
     //! turn on/off Catalina's data port loopback
     void data_port_loopback(const bool on)
     {
@@ -156,7 +251,76 @@ public:
         _device.data_port_loopback(on);
     }
 
+    void invalidate_calibration_cache(void)
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+
+        _device.invalidate_calibration_cache();
+        if (not _cal_file.empty()) _store_calibration_cache();
+    }
+
+    void set_calibration_cache_file(const std::string &path)
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+
+        _cal_file = path;
+        if (not _cal_file.empty()) _load_calibration_cache();
+    }
+
 private:
+    /*******************************************************************
+     * The calibration cache file:
+     * One row per calibration with the clock rate, temperature band,
+     * RX band, TX band, then the result registers in hex.
+     ******************************************************************/
+    void _load_calibration_cache(void)
+    {
+        std::ifstream cache_file(_cal_file.c_str());
+        if (not cache_file.is_open()) return;
+        std::vector<ad9361_device_t::calibration_t> cals;
+        BOOST_FOREACH(const csv::row_type &row, csv::to_rows(cache_file)){
+            if (row.size() != 4 + ad9361_device_t::AD9361_NUM_CAL_REGS) continue;
+            try{
+                ad9361_device_t::calibration_t cal;
+                cal.clock_rate = boost::lexical_cast<double>(boost::trim_copy(row[0]));
+                cal.temp_band = boost::lexical_cast<int>(boost::trim_copy(row[1]));
+                cal.rx_band = boost::lexical_cast<int>(boost::trim_copy(row[2]));
+                cal.tx_band = boost::lexical_cast<int>(boost::trim_copy(row[3]));
+                for (size_t i = 0; i < ad9361_device_t::AD9361_NUM_CAL_REGS; i++) {
+                    const std::string reg = boost::trim_copy(row[4 + i]);
+                    if (reg.empty() or reg.size() > 2) throw boost::bad_lexical_cast();
+                    cal.regs[i] = boost::uint8_t(std::strtoul(reg.c_str(), NULL, 16));
+                }
+                cals.push_back(cal);
+            }
+            catch(const boost::bad_lexical_cast &){
+                //skip a damaged row, that rate gets calibrated again
+            }
+        }
+        _device.add_calibration_cache(cals);
+        UHD_LOG << boost::format("ad9361_ctrl: loaded %u calibrations from %s") % cals.size() % _cal_file << std::endl;
+    }
+
+    void _store_calibration_cache(void)
+    {
+        try{
+            const boost::filesystem::path cache_path(_cal_file);
+            if (cache_path.has_parent_path()) boost::filesystem::create_directories(cache_path.parent_path());
+            std::ofstream cache_file(_cal_file.c_str(), std::ios::trunc);
+            BOOST_FOREACH(const ad9361_device_t::calibration_t &cal, _device.get_calibration_cache()){
+                cache_file << boost::format("%.6f,%d,%d,%d")
+                    % cal.clock_rate % cal.temp_band % cal.rx_band % cal.tx_band;
+                for (size_t i = 0; i < ad9361_device_t::AD9361_NUM_CAL_REGS; i++) {
+                    cache_file << boost::format(",%02x") % int(cal.regs[i]);
+                }
+                cache_file << std::endl;
+            }
+        }
+        catch(const std::exception &e){
+            UHD_LOG << "ad9361_ctrl: cannot store the calibration cache: " << e.what() << std::endl;
+        }
+    }
+
     static ad9361_device_t::direction_t _get_direction_from_antenna(const std::string& antenna)
     {
         std::string sub = antenna.substr(0, 2);
@@ -185,8 +349,15 @@ private:
 
     ad9361_device_t _device;
     boost::mutex    _mutex;
+    std::string     _cal_file;
 };
 
+std::string ad9361_ctrl::get_calibration_cache_file(const std::string &serial)
+{
+    return (boost::filesystem::path(uhd::get_app_path()) / ".uhd" / "cache"
+        / ("ad9361_cal_" + serial + ".csv")).string();
+}
+
 //----------------------------------------------------------------------
 // Make an instance of the AD9361 Control interface
 //----------------------------------------------------------------------
@@ -94,8 +94,39 @@ public:
     //! tune the given frontend, return the exact value
     virtual double tune(const std::string &which, const double value) = 0;
 
+    //! get the number of fast lock profiles per direction
+    static size_t get_num_fastlock_profiles(void)
+    {
+        return ad9361_device_t::AD9361_NUM_FASTLOCK_PROFILES;
+    }
+
+    //! store the current tune of the frontend, tuning back to it recalls the profile
+    virtual void store_fastlock_profile(const std::string &which, const size_t profile) = 0;
+
+    //! forget the cached calibration results, in memory and in the cache file
+    virtual void invalidate_calibration_cache(void) = 0;
+
+    /*!
+     * Keep the calibration results of this codec in a file between runs.
+     * The results of the file are used at once; every calibration made
+     * later is added to it. The file must belong to this very device.
+     */
+    virtual void set_calibration_cache_file(const std::string &path) = 0;
+
+    //! get the default calibration cache file for the device with this serial
+    static std::string get_calibration_cache_file(const std::string &serial);
+
     //! turn on/off Catalina's data port loopback
     virtual void data_port_loopback(const bool on) = 0;
+
+    /*!
+     * Calls without a result made between begin_batch() and end_batch()
+     * may be held back and sent along with the next call that has one.
+     * Batches nest; the outermost end_batch() sends and waits for what
+     * is held back, so the codec is set up when it returns.
+     */
+    virtual void begin_batch(void) {}
+    virtual void end_batch(void) {}
 };
 
 }}
@@ -65,6 +65,12 @@ public:
 
     virtual boost::uint8_t peek8(boost::uint32_t reg) = 0;
     virtual void poke8(boost::uint32_t reg, boost::uint8_t val) = 0;
+
+    /* Writes between begin_burst() and end_burst() may be held back and
+     * sent in fewer bus transactions, in order. A peek8() sends the held
+     * writes first. Bursts nest; the outermost end_burst() sends. */
+    virtual void begin_burst() {}
+    virtual void end_burst() {}
 };
 
 
@@ -11,12 +11,15 @@
 #include <cmath>
 #include <uhd/exception.hpp>
 #include <uhd/utils/log.hpp>
+#include <uhd/utils/safe_call.hpp>
 #include <boost/cstdint.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/scoped_array.hpp>
 #include <boost/format.hpp>
 #include <boost/math/special_functions.hpp>
+#include <boost/static_assert.hpp>
+#include <algorithm>
 
 ////////////////////////////////////////////////////////////
 // the following macros evaluate to a compile time constant
@@ -53,6 +56,42 @@ int freq_is_nearly_equal(double a, double b) {
     return std::max(a,b) - std::min(a,b) < 1;
 }
 
+/* Hold back the register writes made while this is in scope, so the IO
+ * interface can send them as bursts. Reads still see every write before. */
+class ad9361_burst_guard {
+public:
+    ad9361_burst_guard(ad9361_io::sptr io_iface) : _io_iface(io_iface) {
+        _io_iface->begin_burst();
+    }
+    ~ad9361_burst_guard() {
+        UHD_SAFE_CALL(_io_iface->end_burst();)
+    }
+private:
+    ad9361_io::sptr _io_iface;
+};
+
+/* The synthesizers are tuned in the ALERT state. The guard forces the
+ * ENSM there, and returns it to FDD on destruction if it was in FDD. */
+class ad9361_alert_guard {
+public:
+    ad9361_alert_guard(ad9361_io::sptr io_iface) :
+        _io_iface(io_iface),
+        _not_in_alert((io_iface->peek8(0x017) & 0x0F) != 5)
+    {
+        if (_not_in_alert) {
+            _io_iface->poke8(0x014, 0x01);
+        }
+    }
+    ~ad9361_alert_guard() {
+        if (_not_in_alert) {
+            UHD_SAFE_CALL(_io_iface->poke8(0x014, 0x21);)
+        }
+    }
+private:
+    ad9361_io::sptr _io_iface;
+    const bool _not_in_alert;
+};
+
 /***********************************************************************
  * Filter functions
  **********************************************************************/
@@ -105,6 +144,8 @@ void ad9361_device_t::_program_fir_filter(direction_t direction, int num_taps, b
     _io_iface->poke8(base + 5, reg_numtaps | 0x1a);
     boost::this_thread::sleep(boost::posix_time::milliseconds(1));
 
+    ad9361_burst_guard burst(_io_iface);
+
     /* Zero the unused taps just in case they have stale data */
     int addr;
     for (addr = num_taps; addr < 128; addr++) {
@@ -267,7 +308,7 @@ void ad9361_device_t::_calibrate_synth_charge_pumps()
  * Note that the filter calibration depends heavily on the baseband
  * bandwidth, so this must be re-done after any change to the RX sample
  * rate. */
-double ad9361_device_t::_calibrate_baseband_rx_analog_filter()
+double ad9361_device_t::_calibrate_baseband_rx_analog_filter(const bool run_cal)
 {
     /* For filter tuning, baseband BW is half the complex BW, and must be
      * between 28e6 and 0.2e6. */
@@ -297,20 +338,24 @@ double ad9361_device_t::_calibrate_baseband_rx_analog_filter()
     _io_iface->poke8(0x1d5, 0x3f);
     _io_iface->poke8(0x1c0, 0x03);
 
-    /* Enable RX1 & RX2 filter tuners. */
-    _io_iface->poke8(0x1e2, 0x02);
-    _io_iface->poke8(0x1e3, 0x02);
-
-    /* Run the calibration! */
-    size_t count = 0;
-    _io_iface->poke8(0x016, 0x80);
-    while (_io_iface->peek8(0x016) & 0x80) {
-        if (count > 100) {
-            throw uhd::runtime_error("[ad9361_device_t] RX baseband filter cal FAILURE");
-            break;
+    /* Without a calibration, the tuners stay off and the filter keeps the
+     * restored tune words. */
+    if (run_cal) {
+        /* Enable RX1 & RX2 filter tuners. */
+        _io_iface->poke8(0x1e2, 0x02);
+        _io_iface->poke8(0x1e3, 0x02);
+
+        /* Run the calibration! */
+        size_t count = 0;
+        _io_iface->poke8(0x016, 0x80);
+        while (_io_iface->peek8(0x016) & 0x80) {
+            if (count > 100) {
+                throw uhd::runtime_error("[ad9361_device_t] RX baseband filter cal FAILURE");
+                break;
+            }
+            count++;
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
         }
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
     }
 
     /* Disable RX1 & RX2 filter tuners. */
@@ -325,7 +370,7 @@ double ad9361_device_t::_calibrate_baseband_rx_analog_filter()
  * Note that the filter calibration depends heavily on the baseband
  * bandwidth, so this must be re-done after any change to the TX sample
  * rate. */
-double ad9361_device_t::_calibrate_baseband_tx_analog_filter()
+double ad9361_device_t::_calibrate_baseband_tx_analog_filter(const bool run_cal)
 {
     /* For filter tuning, baseband BW is half the complex BW, and must be
      * between 28e6 and 0.2e6. */
@@ -345,20 +390,22 @@ double ad9361_device_t::_calibrate_baseband_tx_analog_filter()
     _io_iface->poke8(0x0d6, (txbbfdiv & 0x00FF));
     _io_iface->poke8(0x0d7, _regs.bbftune_mode);
 
-    /* Enable the filter tuner. */
-    _io_iface->poke8(0x0ca, 0x22);
-
-    /* Calibrate! */
-    size_t count = 0;
-    _io_iface->poke8(0x016, 0x40);
-    while (_io_iface->peek8(0x016) & 0x40) {
-        if (count > 100) {
-            throw uhd::runtime_error("[ad9361_device_t] TX baseband filter cal FAILURE");
-            break;
+    if (run_cal) {
+        /* Enable the filter tuner. */
+        _io_iface->poke8(0x0ca, 0x22);
+
+        /* Calibrate! */
+        size_t count = 0;
+        _io_iface->poke8(0x016, 0x40);
+        while (_io_iface->peek8(0x016) & 0x40) {
+            if (count > 100) {
+                throw uhd::runtime_error("[ad9361_device_t] TX baseband filter cal FAILURE");
+                break;
+            }
+
+            count++;
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
         }
-
-        count++;
-        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
     }
 
     /* Disable the filter tuner. */
@@ -836,6 +883,8 @@ void ad9361_device_t::_program_mixer_gm_subtable()
     boost::uint8_t gm[] = { 0x00, 0x0D, 0x15, 0x1B, 0x21, 0x25, 0x29, 0x2C, 0x2F, 0x31,
             0x33, 0x34, 0x35, 0x3A, 0x3D, 0x3E };
 
+    ad9361_burst_guard burst(_io_iface);
+
     /* Start the clock. */
     _io_iface->poke8(0x13f, 0x02);
 
@@ -889,6 +938,7 @@ void ad9361_device_t::_program_gain_table() {
 
     /* Okay, we have to program a new gain table. Sucks, brah. Start the
      * gain table clock. */
+    ad9361_burst_guard burst(_io_iface);
     _io_iface->poke8(0x137, 0x1A);
 
     /* IT'S PROGRAMMING TIME. */
@@ -926,6 +976,7 @@ void ad9361_device_t::_program_gain_table() {
  * This really only needs to be done once, at initialization. */
 void ad9361_device_t::_setup_gain_control()
 {
+    ad9361_burst_guard burst(_io_iface);
     _io_iface->poke8(0x0FA, 0xE0); // Gain Control Mode Select
     _io_iface->poke8(0x0FB, 0x08); // Table, Digital Gain, Man Gain Ctrl
     _io_iface->poke8(0x0FC, 0x23); // Incr Step Size, ADC Overrange Size
@@ -982,6 +1033,7 @@ void ad9361_device_t::_setup_synth(direction_t direction, double vcorate)
     boost::uint8_t loop_filter_r3 = synth_cal_lut[vcoindex][11];
 
     /* ... annnd program! */
+    ad9361_burst_guard burst(_io_iface);
     if (direction == RX) {
         _io_iface->poke8(0x23a, 0x40 | vco_output_level);
         _io_iface->poke8(0x239, 0xC0 | vco_varactor);
@@ -1151,27 +1203,29 @@ double ad9361_device_t::_tune_helper(direction_t direction, const double value)
             throw uhd::runtime_error("[ad9361_device_t] [_tune_helper] INVALID_CODE_PATH");
         }
 
-        _io_iface->poke8(0x004, _regs.inputsel);
-
-        /* Store vcodiv setting. */
-        _regs.vcodivs = (_regs.vcodivs & 0xF0) | (i & 0x0F);
-
-        /* Setup the synthesizer. */
-        _setup_synth(RX, actual_vcorate);
-
-        /* Tune!!!! */
-        _io_iface->poke8(0x233, nfrac & 0xFF);
-        _io_iface->poke8(0x234, (nfrac >> 8) & 0xFF);
-        _io_iface->poke8(0x235, (nfrac >> 16) & 0xFF);
-        _io_iface->poke8(0x232, (nint >> 8) & 0xFF);
-        _io_iface->poke8(0x231, nint & 0xFF);
-        _io_iface->poke8(0x005, _regs.vcodivs);
+        {
+            /* The synthesizer settings go out as one burst. */
+            ad9361_burst_guard burst(_io_iface);
+            _io_iface->poke8(0x004, _regs.inputsel);
+
+            /* Store vcodiv setting. */
+            _regs.vcodivs = (_regs.vcodivs & 0xF0) | (i & 0x0F);
+
+            /* Setup the synthesizer. */
+            _exit_fastlock(RX);
+            _setup_synth(RX, actual_vcorate);
+
+            /* Tune!!!! */
+            _io_iface->poke8(0x233, nfrac & 0xFF);
+            _io_iface->poke8(0x234, (nfrac >> 8) & 0xFF);
+            _io_iface->poke8(0x235, (nfrac >> 16) & 0xFF);
+            _io_iface->poke8(0x232, (nint >> 8) & 0xFF);
+            _io_iface->poke8(0x231, nint & 0xFF);
+            _io_iface->poke8(0x005, _regs.vcodivs);
+        }
 
         /* Lock the PLL! */
-        boost::this_thread::sleep(boost::posix_time::milliseconds(2));
-        if ((_io_iface->peek8(0x247) & 0x02) == 0) {
-            throw uhd::runtime_error("[ad9361_device_t] RX PLL NOT LOCKED");
-        }
+        _wait_for_lock(RX);
 
         _rx_freq = actual_lo;
 
@@ -1192,32 +1246,297 @@ double ad9361_device_t::_tune_helper(direction_t direction, const double value)
             throw uhd::runtime_error("[ad9361_device_t] [_tune_helper] INVALID_CODE_PATH");
         }
 
-        _io_iface->poke8(0x004, _regs.inputsel);
+        {
+            /* The synthesizer settings go out as one burst. */
+            ad9361_burst_guard burst(_io_iface);
+            _io_iface->poke8(0x004, _regs.inputsel);
+
+            /* Store vcodiv setting. */
+            _regs.vcodivs = (_regs.vcodivs & 0x0F) | ((i & 0x0F) << 4);
+
+            /* Setup the synthesizer. */
+            _exit_fastlock(TX);
+            _setup_synth(TX, actual_vcorate);
+
+            /* Tune it, homey. */
+            _io_iface->poke8(0x273, nfrac & 0xFF);
+            _io_iface->poke8(0x274, (nfrac >> 8) & 0xFF);
+            _io_iface->poke8(0x275, (nfrac >> 16) & 0xFF);
+            _io_iface->poke8(0x272, (nint >> 8) & 0xFF);
+            _io_iface->poke8(0x271, nint & 0xFF);
+            _io_iface->poke8(0x005, _regs.vcodivs);
+        }
 
-        /* Store vcodiv setting. */
-        _regs.vcodivs = (_regs.vcodivs & 0x0F) | ((i & 0x0F) << 4);
+        /* Lock the PLL! */
+        _wait_for_lock(TX);
 
-        /* Setup the synthesizer. */
-        _setup_synth(TX, actual_vcorate);
+        _tx_freq = actual_lo;
 
-        /* Tune it, homey. */
-        _io_iface->poke8(0x273, nfrac & 0xFF);
-        _io_iface->poke8(0x274, (nfrac >> 8) & 0xFF);
-        _io_iface->poke8(0x275, (nfrac >> 16) & 0xFF);
-        _io_iface->poke8(0x272, (nint >> 8) & 0xFF);
-        _io_iface->poke8(0x271, nint & 0xFF);
-        _io_iface->poke8(0x005, _regs.vcodivs);
+        return actual_lo;
+    }
+}
 
-        /* Lock the PLL! */
-        boost::this_thread::sleep(boost::posix_time::milliseconds(2));
-        if ((_io_iface->peek8(0x287) & 0x02) == 0) {
-            throw uhd::runtime_error("[ad9361_device_t] TX PLL NOT LOCKED");
+/* Wait for the RX or TX synthesizer to lock.
+ *
+ * The lock detect is polled with a doubling interval: a fast lock profile
+ * locks within tens of microseconds, a full VCO calibration takes up to a
+ * few milliseconds, and both cost only a handful of SPI reads. */
+static const long AD9361_LOCK_TIMEOUT_MS = 10;
+
+void ad9361_device_t::_wait_for_lock(direction_t direction)
+{
+    const boost::uint16_t lock_reg = (direction == RX) ? 0x247 : 0x287;
+    const boost::system_time deadline = boost::get_system_time()
+        + boost::posix_time::milliseconds(AD9361_LOCK_TIMEOUT_MS);
+
+    long poll_us = 5;
+    while ((_io_iface->peek8(lock_reg) & 0x02) == 0) {
+        if (boost::get_system_time() > deadline) {
+            throw uhd::runtime_error((direction == RX) ?
+                "[ad9361_device_t] RX PLL NOT LOCKED" : "[ad9361_device_t] TX PLL NOT LOCKED");
         }
+        boost::this_thread::sleep(boost::posix_time::microseconds(poll_us));
+        poll_us = std::min<long>(poll_us * 2, 500);
+    }
+}
 
-        _tx_freq = actual_lo;
+/* Fast lock profiles.
+ *
+ * A profile holds the synthesizer words of one tune, laid out as in the
+ * fast lock section of the AD9361 reference manual. They are read back
+ * from the synthesizer registers after a normal tune and written to the
+ * profile RAM through the fast lock program registers. The VCO divider
+ * and the band select are not part of the profile, they are kept on the
+ * host and restored on recall. */
+static const size_t AD9361_FASTLOCK_NUM_WORDS = 16;
+
+/* Register offset of the TX synthesizer block from the RX one. */
+static const boost::uint16_t AD9361_TX_SYNTH_OFFSET = 0x040;
+
+static void read_fastlock_words(ad9361_io::sptr io, boost::uint16_t offs, boost::uint8_t *words)
+{
+    const boost::uint8_t bias = io->peek8(0x242 + offs);
+    const boost::uint8_t charge_pump = io->peek8(0x23b + offs) & 0x3F;
+    const boost::uint8_t loop_filter_1 = io->peek8(0x23e + offs);
+    const boost::uint8_t loop_filter_2 = io->peek8(0x23f + offs);
+    const boost::uint8_t loop_filter_r3 = io->peek8(0x240 + offs) & 0x0F;
+
+    /* The loop filter words hold an initial and a steady state value,
+     * both are set to the values of the normal tune. */
+    words[0]  = io->peek8(0x231 + offs);                          //integer word [7:0]
+    words[1]  = io->peek8(0x232 + offs) & 0x07;                   //integer word [10:8]
+    words[2]  = io->peek8(0x233 + offs);                          //fractional word [7:0]
+    words[3]  = io->peek8(0x234 + offs);                          //fractional word [15:8]
+    words[4]  = io->peek8(0x235 + offs) & 0x7F;                   //fractional word [22:16]
+    words[5]  = ((bias & 0x07) << 4) | (io->peek8(0x239 + offs) & 0x0F); //VCO bias ref, varactor
+    words[6]  = (((bias >> 3) & 0x03) << 6) | charge_pump;        //VCO bias tcf, initial charge pump
+    words[7]  = charge_pump;                                      //steady state charge pump
+    words[8]  = (loop_filter_r3 << 4) | loop_filter_r3;           //R3
+    words[9]  = ((loop_filter_2 & 0x0F) << 4) | (loop_filter_2 & 0x0F); //C3
+    words[10] = ((loop_filter_1 & 0x0F) << 4) | (loop_filter_1 & 0x0F); //C1
+    words[11] = (loop_filter_1 & 0xF0) | (loop_filter_1 >> 4);    //C2
+    words[12] = (loop_filter_2 & 0xF0) | (loop_filter_2 >> 4);    //R1
+    words[13] = ((io->peek8(0x245 + offs) & 0x0F) << 4)           //VCO varactor offset
+              | ((io->peek8(0x238 + offs) >> 3) & 0x0F);          //VCO cal offset
+    words[14] = ((io->peek8(0x251 + offs) & 0x0F) << 4)           //VCO varactor reference
+              | (io->peek8(0x23a + offs) & 0x0F);                 //VCO output level
+    words[15] = 0x00;
+}
 
-        return actual_lo;
+void ad9361_device_t::store_fastlock_profile(direction_t direction, size_t profile)
+{
+    boost::lock_guard<boost::recursive_mutex> lock(_mutex);
+
+    if (profile >= AD9361_NUM_FASTLOCK_PROFILES) {
+        throw uhd::value_error(str(boost::format(
+            "[ad9361_device_t] fast lock profile %d out of range") % profile));
+    }
+    fastlock_state_t &state = (direction == RX) ? _rx_fastlock : _tx_fastlock;
+    const boost::uint16_t offs = (direction == RX) ? 0 : AD9361_TX_SYNTH_OFFSET;
+    const double req_freq = (direction == RX) ? _req_rx_freq : _req_tx_freq;
+    if (req_freq == 0.0) {
+        throw uhd::runtime_error("[ad9361_device_t] fast lock store before the first tune");
+    }
+
+    /* While a profile is in use the synthesizer registers hold an older
+     * tune, so tune normally to read back the words of this frequency. */
+    if (state.active == int(profile)) {
+        return;
+    } else if (state.active >= 0) {
+        ad9361_alert_guard alert(_io_iface);
+        _tune_helper(direction, req_freq);
+    }
+    boost::uint8_t words[AD9361_FASTLOCK_NUM_WORDS];
+    read_fastlock_words(_io_iface, offs, words);
+
+    /* Write the words to the profile RAM. */
+    {
+        ad9361_burst_guard burst(_io_iface);
+        for (size_t i = 0; i < AD9361_FASTLOCK_NUM_WORDS; i++) {
+            _io_iface->poke8(0x25c + offs, boost::uint8_t((profile << 4) | i));
+            _io_iface->poke8(0x25d + offs, words[i]);
+            _io_iface->poke8(0x25f + offs, 0x03); //program write, program clock enable
+        }
+        _io_iface->poke8(0x25f + offs, 0x00);
+    }
+
+    /* A frequency lives in one profile only. */
+    for (size_t i = 0; i < AD9361_NUM_FASTLOCK_PROFILES; i++) {
+        if (state.profiles[i].valid and freq_is_nearly_equal(state.profiles[i].req_freq, req_freq)) {
+            state.profiles[i].valid = false;
+        }
+    }
+    fastlock_profile_t &entry = state.profiles[profile];
+    entry.valid = true;
+    entry.req_freq = req_freq;
+    entry.freq = (direction == RX) ? _rx_freq : _tx_freq;
+    entry.vcodiv = (direction == RX) ? (_regs.vcodivs & 0x0F) : (_regs.vcodivs & 0xF0);
+    entry.inputsel = (direction == RX) ? (_regs.inputsel & 0x3F) : (_regs.inputsel & 0x40);
+}
+
+/* Find the stored profile of a requested frequency, -1 if there is none. */
+int ad9361_device_t::_find_fastlock_profile(direction_t direction, const double value)
+{
+    const fastlock_state_t &state = (direction == RX) ? _rx_fastlock : _tx_fastlock;
+    for (size_t i = 0; i < AD9361_NUM_FASTLOCK_PROFILES; i++) {
+        if (state.profiles[i].valid and freq_is_nearly_equal(state.profiles[i].req_freq, value)) {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+/* Switch the synthesizer to a stored profile. */
+double ad9361_device_t::_recall_fastlock_profile(direction_t direction, size_t profile)
+{
+    fastlock_state_t &state = (direction == RX) ? _rx_fastlock : _tx_fastlock;
+    const fastlock_profile_t &entry = state.profiles[profile];
+    const boost::uint16_t offs = (direction == RX) ? 0 : AD9361_TX_SYNTH_OFFSET;
+
+    /* Restore the band select and the VCO divider of the profile. */
+    if (direction == RX) {
+        _regs.inputsel = (_regs.inputsel & 0xC0) | entry.inputsel;
+        _regs.vcodivs = (_regs.vcodivs & 0xF0) | entry.vcodiv;
+    } else {
+        _regs.inputsel = (_regs.inputsel & 0xBF) | entry.inputsel;
+        _regs.vcodivs = (_regs.vcodivs & 0x0F) | entry.vcodiv;
     }
+    _io_iface->poke8(0x004, _regs.inputsel);
+    _io_iface->poke8(0x005, _regs.vcodivs);
+
+    /* Profile select, fast lock mode enable. */
+    _io_iface->poke8(0x25a + offs, boost::uint8_t((profile << 5) | 0x01));
+    state.active = int(profile);
+    _wait_for_lock(direction);
+
+    if (direction == RX) {
+        _req_rx_freq = entry.req_freq;
+        _rx_freq = entry.freq;
+    } else {
+        _req_tx_freq = entry.req_freq;
+        _tx_freq = entry.freq;
+    }
+    return entry.freq;
+}
+
+/* Leave fast lock mode before the synthesizer is programmed directly. */
+void ad9361_device_t::_exit_fastlock(direction_t direction)
+{
+    fastlock_state_t &state = (direction == RX) ? _rx_fastlock : _tx_fastlock;
+    if (state.active < 0) return;
+    _io_iface->poke8((direction == RX) ? 0x25a : 0x29a, 0x00);
+    state.active = -1;
+}
+
+void ad9361_device_t::_clear_fastlock_profiles()
+{
+    for (size_t i = 0; i < AD9361_NUM_FASTLOCK_PROFILES; i++) {
+        _rx_fastlock.profiles[i].valid = false;
+        _tx_fastlock.profiles[i].valid = false;
+    }
+    _rx_fastlock.active = -1;
+    _tx_fastlock.active = -1;
+}
+
+/***********************************************************************
+ * Calibration cache
+ ***********************************************************************/
+
+/* The registers holding the calibration results: the RX baseband filter
+ * resistor and capacitor words, the TX baseband filter words, and the TX
+ * quadrature phase, gain and offset corrections of both TX outputs. The
+ * baseband and RF DC offsets are not kept; their tracking is enabled by
+ * the RX quadrature setup, which runs at every rate change. */
+static const boost::uint16_t AD9361_CAL_REGS[] = {
+    0x1e0, 0x1e1, 0x1e4, 0x1e5, 0x1e6, 0x1e7, 0x1e8, 0x1e9, 0x1ea, 0x1eb, 0x1ec,
+    0x0c2, 0x0c3, 0x0c4, 0x0c5, 0x0c6, 0x0c7, 0x0c8, 0x0c9,
+    0x08e, 0x08f, 0x090, 0x091, 0x092, 0x093, 0x094, 0x095,
+    0x096, 0x097, 0x098, 0x099, 0x09a, 0x09b, 0x09c, 0x09d
+};
+BOOST_STATIC_ASSERT(sizeof(AD9361_CAL_REGS) / sizeof(AD9361_CAL_REGS[0])
+    == ad9361_device_t::AD9361_NUM_CAL_REGS);
+
+/* Temperature codes per band; the code is about 1.1 per degree C. */
+static const int AD9361_CAL_TEMP_BAND_CODES = 16;
+
+/* The band edges of the gain tables, which also select the calibration
+ * settings of the quadrature and RF DC offset calibrations. */
+static int get_cal_freq_band(const double freq)
+{
+    if (freq < 1300e6) return 0;
+    if (freq < 4e9) return 1;
+    return 2;
+}
+
+ad9361_device_t::calibration_t ad9361_device_t::_get_calibration_key(const double rate)
+{
+    calibration_t key;
+    key.clock_rate = rate;
+    key.temp_band = _io_iface->peek8(0x00E) / AD9361_CAL_TEMP_BAND_CODES;
+    key.rx_band = get_cal_freq_band(_rx_freq);
+    key.tx_band = get_cal_freq_band(_tx_freq);
+    std::fill(key.regs, key.regs + AD9361_NUM_CAL_REGS, 0);
+    return key;
+}
+
+int ad9361_device_t::_find_calibration(const calibration_t &key)
+{
+    for (size_t i = 0; i < _cal_cache.size(); i++) {
+        const calibration_t &cal = _cal_cache[i];
+        if (freq_is_nearly_equal(cal.clock_rate, key.clock_rate)
+                and cal.temp_band == key.temp_band
+                and cal.rx_band == key.rx_band
+                and cal.tx_band == key.tx_band) {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+void ad9361_device_t::_restore_calibration(const calibration_t &cal)
+{
+    ad9361_burst_guard burst(_io_iface);
+    for (size_t i = 0; i < AD9361_NUM_CAL_REGS; i++) {
+        _io_iface->poke8(AD9361_CAL_REGS[i], cal.regs[i]);
+    }
+}
+
+void ad9361_device_t::_store_calibration(calibration_t &key)
+{
+    for (size_t i = 0; i < AD9361_NUM_CAL_REGS; i++) {
+        key.regs[i] = _io_iface->peek8(AD9361_CAL_REGS[i]);
+    }
+    _add_calibration(key);
+    _num_stored_cals++;
+}
+
+void ad9361_device_t::_add_calibration(const calibration_t &cal)
+{
+    /* The cache is in insertion order, so the front is the oldest. */
+    if (_cal_cache.size() >= AD9361_MAX_NUM_CALS) {
+        _cal_cache.erase(_cal_cache.begin());
+    }
+    _cal_cache.push_back(cal);
 }
 
 /* Configure the various clock / sample rates in the RX and TX chains.
@@ -1387,6 +1706,7 @@ void ad9361_device_t::initialize()
     _rx2_gain = 0;
     _tx1_gain = 0;
     _tx2_gain = 0;
+    _clear_fastlock_profiles();
 
     /* Reset the device. */
     _io_iface->poke8(0x000, 0x01);
@@ -1532,8 +1852,8 @@ void ad9361_device_t::initialize()
     _program_gain_table();
     _setup_gain_control();
 
-    _calibrate_baseband_rx_analog_filter();
-    _calibrate_baseband_tx_analog_filter();
+    _calibrate_baseband_rx_analog_filter(true);
+    _calibrate_baseband_tx_analog_filter(true);
     _calibrate_rx_TIAs();
     _calibrate_secondary_tx_filter();
 
@@ -1651,21 +1971,40 @@ double ad9361_device_t::set_clock_rate(const double req_rate)
     _tune_helper(RX, _rx_freq);
     _tune_helper(TX, _tx_freq);
 
+    /* The charge pump calibration invalidates the stored profiles. */
+    _clear_fastlock_profiles();
+
     _program_mixer_gm_subtable();
     _program_gain_table();
     _setup_gain_control();
     _reprogram_gains();
 
-    _calibrate_baseband_rx_analog_filter();
-    _calibrate_baseband_tx_analog_filter();
+    /* With the results of an earlier calibration at this rate, restore
+     * them instead of running the filter and quadrature calibrations. */
+    calibration_t cal_key = _get_calibration_key(rate);
+    const int cal_index = _find_calibration(cal_key);
+    const bool run_cal = (cal_index < 0);
+    UHD_LOG << boost::format("[ad9361_device_t::set_clock_rate] calibration cache %s\n") % (run_cal ? "miss" : "hit");
+
+    _calibrate_baseband_rx_analog_filter(run_cal);
+    _calibrate_baseband_tx_analog_filter(run_cal);
+    if (not run_cal) {
+        _restore_calibration(_cal_cache[cal_index]);
+    }
     _calibrate_rx_TIAs();
     _calibrate_secondary_tx_filter();
 
     _setup_adc();
 
-    _calibrate_tx_quadrature();
+    if (run_cal) {
+        _calibrate_tx_quadrature();
+    }
     _calibrate_rx_quadrature();
 
+    if (run_cal) {
+        _store_calibration(cal_key);
+    }
+
     // cals done, set PPORT config
     switch (_client_params->get_digital_interface_mode()) {
         case AD9361_DDR_FDD_LVCMOS: {
@@ -1796,15 +2135,22 @@ double ad9361_device_t::tune(direction_t direction, const double value)
         throw uhd::runtime_error("[ad9361_device_t] [tune] INVALID_CODE_PATH");
     }
 
-    /* If we aren't already in the ALERT state, we will need to return to
-     * the FDD state after tuning. */
-    int not_in_alert = 0;
-    if ((_io_iface->peek8(0x017) & 0x0F) != 5) {
-        /* Force the device into the ALERT state. */
-        not_in_alert = 1;
-        _io_iface->poke8(0x014, 0x01);
+    /* A stored frequency is a profile switch: the synthesizer state and the
+     * VCO calibration are in the profile, the quadrature calibrations are
+     * left as they are. Only the gain table follows the band. */
+    const int profile = _find_fastlock_profile(direction, value);
+    if (profile >= 0) {
+        double tune_freq = _recall_fastlock_profile(direction, size_t(profile));
+        if (direction == RX) {
+            _program_gain_table();
+            _reprogram_gains();
+        }
+        return tune_freq;
     }
 
+    /* Tune in the ALERT state, back to FDD afterwards if we were there. */
+    ad9361_alert_guard alert(_io_iface);
+
     /* Tune the RF VCO! */
     double tune_freq = _tune_helper(direction, value);
 
@@ -1820,11 +2166,6 @@ double ad9361_device_t::tune(direction_t direction, const double value)
     _calibrate_tx_quadrature();
     _calibrate_rx_quadrature();
 
-    /* If we were in the FDD state, return it now. */
-    if (not_in_alert) {
-        _io_iface->poke8(0x014, 0x21);
-    }
-
     return tune_freq;
 }
 
@@ -1895,6 +2236,37 @@ double ad9361_device_t::set_gain(direction_t direction, chain_t chain, const dou
     }
 }
 
+void ad9361_device_t::invalidate_calibration_cache()
+{
+    boost::lock_guard<boost::recursive_mutex> lock(_mutex);
+    _cal_cache.clear();
+}
+
+std::vector<ad9361_device_t::calibration_t> ad9361_device_t::get_calibration_cache()
+{
+    boost::lock_guard<boost::recursive_mutex> lock(_mutex);
+    return _cal_cache;
+}
+
+void ad9361_device_t::add_calibration_cache(const std::vector<calibration_t> &cals)
+{
+    boost::lock_guard<boost::recursive_mutex> lock(_mutex);
+    for (size_t i = 0; i < cals.size(); i++) {
+        const int index = _find_calibration(cals[i]);
+        if (index < 0) {
+            _add_calibration(cals[i]);
+        } else {
+            _cal_cache[index] = cals[i];
+        }
+    }
+}
+
+size_t ad9361_device_t::get_num_stored_calibrations()
+{
+    boost::lock_guard<boost::recursive_mutex> lock(_mutex);
+    return _num_stored_cals;
+}
+
 void ad9361_device_t::output_test_tone()
 {
     boost::lock_guard<boost::recursive_mutex> lock(_mutex);
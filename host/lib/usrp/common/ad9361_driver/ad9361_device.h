@@ -8,6 +8,7 @@
 #include <ad9361_client.h>
 #include <boost/noncopyable.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <vector>
 
 namespace uhd { namespace usrp {
 
@@ -18,7 +19,7 @@ public:
     enum chain_t { CHAIN_1, CHAIN_2 };
 
     ad9361_device_t(ad9361_params::sptr client, ad9361_io::sptr io_iface) :
-        _client_params(client), _io_iface(io_iface) {}
+        _client_params(client), _io_iface(io_iface), _num_stored_cals(0) {}
 
     /* Initialize the AD9361 codec. */
     void initialize();
@@ -57,6 +58,43 @@ public:
      * are done in terms of attenuation. */
     double set_gain(direction_t direction, chain_t chain, const double value);
 
+    /* Store the current RX or TX synthesizer state in a fast lock profile.
+     *
+     * AD9361 holds eight calibrated synthesizer states per direction. Once
+     * a frequency is stored, tuning back to it switches to the profile
+     * instead of running the VCO and quadrature calibrations, so the retune
+     * takes tens of microseconds. Storing overwrites the profile. */
+    void store_fastlock_profile(direction_t direction, size_t profile);
+
+    /* The results of the clock rate dependent calibrations: the RX and TX
+     * baseband filter tunes and the TX quadrature corrections.
+     *
+     * set_clock_rate() keeps them per clock rate, die temperature band and
+     * RX / TX frequency band. A later change to a rate with matching bands
+     * restores them instead of calibrating again. At most
+     * AD9361_MAX_NUM_CALS are kept, the oldest one is dropped first. */
+    static const size_t AD9361_NUM_CAL_REGS = 35;
+    static const size_t AD9361_MAX_NUM_CALS = 64;
+    typedef struct {
+        double clock_rate;
+        int temp_band;
+        int rx_band;
+        int tx_band;
+        boost::uint8_t regs[AD9361_NUM_CAL_REGS];
+    } calibration_t;
+
+    /* Forget the cached calibrations. */
+    void invalidate_calibration_cache();
+
+    /* Get or add cached calibrations, e.g. to keep them between runs.
+     * Only results of this very chip may be added. */
+    std::vector<calibration_t> get_calibration_cache();
+    void add_calibration_cache(const std::vector<calibration_t> &cals);
+
+    /* The number of calibrations set_clock_rate() ran and stored so far.
+     * Unlike the cache size, it grows when a full cache drops one. */
+    size_t get_num_stored_calibrations();
+
     /* Make AD9361 output its test tone. */
     void output_test_tone();
 
@@ -67,6 +105,7 @@ public:
     static const double AD9361_MAX_GAIN;
     static const double AD9361_MAX_CLOCK_RATE;
     static const double AD9361_RECOMMENDED_MAX_CLOCK_RATE;
+    static const size_t AD9361_NUM_FASTLOCK_PROFILES = 8;
 
 private:    //Methods
     void _program_fir_filter(direction_t direction, int num_taps, boost::uint16_t *coeffs);
@@ -74,8 +113,8 @@ private:    //Methods
     void _setup_rx_fir(size_t num_taps);
     void _calibrate_lock_bbpll();
     void _calibrate_synth_charge_pumps();
-    double _calibrate_baseband_rx_analog_filter();
-    double _calibrate_baseband_tx_analog_filter();
+    double _calibrate_baseband_rx_analog_filter(const bool run_cal);
+    double _calibrate_baseband_tx_analog_filter(const bool run_cal);
     void _calibrate_secondary_tx_filter();
     void _calibrate_rx_TIAs();
     void _setup_adc();
@@ -91,7 +130,17 @@ private:    //Methods
     double _tune_bbvco(const double rate);
     void _reprogram_gains();
     double _tune_helper(direction_t direction, const double value);
+    void _wait_for_lock(direction_t direction);
+    int _find_fastlock_profile(direction_t direction, const double value);
+    double _recall_fastlock_profile(direction_t direction, size_t profile);
+    void _exit_fastlock(direction_t direction);
+    void _clear_fastlock_profiles();
     double _setup_rates(const double rate);
+    calibration_t _get_calibration_key(const double rate);
+    int _find_calibration(const calibration_t &key);
+    void _restore_calibration(const calibration_t &cal);
+    void _store_calibration(calibration_t &key);
+    void _add_calibration(const calibration_t &cal);
 
 private:    //Members
     typedef struct {
@@ -104,6 +153,19 @@ private:    //Members
         boost::uint8_t bbftune_mode;
     } chip_regs_t;
 
+    typedef struct {
+        bool valid;
+        double req_freq;
+        double freq;
+        boost::uint8_t vcodiv;
+        boost::uint8_t inputsel;
+    } fastlock_profile_t;
+
+    typedef struct {
+        fastlock_profile_t profiles[AD9361_NUM_FASTLOCK_PROFILES];
+        int active; //profile in use, -1 when tuned normally
+    } fastlock_state_t;
+
     //Interfaces
     ad9361_params::sptr _client_params;
     ad9361_io::sptr     _io_iface;
@@ -117,6 +179,9 @@ private:    //Members
     boost::int32_t      _tfir_factor;
     //Register soft-copies
     chip_regs_t         _regs;
+    fastlock_state_t    _rx_fastlock, _tx_fastlock;
+    std::vector<calibration_t> _cal_cache;
+    size_t              _num_stored_cals;
     //Synchronization
     boost::recursive_mutex  _mutex;
 };
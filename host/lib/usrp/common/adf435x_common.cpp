@@ -20,7 +20,12 @@
 #include <boost/math/special_functions/round.hpp>
 #include <uhd/types/tune_request.hpp>
 #include <uhd/utils/log.hpp>
+#include <uhd/utils/static.hpp>
+#include <boost/array.hpp>
+#include <boost/thread/mutex.hpp>
 #include <cmath>
+#include <deque>
+#include <map>
 
 
 using namespace uhd;
@@ -28,7 +33,7 @@ using namespace uhd;
 /***********************************************************************
  * ADF 4350/4351 Tuning Utility
  **********************************************************************/
-adf435x_tuning_settings tune_adf435x_synth(
+static adf435x_tuning_settings search_adf435x_synth(
     const double target_freq,
     const double ref_freq,
     const adf435x_tuning_constraints& constraints,
@@ -159,3 +164,119 @@ adf435x_tuning_settings tune_adf435x_synth(
 
     return settings;
 }
+
+/***********************************************************************
+ * ADF 4350/4351 Tuning Plan Cache
+ **********************************************************************/
+//! The inputs of a search, in a form that can be ordered
+typedef boost::array<double, 11> adf435x_plan_key_t;
+
+struct adf435x_plan_t {
+    adf435x_tuning_settings settings;
+    double actual_freq;
+};
+
+//! Enough for a scan over the full range with a 1 MHz grid
+static const size_t ADF435X_MAX_PLANS = 8192;
+
+struct adf435x_plan_cache_t {
+    boost::mutex mutex;
+    std::map<adf435x_plan_key_t, adf435x_plan_t> plans;
+    std::deque<adf435x_plan_key_t> order; //oldest first
+};
+
+UHD_SINGLETON_FCN(adf435x_plan_cache_t, get_plan_cache);
+
+adf435x_tuning_settings tune_adf435x_synth(
+    const double target_freq,
+    const double ref_freq,
+    const adf435x_tuning_constraints& constraints,
+    double& actual_freq)
+{
+    adf435x_plan_cache_t &cache = get_plan_cache();
+
+    adf435x_plan_key_t key;
+    key[0] = target_freq;
+    key[1] = ref_freq;
+    key[2] = constraints.force_frac0;
+    key[3] = constraints.feedback_after_divider;
+    key[4] = constraints.ref_doubler_threshold;
+    key[5] = constraints.pfd_freq_max;
+    key[6] = constraints.band_sel_freq_max;
+    key[7] = constraints.rf_divider_range.start();
+    key[8] = constraints.rf_divider_range.stop();
+    key[9] = constraints.int_range.start();
+    key[10] = constraints.int_range.stop();
+
+    {
+        boost::mutex::scoped_lock lock(cache.mutex);
+        std::map<adf435x_plan_key_t, adf435x_plan_t>::const_iterator it = cache.plans.find(key);
+        if (it != cache.plans.end()) {
+            actual_freq = it->second.actual_freq;
+            return it->second.settings;
+        }
+    }
+
+    adf435x_plan_t plan;
+    plan.settings = search_adf435x_synth(target_freq, ref_freq, constraints, plan.actual_freq);
+
+    boost::mutex::scoped_lock lock(cache.mutex);
+    if (cache.plans.insert(std::make_pair(key, plan)).second) {
+        cache.order.push_back(key);
+        if (cache.order.size() > ADF435X_MAX_PLANS) {
+            cache.plans.erase(cache.order.front());
+            cache.order.pop_front();
+        }
+    }
+    actual_freq = plan.actual_freq;
+    return plan.settings;
+}
+
+size_t adf435x_num_plans(void)
+{
+    adf435x_plan_cache_t &cache = get_plan_cache();
+    boost::mutex::scoped_lock lock(cache.mutex);
+    return cache.plans.size();
+}
+
+double adf435x_align_to_grid(const uhd::device_addr_t &tune_args, const double target_freq)
+{
+    const double grid = tune_args.cast<double>("lo_grid", 0.0);
+    if (grid <= 0.0) return target_freq;
+    return grid * boost::math::round(target_freq / grid);
+}
+
+/***********************************************************************
+ * ADF 4350/4351 Register Shadow
+ **********************************************************************/
+adf435x_reg_shadow::adf435x_reg_shadow(void)
+{
+    this->invalidate();
+}
+
+void adf435x_reg_shadow::invalidate(void)
+{
+    for (size_t addr = 0; addr < NUM_REGS; addr++) {
+        _values[addr] = 0;
+        _valid[addr] = false;
+    }
+}
+
+bool adf435x_reg_shadow::needs_write(const size_t addr, const boost::uint32_t value) const
+{
+    UHD_ASSERT_THROW(addr < NUM_REGS);
+    //register 0 makes the synthesizer take the new values
+    return addr == 0 or not _valid[addr] or _values[addr] != value;
+}
+
+void adf435x_reg_shadow::written(const size_t addr, const boost::uint32_t value)
+{
+    UHD_ASSERT_THROW(addr < NUM_REGS);
+    _values[addr] = value;
+    _valid[addr] = true;
+}
+
+bool adf435x_reg_shadow::needs_counter_reset(const boost::uint32_t reg1, const boost::uint32_t reg2) const
+{
+    return this->needs_write(1, reg1) or this->needs_write(2, reg2);
+}
@@ -21,6 +21,7 @@
 #include <boost/cstdint.hpp>
 #include <uhd/property_tree.hpp>
 #include <uhd/types/ranges.hpp>
+#include <uhd/types/device_addr.hpp>
 
 //Common IO Pins
 #define ADF435X_CE (1 << 3)
@@ -53,6 +54,12 @@ struct adf435x_tuning_settings {
     boost::uint16_t rf_divider;
 };
 
+/*!
+ * Find the synthesizer settings for a target frequency.
+ * The settings are remembered per target, reference and constraints,
+ * so revisiting a frequency (as a scan does) skips the search. When
+ * the memo is full, the oldest settings are forgotten first.
+ */
 adf435x_tuning_settings tune_adf435x_synth(
     const double target_freq,
     const double ref_freq,
@@ -60,4 +67,51 @@ adf435x_tuning_settings tune_adf435x_synth(
     double& actual_freq
 );
 
+//! Get the number of settings remembered by tune_adf435x_synth()
+size_t adf435x_num_plans(void);
+
+/*!
+ * Move a target frequency to the nearest point of the LO grid.
+ * The grid step comes from the "lo_grid" tune argument (in Hz, no grid
+ * when absent). A scan on a grid tunes a few settings over and over and
+ * leaves the remaining offset to the DSP.
+ */
+double adf435x_align_to_grid(const uhd::device_addr_t &tune_args, const double target_freq);
+
+/*!
+ * The registers last written to an ADF435x or MAX2870 synthesizer.
+ *
+ * A retune only writes the registers that changed. The synthesizer takes
+ * the new values when register 0 is written, so register 0 is written in
+ * any case, and last.
+ */
+class adf435x_reg_shadow {
+public:
+    static const size_t NUM_REGS = 6;
+
+    adf435x_reg_shadow(void);
+
+    //! Forget what was written, e.g. after the synthesizer lost power
+    void invalidate(void);
+
+    //! Does the register have to be written to hold this value?
+    bool needs_write(const size_t addr, const boost::uint32_t value) const;
+
+    //! Note that the register now holds this value
+    void written(const size_t addr, const boost::uint32_t value);
+
+    /*!
+     * Do the N and R counters have to be reset before these values?
+     * Registers 1 and 2 hold the prescaler, the modulus and the reference
+     * path. While they keep their values, a retune only changes INT and
+     * FRAC in register 0, which the synthesizer loads on the write of
+     * register 0 with the counters running, so no reset is needed.
+     */
+    bool needs_counter_reset(const boost::uint32_t reg1, const boost::uint32_t reg2) const;
+
+private:
+    boost::uint32_t _values[NUM_REGS];
+    bool _valid[NUM_REGS];
+};
+
 #endif /* INCLUDED_ADF435X_COMMON_HPP */
@@ -17,14 +17,15 @@
 
 #include "apply_corrections.hpp"
 #include <uhd/usrp/dboard_eeprom.hpp>
+#include <uhd/usrp/fe_cal_table.hpp>
 #include <uhd/utils/paths.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/csv.hpp>
 #include <uhd/types/dict.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/foreach.hpp>
 #include <boost/thread/mutex.hpp>
-#include <cstdio>
+#include <boost/shared_ptr.hpp>
+#include <boost/version.hpp>
 #include <complex>
 #include <fstream>
 
@@ -33,64 +34,93 @@ namespace fs = boost::filesystem;
 boost::mutex corrections_mutex;
 
 /***********************************************************************
- * Helper routines
+ * FE apply corrections implementation
  **********************************************************************/
-static double linear_interp(double x, double x0, double y0, double x1, double y1){
-    return y0 + (x - x0)*(y1 - y0)/(x1 - x0);
+typedef uhd::usrp::fe_cal_table fe_cal_table;
+
+/*!
+ * The loaded tables, by file path.
+ * The cache is never modified once published: a load publishes a copy
+ * with the new table, so lookups only take a snapshot of the pointer.
+ * The mutex serializes the loads (and the snapshots without atomic
+ * shared_ptr access, before Boost 1.53).
+ */
+typedef uhd::dict<std::string, fe_cal_table::sptr> fe_cal_cache_type;
+typedef boost::shared_ptr<const fe_cal_cache_type> fe_cal_cache_sptr;
+static fe_cal_cache_sptr fe_cal_cache(new fe_cal_cache_type());
+
+static fe_cal_cache_sptr get_fe_cal_cache(void){
+    #if BOOST_VERSION >= 105300
+    return boost::atomic_load(&fe_cal_cache);
+    #else
+    boost::mutex::scoped_lock l(corrections_mutex);
+    return fe_cal_cache;
+    #endif
 }
 
-/***********************************************************************
- * FE apply corrections implementation
- **********************************************************************/
-struct fe_cal_t{
-    double lo_freq;
-    double iq_corr_real;
-    double iq_corr_imag;
-};
-
-static bool fe_cal_comp(fe_cal_t a, fe_cal_t b){
-    return (a.lo_freq < b.lo_freq);
+static void set_fe_cal_cache(const fe_cal_cache_sptr &cache){
+    //called with the mutex held
+    #if BOOST_VERSION >= 105300
+    boost::atomic_store(&fe_cal_cache, cache);
+    #else
+    fe_cal_cache = cache;
+    #endif
 }
 
-static uhd::dict<std::string, std::vector<fe_cal_t> > fe_cal_cache;
+static fe_cal_table::sptr load_fe_cal_csv(const fs::path &cal_data_path){
+    std::ifstream cal_data(cal_data_path.string().c_str());
+
+    //skip the header up to and including the column names
+    std::string line;
+    while (std::getline(cal_data, line)){
+        if (line.compare(0, 16, "DATA STARTS HERE") != 0) continue;
+        std::getline(cal_data, line);
+        break;
+    }
 
-static bool is_same_freq(const double f1, const double f2)
-{
-    const double epsilon = 0.1;
-    return ((f1 - epsilon) < f2 and (f1 + epsilon) > f2);
+    //lo_frequency, correction_real, correction_imag
+    const uhd::csv::columns_type columns = uhd::csv::to_columns(cal_data, 3);
+    std::vector<uhd::usrp::fe_cal_point_t> datas(columns[0].size());
+    for (size_t i = 0; i < datas.size(); i++){
+        datas[i].lo_freq = columns[0][i];
+        datas[i].corr_real = columns[1][i];
+        datas[i].corr_imag = columns[2][i];
+    }
+    return fe_cal_table::make(datas);
 }
 
-static std::complex<double> get_fe_correction(
-    const std::string &key, const double lo_freq
-){
-    const std::vector<fe_cal_t> &datas = fe_cal_cache[key];
-    if (datas.empty()) throw uhd::runtime_error("empty calibration table " + key);
+static fe_cal_table::sptr get_fe_cal_table(const fs::path &cal_data_path){
+    const std::string key = cal_data_path.string();
+    {
+        const fe_cal_cache_sptr cache = get_fe_cal_cache();
+        if (cache->has_key(key)) return (*cache)[key];
+    }
 
-    //search for lo freq
-    size_t lo_index = 0;
-    size_t hi_index = datas.size()-1;
-    for (size_t i = 0; i < datas.size(); i++){
-        if (is_same_freq(datas[i].lo_freq, lo_freq))
-        {
-            hi_index = i;
-            lo_index = i;
-            break;
+    //not loaded yet: load under the lock, unless another thread just did
+    boost::mutex::scoped_lock l(corrections_mutex);
+    if (fe_cal_cache->has_key(key)) return (*fe_cal_cache)[key];
+
+    //prefer the binary table when it is at least as new as the csv
+    fe_cal_table::sptr table;
+    fs::path bin_path(cal_data_path);
+    bin_path.replace_extension(fe_cal_table::BIN_EXT);
+    if (fs::exists(bin_path) and fs::last_write_time(bin_path) >= fs::last_write_time(cal_data_path)){
+        try{
+            table = fe_cal_table::load(bin_path.string());
+            UHD_MSG(status) << "Loaded " << bin_path.string() << std::endl;
         }
-        if (datas[i].lo_freq > lo_freq){
-            hi_index = i;
-            break;
+        catch(const uhd::io_error &e){
+            UHD_MSG(warning) << e.what() << ", falling back to csv" << std::endl;
         }
-        lo_index = i;
     }
-
-    if (lo_index == 0) return std::complex<double>(datas[lo_index].iq_corr_real, datas[lo_index].iq_corr_imag);
-    if (hi_index == lo_index) return std::complex<double>(datas[hi_index].iq_corr_real, datas[hi_index].iq_corr_imag);
-
-    //interpolation time
-    return std::complex<double>(
-        linear_interp(lo_freq, datas[lo_index].lo_freq, datas[lo_index].iq_corr_real, datas[hi_index].lo_freq, datas[hi_index].iq_corr_real),
-        linear_interp(lo_freq, datas[lo_index].lo_freq, datas[lo_index].iq_corr_imag, datas[hi_index].lo_freq, datas[hi_index].iq_corr_imag)
-    );
+    if (not table){
+        table = load_fe_cal_csv(cal_data_path);
+        UHD_MSG(status) << "Loaded " << cal_data_path.string() << std::endl;
+    }
+    boost::shared_ptr<fe_cal_cache_type> cache(new fe_cal_cache_type(*fe_cal_cache));
+    (*cache)[key] = table;
+    set_fe_cal_cache(cache);
+    return table;
 }
 
 static void apply_fe_corrections(
@@ -107,38 +137,11 @@ static void apply_fe_corrections(
     const fs::path cal_data_path = fs::path(uhd::get_app_path()) / ".uhd" / "cal" / (file_prefix + db_eeprom.serial + ".csv");
     if (not fs::exists(cal_data_path)) return;
 
-    //parse csv file or get from cache
-    if (not fe_cal_cache.has_key(cal_data_path.string())){
-        std::ifstream cal_data(cal_data_path.string().c_str());
-        const uhd::csv::rows_type rows = uhd::csv::to_rows(cal_data);
-
-        bool read_data = false, skip_next = false;;
-        std::vector<fe_cal_t> datas;
-        BOOST_FOREACH(const uhd::csv::row_type &row, rows){
-            if (not read_data and not row.empty() and row[0] == "DATA STARTS HERE"){
-                read_data = true;
-                skip_next = true;
-                continue;
-            }
-            if (not read_data) continue;
-            if (skip_next){
-                skip_next = false;
-                continue;
-            }
-            fe_cal_t data;
-            std::sscanf(row[0].c_str(), "%lf" , &data.lo_freq);
-            std::sscanf(row[1].c_str(), "%lf" , &data.iq_corr_real);
-            std::sscanf(row[2].c_str(), "%lf" , &data.iq_corr_imag);
-            datas.push_back(data);
-        }
-        std::sort(datas.begin(), datas.end(), fe_cal_comp);
-        fe_cal_cache[cal_data_path.string()] = datas;
-        UHD_MSG(status) << "Loaded " << cal_data_path.string() << std::endl;
-
-    }
-
+    //tables are immutable once loaded and the cache is a published snapshot,
+    //so only the first lookup of a file takes the lock
+    const fe_cal_table::sptr table = get_fe_cal_table(cal_data_path);
     sub_tree->access<std::complex<double> >(fe_path)
-        .set(get_fe_correction(cal_data_path.string(), lo_freq));
+        .set(table->get_correction(lo_freq));
 }
 
 /***********************************************************************
@@ -149,7 +152,6 @@ void uhd::usrp::apply_tx_fe_corrections(
     const std::string &slot, //name of dboard slot
     const double lo_freq //actual lo freq
 ){
-    boost::mutex::scoped_lock l(corrections_mutex);
     try{
         apply_fe_corrections(
             sub_tree,
@@ -176,7 +178,6 @@ void uhd::usrp::apply_rx_fe_corrections(
     const std::string &slot, //name of dboard slot
     const double lo_freq //actual lo freq
 ){
-    boost::mutex::scoped_lock l(corrections_mutex);
     try{
         apply_fe_corrections(
             sub_tree,
@@ -64,7 +64,7 @@ public:
         while (_xport->get_recv_buff(0.0)){} //flush
         this->set_time(uhd::time_spec_t(0.0));
         this->set_tick_rate(1.0); //something possible but bogus
-        _msg_task = task::make(boost::bind(&fifo_ctrl_excelsior_impl::handle_msg, this));
+        _msg_task = task::make(boost::bind(&fifo_ctrl_excelsior_impl::handle_msg, this), "e100_fifo_ctrl");
         this->init_spi();
     }
 
@@ -80,6 +80,10 @@ public:
         return _async_fifo.pop_with_timed_wait(async_metadata, timeout);
     }
 
+    void push_async_msg(const async_metadata_t &async_metadata){
+        _async_fifo.push_with_pop_on_full(async_metadata);
+    }
+
     void handle_msg(void){
         set_thread_priority_safe();
         while (not boost::this_thread::interruption_requested()){
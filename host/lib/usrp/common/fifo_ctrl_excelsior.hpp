@@ -59,6 +59,9 @@ public:
 
     //! Pop an async message from the queue or timeout
     virtual bool pop_async_msg(uhd::async_metadata_t &async_metadata, double timeout) = 0;
+
+    //! Push a message into the async queue (drops the oldest when full)
+    virtual void push_async_msg(const uhd::async_metadata_t &async_metadata) = 0;
 };
 
 #endif /* INCLUDED_B200_CTRL_HPP */
@@ -0,0 +1,55 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "publish_stream_stats.hpp"
+#include <boost/format.hpp>
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+using namespace uhd;
+using namespace uhd::usrp;
+using namespace uhd::transport;
+
+void uhd::usrp::publish_stream_stats(
+    property_tree::sptr tree,
+    const std::string &type,
+    const std::vector<size_t> &channels,
+    const std::vector<std::string> &mboards,
+    sph::stream_stats_block::sptr stats
+){
+    //one transport channel per streamer channel, else every transport carries every channel
+    const bool xport_per_chan = (stats->xports.size() == channels.size());
+
+    for (size_t i = 0; i < channels.size(); i++){
+        const std::string mb = mboards.empty()? "0" : mboards.at(i);
+        const fs_path path = fs_path("/mboards") / mb / "streamers" / str(boost::format("%s%u") % type % channels[i]);
+        if (tree->exists(path)) tree->remove(path);
+
+        //the getters hold the stats block, not the streamer
+        tree->create<stream_stats_t>(path / "stats")
+            .publish(boost::bind(&sph::stream_stats_block::get_total, stats));
+        for (size_t x = 0; x < stats->xports.size(); x++){
+            if (xport_per_chan and x != i) continue;
+            const fs_path xport_path = path / "xports" / boost::lexical_cast<std::string>(x);
+            tree->create<stream_stats_t>(xport_path / "stats")
+                .publish(boost::bind(&sph::stream_stats_block::get_xport, stats, x));
+            if (not stats->has_fc_credit(x)) continue;
+            tree->create<size_t>(xport_path / "fc_credit")
+                .publish(boost::bind(&sph::stream_stats_block::get_fc_credit, stats, x));
+        }
+    }
+}
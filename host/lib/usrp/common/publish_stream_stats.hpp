@@ -0,0 +1,48 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_COMMON_PUBLISH_STREAM_STATS_HPP
+#define INCLUDED_LIBUHD_USRP_COMMON_PUBLISH_STREAM_STATS_HPP
+
+#include "../../transport/stream_stats_block.hpp"
+#include <uhd/config.hpp>
+#include <uhd/property_tree.hpp>
+#include <string>
+#include <vector>
+
+namespace uhd{ namespace usrp{
+
+    /*!
+     * Publish the statistics of a streamer into the property tree.
+     * Each channel of the streamer appears under
+     * /mboards/<mb>/streamers/<type><chan>: stats holds the totals of
+     * the whole streamer, and xports/<n>/stats the transport channels
+     * that carry this channel (with xports/<n>/fc_credit when the
+     * transport reports flow control credit).
+     * A streamer created later for the same channel replaces the entries.
+     */
+    void publish_stream_stats(
+        property_tree::sptr tree,
+        const std::string &type, //rx or tx
+        const std::vector<size_t> &channels, //the device channels of the streamer
+        const std::vector<std::string> &mboards, //the mboard of each channel, empty when all are on mboard 0
+        transport::sph::stream_stats_block::sptr stats
+    );
+
+}} //namespace uhd::usrp
+
+#endif /* INCLUDED_LIBUHD_USRP_COMMON_PUBLISH_STREAM_STATS_HPP */
@@ -86,8 +86,10 @@ public:
     boost::uint32_t peek32(const wb_addr_type addr)
     {
         boost::mutex::scoped_lock lock(_mutex);
+        const time_spec_t start = time_spec_t::get_system_time();
         this->send_pkt(SR_READBACK, addr/8);
         const boost::uint64_t res = this->wait_for_ack(true);
+        _rtt.add((time_spec_t::get_system_time() - start).get_real_secs());
         const boost::uint32_t lo = boost::uint32_t(res & 0xffffffff);
         const boost::uint32_t hi = boost::uint32_t(res >> 32);
         return ((addr/4) & 0x1)? hi : lo;
@@ -96,8 +98,11 @@ public:
     boost::uint64_t peek64(const wb_addr_type addr)
     {
         boost::mutex::scoped_lock lock(_mutex);
+        const time_spec_t start = time_spec_t::get_system_time();
         this->send_pkt(SR_READBACK, addr/8);
-        return this->wait_for_ack(true);
+        const boost::uint64_t res = this->wait_for_ack(true);
+        _rtt.add((time_spec_t::get_system_time() - start).get_real_secs());
+        return res;
     }
 
     /*******************************************************************
@@ -117,6 +122,12 @@ public:
         _tick_rate = rate;
     }
 
+    uhd::time_histogram_t get_rtt_stats(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        return _rtt;
+    }
+
 private:
     // This is the buffer type for messages in radio control core.
     struct resp_buff_type
@@ -326,6 +337,7 @@ private:
     bool _use_time;
     double _tick_rate;
     double _timeout;
+    uhd::time_histogram_t _rtt;
     std::queue<size_t> _outstanding_seqs;
     bounded_buffer<resp_buff_type> _resp_queue;
     const size_t _resp_queue_size;
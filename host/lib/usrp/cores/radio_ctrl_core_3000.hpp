@@ -20,6 +20,7 @@
 
 #include <uhd/utils/msg_task.hpp>
 #include <uhd/types/time_spec.hpp>
+#include <uhd/types/stream_stats.hpp>
 #include <uhd/transport/zero_copy.hpp>
 #include <uhd/types/wb_iface.hpp>
 #include <boost/shared_ptr.hpp>
@@ -56,6 +57,9 @@ public:
 
     //! Set the tick rate (converting time into ticks)
     virtual void set_tick_rate(const double rate) = 0;
+
+    //! Get the round-trip times of readback transactions
+    virtual uhd::time_histogram_t get_rtt_stats(void) = 0;
 };
 
 #endif /* INCLUDED_LIBUHD_USRP_RADIO_CTRL_3000_HPP */
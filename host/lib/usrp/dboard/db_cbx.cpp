@@ -57,8 +57,8 @@ double sbx_xcvr::cbx::set_lo_freq(dboard_iface::unit_t unit, double target_freq)
     device_addr_t tune_args = subtree->access<device_addr_t>("tune_args").get();
     bool is_int_n = boost::iequals(tune_args.get("mode_n",""), "integer");
 
-    //clip the input
-    target_freq = cbx_freq_range.clip(target_freq);
+    //clip the input (after moving to the LO grid, if the user asked for one)
+    target_freq = cbx_freq_range.clip(adf435x_align_to_grid(tune_args, target_freq));
 
     //map mode setting to valid integer divider (N) values
     static const uhd::range_t int_n_mode_div_range(16,4095,1);
@@ -207,11 +207,13 @@ double sbx_xcvr::cbx::set_lo_freq(dboard_iface::unit_t unit, double target_freq)
     regs.ldf = ldf;
     regs.cpoc = cpoc;
 
-    //write the registers
+    //write the registers that changed
     //correct power-up sequence to write registers (5, 4, 3, 2, 1, 0)
+    adf435x_reg_shadow &shadow = synth_regs[unit];
     int addr;
 
     for(addr=5; addr>=0; addr--){
+        if (not shadow.needs_write(addr, regs.get_reg(addr))) continue;
         UHD_LOGV(often) << boost::format(
             "%s SPI Reg (0x%02x): 0x%08x"
         ) % board_name.c_str() % addr % regs.get_reg(addr) << std::endl;
@@ -219,6 +221,7 @@ double sbx_xcvr::cbx::set_lo_freq(dboard_iface::unit_t unit, double target_freq)
             unit, spi_config_t::EDGE_RISE,
             regs.get_reg(addr), 32
         );
+        shadow.written(addr, regs.get_reg(addr));
     }
 
     //return the actual frequency
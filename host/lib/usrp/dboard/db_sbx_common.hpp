@@ -175,6 +175,9 @@ protected:
         virtual ~sbx_versionx(void) {}
 
         virtual double set_lo_freq(dboard_iface::unit_t unit, double target_freq) = 0;
+
+        /*! The synthesizer registers last written, per unit. */
+        uhd::dict<dboard_iface::unit_t, adf435x_reg_shadow> synth_regs;
     };
 
     /*!
@@ -131,6 +131,8 @@ void wbx_base::set_rx_enabled(bool enb){
     this->get_iface()->set_gpio_out(dboard_iface::UNIT_RX,
         (enb)? RX_POWER_UP : RX_POWER_DOWN, RX_POWER_UP | RX_POWER_DOWN
     );
+    //program the whole synthesizer again once its supply returns
+    if (not enb and db_actual) db_actual->synth_regs[dboard_iface::UNIT_RX].invalidate();
 }
 
 /***********************************************************************
@@ -135,6 +135,9 @@ protected:
         /*! This is the registered instance of the wrapper class, wbx_base. */
         wbx_base *self_base;
 
+        /*! The synthesizer registers last written, per unit. */
+        uhd::dict<dboard_iface::unit_t, adf435x_reg_shadow> synth_regs;
+
         property_tree::sptr get_rx_subtree(void){
             return self_base->get_rx_subtree();
         }
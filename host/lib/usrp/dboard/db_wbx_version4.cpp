@@ -173,6 +173,8 @@ wbx_base::wbx_version4::~wbx_version4(void){
 void wbx_base::wbx_version4::set_tx_enabled(bool enb) {
     self_base->get_iface()->set_gpio_out(dboard_iface::UNIT_TX,
         (enb)? TX_POWER_UP | ADF435X_CE : TX_POWER_DOWN, TX_POWER_UP | TX_POWER_DOWN | 0);
+    //program the whole synthesizer again once its supply returns
+    if (not enb) synth_regs[dboard_iface::UNIT_TX].invalidate();
 }
 
 
@@ -218,6 +220,9 @@ double wbx_base::wbx_version4::set_lo_freq(dboard_iface::unit_t unit, double tar
     device_addr_t tune_args = subtree->access<device_addr_t>("tune_args").get();
     bool is_int_n = boost::iequals(tune_args.get("mode_n",""), "integer");
 
+    //move to the LO grid, if the user asked for one
+    target_freq = wbx_v4_freq_range.clip(adf435x_align_to_grid(tune_args, target_freq));
+
     //map prescaler setting to mininmum integer divider (N) values (pg.18 prescaler)
     static const uhd::dict<int, int> prescaler_to_min_int_div = map_list_of
         (0,23) //adf4351_regs_t::PRESCALER_4_5
@@ -299,18 +304,23 @@ double wbx_base::wbx_version4::set_lo_freq(dboard_iface::unit_t unit, double tar
                                     adf4351_regs_t::LDF_INT_N :
                                     adf4351_regs_t::LDF_FRAC_N;
 
-    //reset the N and R counter
-    regs.counter_reset = adf4351_regs_t::COUNTER_RESET_ENABLED;
-    self_base->get_iface()->write_spi(unit, spi_config_t::EDGE_RISE, regs.get_reg(2), 32);
-    regs.counter_reset = adf4351_regs_t::COUNTER_RESET_DISABLED;
+    //reset the N and R counter, unless only the frequency words change
+    adf435x_reg_shadow &shadow = synth_regs[unit];
+    if (shadow.needs_counter_reset(regs.get_reg(1), regs.get_reg(2))) {
+        regs.counter_reset = adf4351_regs_t::COUNTER_RESET_ENABLED;
+        self_base->get_iface()->write_spi(unit, spi_config_t::EDGE_RISE, regs.get_reg(2), 32);
+        shadow.written(2, regs.get_reg(2)); //so the release below is written
+        regs.counter_reset = adf4351_regs_t::COUNTER_RESET_DISABLED;
+    }
 
-    //write the registers
+    //write the registers that changed
     //correct power-up sequence to write registers (5, 4, 3, 2, 1, 0)
     int addr;
 
     boost::uint16_t rx_id = self_base->get_rx_id().to_uint16();
     std::string board_name = (rx_id == 0x0081) ? "WBX-120" : "WBX";
     for(addr=5; addr>=0; addr--){
+        if (not shadow.needs_write(addr, regs.get_reg(addr))) continue;
         UHD_LOGV(often) << boost::format(
             "%s SPI Reg (0x%02x): 0x%08x"
         ) % board_name.c_str() % addr % regs.get_reg(addr) << std::endl;
@@ -318,6 +328,7 @@ double wbx_base::wbx_version4::set_lo_freq(dboard_iface::unit_t unit, double tar
             unit, spi_config_t::EDGE_RISE,
             regs.get_reg(addr), 32
         );
+        shadow.written(addr, regs.get_reg(addr));
     }
 
     //return the actual frequency
@@ -224,6 +224,10 @@ e100_impl::e100_impl(const uhd::device_addr_t &device_addr){
     _tree->create<time_spec_t>(mb_path / "time/cmd")
         .subscribe(boost::bind(&fifo_ctrl_excelsior::set_time, _fifo_ctrl, _1));
 
+    //host side messages for recv_async_msg()
+    _tree->create<async_metadata_t>(mb_path / "async_msg")
+        .subscribe(boost::bind(&fifo_ctrl_excelsior::push_async_msg, _fifo_ctrl, _1));
+
     ////////////////////////////////////////////////////////////////////
     // create codec control objects
     ////////////////////////////////////////////////////////////////////
@@ -16,6 +16,7 @@
 //
 
 #include "validate_subdev_spec.hpp"
+#include "publish_stream_stats.hpp"
 #include "async_packet_handler.hpp"
 #include "../../transport/super_recv_packet_handler.hpp"
 #include "../../transport/super_send_packet_handler.hpp"
@@ -174,6 +175,9 @@ rx_streamer::sptr e100_impl::get_rx_stream(const uhd::stream_args_t &args_){
     //sets all tick and samp rates on this streamer
     this->update_rates();
 
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "rx", args.channels, std::vector<std::string>(), my_streamer->get_stats_block());
+
     return my_streamer;
 }
 
@@ -229,5 +233,8 @@ tx_streamer::sptr e100_impl::get_tx_stream(const uhd::stream_args_t &args_){
     //sets all tick and samp rates on this streamer
     this->update_rates();
 
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "tx", args.channels, std::vector<std::string>(), my_streamer->get_stats_block());
+
     return my_streamer;
 }
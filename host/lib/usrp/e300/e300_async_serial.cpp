@@ -16,9 +16,16 @@
 //
 
 #include "e300_async_serial.hpp"
+#include <uhd/utils/thread_role.hpp>
 
 namespace uhd { namespace usrp { namespace gps {
 
+static void run_io_service(boost::asio::io_service *io)
+{
+    uhd::apply_thread_role("e300_gps_serial");
+    io->run();
+}
+
 async_serial::async_serial()
     : _io(),
       _port(_io),
@@ -66,7 +73,7 @@ void async_serial::open(
 
     _io.post(boost::bind(&async_serial::_do_read, this));
 
-    boost::thread t(boost::bind(&boost::asio::io_service::run, &_io));
+    boost::thread t(boost::bind(&run_io_service, &_io));
     _background_thread.swap(t);
     _set_error_status(false);
     _open=true;
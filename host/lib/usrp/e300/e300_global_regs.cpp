@@ -18,6 +18,7 @@
 #include "e300_global_regs.hpp"
 
 #include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/utils/byteswap.hpp>
 #include <cstring>
@@ -73,7 +74,7 @@ global_regs::sptr global_regs::make(const size_t ctrl_base)
 class global_regs_zc_impl : public global_regs
 {
 public:
-    global_regs_zc_impl(uhd::transport::zero_copy_if::sptr xport) : _xport(xport)
+    global_regs_zc_impl(uhd::transport::zero_copy_if::sptr xport) : _xport(xport), _seq(0)
     {
     }
 
@@ -83,44 +84,53 @@ public:
 
     boost::uint32_t peek32(const uhd::wb_iface::wb_addr_type addr)
     {
+        boost::mutex::scoped_lock lock(_mutex);
         global_regs_transaction_t transaction;
         transaction.is_poke = uhd::htonx<boost::uint32_t>(0);
         transaction.addr    = uhd::htonx<boost::uint32_t>(
             static_cast<boost::uint32_t>(addr));
-        {
-            uhd::transport::managed_send_buffer::sptr buff = _xport->get_send_buff(10.0);
-            if (not buff or buff->size() < sizeof(transaction))
-                throw std::runtime_error("global_regs_zc_impl send timeout");
-            std::memcpy(buff->cast<void *>(), &transaction, sizeof(transaction));
-            buff->commit(sizeof(transaction));
-        }
-        {
+        transaction.data    = 0;
+        transaction.seq     = uhd::htonx<boost::uint32_t>(++_seq);
+        _send(transaction);
+        //the response to a peek given up on before is dropped
+        global_regs_transaction_t response;
+        do {
             uhd::transport::managed_recv_buffer::sptr buff = _xport->get_recv_buff(10.0);
-            if (not buff or buff->size() < sizeof(transaction))
+            if (not buff)
                 throw std::runtime_error("global_regs_zc_impl recv timeout");
-            std::memcpy(&transaction, buff->cast<const void *>(), sizeof(transaction));
-        }
-        return uhd::ntohx<boost::uint32_t>(transaction.data);
+            if (buff->size() < sizeof(response))
+                continue;
+            std::memcpy(&response, buff->cast<const void *>(), sizeof(response));
+        } while (response.seq != transaction.seq);
+        return uhd::ntohx<boost::uint32_t>(response.data);
     }
 
     void poke32(const uhd::wb_iface::wb_addr_type addr, const boost::uint32_t data)
     {
+        boost::mutex::scoped_lock lock(_mutex);
         global_regs_transaction_t transaction;
         transaction.is_poke = uhd::htonx<boost::uint32_t>(1);
         transaction.addr    = uhd::htonx<boost::uint32_t>(
             static_cast<boost::uint32_t>(addr));
         transaction.data    = uhd::htonx<boost::uint32_t>(data);
-        {
-            uhd::transport::managed_send_buffer::sptr buff = _xport->get_send_buff(10.0);
-            if (not buff or buff->size() < sizeof(transaction))
-                throw uhd::runtime_error("global_regs_zc_impl send timeout");
-            std::memcpy(buff->cast<void *>(), &transaction, sizeof(transaction));
-            buff->commit(sizeof(transaction));
-        }
+        transaction.seq     = uhd::htonx<boost::uint32_t>(++_seq);
+        //pokes are not answered, a burst of them streams out
+        _send(transaction);
     }
 
 private:
+    void _send(const global_regs_transaction_t &transaction)
+    {
+        uhd::transport::managed_send_buffer::sptr buff = _xport->get_send_buff(10.0);
+        if (not buff or buff->size() < sizeof(transaction))
+            throw uhd::runtime_error("global_regs_zc_impl send timeout");
+        std::memcpy(buff->cast<void *>(), &transaction, sizeof(transaction));
+        buff->commit(sizeof(transaction));
+    }
+
     uhd::transport::zero_copy_if::sptr _xport;
+    boost::mutex _mutex;
+    boost::uint32_t _seq;
 };
 
 global_regs::sptr global_regs::make(uhd::transport::zero_copy_if::sptr xport)
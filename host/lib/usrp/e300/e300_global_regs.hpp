@@ -27,7 +27,7 @@ struct global_regs_transaction_t {
     boost::uint32_t is_poke;
     boost::uint32_t addr;
     boost::uint32_t data;
-    boost::uint32_t pad;
+    boost::uint32_t seq; //echoed in the response to a peek
 };
 
 class global_regs : boost::noncopyable, public virtual uhd::wb_iface
@@ -336,8 +336,13 @@ e300_impl::e300_impl(const uhd::device_addr_t &device_addr)
     udp_zero_copy::buff_params dummy_buff_params_out;
 
     if (_xport_path == ETH) {
+        //a codec packet holds a batch of transactions
+        zero_copy_xport_params codec_xport_params = _ctrl_xport_params;
+        codec_xport_params.recv_frame_size = e300_remote_codec_ctrl::packet_t::size(
+            e300_remote_codec_ctrl::packet_t::MAX_TRANSACTIONS);
+        codec_xport_params.send_frame_size = codec_xport_params.recv_frame_size;
         zero_copy_if::sptr codec_xport =
-            udp_zero_copy::make(device_addr["addr"], E300_SERVER_CODEC_PORT, _ctrl_xport_params, dummy_buff_params_out, device_addr);
+            udp_zero_copy::make(device_addr["addr"], E300_SERVER_CODEC_PORT, codec_xport_params, dummy_buff_params_out, device_addr);
         _codec_ctrl = e300_remote_codec_ctrl::make(codec_xport);
         zero_copy_if::sptr gregs_xport =
             udp_zero_copy::make(device_addr["addr"], E300_SERVER_GREGS_PORT, _ctrl_xport_params, dummy_buff_params_out, device_addr);
@@ -372,6 +377,9 @@ e300_impl::e300_impl(const uhd::device_addr_t &device_addr)
         // This is horrible ... why do I have to sleep here?
         boost::this_thread::sleep(boost::posix_time::milliseconds(100));
         _eeprom_manager = boost::make_shared<e300_eeprom_manager>(i2c::make_i2cdev(E300_I2CDEV_DEVICE));
+        if (device_addr.has_key("codec_cal_cache"))
+            _codec_ctrl->set_calibration_cache_file(ad9361_ctrl::get_calibration_cache_file(
+                _eeprom_manager->get_mb_eeprom()["serial"]));
     }
 
     UHD_MSG(status) << "Detecting internal GPSDO.... " << std::flush;
@@ -447,8 +455,10 @@ e300_impl::e300_impl(const uhd::device_addr_t &device_addr)
         .subscribe(boost::bind(&e300_impl::_update_tick_rate, this, _1));
 
     //default some chains on -- needed for setup purposes
+    _codec_ctrl->begin_batch();
     _codec_ctrl->set_active_chains(true, false, true, false);
     _codec_ctrl->set_clock_rate(50e6);
+    _codec_ctrl->end_batch();
 
     ////////////////////////////////////////////////////////////////////
     // setup radios
@@ -491,6 +501,9 @@ e300_impl::e300_impl(const uhd::device_addr_t &device_addr)
         .publish(boost::bind(&time_core_3000::get_time_last_pps, _radio_perifs[0].time64))
         .subscribe(boost::bind(&time_core_3000::set_time_next_pps, _radio_perifs[0].time64, _1))
         .subscribe(boost::bind(&time_core_3000::set_time_next_pps, _radio_perifs[1].time64, _1));
+    //host side messages for recv_async_msg()
+    _tree->create<async_metadata_t>(mb_path / "async_msg")
+        .subscribe(boost::bind(&async_md_type::push_with_pop_on_full, _async_md, _1));
     //setup time source props
     _tree->create<std::string>(mb_path / "time_source" / "value")
         .subscribe(boost::bind(&e300_impl::_update_time_source, this, _1));
@@ -528,6 +541,9 @@ e300_impl::e300_impl(const uhd::device_addr_t &device_addr)
         const fs_path codec_path = mb_path / ("rx_codecs") / "A";
         _tree->create<std::string>(codec_path / "name").set("E3x0 RX dual ADC");
         _tree->create<int>(codec_path / "gains"); //empty cuz gains are in frontend
+        //one cache for the RX and TX calibrations of the codec
+        _tree->create<bool>(codec_path / "cal_cache" / "invalidate")
+            .subscribe(boost::bind(&ad9361_ctrl::invalidate_calibration_cache, _codec_ctrl));
     }
     {
         const fs_path codec_path = mb_path / ("tx_codecs") / "A";
@@ -978,6 +994,8 @@ void e300_impl::_setup_radio(const size_t dspno)
         ctrl_sid,
         dspno ? "1" : "0");
     this->_register_loopback_self_test(perif.ctrl);
+    _tree->create<time_histogram_t>(mb_path / "radio_ctrl" / (dspno ? "1" : "0") / "rtt")
+        .publish(boost::bind(&radio_ctrl_core_3000::get_rtt_stats, perif.ctrl));
     perif.atr = gpio_core_200_32wo::make(perif.ctrl, TOREG(SR_GPIO));
 
     ////////////////////////////////////////////////////////////////////
@@ -1096,6 +1114,8 @@ void e300_impl::_setup_radio(const size_t dspno)
             .set(e300::DEFAULT_FE_FREQ);
         _tree->create<meta_range_t>(rf_fe_path / "freq" / "range")
             .publish(boost::bind(&ad9361_ctrl::get_rf_freq_range));
+        _tree->create<size_t>(rf_fe_path / "fast_lock" / "store")
+            .subscribe(boost::bind(&ad9361_ctrl::store_fastlock_profile, _codec_ctrl, key, _1));
 
         //setup antenna stuff
         if (key[0] == 'R') {
@@ -1125,11 +1145,13 @@ void e300_impl::_update_enables(void)
     const size_t num_tx = (enb_tx1 ? 1 : 0) + (enb_tx2 ? 1:0);
     const bool mimo = num_rx == 2 or num_tx == 2;
 
-    //setup the active chains in the codec
+    //setup the active chains in the codec, in one round trip over the network
+    _codec_ctrl->begin_batch();
     _codec_ctrl->set_active_chains(enb_tx1, enb_tx2, enb_rx1, enb_rx2);
     if ((num_rx + num_tx) == 0)
         _codec_ctrl->set_active_chains(
             true, false, true, false); // enable something
+    _codec_ctrl->end_batch();
 
     //set_active_chains could cause a clock rate change - reset dcm
     _reset_codec_mmcm();
@@ -19,12 +19,14 @@
 #include "e300_impl.hpp"
 #include "e300_fpga_defs.hpp"
 #include "validate_subdev_spec.hpp"
+#include "publish_stream_stats.hpp"
 #include "../../transport/super_recv_packet_handler.hpp"
 #include "../../transport/super_send_packet_handler.hpp"
 #include "async_packet_handler.hpp"
 #include <uhd/transport/bounded_buffer.hpp>
 #include <boost/bind.hpp>
 #include <uhd/utils/tasks.hpp>
+#include <uhd/utils/atomic.hpp>
 #include <boost/foreach.hpp>
 #include <boost/make_shared.hpp>
 
@@ -287,13 +289,12 @@ struct e300_tx_fc_cache_t
     e300_tx_fc_cache_t(void):
         stream_channel(0),
         device_channel(0),
-        last_seq_out(0),
-        last_seq_ack(0),
         seq_queue(1){}
     size_t stream_channel;
     size_t device_channel;
-    size_t last_seq_out;
-    size_t last_seq_ack;
+    //written by the sending thread only, atomic for the credit reads of the statistics
+    uhd::atomic_uint32_t last_seq_out;
+    uhd::atomic_uint32_t last_seq_ack;
     bounded_buffer<size_t> seq_queue;
     boost::shared_ptr<e300_impl::async_md_type> async_queue;
     boost::shared_ptr<e300_impl::async_md_type> old_async_queue;
@@ -369,23 +370,33 @@ static managed_send_buffer::sptr get_tx_buff_with_flowctrl(
 ){
     while (true)
     {
-        const size_t delta = (fc_cache->last_seq_out & HW_SEQ_NUM_MASK) - (fc_cache->last_seq_ack & HW_SEQ_NUM_MASK);
+        const size_t delta = (fc_cache->last_seq_out.read() & HW_SEQ_NUM_MASK) - (fc_cache->last_seq_ack.read() & HW_SEQ_NUM_MASK);
         if ((delta & HW_SEQ_NUM_MASK) <= fc_window)
             break;
 
-        const bool ok = fc_cache->seq_queue.pop_with_timed_wait(fc_cache->last_seq_ack, timeout);
+        size_t seq_ack;
+        const bool ok = fc_cache->seq_queue.pop_with_timed_wait(seq_ack, timeout);
         if (not ok)
             return managed_send_buffer::sptr(); //timeout waiting for flow control
+        fc_cache->last_seq_ack.write(boost::uint32_t(seq_ack));
     }
 
     managed_send_buffer::sptr buff = xport->get_send_buff(timeout);
     if (buff) {
-        fc_cache->last_seq_out++; //update seq, this will actually be a send
+        fc_cache->last_seq_out.write(fc_cache->last_seq_out.read() + 1); //update seq, this will actually be a send
     }
 
     return buff;
 }
 
+static size_t get_tx_fc_credit(
+    boost::shared_ptr<e300_tx_fc_cache_t> fc_cache,
+    const size_t fc_window
+){
+    const size_t delta = ((fc_cache->last_seq_out.read() & HW_SEQ_NUM_MASK) - (fc_cache->last_seq_ack.read() & HW_SEQ_NUM_MASK)) & HW_SEQ_NUM_MASK;
+    return (delta <= fc_window)? fc_window + 1 - delta : 0;
+}
+
 /***********************************************************************
  * Async Data
  **********************************************************************/
@@ -488,6 +499,10 @@ rx_streamer::sptr e300_impl::get_rx_stream(const uhd::stream_args_t &args_)
 
     }
     _update_enables();
+
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "rx", args.channels, std::vector<std::string>(), my_streamer->get_stats_block());
+
     return my_streamer;
 }
 
@@ -575,12 +590,15 @@ tx_streamer::sptr e300_impl::get_tx_stream(const uhd::stream_args_t &args_)
 
         task::sptr task = task::make(boost::bind(&handle_tx_async_msgs,
                                                  fc_cache, data_xports.recv,
-                                                 get_tick_rate_fn));
+                                                 get_tick_rate_fn), "e300_tx_async");
 
         my_streamer->set_xport_chan_get_buff(
             stream_i,
             boost::bind(&get_tx_buff_with_flowctrl, task, fc_cache, data_xports.send, fc_window, _1)
         );
+        my_streamer->set_xport_chan_fc_credit(
+            stream_i, boost::bind(&get_tx_fc_credit, fc_cache, fc_window)
+        );
 
         my_streamer->set_async_receiver(
             boost::bind(&async_md_type::pop_with_timed_wait, async_md, _1, _2)
@@ -594,6 +612,10 @@ tx_streamer::sptr e300_impl::get_tx_stream(const uhd::stream_args_t &args_)
         _tree->access<double>(str(boost::format("/mboards/0/tx_dsps/%u/rate/value") % radio_index)).update();
     }
     _update_enables();
+
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "tx", args.channels, std::vector<std::string>(), my_streamer->get_stats_block());
+
     return my_streamer;
 }
 }}} // namespace
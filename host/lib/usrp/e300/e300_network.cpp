@@ -30,8 +30,10 @@
 #include "e300_defaults.hpp"
 #include "e300_common.hpp"
 #include "e300_remote_codec_ctrl.hpp"
+#include "../../transport/udp_tunnel.hpp"
 
 #include <uhd/utils/msg.hpp>
+#include <uhd/utils/thread_role.hpp>
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/utils/images.hpp>
 
@@ -40,6 +42,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/make_shared.hpp>
 
+#include <algorithm>
 #include <fstream>
 
 using namespace uhd;
@@ -51,53 +54,27 @@ namespace uhd { namespace usrp { namespace e300 {
 
 static const size_t E300_NETWORK_DEBUG = false;
 
-static inline bool wait_for_recv_ready(int sock_fd, const size_t timeout_ms)
-{
-    //setup timeval for timeout
-    timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = timeout_ms*1000;
-
-    //setup rset for timeout
-    fd_set rset;
-    FD_ZERO(&rset);
-    FD_SET(sock_fd, &rset);
-
-    //call select with timeout on receive socket
-    return ::select(sock_fd+1, &rset, NULL, NULL, &tv) > 0;
-}
-
-static boost::mutex endpoint_mutex;
-
 /***********************************************************************
  * Receive tunnel - forwards recv interface to send socket
  **********************************************************************/
 static void e300_recv_tunnel(
     const std::string &name,
+    const std::string &role,
     uhd::transport::zero_copy_if::sptr recver,
     boost::shared_ptr<asio::ip::udp::socket> sender,
-    asio::ip::udp::endpoint *endpoint,
+    udp_tunnel_endpoint *endpoint,
+    const size_t max_burst,
     bool *running
 )
 {
-    asio::ip::udp::endpoint _tx_endpoint;
+    uhd::apply_thread_role(role);
     try
     {
+        udp_tunnel_to_socket tunnel(recver, sender->native(), *endpoint, max_burst);
         while (*running)
         {
-            //step 1 - get the buffer
-            managed_recv_buffer::sptr buff = recver->get_recv_buff();
-            if (not buff) continue;
-            if (E300_NETWORK_DEBUG) UHD_MSG(status) << name << " got " << buff->size() << std::endl;
-
-            //step 1.5 -- update endpoint
-            {
-                boost::mutex::scoped_lock l(endpoint_mutex);
-                _tx_endpoint = *endpoint;
-            }
-
-            //step 2 - send to the socket
-            sender->send_to(asio::buffer(buff->cast<const void *>(), buff->size()), _tx_endpoint);
+            const size_t num_packets = tunnel.forward(0.1);
+            if (E300_NETWORK_DEBUG and num_packets) UHD_MSG(status) << name << " forwarded " << num_packets << std::endl;
         }
     }
     catch(const std::exception &ex)
@@ -117,35 +94,22 @@ static void e300_recv_tunnel(
  **********************************************************************/
 static void e300_send_tunnel(
     const std::string &name,
+    const std::string &role,
     boost::shared_ptr<asio::ip::udp::socket> recver,
     uhd::transport::zero_copy_if::sptr sender,
-    asio::ip::udp::endpoint *endpoint,
+    udp_tunnel_endpoint *endpoint,
+    const size_t max_burst,
     bool *running
 )
 {
-    asio::ip::udp::endpoint _rx_endpoint;
+    uhd::apply_thread_role(role);
     try
     {
+        udp_tunnel_from_socket tunnel(recver->native(), sender, *endpoint, max_burst);
         while (*running)
         {
-            //step 1 - get the buffer
-            managed_send_buffer::sptr buff = sender->get_send_buff();
-            if (not buff) continue;
-
-            //step 2 - recv from socket
-            while (not wait_for_recv_ready(recver->native(), 100) and *running){}
-            if (not *running) break;
-            const size_t num_bytes = recver->receive_from(asio::buffer(buff->cast<void *>(), buff->size()), _rx_endpoint);
-            if (E300_NETWORK_DEBUG) UHD_MSG(status) << name << " got " << num_bytes << std::endl;
-
-            //step 2.5 -- update endpoint
-            {
-                boost::mutex::scoped_lock l(endpoint_mutex);
-                *endpoint = _rx_endpoint;
-            }
-
-            //step 3 - commit the buffer
-            buff->commit(num_bytes);
+            const size_t num_packets = tunnel.forward(0.1);
+            if (E300_NETWORK_DEBUG and num_packets) UHD_MSG(status) << name << " forwarded " << num_packets << std::endl;
         }
     }
     catch(const std::exception &ex)
@@ -160,6 +124,69 @@ static void e300_send_tunnel(
     *running = false;
 }
 
+/***********************************************************************
+ * CODEC tunnel - runs the transactions of a packet in order, one response
+ **********************************************************************/
+typedef e300_remote_codec_ctrl::transaction_t codec_xact_t;
+typedef e300_remote_codec_ctrl::packet_t codec_packet_t;
+
+static void e300_codec_ctrl_transact(
+    ad9361_ctrl::sptr _codec_ctrl,
+    const codec_xact_t *in,
+    codec_xact_t *out
+)
+{
+    std::memcpy(out, in, sizeof(codec_xact_t));
+
+    std::string which_str;
+    switch (uhd::ntohx<boost::uint32_t>(in->which)) {
+    case codec_xact_t::CHAIN_TX1:
+        which_str = "TX1"; break;
+    case codec_xact_t::CHAIN_TX2:
+        which_str = "TX2"; break;
+    case codec_xact_t::CHAIN_RX1:
+        which_str = "RX1"; break;
+    case codec_xact_t::CHAIN_RX2:
+        which_str = "RX2"; break;
+    default:
+        which_str = ""; break;
+    }
+
+    switch (uhd::ntohx<boost::uint32_t>(in->action)) {
+    case codec_xact_t::ACTION_SET_GAIN:
+        out->gain = _codec_ctrl->set_gain(which_str, in->gain);
+        break;
+    case codec_xact_t::ACTION_SET_CLOCK_RATE:
+        out->rate = _codec_ctrl->set_clock_rate(in->rate);
+        break;
+    case codec_xact_t::ACTION_SET_ACTIVE_CHANS:
+        _codec_ctrl->set_active_chains(
+            uhd::ntohx<boost::uint32_t>(in->bits) & (1<<0),
+            uhd::ntohx<boost::uint32_t>(in->bits) & (1<<1),
+            uhd::ntohx<boost::uint32_t>(in->bits) & (1<<2),
+            uhd::ntohx<boost::uint32_t>(in->bits) & (1<<3));
+        break;
+    case codec_xact_t::ACTION_TUNE:
+        out->freq = _codec_ctrl->tune(which_str, in->freq);
+        break;
+    case codec_xact_t::ACTION_STORE_FASTLOCK:
+        _codec_ctrl->store_fastlock_profile(which_str,
+            uhd::ntohx<boost::uint32_t>(in->bits));
+        break;
+    case codec_xact_t::ACTION_INVALIDATE_CAL_CACHE:
+        _codec_ctrl->invalidate_calibration_cache();
+        break;
+    case codec_xact_t::ACTION_SET_LOOPBACK:
+        _codec_ctrl->data_port_loopback(
+            uhd::ntohx<boost::uint32_t>(in->bits) & 1);
+        break;
+    default:
+        UHD_MSG(status) << "Got unknown request?!" << std::endl;
+        //Zero out actions to fail this request on client
+        out->action = uhd::htonx<boost::uint32_t>(0);
+    }
+}
+
 static void e300_codec_ctrl_tunnel(
     const std::string &name,
     boost::shared_ptr<asio::ip::udp::socket> socket,
@@ -168,69 +195,33 @@ static void e300_codec_ctrl_tunnel(
     bool *running
 )
 {
+    uhd::apply_thread_role("e300_tunnel");
     asio::ip::udp::endpoint _endpoint;
     try
     {
         while (*running)
         {
-            uint8_t in_buff[64] = {};
-            uint8_t out_buff[64] = {};
+            codec_packet_t in;
+            codec_packet_t out;
 
-            const size_t num_bytes = socket->receive_from(asio::buffer(in_buff), *endpoint);
+            const size_t num_bytes = socket->receive_from(asio::buffer(&in, sizeof(in)), *endpoint);
 
-            typedef e300_remote_codec_ctrl::transaction_t codec_xact_t;
-
-            if (num_bytes < sizeof(codec_xact_t)) {
-                std::cout << "Received short packet of " << num_bytes  << std::endl;
+            if (num_bytes < codec_packet_t::size(0)) {
+                UHD_MSG(warning) << "Received short packet of " << num_bytes << std::endl;
                 continue;
             }
 
-            codec_xact_t *in = reinterpret_cast<codec_xact_t*>(in_buff);
-            codec_xact_t *out = reinterpret_cast<codec_xact_t*>(out_buff);
-            std::memcpy(out, in, sizeof(codec_xact_t));
-
-            std::string which_str;
-            switch (uhd::ntohx<boost::uint32_t>(in->which)) {
-            case codec_xact_t::CHAIN_TX1:
-                which_str = "TX1"; break;
-            case codec_xact_t::CHAIN_TX2:
-                which_str = "TX2"; break;
-            case codec_xact_t::CHAIN_RX1:
-                which_str = "RX1"; break;
-            case codec_xact_t::CHAIN_RX2:
-                which_str = "RX2"; break;
-            default:
-                which_str = ""; break;
-            }
+            //a packet cut short runs the transactions that it holds
+            const size_t num_transactions = std::min(
+                size_t(uhd::ntohx<boost::uint32_t>(in.num_transactions)),
+                (num_bytes - codec_packet_t::size(0))/sizeof(codec_xact_t));
 
-            switch (uhd::ntohx<boost::uint32_t>(in->action)) {
-            case codec_xact_t::ACTION_SET_GAIN:
-                out->gain = _codec_ctrl->set_gain(which_str, in->gain);
-                break;
-            case codec_xact_t::ACTION_SET_CLOCK_RATE:
-                out->rate = _codec_ctrl->set_clock_rate(in->rate);
-                break;
-            case codec_xact_t::ACTION_SET_ACTIVE_CHANS:
-                _codec_ctrl->set_active_chains(
-                    uhd::ntohx<boost::uint32_t>(in->bits) & (1<<0),
-                    uhd::ntohx<boost::uint32_t>(in->bits) & (1<<1),
-                    uhd::ntohx<boost::uint32_t>(in->bits) & (1<<2),
-                    uhd::ntohx<boost::uint32_t>(in->bits) & (1<<3));
-                break;
-            case codec_xact_t::ACTION_TUNE:
-                out->freq = _codec_ctrl->tune(which_str, in->freq);
-                break;
-            case codec_xact_t::ACTION_SET_LOOPBACK:
-                _codec_ctrl->data_port_loopback(
-                    uhd::ntohx<boost::uint32_t>(in->bits) & 1);
-                break;
-            default:
-                UHD_MSG(status) << "Got unknown request?!" << std::endl;
-                //Zero out actions to fail this request on client
-                out->action = uhd::htonx<boost::uint32_t>(0);
-            }
+            out.seq = in.seq;
+            out.num_transactions = uhd::htonx<boost::uint32_t>(boost::uint32_t(num_transactions));
+            for (size_t i = 0; i < num_transactions; i++)
+                e300_codec_ctrl_transact(_codec_ctrl, &in.transactions[i], &out.transactions[i]);
 
-            socket->send_to(asio::buffer(out_buff, 64), *endpoint);
+            socket->send_to(asio::buffer(&out, codec_packet_t::size(num_transactions)), *endpoint);
         }
     }
     catch(const std::exception &ex)
@@ -253,6 +244,7 @@ static void e300_global_regs_tunnel(
     bool *running
 )
 {
+    uhd::apply_thread_role("e300_tunnel");
     UHD_ASSERT_THROW(regs);
     asio::ip::udp::endpoint _endpoint;
     try
@@ -300,6 +292,7 @@ static void e300_sensor_tunnel(
     bool *running
 )
 {
+    uhd::apply_thread_role("e300_tunnel");
     asio::ip::udp::endpoint _endpoint;
     try
     {
@@ -358,6 +351,7 @@ static void e300_i2c_tunnel(
     bool *running
 )
 {
+    uhd::apply_thread_role("e300_tunnel");
     UHD_ASSERT_THROW(i2c);
     asio::ip::udp::endpoint _endpoint;
     try
@@ -449,6 +443,8 @@ private:
     boost::shared_ptr<global_regs>           _global_regs;
     boost::shared_ptr<e300_sensor_manager>   _sensor_manager;
     boost::shared_ptr<e300_eeprom_manager>   _eeprom_manager;
+    size_t                                   _tunnel_burst;
+    uhd::thread_role_args::sptr              _thread_roles;
 };
 
 network_server_impl::~network_server_impl(void)
@@ -463,6 +459,7 @@ void network_server_impl::_run_server(
     const std::string &what,
     const size_t fe)
 {
+    uhd::apply_thread_role("e300_server");
     asio::io_service io_service;
     asio::ip::udp::resolver resolver(io_service);
     asio::ip::udp::resolver::query query(asio::ip::udp::v4(), "0.0.0.0", port);
@@ -487,17 +484,18 @@ void network_server_impl::_run_server(
             boost::thread_group tg;
             bool running = true;
             xports_t &perif = _xports[fe];
+            udp_tunnel_endpoint tunnel_endpoint;
             if (what == "RX") {
-                tg.create_thread(boost::bind(&e300_recv_tunnel, "RX data tunnel", perif.rx_data_xport, socket, &endpoint, &running));
-                tg.create_thread(boost::bind(&e300_send_tunnel, "RX flow tunnel", socket, perif.rx_flow_xport, &endpoint, &running));
+                tg.create_thread(boost::bind(&e300_recv_tunnel, "RX data tunnel", "e300_data_tunnel", perif.rx_data_xport, socket, &tunnel_endpoint, _tunnel_burst, &running));
+                tg.create_thread(boost::bind(&e300_send_tunnel, "RX flow tunnel", "e300_tunnel", socket, perif.rx_flow_xport, &tunnel_endpoint, _tunnel_burst, &running));
             }
             if (what == "TX") {
-                tg.create_thread(boost::bind(&e300_recv_tunnel, "TX flow tunnel", perif.tx_flow_xport, socket, &endpoint, &running));
-                tg.create_thread(boost::bind(&e300_send_tunnel, "TX data tunnel", socket, perif.tx_data_xport, &endpoint, &running));
+                tg.create_thread(boost::bind(&e300_recv_tunnel, "TX flow tunnel", "e300_tunnel", perif.tx_flow_xport, socket, &tunnel_endpoint, _tunnel_burst, &running));
+                tg.create_thread(boost::bind(&e300_send_tunnel, "TX data tunnel", "e300_data_tunnel", socket, perif.tx_data_xport, &tunnel_endpoint, _tunnel_burst, &running));
             }
             if (what == "CTRL") {
-                tg.create_thread(boost::bind(&e300_recv_tunnel, "response tunnel", perif.recv_ctrl_xport, socket, &endpoint, &running));
-                tg.create_thread(boost::bind(&e300_send_tunnel, "control tunnel", socket, perif.send_ctrl_xport, &endpoint, &running));
+                tg.create_thread(boost::bind(&e300_recv_tunnel, "response tunnel", "e300_tunnel", perif.recv_ctrl_xport, socket, &tunnel_endpoint, _tunnel_burst, &running));
+                tg.create_thread(boost::bind(&e300_send_tunnel, "control tunnel", "e300_tunnel", socket, perif.send_ctrl_xport, &tunnel_endpoint, _tunnel_burst, &running));
             }
             if (what == "CODEC") {
                 tg.create_thread(boost::bind(&e300_codec_ctrl_tunnel, "CODEC tunnel", socket, _codec_ctrl, &endpoint, &running));
@@ -543,6 +541,10 @@ void network_server_impl::run()
 }
 network_server_impl::network_server_impl(const uhd::device_addr_t &device_addr)
 {
+    //placement of the tunnel threads, e.g. thread_e300_data_tunnel_cpus=1
+    _thread_roles = uhd::thread_role_args::make(device_addr);
+    _tunnel_burst = device_addr.cast<size_t>("tunnel_burst", e300::DEFAULT_NET_TUNNEL_BURST);
+
     _eeprom_manager = boost::make_shared<e300_eeprom_manager>(i2c::make_i2cdev(E300_I2CDEV_DEVICE));
     if (not device_addr.has_key("no_reload_fpga")) {
         // Load FPGA image if provided via args
@@ -18,8 +18,10 @@
 #include "e300_remote_codec_ctrl.hpp"
 
 #include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/utils/byteswap.hpp>
+#include <vector>
 #include <cstring>
 #include <iostream>
 
@@ -28,7 +30,8 @@ namespace uhd { namespace usrp { namespace e300 {
 class e300_remote_codec_ctrl_impl : public e300_remote_codec_ctrl
 {
 public:
-    e300_remote_codec_ctrl_impl(uhd::transport::zero_copy_if::sptr xport) : _xport(xport)
+    e300_remote_codec_ctrl_impl(uhd::transport::zero_copy_if::sptr xport) :
+        _xport(xport), _seq(0), _acked_seq(0), _batch_depth(0)
     {
     }
 
@@ -38,106 +41,204 @@ public:
 
     double set_gain(const std::string &which, const double value)
     {
-        _clear();
-        _args.action = uhd::htonx<boost::uint32_t>(transaction_t::ACTION_SET_GAIN);
-        if (which == "TX1")      _args.which = uhd::htonx<boost::uint32_t>(transaction_t::CHAIN_TX1);
-        else if (which == "TX2") _args.which = uhd::htonx<boost::uint32_t>(transaction_t::CHAIN_TX2);
-        else if (which == "RX1") _args.which = uhd::htonx<boost::uint32_t>(transaction_t::CHAIN_RX1);
-        else if (which == "RX2") _args.which = uhd::htonx<boost::uint32_t>(transaction_t::CHAIN_RX2);
-        else throw std::runtime_error("e300_remote_codec_ctrl_impl incorrect chain string.");
-        _args.gain = value;
+        transaction_t args = _make(transaction_t::ACTION_SET_GAIN, _get_chain(which));
+        args.gain = value;
 
-        _transact();
-        return _retval.gain;
+        return _transact(args).gain;
     }
 
     double set_clock_rate(const double rate)
     {
-        _clear();
-        _args.action = uhd::htonx<boost::uint32_t>(
-            transaction_t::ACTION_SET_CLOCK_RATE);
-        _args.which = uhd::htonx<boost::uint32_t>(
-            transaction_t::CHAIN_NONE);  /*Unused*/
-        _args.rate = rate;
+        transaction_t args = _make(transaction_t::ACTION_SET_CLOCK_RATE, transaction_t::CHAIN_NONE);
+        args.rate = rate;
 
-        _transact();
-        return _retval.gain;
+        return _transact(args).rate;
     }
 
     void set_active_chains(bool tx1, bool tx2, bool rx1, bool rx2)
     {
-        _clear();
-        _args.action = uhd::htonx<boost::uint32_t>(
-            transaction_t::ACTION_SET_ACTIVE_CHANS);
-        /*Unused*/
-        _args.which = uhd::htonx<boost::uint32_t>(
-            transaction_t::CHAIN_NONE);
-        _args.bits = uhd::htonx<boost::uint32_t>(
+        transaction_t args = _make(transaction_t::ACTION_SET_ACTIVE_CHANS, transaction_t::CHAIN_NONE);
+        args.bits = uhd::htonx<boost::uint32_t>(
                      (tx1 ? (1<<0) : 0) |
                      (tx2 ? (1<<1) : 0) |
                      (rx1 ? (1<<2) : 0) |
                      (rx2 ? (1<<3) : 0));
 
-        _transact();
+        _post(args);
     }
 
     double tune(const std::string &which, const double value)
     {
-        _clear();
-        _args.action = uhd::htonx<boost::uint32_t>(transaction_t::ACTION_TUNE);
-        if (which == "TX1")      _args.which = uhd::htonx<boost::uint32_t>(transaction_t::CHAIN_TX1);
-        else if (which == "TX2") _args.which = uhd::htonx<boost::uint32_t>(transaction_t::CHAIN_TX2);
-        else if (which == "RX1") _args.which = uhd::htonx<boost::uint32_t>(transaction_t::CHAIN_RX1);
-        else if (which == "RX2") _args.which = uhd::htonx<boost::uint32_t>(transaction_t::CHAIN_RX2);
-        else throw std::runtime_error("e300_remote_codec_ctrl_impl incorrect chain string.");
-        _args.freq = value;
+        transaction_t args = _make(transaction_t::ACTION_TUNE, _get_chain(which));
+        args.freq = value;
 
-        _transact();
-        return _retval.freq;
+        return _transact(args).freq;
+    }
+
+    void store_fastlock_profile(const std::string &which, const size_t profile)
+    {
+        transaction_t args = _make(transaction_t::ACTION_STORE_FASTLOCK, _get_chain(which));
+        //checked here, an exception on the server ends the tunnel
+        if (profile >= get_num_fastlock_profiles())
+            throw uhd::value_error("e300_remote_codec_ctrl_impl fast lock profile out of range.");
+        args.bits = uhd::htonx<boost::uint32_t>(boost::uint32_t(profile));
+
+        _post(args);
+    }
+
+    void invalidate_calibration_cache(void)
+    {
+        _post(_make(transaction_t::ACTION_INVALIDATE_CAL_CACHE, transaction_t::CHAIN_NONE));
+    }
+
+    void set_calibration_cache_file(const std::string &)
+    {
+        //the codec and its cache live in the server process
+        throw uhd::not_implemented_error("e300_remote_codec_ctrl_impl cannot keep a calibration cache file.");
     }
 
     void data_port_loopback(const bool on)
     {
-        _clear();
-        _args.action = uhd::htonx<boost::uint32_t>(transaction_t::ACTION_SET_LOOPBACK);
-        _args.which  = uhd::htonx<boost::uint32_t>(transaction_t::CHAIN_NONE);  /*Unused*/
-        _args.bits = uhd::htonx<boost::uint32_t>(on ? 1 : 0);
+        transaction_t args = _make(transaction_t::ACTION_SET_LOOPBACK, transaction_t::CHAIN_NONE);
+        args.bits = uhd::htonx<boost::uint32_t>(on ? 1 : 0);
 
-        _transact();
+        _post(args);
+    }
+
+    void begin_batch(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _batch_depth++;
+    }
+
+    void end_batch(void)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        if (_batch_depth == 0 or --_batch_depth != 0) return;
+        _flush();
+        _wait_all();
     }
 
 private:
-    void _transact() {
-        {
-            uhd::transport::managed_send_buffer::sptr buff = _xport->get_send_buff(10.0);
-            if (not buff or buff->size() < sizeof(_args))
-                throw std::runtime_error("e300_remote_codec_ctrl_impl send timeout");
-            std::memcpy(buff->cast<void *>(), &_args, sizeof(_args));
-            buff->commit(sizeof(_args));
+    static boost::uint32_t _get_chain(const std::string &which)
+    {
+        if (which == "TX1") return transaction_t::CHAIN_TX1;
+        if (which == "TX2") return transaction_t::CHAIN_TX2;
+        if (which == "RX1") return transaction_t::CHAIN_RX1;
+        if (which == "RX2") return transaction_t::CHAIN_RX2;
+        throw std::runtime_error("e300_remote_codec_ctrl_impl incorrect chain string.");
+    }
+
+    static transaction_t _make(const boost::uint32_t action, const boost::uint32_t which)
+    {
+        transaction_t args;
+        std::memset(&args, 0, sizeof(args));
+        args.action = uhd::htonx<boost::uint32_t>(action);
+        args.which = uhd::htonx<boost::uint32_t>(which);
+        return args;
+    }
+
+    //! Run a call without a result; in a batch it is held back
+    void _post(const transaction_t &args)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _queue(args);
+        if (_batch_depth != 0) return;
+        _flush();
+        _wait_all();
+    }
+
+    //! Run a call with a result, along with the calls held back before it
+    transaction_t _transact(const transaction_t &args)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _queue(args);
+        _flush();
+        _wait_all();
+        return _last_result;
+    }
+
+    /*!
+     * Hold back a transaction (called with the mutex held).
+     * A full packet goes out at once, without waiting for its response.
+     */
+    void _queue(const transaction_t &args)
+    {
+        if (_pending.size() == packet_t::MAX_TRANSACTIONS) _flush();
+        _pending.push_back(args);
+    }
+
+    //! Send the held back transactions (called with the mutex held)
+    void _flush(void)
+    {
+        if (_pending.empty()) return;
+        const size_t num_bytes = packet_t::size(_pending.size());
+        uhd::transport::managed_send_buffer::sptr buff = _xport->get_send_buff(10.0);
+        if (not buff or buff->size() < num_bytes) {
+            _reset();
+            throw std::runtime_error("e300_remote_codec_ctrl_impl send timeout");
         }
-        {
+        packet_t *packet = buff->cast<packet_t *>();
+        packet->seq = uhd::htonx<boost::uint32_t>(++_seq);
+        packet->num_transactions = uhd::htonx<boost::uint32_t>(boost::uint32_t(_pending.size()));
+        std::memcpy(packet->transactions, &_pending.front(), _pending.size()*sizeof(transaction_t));
+        buff->commit(num_bytes);
+        _in_flight.push_back(_pending);
+        _pending.clear();
+    }
+
+    /*!
+     * Wait for the responses to all packets sent (called with the mutex held).
+     * Responses to packets given up on before are dropped.
+     */
+    void _wait_all(void)
+    {
+        while (_acked_seq != _seq) {
             uhd::transport::managed_recv_buffer::sptr buff = _xport->get_recv_buff(10.0);
-            if (not buff or buff->size() < sizeof(_retval))
+            if (not buff) {
+                _reset();
                 throw std::runtime_error("e300_remote_codec_ctrl_impl recv timeout");
-            std::memcpy(&_retval, buff->cast<const void *>(), sizeof(_retval));
+            }
+            if (buff->size() < packet_t::size(0)) continue;
+            const packet_t *packet = buff->cast<const packet_t *>();
+            const boost::uint32_t seq = uhd::ntohx<boost::uint32_t>(packet->seq);
+            if (seq != _acked_seq + 1) continue;
+
+            const std::vector<transaction_t> &sent = _in_flight.front();
+            const size_t num_transactions = uhd::ntohx<boost::uint32_t>(packet->num_transactions);
+            if (num_transactions != sent.size() or buff->size() < packet_t::size(num_transactions)) {
+                _reset();
+                throw std::runtime_error("e300_remote_codec_ctrl_impl trancation failed.");
+            }
+            for (size_t i = 0; i < num_transactions; i++) {
+                if (packet->transactions[i].action != sent[i].action) {
+                    _reset();
+                    throw std::runtime_error("e300_remote_codec_ctrl_impl trancation failed.");
+                }
+            }
+            std::memcpy(&_last_result, &packet->transactions[num_transactions-1], sizeof(_last_result));
+            _in_flight.erase(_in_flight.begin());
+            _acked_seq = seq;
         }
-
-        if (_args.action != _retval.action)
-            throw std::runtime_error("e300_remote_codec_ctrl_impl trancation failed.");
     }
 
-    void _clear() {
-        _args.action = 0;
-        _args.which = 0;
-        _args.bits = 0;
-        _retval.action = 0;
-        _retval.which = 0;
-        _retval.bits = 0;
+    //! Give up on what is held back or in flight after an error
+    void _reset(void)
+    {
+        _pending.clear();
+        _in_flight.clear();
+        _acked_seq = _seq;
+        _batch_depth = 0;
     }
 
     uhd::transport::zero_copy_if::sptr _xport;
-    transaction_t                      _args;
-    transaction_t                      _retval;
+    boost::mutex                       _mutex;
+    boost::uint32_t                    _seq;
+    boost::uint32_t                    _acked_seq;
+    size_t                             _batch_depth;
+    std::vector<transaction_t>         _pending;
+    std::vector<std::vector<transaction_t> > _in_flight;
+    transaction_t                      _last_result;
 };
 
 ad9361_ctrl::sptr e300_remote_codec_ctrl::make(uhd::transport::zero_copy_if::sptr xport)
@@ -42,6 +42,8 @@ public:
         static const boost::uint32_t ACTION_SET_ACTIVE_CHANS    = 12;
         static const boost::uint32_t ACTION_TUNE                = 13;
         static const boost::uint32_t ACTION_SET_LOOPBACK        = 14;
+        static const boost::uint32_t ACTION_STORE_FASTLOCK      = 15;
+        static const boost::uint32_t ACTION_INVALIDATE_CAL_CACHE = 16;
 
         //Values for "which"
         static const boost::uint32_t CHAIN_NONE = 0;
@@ -51,6 +53,25 @@ public:
         static const boost::uint32_t CHAIN_RX2  = 4;
     };
 
+    /*!
+     * A request carries a sequence number and the transactions to run
+     * in order; the response echoes both with the results filled in.
+     * A transaction that failed comes back with a zero action.
+     */
+    struct packet_t {
+        static const size_t MAX_TRANSACTIONS = 16;
+
+        boost::uint32_t     seq;
+        boost::uint32_t     num_transactions;
+        transaction_t       transactions[MAX_TRANSACTIONS];
+
+        //! the size of a packet with n transactions
+        static size_t size(const size_t n)
+        {
+            return 2*sizeof(boost::uint32_t) + n*sizeof(transaction_t);
+        }
+    };
+
     static sptr make(uhd::transport::zero_copy_if::sptr xport);
 };
 
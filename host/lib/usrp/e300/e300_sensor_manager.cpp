@@ -32,7 +32,7 @@ class e300_sensor_proxy : public e300_sensor_manager
 {
 public:
     e300_sensor_proxy(
-        uhd::transport::zero_copy_if::sptr xport) : _xport(xport)
+        uhd::transport::zero_copy_if::sptr xport) : _xport(xport), _seq(0)
     {
     }
 
@@ -56,115 +56,39 @@ public:
 
     uhd::sensor_value_t get_mb_temp(void)
     {
-        boost::mutex::scoped_lock(_mutex);
-        sensor_transaction_t transaction;
-        transaction.which = uhd::htonx<boost::uint32_t>(ZYNQ_TEMP);
-        {
-            uhd::transport::managed_send_buffer::sptr buff
-                = _xport->get_send_buff(1.0);
-            if (not buff or buff->size() < sizeof(transaction)) {
-                throw uhd::runtime_error("sensor proxy send timeout");
-            }
-            std::memcpy(
-                buff->cast<void *>(),
-                &transaction,
-                sizeof(transaction));
-            buff->commit(sizeof(transaction));
-        }
-        {
-            uhd::transport::managed_recv_buffer::sptr buff
-                = _xport->get_recv_buff(1.0);
-
-            if (not buff or buff->size() < sizeof(transaction))
-                throw uhd::runtime_error("sensor proxy recv timeout");
-
-            std::memcpy(
-                &transaction,
-                buff->cast<const void *>(),
-                sizeof(transaction));
-        }
-        UHD_ASSERT_THROW(uhd::ntohx<boost::uint32_t>(transaction.which) == ZYNQ_TEMP);
         // TODO: Use proper serialization here ...
         return sensor_value_t(
             "temp",
             e300_sensor_manager::unpack_float_from_uint32_t(
-                uhd::ntohx(transaction.value)),
+                _transact(ZYNQ_TEMP)),
             "C");
     }
 
     uhd::sensor_value_t get_gps_time(void)
     {
-        boost::mutex::scoped_lock(_mutex);
-        sensor_transaction_t transaction;
-        transaction.which = uhd::htonx<boost::uint32_t>(GPS_TIME);
-        {
-            uhd::transport::managed_send_buffer::sptr buff
-                = _xport->get_send_buff(1.0);
-            if (not buff or buff->size() < sizeof(transaction)) {
-                throw uhd::runtime_error("sensor proxy send timeout");
-            }
-            std::memcpy(
-                buff->cast<void *>(),
-                &transaction,
-                sizeof(transaction));
-            buff->commit(sizeof(transaction));
-        }
-        {
-            uhd::transport::managed_recv_buffer::sptr buff
-                = _xport->get_recv_buff(1.0);
-
-            if (not buff or buff->size() < sizeof(transaction))
-                throw uhd::runtime_error("sensor proxy recv timeout");
-
-            std::memcpy(
-                &transaction,
-                buff->cast<const void *>(),
-                sizeof(transaction));
-        }
-        UHD_ASSERT_THROW(uhd::ntohx<boost::uint32_t>(transaction.which) == GPS_TIME);
-        // TODO: Use proper serialization here ...
-        return sensor_value_t("GPS epoch time", int(uhd::ntohx<boost::uint32_t>(transaction.value)), "seconds");
+        return sensor_value_t("GPS epoch time", int(_transact(GPS_TIME)), "seconds");
     }
 
     bool get_gps_found(void)
     {
-        boost::mutex::scoped_lock(_mutex);
-        sensor_transaction_t transaction;
-        transaction.which = uhd::htonx<boost::uint32_t>(GPS_FOUND);
-        {
-            uhd::transport::managed_send_buffer::sptr buff
-                = _xport->get_send_buff(1.0);
-            if (not buff or buff->size() < sizeof(transaction)) {
-                throw uhd::runtime_error("sensor proxy send timeout");
-            }
-            std::memcpy(
-                buff->cast<void *>(),
-                &transaction,
-                sizeof(transaction));
-            buff->commit(sizeof(transaction));
-        }
-        {
-            uhd::transport::managed_recv_buffer::sptr buff
-                = _xport->get_recv_buff(1.0);
-
-            if (not buff or buff->size() < sizeof(transaction))
-                throw uhd::runtime_error("sensor proxy recv timeout");
+        return static_cast<bool>(_transact(GPS_FOUND));
+    }
 
-            std::memcpy(
-                &transaction,
-                buff->cast<const void *>(),
-                sizeof(transaction));
-        }
-        UHD_ASSERT_THROW(uhd::ntohx<boost::uint32_t>(transaction.which) == GPS_FOUND);
+    uhd::sensor_value_t get_gps_lock(void)
+    {
         // TODO: Use proper serialization here ...
-        return static_cast<bool>(uhd::ntohx(transaction.value));
+        return sensor_value_t("GPS lock status", static_cast<bool>(_transact(GPS_LOCK)), "locked", "unlocked");
     }
 
-    uhd::sensor_value_t get_gps_lock(void)
+private:
+    //! Read a sensor, the response to a request given up on before is dropped
+    boost::uint32_t _transact(const sensor which)
     {
-        boost::mutex::scoped_lock(_mutex);
+        boost::mutex::scoped_lock lock(_mutex);
         sensor_transaction_t transaction;
-        transaction.which = uhd::htonx<boost::uint32_t>(GPS_LOCK);
+        transaction.which = uhd::htonx<boost::uint32_t>(which);
+        transaction.value = 0;
+        transaction.seq = uhd::htonx<boost::uint32_t>(++_seq);
         {
             uhd::transport::managed_send_buffer::sptr buff
                 = _xport->get_send_buff(1.0);
@@ -177,26 +101,28 @@ public:
                 sizeof(transaction));
             buff->commit(sizeof(transaction));
         }
-        {
+        sensor_transaction_t response;
+        do {
             uhd::transport::managed_recv_buffer::sptr buff
                 = _xport->get_recv_buff(1.0);
 
-            if (not buff or buff->size() < sizeof(transaction))
+            if (not buff)
                 throw uhd::runtime_error("sensor proxy recv timeout");
+            if (buff->size() < sizeof(response))
+                continue;
 
             std::memcpy(
-                &transaction,
+                &response,
                 buff->cast<const void *>(),
-                sizeof(transaction));
-        }
-        UHD_ASSERT_THROW(uhd::ntohx<boost::uint32_t>(transaction.which) == GPS_LOCK);
-        // TODO: Use proper serialization here ...
-        return sensor_value_t("GPS lock status", static_cast<bool>(uhd::ntohx(transaction.value)), "locked", "unlocked");
+                sizeof(response));
+        } while (response.seq != transaction.seq);
+        UHD_ASSERT_THROW(response.which == transaction.which);
+        return uhd::ntohx(response.value);
     }
 
-private:
     uhd::transport::zero_copy_if::sptr _xport;
     boost::mutex                       _mutex;
+    boost::uint32_t                    _seq;
 };
 
 }}} // namespace
@@ -34,6 +34,7 @@ struct sensor_transaction_t {
         boost::uint32_t value;
         boost::uint32_t value64;
     };
+    boost::uint32_t seq; //echoed in the response
 };
 
 
@@ -22,6 +22,8 @@
 #ifdef E300_NATIVE
 #include <boost/thread.hpp>
 #include <boost/format.hpp>
+#include <algorithm>
+#include <cstring>
 
 #include <fcntl.h>
 #include <sys/ioctl.h>
@@ -81,29 +83,64 @@ public:
     {
         int ret(0);
         struct spi_ioc_transfer tr;
+        std::memset(&tr, 0, sizeof(tr));
 
-        uint8_t *tx_data = reinterpret_cast<uint8_t *>(&data);
-
-
-        UHD_ASSERT_THROW(num_bits == 24);
-        uint8_t tx[] = {tx_data[2], tx_data[1], tx_data[0]};
-
-        uint8_t rx[3];
-        tr.tx_buf = (unsigned long) &tx[0];
-        tr.rx_buf = (unsigned long) &rx[0];
-        tr.len = num_bits >> 3;
-        tr.bits_per_word = _bits;
-        tr.speed_hz = _speed;
-        tr.delay_usecs = _delay;
+        uint8_t tx[4];
+        uint8_t rx[4];
+        _fill_transfer(tr, tx, rx, data, num_bits);
 
         ret = ioctl(_fd, SPI_IOC_MESSAGE(1), &tr);
         if (ret < 1)
             throw uhd::runtime_error("Could not send spidev message");
 
-        return rx[2];
+        return rx[tr.len - 1];
+    }
+
+    void write_spi_burst(int, const uhd::spi_config_t &,
+                         const std::vector<boost::uint32_t> &data,
+                         size_t num_bits)
+    {
+        //one ioctl per chunk, chip select toggles between the words
+        struct spi_ioc_transfer tr[MAX_BURST_WORDS];
+        uint8_t tx[MAX_BURST_WORDS][4];
+        uint8_t rx[MAX_BURST_WORDS][4];
+
+        for (size_t first = 0; first < data.size(); first += MAX_BURST_WORDS) {
+            const size_t num_words = std::min<size_t>(MAX_BURST_WORDS, data.size() - first);
+            std::memset(tr, 0, sizeof(tr));
+            for (size_t i = 0; i < num_words; i++) {
+                _fill_transfer(tr[i], tx[i], rx[i], data[first + i], num_bits);
+                tr[i].cs_change = (i + 1 < num_words) ? 1 : 0;
+            }
+
+            const int ret = ioctl(_fd,
+                _IOC(_IOC_WRITE, SPI_IOC_MAGIC, 0, num_words * sizeof(struct spi_ioc_transfer)), tr);
+            if (ret < 1)
+                throw uhd::runtime_error("Could not send spidev burst message");
+        }
     }
 
 private:
+    //fits the 4096 byte limit of a spidev message
+    static const size_t MAX_BURST_WORDS = 64;
+
+    //! Fill a transfer with data, sent most significant byte first
+    void _fill_transfer(struct spi_ioc_transfer &tr, uint8_t *tx, uint8_t *rx,
+                        const boost::uint32_t data, const size_t num_bits)
+    {
+        UHD_ASSERT_THROW(num_bits >= 8 and num_bits <= 32 and num_bits % 8 == 0);
+        const size_t num_bytes = num_bits >> 3;
+        for (size_t i = 0; i < num_bytes; i++)
+            tx[i] = uint8_t(data >> (8 * (num_bytes - 1 - i)));
+
+        tr.tx_buf = (unsigned long) tx;
+        tr.rx_buf = (unsigned long) rx;
+        tr.len = num_bytes;
+        tr.bits_per_word = _bits;
+        tr.speed_hz = _speed;
+        tr.delay_usecs = _delay;
+    }
+
     int _fd;
     boost::uint8_t _mode;
     boost::uint32_t _speed;
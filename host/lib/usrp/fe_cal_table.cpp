@@ -0,0 +1,225 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/usrp/fe_cal_table.hpp>
+#include <uhd/exception.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace uhd;
+using namespace uhd::usrp;
+
+namespace fs = boost::filesystem;
+namespace ip = boost::interprocess;
+
+/***********************************************************************
+ * Binary file layout
+ *
+ * The file is a header followed by num_points packed fe_cal_point_t,
+ * sorted by ascending LO frequency. Values are stored in host byte
+ * order; a table written on a host of the other endianness fails the
+ * version check and the caller falls back to the CSV file.
+ **********************************************************************/
+static const char FE_CAL_MAGIC[8] = {'U', 'H', 'D', 'F', 'E', 'C', 'A', 'L'};
+static const boost::uint32_t FE_CAL_VERSION = 1;
+
+struct fe_cal_file_header_t{
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t point_size;
+    boost::uint64_t num_points;
+};
+
+BOOST_STATIC_ASSERT(sizeof(fe_cal_point_t) == 3*sizeof(double));
+BOOST_STATIC_ASSERT(sizeof(fe_cal_file_header_t) % sizeof(double) == 0);
+
+const std::string fe_cal_table::BIN_EXT = ".bin";
+
+/***********************************************************************
+ * Helper routines
+ **********************************************************************/
+static bool fe_cal_comp(const fe_cal_point_t &a, const fe_cal_point_t &b){
+    return (a.lo_freq < b.lo_freq);
+}
+
+static bool fe_cal_freq_comp(const fe_cal_point_t &a, const double lo_freq){
+    return (a.lo_freq < lo_freq);
+}
+
+static bool is_same_freq(const double f1, const double f2)
+{
+    const double epsilon = 0.1;
+    return ((f1 - epsilon) < f2 and (f1 + epsilon) > f2);
+}
+
+static double linear_interp(double x, double x0, double y0, double x1, double y1){
+    return y0 + (x - x0)*(y1 - y0)/(x1 - x0);
+}
+
+static std::complex<double> to_complex(const fe_cal_point_t &point){
+    return std::complex<double>(point.corr_real, point.corr_imag);
+}
+
+/***********************************************************************
+ * Table implementation
+ **********************************************************************/
+class fe_cal_table_impl : public fe_cal_table{
+public:
+    //! Make a table that owns a sorted copy of the points
+    fe_cal_table_impl(const std::vector<fe_cal_point_t> &points):
+        _owned(points)
+    {
+        std::sort(_owned.begin(), _owned.end(), fe_cal_comp);
+        _points = _owned.empty()? NULL : &_owned.front();
+        _size = _owned.size();
+    }
+
+    //! Make a table that takes ownership of a mapped file region
+    fe_cal_table_impl(
+        boost::scoped_ptr<ip::file_mapping> &mapping,
+        boost::scoped_ptr<ip::mapped_region> &region,
+        const fe_cal_point_t *points, const size_t size
+    ):
+        _points(points), _size(size)
+    {
+        _mapping.swap(mapping);
+        _region.swap(region);
+    }
+
+    size_t size(void) const{
+        return _size;
+    }
+
+    const fe_cal_point_t &operator[](const size_t i) const{
+        if (i >= _size) throw uhd::index_error("fe_cal_table: index out of range");
+        return _points[i];
+    }
+
+    std::complex<double> get_correction(const double lo_freq) const{
+        if (_size == 0) throw uhd::runtime_error("empty calibration table");
+
+        //search for the first point at or above the lo freq
+        const fe_cal_point_t *end = _points + _size;
+        const fe_cal_point_t *hi = std::lower_bound(_points, end, lo_freq, fe_cal_freq_comp);
+
+        //clip to the edges of the table
+        if (hi == end) return to_complex(*(end-1));
+        if (hi == _points or is_same_freq(hi->lo_freq, lo_freq)) return to_complex(*hi);
+        const fe_cal_point_t *lo = hi - 1;
+        if (is_same_freq(lo->lo_freq, lo_freq)) return to_complex(*lo);
+
+        //interpolation time
+        return std::complex<double>(
+            linear_interp(lo_freq, lo->lo_freq, lo->corr_real, hi->lo_freq, hi->corr_real),
+            linear_interp(lo_freq, lo->lo_freq, lo->corr_imag, hi->lo_freq, hi->corr_imag)
+        );
+    }
+
+private:
+    std::vector<fe_cal_point_t> _owned;
+    boost::scoped_ptr<ip::file_mapping> _mapping;
+    boost::scoped_ptr<ip::mapped_region> _region;
+    const fe_cal_point_t *_points;
+    size_t _size;
+};
+
+/***********************************************************************
+ * Factories
+ **********************************************************************/
+fe_cal_table::~fe_cal_table(void){
+    /* NOP */
+}
+
+fe_cal_table::sptr fe_cal_table::make(const std::vector<fe_cal_point_t> &points){
+    return sptr(new fe_cal_table_impl(points));
+}
+
+fe_cal_table::sptr fe_cal_table::load(const std::string &path){
+    if (not fs::exists(path)) throw uhd::io_error("calibration table not found: " + path);
+    const boost::uintmax_t file_size = fs::file_size(path);
+    if (file_size < sizeof(fe_cal_file_header_t)){
+        throw uhd::io_error("calibration table truncated: " + path);
+    }
+
+    boost::scoped_ptr<ip::file_mapping> mapping;
+    boost::scoped_ptr<ip::mapped_region> region;
+    try{
+        mapping.reset(new ip::file_mapping(path.c_str(), ip::read_only));
+        region.reset(new ip::mapped_region(*mapping, ip::read_only));
+    }
+    catch(const ip::interprocess_exception &e){
+        throw uhd::io_error("cannot map calibration table " + path + ": " + e.what());
+    }
+
+    //validate the header against the mapped size,
+    //dividing so a corrupt point count cannot overflow the check
+    const char *mem = static_cast<const char *>(region->get_address());
+    fe_cal_file_header_t header;
+    std::memcpy(&header, mem, sizeof(header));
+    const boost::uintmax_t data_size = file_size - sizeof(header);
+    if (
+        std::memcmp(header.magic, FE_CAL_MAGIC, sizeof(FE_CAL_MAGIC)) != 0 or
+        header.version != FE_CAL_VERSION or
+        header.point_size != sizeof(fe_cal_point_t) or
+        data_size % sizeof(fe_cal_point_t) != 0 or
+        header.num_points != data_size/sizeof(fe_cal_point_t)
+    ){
+        throw uhd::io_error("malformed calibration table: " + path);
+    }
+
+    //binary search relies on the points being sorted
+    const fe_cal_point_t *points = reinterpret_cast<const fe_cal_point_t *>(mem + sizeof(header));
+    const size_t num_points = size_t(header.num_points);
+    for (size_t i = 1; i < num_points; i++){
+        if (points[i].lo_freq < points[i-1].lo_freq){
+            throw uhd::io_error("unsorted calibration table: " + path);
+        }
+    }
+
+    return sptr(new fe_cal_table_impl(mapping, region, points, num_points));
+}
+
+void fe_cal_table::write(const std::string &path, const std::vector<fe_cal_point_t> &points){
+    std::vector<fe_cal_point_t> sorted(points);
+    std::sort(sorted.begin(), sorted.end(), fe_cal_comp);
+
+    fe_cal_file_header_t header;
+    std::memcpy(header.magic, FE_CAL_MAGIC, sizeof(FE_CAL_MAGIC));
+    header.version = FE_CAL_VERSION;
+    header.point_size = sizeof(fe_cal_point_t);
+    header.num_points = sorted.size();
+
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path.c_str(), std::ofstream::binary | std::ofstream::trunc);
+        if (not out) throw uhd::io_error("cannot write calibration table: " + tmp_path);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        if (not sorted.empty()) out.write(
+            reinterpret_cast<const char *>(&sorted.front()),
+            sorted.size()*sizeof(fe_cal_point_t)
+        );
+        if (not out) throw uhd::io_error("cannot write calibration table: " + tmp_path);
+    }
+    fs::rename(tmp_path, path);
+}
@@ -18,19 +18,24 @@
 #include <uhd/usrp/gps_ctrl.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/log.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <uhd/utils/safe_call.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/types/sensors.hpp>
+#include <uhd/types/time_spec.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/assign/list_of.hpp>
 #include <boost/cstdint.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/format.hpp>
-#include <boost/regex.hpp>
-
-#include "boost/tuple/tuple.hpp"
-#include "boost/foreach.hpp"
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cstring>
 
 using namespace uhd;
 using namespace boost::gregorian;
@@ -46,105 +51,198 @@ gps_ctrl::~gps_ctrl(void){
     /* NOP */
 }
 
-class gps_ctrl_impl : public gps_ctrl{
-private:
-  std::map<std::string, boost::tuple<std::string, boost::system_time, bool> > sensors;
-
-  std::string get_cached_sensor(const std::string sensor, const int freshness, const bool once, const bool touch=true) {
-    boost::system_time time = boost::get_system_time();
-    try {
-      // this is nasty ...
-      //std::cout << boost::format("Requested %s - seen? ") % sensor << sensors[sensor].get<2>() << " once? " << once << std::endl;
-      if(time - sensors[sensor].get<1>() < milliseconds(freshness) && (!once or !sensors[sensor].get<2>())) {
-        sensors[sensor] = boost::make_tuple(sensors[sensor].get<0>(), sensors[sensor].get<1>(), touch);
-        return sensors[sensor].get<0>();
-      } else {
-          return update_cached_sensors(sensor);
-      }
-    } catch(std::exception &e) {
-      UHD_MSG(warning) << "get_cached_sensor: " << e.what();
+/***********************************************************************
+ * The latest GPSDO sentences:
+ * The reader task is the only writer. It makes the sequence odd while
+ * it writes, so a sensor read copies a sentence without a lock and tries
+ * again when the sequence was odd or changed underneath it.
+ **********************************************************************/
+static const size_t GPS_MAX_SENTENCE_LEN = 128;
+
+enum gps_sentence_type{
+    GPS_SENTENCE_GPGGA,
+    GPS_SENTENCE_GPRMC,
+    GPS_SENTENCE_SERVO,
+    GPS_NUM_SENTENCE_TYPES
+};
+
+struct gps_sentence_t{
+    char text[GPS_MAX_SENTENCE_LEN]; //null terminated, empty for none
+    double time;                     //system time of the arrival in seconds
+    boost::uint32_t count;           //sentences of this type so far
+};
+
+class gps_snapshot{
+public:
+    gps_snapshot(void){
+        std::memset(_sentences, 0, sizeof(_sentences));
+    }
+
+    void write(const gps_sentence_type type, const std::string &text, const double time){
+        _seq.inc();
+        gps_sentence_t &sentence = _sentences[type];
+        const size_t len = std::min(text.size(), GPS_MAX_SENTENCE_LEN - 1);
+        std::memcpy(sentence.text, text.data(), len);
+        sentence.text[len] = '\0';
+        sentence.time = time;
+        sentence.count++;
+        _seq.inc();
     }
-    return std::string();
-  }
 
-    static bool is_nmea_checksum_ok(std::string nmea)
+    gps_sentence_t read(const gps_sentence_type type){
+        gps_sentence_t sentence;
+        while (true){
+            const boost::uint32_t seq = _seq.read();
+            if (seq % 2 == 0){
+                std::memcpy(&sentence, &_sentences[type], sizeof(sentence));
+                uhd::atomic_fence(); //the copy is done before the sequence is checked
+                if (_seq.read() == seq) return sentence;
+            }
+            boost::this_thread::yield();
+        }
+    }
+
+private:
+    uhd::atomic_uint32_t _seq;
+    gps_sentence_t _sentences[GPS_NUM_SENTENCE_TYPES];
+};
+
+/***********************************************************************
+ * GPS control implementation
+ **********************************************************************/
+class gps_ctrl_impl : public gps_ctrl{
+private:
+    static bool is_nmea_checksum_ok(const std::string &nmea)
     {
         if (nmea.length() < 5 || nmea[0] != '$' || nmea[nmea.length()-3] != '*')
             return false;
 
-        std::stringstream ss;
-        boost::uint32_t string_crc;
-        boost::uint32_t calculated_crc = 0;
-
         // get crc from string
-        ss << std::hex << nmea.substr(nmea.length()-2, 2);
-        ss >> string_crc;
+        boost::uint32_t string_crc = 0;
+        for (size_t i = nmea.length()-2; i < nmea.length(); i++)
+        {
+            const char ch = nmea[i];
+            string_crc <<= 4;
+            if (ch >= '0' and ch <= '9') string_crc |= ch - '0';
+            else if (ch >= 'A' and ch <= 'F') string_crc |= ch - 'A' + 10;
+            else if (ch >= 'a' and ch <= 'f') string_crc |= ch - 'a' + 10;
+            else return false;
+        }
 
         // calculate crc
+        boost::uint32_t calculated_crc = 0;
         for (size_t i = 1; i < nmea.length()-3; i++)
-            calculated_crc ^= nmea[i];
+            calculated_crc ^= boost::uint8_t(nmea[i]);
 
         // return comparison
         return (string_crc == calculated_crc);
     }
 
-  std::string update_cached_sensors(const std::string sensor) {
-    if(not gps_detected() || (gps_type != GPS_TYPE_INTERNAL_GPSDO)) {
-        UHD_MSG(error) << "get_stat(): unsupported GPS or no GPS detected";
-        return std::string();
-    }
-
-    const std::list<std::string> list = boost::assign::list_of("GPGGA")("GPRMC")("SERVO");
-    static const boost::regex status_regex("\\d\\d-\\d\\d-\\d\\d");
-    static const boost::regex gp_msg_regex("^\\$GP.*,\\*[0-9A-F]{2}$");
-    std::map<std::string,std::string> msgs;
-
-    // Get all GPSDO messages available
-    // Creating a map here because we only want the latest of each message type
-    for (std::string msg = _recv(); msg.length(); msg = _recv())
+    //! The servo status lines start with the date as yy-mm-dd
+    static bool is_servo_status(const std::string &line)
     {
-        // Strip any end of line characters
-        erase_all(msg, "\r");
-        erase_all(msg, "\n");
-
-        if (msg.length() < 6)
+        if (line.length() < 8) return false;
+        for (size_t i = 0; i < 8; i++)
         {
-            UHD_LOGV(regularly) << __FUNCTION__ << ": Short NMEA string: " << msg << std::endl;
-            continue;
+            const bool ok = (i == 2 or i == 5)? line[i] == '-' : (line[i] >= '0' and line[i] <= '9');
+            if (not ok) return false;
         }
+        return true;
+    }
 
-        // Look for SERVO message
-        if (boost::regex_search(msg, status_regex, boost::regex_constants::match_continuous))
-        {
-            msgs["SERVO"] = msg;
-        }
-        else if (boost::regex_match(msg, gp_msg_regex) and is_nmea_checksum_ok(msg))
-        {
-            msgs[msg.substr(1,5)] = msg;
-        }
-        else
+  //called by the reader task: takes what the uart has, then turns an idle servo tracking off
+  void read_sentences(void) {
+    for (std::string chars = _uart->read_uart(0.0); not chars.empty(); chars = _uart->read_uart(0.0))
+    {
+        for (size_t i = 0; i < chars.length(); i++)
         {
-            UHD_LOGV(regularly) << __FUNCTION__ << ": Malformed NMEA string: " << msg << std::endl;
+            const char ch = chars[i];
+            if (ch == '\r' or ch == '\n')
+            {
+                if (not _line_overflow and not _line.empty()) handle_sentence(_line);
+                _line.clear();
+                _line_overflow = false;
+            }
+            else if (_line.length() + 1 < GPS_MAX_SENTENCE_LEN) _line += ch;
+            else _line_overflow = true;
         }
     }
 
-    boost::system_time time = boost::get_system_time();
+    boost::mutex::scoped_lock lock(_servo_mutex);
+    if (_servo_tracking and boost::get_system_time() > _servo_last_read + milliseconds(GPS_SERVO_IDLE_MS)) {
+        _send("SERV:TRAC 0\n");
+        _servo_tracking = false;
+    }
+  }
+
+  void handle_sentence(const std::string &line) {
+    const double now = time_spec_t::get_system_time().get_real_secs();
 
-    // Update sensors with newly read data
-    BOOST_FOREACH(std::string key, list) {
-        if (msgs[key].length())
-            sensors[key] = boost::make_tuple(msgs[key], time, !sensor.compare(key));
+    if (line.length() < 6)
+    {
+        UHD_LOGV(regularly) << __FUNCTION__ << ": Short NMEA string: " << line << std::endl;
+        return;
+    }
+    else if (is_servo_status(line))
+    {
+        _snapshot.write(GPS_SENTENCE_SERVO, line, now);
+    }
+    else if (line.compare(0, 6, "$GPGGA") == 0 and is_nmea_checksum_ok(line))
+    {
+        _snapshot.write(GPS_SENTENCE_GPGGA, line, now);
+    }
+    else if (line.compare(0, 6, "$GPRMC") == 0 and is_nmea_checksum_ok(line))
+    {
+        _snapshot.write(GPS_SENTENCE_GPRMC, line, now);
+    }
+    else
+    {
+        //other sentences are well-formed but not used
+        if (line.compare(0, 3, "$GP") != 0 or not is_nmea_checksum_ok(line))
+            UHD_LOGV(regularly) << __FUNCTION__ << ": Malformed NMEA string: " << line << std::endl;
+        return;
     }
 
-    // Return requested sensor if it was updated
-    if (msgs[sensor].length())
-        return msgs[sensor];
+    //wake up the sensor reads waiting for a sentence
+    {
+        boost::mutex::scoped_lock lock(_arrival_mutex);
+    }
+    _arrival_cond.notify_all();
+  }
 
-    return std::string();
+  static bool is_usable(const gps_sentence_t &sentence, const int freshness, const boost::uint32_t min_count) {
+    const double age = time_spec_t::get_system_time().get_real_secs() - sentence.time;
+    return sentence.count != 0 and sentence.count >= min_count and age < freshness/1000.;
+  }
+
+  /*!
+   * Get the latest sentence of a type that arrived within the freshness (ms).
+   * Waits for the next sentence only when there is no such sentence,
+   * e.g. right after start up. The text is empty when none arrived in time.
+   */
+  gps_sentence_t get_sentence(const gps_sentence_type type, const int freshness, const boost::uint32_t min_count = 0) {
+    gps_sentence_t sentence = _snapshot.read(type);
+    if (is_usable(sentence, freshness, min_count)) return sentence;
+    sentence.text[0] = '\0';
+
+    if(not gps_detected() || (gps_type != GPS_TYPE_INTERNAL_GPSDO)) {
+        UHD_MSG(error) << "get_stat(): unsupported GPS or no GPS detected";
+        return sentence;
+    }
+
+    const boost::system_time comm_timeout = boost::get_system_time() + milliseconds(GPS_COMM_TIMEOUT_MS);
+    boost::mutex::scoped_lock lock(_arrival_mutex);
+    do {
+        const gps_sentence_t latest = _snapshot.read(type);
+        if (is_usable(latest, freshness, min_count)) return latest;
+    } while (_arrival_cond.timed_wait(lock, comm_timeout));
+    return sentence;
   }
 
 public:
-  gps_ctrl_impl(uart_iface::sptr uart){
+  gps_ctrl_impl(uart_iface::sptr uart):
+    _line_overflow(false), _servo_tracking(false), _time_count(0)
+  {
     _uart = uart;
 
 
@@ -154,7 +252,10 @@ public:
 
     //first we look for an internal GPSDO
     _flush(); //get whatever junk is in the rx buffer right now, and throw it away
-    _send("HAAAY GUYYYYS\n"); //to elicit a response from the GPSDO
+    {
+        boost::mutex::scoped_lock lock(_servo_mutex);
+        _send("HAAAY GUYYYYS\n"); //to elicit a response from the GPSDO
+    }
 
     //wait for _send(...) to return
     sleep(milliseconds(GPSDO_STUPID_DELAY_MS));
@@ -181,6 +282,11 @@ public:
     case GPS_TYPE_INTERNAL_GPSDO:
       UHD_MSG(status) << "Found an internal GPSDO" << std::endl;
       init_gpsdo();
+      //keep the latest sentences in the background so sensor reads do not wait on the uart,
+      //the polls are slow enough that they add little control traffic on X300 and N2x0
+      _reader = task::make_periodic(
+          boost::bind(&gps_ctrl_impl::read_sentences, this),
+          GPS_READ_PERIOD_MS/1000., "uhd_gpsdo");
       break;
 
     case GPS_TYPE_GENERIC_NMEA:
@@ -196,7 +302,11 @@ public:
   }
 
   ~gps_ctrl_impl(void){
-    /* NOP */
+    UHD_SAFE_CALL(
+      _reader.reset(); //stop the reads before the uart goes away
+      boost::mutex::scoped_lock lock(_servo_mutex);
+      if (_servo_tracking) _send("SERV:TRAC 0\n");
+    )
   }
 
   //return a list of supported sensors
@@ -215,7 +325,7 @@ public:
     or key == "gps_gprmc") {
         return sensor_value_t(
                  boost::to_upper_copy(key),
-                 get_cached_sensor(boost::to_upper_copy(key.substr(4,8)), GPS_NMEA_NORMAL_FRESHNESS, false, false),
+                 std::string(get_sentence((key == "gps_gpgga")? GPS_SENTENCE_GPGGA : GPS_SENTENCE_GPRMC, GPS_NMEA_NORMAL_FRESHNESS).text),
                  "");
     }
     else if(key == "gps_time") {
@@ -237,6 +347,7 @@ private:
     //issue some setup stuff so it spits out the appropriate data
     //none of these should issue replies so we don't bother looking for them
     //we have to sleep between commands because the JL device, despite not acking, takes considerable time to process each command.
+    boost::mutex::scoped_lock lock(_servo_mutex);
      sleep(milliseconds(GPSDO_STUPID_DELAY_MS));
     _send("SYST:COMM:SER:ECHO OFF\n");
      sleep(milliseconds(GPSDO_STUPID_DELAY_MS));
@@ -252,26 +363,6 @@ private:
      sleep(milliseconds(GPSDO_STUPID_DELAY_MS));
   }
 
-  //retrieve a raw NMEA sentence
-  std::string get_nmea(std::string msgtype) {
-    std::string reply;
-
-    const boost::system_time comm_timeout = boost::get_system_time() + milliseconds(GPS_COMM_TIMEOUT_MS);
-    while(boost::get_system_time() < comm_timeout) {
-        if(!msgtype.compare("GPRMC")) {
-          reply = get_cached_sensor(msgtype, GPS_NMEA_FRESHNESS, true);
-        }
-        else {
-          reply = get_cached_sensor(msgtype, GPS_NMEA_LOW_FRESHNESS, false);
-        }
-        if(reply.size()) {
-          if(reply.substr(1, 5) == msgtype) return reply;
-        }
-        boost::this_thread::sleep(milliseconds(GPS_TIMEOUT_DELAY_MS));
-    }
-    throw uhd::value_error(str(boost::format("get_nmea(): no %s message found") % msgtype));
-  }
-
   //helper function to retrieve a field from an NMEA sentence
   std::string get_token(std::string sentence, size_t offset) {
     boost::tokenizer<boost::escaped_list_separator<char> > tok(sentence);
@@ -286,12 +377,19 @@ private:
   }
 
   ptime get_time(void) {
-    _flush();
+    boost::mutex::scoped_lock lock(_time_mutex); //each call takes a GPRMC of its own
     int error_cnt = 0;
     ptime gps_time;
     while(error_cnt < 2) {
         try {
-            std::string reply = get_nmea("GPRMC");
+            //a sentence that came in just now and was not used yet, else the next one
+            const gps_sentence_t sentence = get_sentence(
+                GPS_SENTENCE_GPRMC, GPS_NMEA_FRESHNESS + GPS_READ_PERIOD_MS, _time_count + 1);
+            if (sentence.text[0] == '\0') {
+                throw uhd::value_error("get_time(): no GPRMC message found");
+            }
+            _time_count = sentence.count;
+            std::string reply(sentence.text);
 
             std::string datestr = get_token(reply, 9);
             std::string timestr = get_token(reply, 1);
@@ -314,7 +412,6 @@ private:
 
         } catch(std::exception &e) {
             UHD_MSG(warning) << "get_time: " << e.what();
-            _flush();
             error_cnt++;
         }
     }
@@ -335,7 +432,7 @@ private:
     int error_cnt = 0;
     while(error_cnt < 3) {
         try {
-            std::string reply = get_cached_sensor("GPGGA", GPS_LOCK_FRESHNESS, false, false);
+            const std::string reply(get_sentence(GPS_SENTENCE_GPGGA, GPS_LOCK_FRESHNESS).text);
             if(reply.size() <= 1) return false;
 
             return (get_token(reply, 6) != "0");
@@ -349,28 +446,33 @@ private:
   }
 
   std::string get_servo(void) {
-
-    //enable servo reporting
-    _send("SERV:TRAC 1\n");
-    sleep(milliseconds(GPSDO_STUPID_DELAY_MS));
-
-    std::string reply;
-
-    const boost::system_time comm_timeout = boost::get_system_time() + milliseconds(GPS_COMM_TIMEOUT_MS);
-    while(boost::get_system_time() < comm_timeout) {
-        reply = get_cached_sensor("SERVO", GPS_NMEA_LOW_FRESHNESS, false);
-        if(reply.size())
-        {
-            //disable it before leaving function
-            _send("SERV:TRAC 0\n");
-            return reply;
+    {
+        //servo tracking is on while the sensor is read, the reader turns it off when idle
+        boost::mutex::scoped_lock lock(_servo_mutex);
+        _servo_last_read = boost::get_system_time();
+        if (not _servo_tracking) {
+            _send("SERV:TRAC 1\n");
+            _servo_tracking = true;
+            sleep(milliseconds(GPSDO_STUPID_DELAY_MS));
         }
-        boost::this_thread::sleep(milliseconds(GPS_TIMEOUT_DELAY_MS));
     }
-    throw uhd::value_error("get_stat(): no servo message found");
+    const std::string reply(get_sentence(GPS_SENTENCE_SERVO, GPS_SERVO_FRESHNESS).text);
+    if (reply.empty()) throw uhd::value_error("get_stat(): no servo message found");
+    return reply;
   }
 
   uart_iface::sptr _uart;
+  gps_snapshot _snapshot;
+  std::string _line; //the sentence being received, only touched by the reader
+  bool _line_overflow;
+  boost::mutex _arrival_mutex;
+  boost::condition_variable _arrival_cond;
+  boost::mutex _servo_mutex; //also held around every uart write, so commands do not interleave
+  bool _servo_tracking; //guarded by the servo mutex
+  boost::system_time _servo_last_read; //guarded by the servo mutex
+  boost::mutex _time_mutex;
+  boost::uint32_t _time_count; //the last GPRMC used for the time, guarded by the time mutex
+  task::sptr _reader;
 
   void _flush(void){
     while (not _uart->read_uart(0.0).empty()){
@@ -382,6 +484,7 @@ private:
       return _uart->read_uart(timeout);
   }
 
+  //the caller holds the servo mutex
   void _send(const std::string &buf){
       return _uart->write_uart(buf);
   }
@@ -394,12 +497,13 @@ private:
 
   static const int GPS_COMM_TIMEOUT_MS = 1300;
   static const int GPS_NMEA_FRESHNESS = 10;
-  static const int GPS_NMEA_LOW_FRESHNESS = 2500;
   static const int GPS_NMEA_NORMAL_FRESHNESS = 1000;
   static const int GPS_SERVO_FRESHNESS = 2500;
   static const int GPS_LOCK_FRESHNESS = 2500;
   static const int GPS_TIMEOUT_DELAY_MS = 200;
   static const int GPSDO_STUPID_DELAY_MS = 200;
+  static const int GPS_READ_PERIOD_MS = 100;
+  static const int GPS_SERVO_IDLE_MS = 10000;
 };
 
 /***********************************************************************
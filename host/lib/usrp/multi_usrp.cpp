@@ -818,6 +818,13 @@ public:
         return _tree->access<meta_range_t>(rx_rf_fe_root(chan) / "freq" / "range").get();
     }
 
+    void store_rx_fast_lock_profile(size_t profile, size_t chan){
+        const fs_path path = rx_rf_fe_root(chan) / "fast_lock" / "store";
+        if (not _tree->exists(path)) throw uhd::not_implemented_error(
+            "store_rx_fast_lock_profile: the frontend has no fast lock profiles");
+        _tree->access<size_t>(path).set(profile);
+    }
+
     void set_rx_gain(double gain, const std::string &name, size_t chan){
         try {
             return rx_gain_group(chan)->set_value(gain, name);
@@ -1019,6 +1026,13 @@ public:
         return _tree->access<meta_range_t>(tx_rf_fe_root(chan) / "freq" / "range").get();
     }
 
+    void store_tx_fast_lock_profile(size_t profile, size_t chan){
+        const fs_path path = tx_rf_fe_root(chan) / "fast_lock" / "store";
+        if (not _tree->exists(path)) throw uhd::not_implemented_error(
+            "store_tx_fast_lock_profile: the frontend has no fast lock profiles");
+        _tree->access<size_t>(path).set(profile);
+    }
+
     void set_tx_gain(double gain, const std::string &name, size_t chan){
         try {
             return tx_gain_group(chan)->set_value(gain, name);
@@ -1385,6 +1399,14 @@ multi_usrp::~multi_usrp(void){
     /* NOP */
 }
 
+void multi_usrp::store_rx_fast_lock_profile(size_t, size_t){
+    throw uhd::not_implemented_error("store_rx_fast_lock_profile: the device has no fast lock profiles");
+}
+
+void multi_usrp::store_tx_fast_lock_profile(size_t, size_t){
+    throw uhd::not_implemented_error("store_tx_fast_lock_profile: the device has no fast lock profiles");
+}
+
 /***********************************************************************
  * The Make Function
  **********************************************************************/
@@ -0,0 +1,367 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "sim_impl.hpp"
+#include "../../transport/super_recv_packet_handler.hpp"
+#include "../../transport/super_send_packet_handler.hpp"
+#include <uhd/utils/msg.hpp>
+#include <uhd/utils/log.hpp>
+#include <uhd/utils/static.hpp>
+#include <uhd/utils/assert_has.hpp>
+#include <uhd/usrp/mboard_eeprom.hpp>
+#include <uhd/usrp/dboard_eeprom.hpp>
+#include <uhd/exception.hpp>
+#include <boost/format.hpp>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/math/special_functions/round.hpp>
+#include <cmath>
+
+using namespace uhd;
+using namespace uhd::usrp;
+using namespace uhd::transport;
+
+/***********************************************************************
+ * Discovery
+ **********************************************************************/
+static device_addrs_t sim_find(const device_addr_t &hint)
+{
+    device_addrs_t sim_addrs;
+
+    //only found when asked for by type, so it never shows up next to real hardware
+    if (not hint.has_key("type") or hint["type"] != "sim") return sim_addrs;
+
+    device_addr_t new_addr;
+    new_addr["type"] = "sim";
+    new_addr["name"] = hint.get("name", "sim");
+    new_addr["serial"] = hint.get("serial", "SIM0");
+    sim_addrs.push_back(new_addr);
+    return sim_addrs;
+}
+
+/***********************************************************************
+ * Make
+ **********************************************************************/
+static device::sptr sim_make(const device_addr_t &device_addr)
+{
+    return device::sptr(new sim_impl(device_addr));
+}
+
+UHD_STATIC_BLOCK(register_sim_device)
+{
+    device::register_device(&sim_find, &sim_make, device::USRP);
+}
+
+/***********************************************************************
+ * Structors
+ **********************************************************************/
+sim_impl::sim_impl(const device_addr_t &device_addr):
+    _args(device_addr),
+    _num_chans(size_t(device_addr.cast<double>("sim_num_chans", SIM_DEFAULT_NUM_CHANS))),
+    _async_md(new async_md_type(1000/*messages deep*/)),
+    _tick_rate(SIM_DEFAULT_TICK_RATE)
+{
+    UHD_MSG(status) << "Creating simulated device..." << std::endl;
+    if (_num_chans == 0) throw uhd::value_error("sim_num_chans must be at least 1");
+    _type = device::USRP;
+    _tree = property_tree::make();
+    _rx_rates.resize(_num_chans, SIM_DEFAULT_SAMP_RATE);
+    _tx_rates.resize(_num_chans, SIM_DEFAULT_SAMP_RATE);
+    _rx_streamers.resize(_num_chans);
+    _tx_streamers.resize(_num_chans);
+    _rx_xports.resize(_num_chans);
+    _tx_xports.resize(_num_chans);
+
+    ////////////////////////////////////////////////////////////////////
+    // Initialize the properties tree
+    ////////////////////////////////////////////////////////////////////
+    const fs_path mb_path = "/mboards/0";
+    _tree->create<std::string>("/name").set("Simulated Device");
+    _tree->create<std::string>(mb_path / "name").set("SIM");
+    mboard_eeprom_t mb_eeprom;
+    mb_eeprom["name"] = device_addr.get("name", "sim");
+    mb_eeprom["serial"] = device_addr.get("serial", "SIM0");
+    _tree->create<mboard_eeprom_t>(mb_path / "eeprom").set(mb_eeprom);
+
+    ////////////////////////////////////////////////////////////////////
+    // create codec control objects
+    ////////////////////////////////////////////////////////////////////
+    _tree->create<std::string>(mb_path / "rx_codecs" / "A" / "name").set("Simulated ADC");
+    _tree->create<int>(mb_path / "rx_codecs" / "A" / "gains"); //empty cuz gains are in frontend
+    _tree->create<std::string>(mb_path / "tx_codecs" / "A" / "name").set("Simulated DAC");
+    _tree->create<int>(mb_path / "tx_codecs" / "A" / "gains"); //empty cuz gains are in frontend
+
+    ////////////////////////////////////////////////////////////////////
+    // create clock and time control objects
+    ////////////////////////////////////////////////////////////////////
+    _tree->create<double>(mb_path / "tick_rate")
+        .coerce(boost::bind(&sim_impl::set_tick_rate, this, _1))
+        .subscribe(boost::bind(&sim_impl::update_tick_rate, this, _1));
+    _tree->create<time_spec_t>(mb_path / "time" / "now")
+        .publish(boost::bind(&sim_impl::get_time_now, this))
+        .subscribe(boost::bind(&sim_impl::set_time_now, this, _1));
+    _tree->create<time_spec_t>(mb_path / "time" / "pps")
+        .publish(boost::bind(&sim_impl::get_time_last_pps, this))
+        .subscribe(boost::bind(&sim_impl::set_time_next_pps, this, _1));
+    _tree->create<time_spec_t>(mb_path / "time" / "cmd");
+
+    //host side messages for recv_async_msg()
+    _tree->create<async_metadata_t>(mb_path / "async_msg")
+        .subscribe(boost::bind(&async_md_type::push_with_pop_on_full, _async_md, _1));
+
+    static const std::vector<std::string> sources(1, "internal");
+    _tree->create<std::string>(mb_path / "time_source" / "value")
+        .subscribe(boost::bind(&uhd::assert_has<std::string, std::vector<std::string> >, sources, _1, "time source"))
+        .set("internal");
+    _tree->create<std::vector<std::string> >(mb_path / "time_source" / "options").set(sources);
+    _tree->create<std::string>(mb_path / "clock_source" / "value")
+        .subscribe(boost::bind(&uhd::assert_has<std::string, std::vector<std::string> >, sources, _1, "clock source"))
+        .set("internal");
+    _tree->create<std::vector<std::string> >(mb_path / "clock_source" / "options").set(sources);
+    _tree->create<sensor_value_t>(mb_path / "sensors" / "ref_locked")
+        .set(sensor_value_t("Ref", true, "locked", "unlocked"));
+
+    ////////////////////////////////////////////////////////////////////
+    // create frontend mapping
+    ////////////////////////////////////////////////////////////////////
+    std::vector<size_t> default_map(_num_chans, 0);
+    subdev_spec_t default_spec;
+    for (size_t i = 0; i < _num_chans; i++)
+    {
+        default_map[i] = i;
+        default_spec.push_back(subdev_spec_pair_t("A", boost::lexical_cast<std::string>(i)));
+    }
+    _tree->create<std::vector<size_t> >(mb_path / "rx_chan_dsp_mapping").set(default_map);
+    _tree->create<std::vector<size_t> >(mb_path / "tx_chan_dsp_mapping").set(default_map);
+    _tree->create<subdev_spec_t>(mb_path / "rx_subdev_spec")
+        .subscribe(boost::bind(&sim_impl::update_subdev_spec, this, "rx", _1));
+    _tree->create<subdev_spec_t>(mb_path / "tx_subdev_spec")
+        .subscribe(boost::bind(&sim_impl::update_subdev_spec, this, "tx", _1));
+
+    ////////////////////////////////////////////////////////////////////
+    // create dsp and frontend objects
+    ////////////////////////////////////////////////////////////////////
+    dboard_eeprom_t db_eeprom;
+    _tree->create<dboard_eeprom_t>(mb_path / "dboards" / "A" / "rx_eeprom").set(db_eeprom);
+    _tree->create<dboard_eeprom_t>(mb_path / "dboards" / "A" / "tx_eeprom").set(db_eeprom);
+    _tree->create<dboard_eeprom_t>(mb_path / "dboards" / "A" / "gdb_eeprom").set(db_eeprom);
+
+    for (size_t dspno = 0; dspno < _num_chans; dspno++)
+    {
+        const std::string dsp_name = boost::lexical_cast<std::string>(dspno);
+        for (size_t direction = 0; direction < 2; direction++)
+        {
+            const std::string x = direction? "rx" : "tx";
+            const double max_freq = SIM_DEFAULT_TICK_RATE/2;
+
+            const fs_path dsp_path = mb_path / (x+"_dsps") / dsp_name;
+            _tree->create<meta_range_t>(dsp_path / "rate" / "range")
+                .publish(boost::bind(&sim_impl::get_samp_rates, this));
+            _tree->create<double>(dsp_path / "rate" / "value")
+                .coerce(boost::bind(&sim_impl::coerce_samp_rate, this, _1))
+                .subscribe(direction?
+                    boost::bind(&sim_impl::update_rx_samp_rate, this, dspno, _1) :
+                    boost::bind(&sim_impl::update_tx_samp_rate, this, dspno, _1));
+            _tree->create<meta_range_t>(dsp_path / "freq" / "range")
+                .set(meta_range_t(-max_freq, +max_freq));
+            _tree->create<double>(dsp_path / "freq" / "value")
+                .coerce(boost::bind(&meta_range_t::clip, meta_range_t(-max_freq, +max_freq), _1, false))
+                .set(0.0);
+            if (direction)
+            {
+                _tree->create<stream_cmd_t>(dsp_path / "stream_cmd")
+                    .subscribe(boost::bind(&sim_impl::issue_stream_cmd, this, dspno, _1));
+            }
+
+            const fs_path rf_fe_path = mb_path / "dboards" / "A" / (x+"_frontends") / dsp_name;
+            const meta_range_t freq_range(10e6, 6e9);
+            const meta_range_t gain_range(0.0, 76.0, 1.0);
+            const meta_range_t bw_range(200e3, 56e6);
+            _tree->create<std::string>(rf_fe_path / "name").set("SIM-" + boost::to_upper_copy(x) + dsp_name);
+            _tree->create<int>(rf_fe_path / "sensors"); //empty
+            _tree->create<meta_range_t>(rf_fe_path / "gains" / "PGA" / "range").set(gain_range);
+            _tree->create<double>(rf_fe_path / "gains" / "PGA" / "value")
+                .coerce(boost::bind(&meta_range_t::clip, gain_range, _1, true))
+                .set(0.0);
+            _tree->create<std::string>(rf_fe_path / "connection").set("IQ");
+            _tree->create<bool>(rf_fe_path / "enabled").set(true);
+            _tree->create<bool>(rf_fe_path / "use_lo_offset").set(false);
+            _tree->create<meta_range_t>(rf_fe_path / "bandwidth" / "range").set(bw_range);
+            _tree->create<double>(rf_fe_path / "bandwidth" / "value")
+                .coerce(boost::bind(&meta_range_t::clip, bw_range, _1, false))
+                .set(bw_range.stop());
+            _tree->create<meta_range_t>(rf_fe_path / "freq" / "range").set(freq_range);
+            _tree->create<double>(rf_fe_path / "freq" / "value")
+                .coerce(boost::bind(&meta_range_t::clip, freq_range, _1, false))
+                .set(SIM_DEFAULT_FREQ);
+            const std::vector<std::string> ants(1, direction? "RX" : "TX");
+            _tree->create<std::vector<std::string> >(rf_fe_path / "antenna" / "options").set(ants);
+            _tree->create<std::string>(rf_fe_path / "antenna" / "value").set(ants.front());
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // do some post-init tasks
+    ////////////////////////////////////////////////////////////////////
+    _tree->access<double>(mb_path / "tick_rate").set(
+        device_addr.cast<double>("master_clock_rate", SIM_DEFAULT_TICK_RATE));
+    for (size_t dspno = 0; dspno < _num_chans; dspno++)
+    {
+        const std::string dsp_name = boost::lexical_cast<std::string>(dspno);
+        _tree->access<double>(mb_path / "rx_dsps" / dsp_name / "rate" / "value").set(SIM_DEFAULT_SAMP_RATE);
+        _tree->access<double>(mb_path / "tx_dsps" / dsp_name / "rate" / "value").set(SIM_DEFAULT_SAMP_RATE);
+    }
+    _tree->access<subdev_spec_t>(mb_path / "rx_subdev_spec").set(default_spec);
+    _tree->access<subdev_spec_t>(mb_path / "tx_subdev_spec").set(default_spec);
+    _tree->access<time_spec_t>(mb_path / "time" / "now").set(time_spec_t(0.0));
+}
+
+sim_impl::~sim_impl(void)
+{
+    /* NOP */
+}
+
+/***********************************************************************
+ * Time: the host clock with an offset, PPS edges on whole host seconds
+ **********************************************************************/
+time_spec_t sim_impl::get_time_now(void)
+{
+    boost::mutex::scoped_lock lock(_time_mutex);
+    return time_spec_t::get_system_time() + _time_offset;
+}
+
+time_spec_t sim_impl::get_time_last_pps(void)
+{
+    boost::mutex::scoped_lock lock(_time_mutex);
+    return time_spec_t(double(time_spec_t::get_system_time().get_full_secs())) + _time_offset;
+}
+
+void sim_impl::set_time_now(const time_spec_t &time)
+{
+    boost::mutex::scoped_lock lock(_time_mutex);
+    _time_offset = time - time_spec_t::get_system_time();
+}
+
+void sim_impl::set_time_next_pps(const time_spec_t &time)
+{
+    //the new time applies from now on, as if the PPS edge already happened
+    boost::mutex::scoped_lock lock(_time_mutex);
+    const time_spec_t next_pps(double(time_spec_t::get_system_time().get_full_secs() + 1));
+    _time_offset = time - next_pps;
+}
+
+/***********************************************************************
+ * Rates
+ **********************************************************************/
+double sim_impl::set_tick_rate(const double rate)
+{
+    if (rate <= 0.0) throw uhd::value_error("master_clock_rate must be positive");
+    _tick_rate = rate;
+    return rate;
+}
+
+void sim_impl::update_tick_rate(const double rate)
+{
+    for (size_t dspno = 0; dspno < _num_chans; dspno++)
+    {
+        boost::shared_ptr<sph::recv_packet_streamer> rx_streamer = _rx_streamers[dspno].lock();
+        if (rx_streamer) rx_streamer->set_tick_rate(rate);
+        boost::shared_ptr<sph::send_packet_streamer> tx_streamer = _tx_streamers[dspno].lock();
+        if (tx_streamer) tx_streamer->set_tick_rate(rate);
+        //coerce the sample rates again for the new tick rate
+        const std::string dsp_name = boost::lexical_cast<std::string>(dspno);
+        _tree->access<double>(fs_path("/mboards/0/rx_dsps") / dsp_name / "rate" / "value").set(_rx_rates[dspno]);
+        _tree->access<double>(fs_path("/mboards/0/tx_dsps") / dsp_name / "rate" / "value").set(_tx_rates[dspno]);
+    }
+}
+
+double sim_impl::coerce_samp_rate(const double rate)
+{
+    const double decim = std::max(1.0, std::min(double(SIM_MAX_DECIM), boost::math::round(_tick_rate/rate)));
+    return _tick_rate/decim;
+}
+
+meta_range_t sim_impl::get_samp_rates(void)
+{
+    meta_range_t range;
+    for (size_t decim = SIM_MAX_DECIM; decim > 0; decim--)
+    {
+        range.push_back(range_t(_tick_rate/decim));
+    }
+    return range;
+}
+
+void sim_impl::update_rx_samp_rate(const size_t dspno, const double rate)
+{
+    _rx_rates[dspno] = rate;
+    boost::shared_ptr<sph::recv_packet_streamer> my_streamer = _rx_streamers[dspno].lock();
+    if (my_streamer) my_streamer->set_samp_rate(rate);
+    sim_zero_copy::sptr xport = _rx_xports[dspno].lock();
+    if (xport) xport->set_rates(rate, _tick_rate);
+}
+
+void sim_impl::update_tx_samp_rate(const size_t dspno, const double rate)
+{
+    _tx_rates[dspno] = rate;
+    boost::shared_ptr<sph::send_packet_streamer> my_streamer = _tx_streamers[dspno].lock();
+    if (my_streamer) my_streamer->set_samp_rate(rate);
+    sim_zero_copy::sptr xport = _tx_xports[dspno].lock();
+    if (xport) xport->set_rates(rate, _tick_rate);
+}
+
+/***********************************************************************
+ * Frontend mapping
+ **********************************************************************/
+void sim_impl::update_subdev_spec(const std::string &tx_rx, const subdev_spec_t &spec)
+{
+    std::vector<size_t> chan_to_dsp_map(spec.size(), 0);
+    for (size_t i = 0; i < spec.size(); i++)
+    {
+        size_t dspno = _num_chans;
+        try
+        {
+            dspno = boost::lexical_cast<size_t>(spec[i].sd_name);
+        }
+        catch(const boost::bad_lexical_cast &)
+        {
+            //bad name, caught by the range check below
+        }
+        if (spec[i].db_name != "A" or dspno >= _num_chans)
+        {
+            throw uhd::value_error(str(boost::format(
+                "The simulated device has no %s frontend %s:%s"
+            ) % tx_rx % spec[i].db_name % spec[i].sd_name));
+        }
+        chan_to_dsp_map[i] = dspno;
+    }
+    _tree->access<std::vector<size_t> >(fs_path("/mboards/0") / (tx_rx + "_chan_dsp_mapping")).set(chan_to_dsp_map);
+}
+
+size_t sim_impl::get_dsp_for_chan(const std::string &tx_rx, const size_t chan)
+{
+    const std::vector<size_t> dsp_map =
+        _tree->access<std::vector<size_t> >(fs_path("/mboards/0") / (tx_rx + "_chan_dsp_mapping")).get();
+    if (chan >= dsp_map.size())
+    {
+        throw uhd::index_error(str(boost::format(
+            "The simulated device has no %s channel %u"
+        ) % tx_rx % chan));
+    }
+    return dsp_map[chan];
+}
@@ -0,0 +1,100 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_SIM_IMPL_HPP
+#define INCLUDED_SIM_IMPL_HPP
+
+#include <uhd/property_tree.hpp>
+#include <uhd/device.hpp>
+#include <uhd/usrp/subdev_spec.hpp>
+#include <uhd/types/sensors.hpp>
+#include <uhd/types/ranges.hpp>
+#include <uhd/types/stream_cmd.hpp>
+#include <uhd/transport/sim_zero_copy.hpp>
+#include <uhd/transport/bounded_buffer.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+#include <vector>
+
+static const double SIM_DEFAULT_TICK_RATE = 200e6;
+static const double SIM_DEFAULT_SAMP_RATE = 1e6;
+static const double SIM_DEFAULT_FREQ = 1e9;
+static const size_t SIM_DEFAULT_NUM_CHANS = 2;
+static const size_t SIM_MAX_DECIM = 1024;
+static const size_t SIM_MAX_HDR_LEN = 16; // bytes, CHDR or VRT with sid and tsf
+
+namespace uhd{ namespace transport{ namespace sph{
+    class recv_packet_streamer;
+    class send_packet_streamer;
+}}}
+
+/*!
+ * A simulated device for measuring the host streaming code.
+ *
+ * The device has one motherboard with a number of RX and TX channels.
+ * Each streamer channel gets a sim_zero_copy transport that generates
+ * and consumes packets at the configured sample rate, so streaming
+ * apps (benchmark_rate, latency_test) run without hardware.
+ */
+class sim_impl : public uhd::device
+{
+public:
+    sim_impl(const uhd::device_addr_t &);
+    ~sim_impl(void);
+
+    //the io interface
+    uhd::rx_streamer::sptr get_rx_stream(const uhd::stream_args_t &);
+    uhd::tx_streamer::sptr get_tx_stream(const uhd::stream_args_t &);
+    bool recv_async_msg(uhd::async_metadata_t &, double);
+
+    typedef uhd::transport::bounded_buffer<uhd::async_metadata_t> async_md_type;
+
+private:
+    uhd::device_addr_t _args;
+    size_t _num_chans;
+    boost::mutex _transport_setup_mutex;
+    boost::shared_ptr<async_md_type> _async_md;
+
+    //device time: the host clock plus an offset
+    boost::mutex _time_mutex;
+    uhd::time_spec_t _time_offset;
+    uhd::time_spec_t get_time_now(void);
+    uhd::time_spec_t get_time_last_pps(void);
+    void set_time_now(const uhd::time_spec_t &time);
+    void set_time_next_pps(const uhd::time_spec_t &time);
+
+    //rates
+    double _tick_rate;
+    std::vector<double> _rx_rates, _tx_rates;
+    double set_tick_rate(const double rate);
+    void update_tick_rate(const double rate);
+    double coerce_samp_rate(const double rate);
+    uhd::meta_range_t get_samp_rates(void);
+    void update_rx_samp_rate(const size_t dspno, const double rate);
+    void update_tx_samp_rate(const size_t dspno, const double rate);
+    void update_subdev_spec(const std::string &tx_rx, const uhd::usrp::subdev_spec_t &spec);
+    void issue_stream_cmd(const size_t dspno, const uhd::stream_cmd_t &stream_cmd);
+
+    //streamers and transports of each dsp, held weakly
+    std::vector<boost::weak_ptr<uhd::transport::sph::recv_packet_streamer> > _rx_streamers;
+    std::vector<boost::weak_ptr<uhd::transport::sph::send_packet_streamer> > _tx_streamers;
+    std::vector<boost::weak_ptr<uhd::transport::sim_zero_copy> > _rx_xports, _tx_xports;
+    uhd::transport::sim_zero_copy::sptr make_transport(const uhd::device_addr_t &stream_args);
+    size_t get_dsp_for_chan(const std::string &tx_rx, const size_t chan);
+};
+
+#endif /* INCLUDED_SIM_IMPL_HPP */
@@ -0,0 +1,261 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "sim_impl.hpp"
+#include "async_packet_handler.hpp"
+#include "publish_stream_stats.hpp"
+#include "../../transport/super_recv_packet_handler.hpp"
+#include "../../transport/super_send_packet_handler.hpp"
+#include <uhd/utils/log.hpp>
+#include <uhd/exception.hpp>
+#include <boost/format.hpp>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#include <algorithm>
+
+using namespace uhd;
+using namespace uhd::usrp;
+using namespace uhd::transport;
+
+/***********************************************************************
+ * VITA stuff
+ **********************************************************************/
+static void sim_if_hdr_unpack_chdr(
+    const boost::uint32_t *packet_buff,
+    vrt::if_packet_info_t &if_packet_info
+){
+    if_packet_info.link_type = vrt::if_packet_info_t::LINK_TYPE_CHDR;
+    return vrt::if_hdr_unpack_le(packet_buff, if_packet_info);
+}
+
+static void sim_if_hdr_pack_chdr(
+    boost::uint32_t *packet_buff,
+    vrt::if_packet_info_t &if_packet_info
+){
+    if_packet_info.link_type = vrt::if_packet_info_t::LINK_TYPE_CHDR;
+    return vrt::if_hdr_pack_le(packet_buff, if_packet_info);
+}
+
+static void sim_if_hdr_unpack_vrt(
+    const boost::uint32_t *packet_buff,
+    vrt::if_packet_info_t &if_packet_info
+){
+    if_packet_info.link_type = vrt::if_packet_info_t::LINK_TYPE_NONE;
+    return vrt::if_hdr_unpack_le(packet_buff, if_packet_info);
+}
+
+static void sim_if_hdr_pack_vrt(
+    boost::uint32_t *packet_buff,
+    vrt::if_packet_info_t &if_packet_info
+){
+    if_packet_info.link_type = vrt::if_packet_info_t::LINK_TYPE_NONE;
+    return vrt::if_hdr_pack_le(packet_buff, if_packet_info);
+}
+
+/***********************************************************************
+ * Transport setup
+ **********************************************************************/
+sim_zero_copy::sptr sim_impl::make_transport(const device_addr_t &stream_args)
+{
+    //stream args override the device args (frame sizes, sim_* knobs)
+    device_addr_t hints = _args;
+    BOOST_FOREACH(const std::string &key, stream_args.keys())
+    {
+        hints[key] = stream_args[key];
+    }
+    sim_zero_copy::sptr xport = sim_zero_copy::make(hints);
+    //Using "this" is OK because we know that sim_impl will outlive the transport
+    xport->set_time_source(boost::bind(&sim_impl::get_time_now, this));
+    return xport;
+}
+
+/***********************************************************************
+ * Async Data
+ **********************************************************************/
+bool sim_impl::recv_async_msg(
+    async_metadata_t &async_metadata, double timeout
+){
+    return _async_md->pop_with_timed_wait(async_metadata, timeout);
+}
+
+static void handle_tx_async_msg(
+    boost::shared_ptr<sim_impl::async_md_type> async_queue,
+    boost::shared_ptr<sim_impl::async_md_type> old_async_queue,
+    const size_t stream_channel,
+    const size_t device_channel,
+    async_metadata_t metadata
+){
+    metadata.channel = stream_channel;
+    async_queue->push_with_pop_on_full(metadata);
+    metadata.channel = device_channel;
+    old_async_queue->push_with_pop_on_full(metadata);
+    standard_async_msg_prints(metadata);
+}
+
+void sim_impl::issue_stream_cmd(const size_t dspno, const stream_cmd_t &stream_cmd)
+{
+    sim_zero_copy::sptr xport = _rx_xports[dspno].lock();
+    if (xport) xport->issue_stream_cmd(stream_cmd);
+}
+
+/***********************************************************************
+ * Receive streamer
+ **********************************************************************/
+rx_streamer::sptr sim_impl::get_rx_stream(const uhd::stream_args_t &args_)
+{
+    boost::mutex::scoped_lock lock(_transport_setup_mutex);
+    stream_args_t args = args_;
+
+    //setup defaults for unspecified values
+    if (not args.otw_format.empty() and args.otw_format != "sc16")
+    {
+        throw uhd::value_error("sim_impl::get_rx_stream only supports otw_format sc16");
+    }
+    args.otw_format = "sc16";
+    args.channels = args.channels.empty()? std::vector<size_t>(1, 0) : args.channels;
+
+    boost::shared_ptr<sph::recv_packet_streamer> my_streamer;
+    for (size_t stream_i = 0; stream_i < args.channels.size(); stream_i++)
+    {
+        const size_t chan = args.channels[stream_i];
+        const size_t dspno = this->get_dsp_for_chan("rx", chan);
+
+        sim_zero_copy::sptr xport = this->make_transport(args.args);
+        const size_t bpp = xport->get_recv_frame_size() - SIM_MAX_HDR_LEN; // bytes per packet
+        const size_t bpi = convert::get_bytes_per_item(args.otw_format); // bytes per item
+        const size_t spp = std::min<size_t>(bpp/bpi, unsigned(args.args.cast<double>("spp", bpp/bpi))); // samples per packet
+        xport->set_samps_per_packet(spp);
+        xport->set_sid(boost::uint32_t(dspno));
+
+        //make the new streamer given the samples per packet
+        if (not my_streamer) my_streamer = boost::make_shared<sph::recv_packet_streamer>(spp);
+        my_streamer->resize(args.channels.size());
+        my_streamer->set_vrt_unpacker(xport->is_chdr()? &sim_if_hdr_unpack_chdr : &sim_if_hdr_unpack_vrt);
+
+        //set the converter
+        uhd::convert::id_type id;
+        id.input_format = args.otw_format + "_item32_le";
+        id.num_inputs = 1;
+        id.output_format = args.cpu_format;
+        id.num_outputs = 1;
+        my_streamer->set_converter(id);
+
+        //Give the streamer a functor to get the recv_buffer
+        //bind requires a zero_copy_if::sptr to add a streamer->xport lifetime dependency
+        my_streamer->set_xport_chan_get_buff(
+            stream_i,
+            boost::bind(&zero_copy_if::get_recv_buff, xport, _1),
+            true /*flush*/
+        );
+        //The simulated device keeps streaming through an overflow,
+        //so the default (no-op) overflow handler is used.
+        my_streamer->set_issue_stream_cmd(
+            stream_i, boost::bind(&sim_zero_copy::issue_stream_cmd, xport, _1)
+        );
+
+        //Store weak pointers to prevent a streamer->sim_impl->streamer circular dependency
+        _rx_streamers[dspno] = boost::weak_ptr<sph::recv_packet_streamer>(my_streamer);
+        _rx_xports[dspno] = xport;
+
+        //sets all tick and samp rates on this streamer
+        my_streamer->set_tick_rate(_tick_rate);
+        this->update_rx_samp_rate(dspno, _rx_rates[dspno]);
+    }
+
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "rx", args.channels, std::vector<std::string>(), my_streamer->get_stats_block());
+
+    return my_streamer;
+}
+
+/***********************************************************************
+ * Transmit streamer
+ **********************************************************************/
+tx_streamer::sptr sim_impl::get_tx_stream(const uhd::stream_args_t &args_)
+{
+    boost::mutex::scoped_lock lock(_transport_setup_mutex);
+    stream_args_t args = args_;
+
+    //setup defaults for unspecified values
+    if (not args.otw_format.empty() and args.otw_format != "sc16")
+    {
+        throw uhd::value_error("sim_impl::get_tx_stream only supports otw_format sc16");
+    }
+    args.otw_format = "sc16";
+    args.channels = args.channels.empty()? std::vector<size_t>(1, 0) : args.channels;
+
+    //shared async queue for all channels in streamer
+    boost::shared_ptr<async_md_type> async_md(new async_md_type(1000/*messages deep*/));
+
+    boost::shared_ptr<sph::send_packet_streamer> my_streamer;
+    for (size_t stream_i = 0; stream_i < args.channels.size(); stream_i++)
+    {
+        const size_t chan = args.channels[stream_i];
+        const size_t dspno = this->get_dsp_for_chan("tx", chan);
+
+        sim_zero_copy::sptr xport = this->make_transport(args.args);
+        const size_t bpp = xport->get_send_frame_size() - SIM_MAX_HDR_LEN;
+        const size_t bpi = convert::get_bytes_per_item(args.otw_format);
+        const size_t spp = unsigned(args.args.cast<double>("spp", bpp/bpi));
+
+        //make the new streamer given the samples per packet
+        if (not my_streamer) my_streamer = boost::make_shared<sph::send_packet_streamer>(spp);
+        my_streamer->resize(args.channels.size());
+        my_streamer->set_vrt_packer(xport->is_chdr()? &sim_if_hdr_pack_chdr : &sim_if_hdr_pack_vrt);
+
+        //set the converter
+        uhd::convert::id_type id;
+        id.input_format = args.cpu_format;
+        id.num_inputs = 1;
+        id.output_format = args.otw_format + "_item32_le";
+        id.num_outputs = 1;
+        my_streamer->set_converter(id);
+
+        //transmit events go to the streamer and to the device queue
+        xport->set_async_handler(boost::bind(&handle_tx_async_msg, async_md, _async_md, stream_i, chan, _1));
+
+        //Give the streamer a functor to get the send buffer
+        //the transport applies the flow control of the simulated device buffer
+        my_streamer->set_xport_chan_get_buff(
+            stream_i,
+            boost::bind(&zero_copy_if::get_send_buff, xport, _1)
+        );
+        my_streamer->set_xport_chan_fc_credit(
+            stream_i, boost::bind(&sim_zero_copy::get_send_credit, xport)
+        );
+        //Give the streamer a functor handled received async messages
+        my_streamer->set_async_receiver(
+            boost::bind(&async_md_type::pop_with_timed_wait, async_md, _1, _2)
+        );
+        my_streamer->set_xport_chan_sid(stream_i, true, boost::uint32_t(dspno));
+        my_streamer->set_enable_trailer(false);
+
+        //Store weak pointers to prevent a streamer->sim_impl->streamer circular dependency
+        _tx_streamers[dspno] = boost::weak_ptr<sph::send_packet_streamer>(my_streamer);
+        _tx_xports[dspno] = xport;
+
+        //sets all tick and samp rates on this streamer
+        my_streamer->set_tick_rate(_tick_rate);
+        this->update_tx_samp_rate(dspno, _tx_rates[dspno]);
+    }
+
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "tx", args.channels, std::vector<std::string>(), my_streamer->get_stats_block());
+
+    return my_streamer;
+}
@@ -0,0 +1,333 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/usrp/timed_command_queue.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <uhd/utils/msg.hpp>
+#include <uhd/utils/safe_call.hpp>
+#include <uhd/exception.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <boost/bind.hpp>
+#include <deque>
+
+using namespace uhd;
+using namespace uhd::usrp;
+
+static boost::posix_time::time_duration to_time_dur(const double timeout){
+    return boost::posix_time::microseconds(long(timeout*1e6));
+}
+
+/***********************************************************************
+ * Batch operations: each sets the command time of its own mboard
+ **********************************************************************/
+class scoped_command_time{
+public:
+    scoped_command_time(multi_usrp::sptr usrp, const time_spec_t &time_spec, const size_t mboard):
+        _usrp(usrp), _mboard(mboard)
+    {
+        _usrp->set_command_time(time_spec, _mboard);
+    }
+
+    ~scoped_command_time(void){
+        UHD_SAFE_CALL(_usrp->clear_command_time(_mboard);)
+    }
+
+private:
+    multi_usrp::sptr _usrp;
+    const size_t _mboard;
+};
+
+static size_t chan_to_mboard(multi_usrp::sptr usrp, const bool is_rx, size_t chan){
+    if (chan == multi_usrp::ALL_CHANS) return multi_usrp::ALL_MBOARDS;
+    for (size_t mboard = 0; mboard < usrp->get_num_mboards(); mboard++){
+        const size_t num_chans = (is_rx? usrp->get_rx_subdev_spec(mboard) : usrp->get_tx_subdev_spec(mboard)).size();
+        if (chan < num_chans) return mboard;
+        chan -= num_chans;
+    }
+    throw uhd::index_error(str(boost::format("timed_command_queue: invalid channel %d") % chan));
+}
+
+static void do_set_rx_gain(multi_usrp::sptr usrp, const time_spec_t &time_spec, double gain, const std::string &name, size_t chan){
+    scoped_command_time cmd_time(usrp, time_spec, chan_to_mboard(usrp, true, chan));
+    usrp->set_rx_gain(gain, name, chan);
+}
+
+static void do_set_tx_gain(multi_usrp::sptr usrp, const time_spec_t &time_spec, double gain, const std::string &name, size_t chan){
+    scoped_command_time cmd_time(usrp, time_spec, chan_to_mboard(usrp, false, chan));
+    usrp->set_tx_gain(gain, name, chan);
+}
+
+static void do_set_rx_freq(multi_usrp::sptr usrp, const time_spec_t &time_spec, const tune_request_t &tune_request, size_t chan){
+    scoped_command_time cmd_time(usrp, time_spec, chan_to_mboard(usrp, true, chan));
+    usrp->set_rx_freq(tune_request, chan);
+}
+
+static void do_set_tx_freq(multi_usrp::sptr usrp, const time_spec_t &time_spec, const tune_request_t &tune_request, size_t chan){
+    scoped_command_time cmd_time(usrp, time_spec, chan_to_mboard(usrp, false, chan));
+    usrp->set_tx_freq(tune_request, chan);
+}
+
+static void do_set_gpio_attr(
+    multi_usrp::sptr usrp, const time_spec_t &time_spec,
+    const std::string &bank, const std::string &attr,
+    const boost::uint32_t value, const boost::uint32_t mask, const size_t mboard
+){
+    scoped_command_time cmd_time(usrp, time_spec, mboard);
+    usrp->set_gpio_attr(bank, attr, value, mask, mboard);
+}
+
+//stream commands carry their own time spec, no command time needed
+static void do_issue_stream_cmd(multi_usrp::sptr usrp, const time_spec_t &time_spec, stream_cmd_t stream_cmd, size_t chan){
+    if (stream_cmd.stream_now){
+        stream_cmd.stream_now = false;
+        stream_cmd.time_spec = time_spec;
+    }
+    usrp->issue_stream_cmd(stream_cmd, chan);
+}
+
+static void do_operation(
+    multi_usrp::sptr usrp, const time_spec_t &time_spec,
+    const timed_command_batch_t::operation_t &operation, const size_t mboard
+){
+    scoped_command_time cmd_time(usrp, time_spec, mboard);
+    operation(usrp);
+}
+
+timed_command_batch_t::timed_command_batch_t(const time_spec_t &time_spec_, const size_t id_):
+    time_spec(time_spec_), id(id_)
+{
+    /* NOP */
+}
+
+void timed_command_batch_t::set_rx_gain(double gain, const std::string &name, size_t chan){
+    _operations.push_back(boost::bind(&do_set_rx_gain, _1, _2, gain, name, chan));
+}
+
+void timed_command_batch_t::set_tx_gain(double gain, const std::string &name, size_t chan){
+    _operations.push_back(boost::bind(&do_set_tx_gain, _1, _2, gain, name, chan));
+}
+
+void timed_command_batch_t::set_rx_freq(const tune_request_t &tune_request, size_t chan){
+    _operations.push_back(boost::bind(&do_set_rx_freq, _1, _2, tune_request, chan));
+}
+
+void timed_command_batch_t::set_tx_freq(const tune_request_t &tune_request, size_t chan){
+    _operations.push_back(boost::bind(&do_set_tx_freq, _1, _2, tune_request, chan));
+}
+
+void timed_command_batch_t::set_gpio_attr(
+    const std::string &bank, const std::string &attr,
+    const boost::uint32_t value, const boost::uint32_t mask,
+    const size_t mboard
+){
+    _operations.push_back(boost::bind(&do_set_gpio_attr, _1, _2, bank, attr, value, mask, mboard));
+}
+
+void timed_command_batch_t::issue_stream_cmd(const stream_cmd_t &stream_cmd, size_t chan){
+    _operations.push_back(boost::bind(&do_issue_stream_cmd, _1, _2, stream_cmd, chan));
+}
+
+void timed_command_batch_t::add_operation(const operation_t &operation, const size_t mboard){
+    _operations.push_back(boost::bind(&do_operation, _1, _2, operation, mboard));
+}
+
+const std::vector<timed_command_batch_t::timed_operation_t> &timed_command_batch_t::get_operations(void) const{
+    return _operations;
+}
+
+/***********************************************************************
+ * Events as async messages
+ **********************************************************************/
+const boost::uint32_t timed_command_event_t::USER_PAYLOAD_TAG;
+
+async_metadata_t timed_command_event_t::to_async_metadata(void) const{
+    async_metadata_t async_metadata;
+    async_metadata.channel = 0;
+    async_metadata.has_time_spec = true;
+    async_metadata.time_spec = this->time_spec;
+    async_metadata.event_code = async_metadata_t::EVENT_CODE_USER_PAYLOAD;
+    async_metadata.user_payload[0] = USER_PAYLOAD_TAG;
+    async_metadata.user_payload[1] = boost::uint32_t(this->id);
+    async_metadata.user_payload[2] = boost::uint32_t(this->event_code);
+    async_metadata.user_payload[3] = 0;
+    return async_metadata;
+}
+
+bool timed_command_event_t::from_async_metadata(const async_metadata_t &async_metadata){
+    if (async_metadata.event_code != async_metadata_t::EVENT_CODE_USER_PAYLOAD) return false;
+    if (async_metadata.user_payload[0] != USER_PAYLOAD_TAG) return false;
+    this->id = async_metadata.user_payload[1];
+    this->time_spec = async_metadata.time_spec;
+    this->event_code = event_code_t(async_metadata.user_payload[2]);
+    return true;
+}
+
+/***********************************************************************
+ * Command queue implementation
+ **********************************************************************/
+class timed_command_queue_impl : public timed_command_queue{
+public:
+    timed_command_queue_impl(multi_usrp::sptr usrp, const size_t capacity, const size_t mboard):
+        _usrp(usrp),
+        _capacity(capacity),
+        _mboard(mboard),
+        _busy(false)
+    {
+        if (_capacity == 0) throw uhd::value_error("timed_command_queue: capacity must be non-zero");
+        _tree = _usrp->get_device()->get_tree();
+        _mb_path = "/mboards/" + _tree->list("/mboards").at(_mboard);
+        if (not _tree->exists(_mb_path / "async_msg")){
+            throw uhd::not_implemented_error("timed_command_queue: the device does not take host side async messages");
+        }
+        _task = task::make(boost::bind(&timed_command_queue_impl::task_loop, this), "uhd_timed_cmd");
+    }
+
+    ~timed_command_queue_impl(void){
+        UHD_SAFE_CALL(
+            this->clear();
+            _task.reset();
+        )
+    }
+
+    bool push(const timed_command_batch_t &batch, const double timeout){
+        boost::mutex::scoped_lock lock(_mutex);
+        if (_batches.size() >= _capacity){
+            if (not _not_full.timed_wait(lock, to_time_dur(timeout), boost::bind(&timed_command_queue_impl::not_full, this))){
+                return false;
+            }
+        }
+        _batches.push_back(batch);
+        lock.unlock();
+        _not_empty.notify_one();
+        return true;
+    }
+
+    size_t get_num_pending(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        return _batches.size() + (_busy? 1 : 0);
+    }
+
+    size_t get_capacity(void){
+        return _capacity;
+    }
+
+    bool wait_for_empty(const double timeout){
+        boost::mutex::scoped_lock lock(_mutex);
+        return _empty.timed_wait(lock, to_time_dur(timeout), boost::bind(&timed_command_queue_impl::is_empty, this));
+    }
+
+    void clear(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        _batches.clear();
+        lock.unlock();
+        _not_full.notify_all();
+        _empty.notify_all(); //empty now unless a batch is being issued
+    }
+
+    void run_exclusive(const timed_command_batch_t::operation_t &operation){
+        boost::mutex::scoped_lock lock(_device_mutex);
+        operation(_usrp);
+    }
+
+private:
+    bool not_full(void) const{
+        return _batches.size() < _capacity;
+    }
+
+    bool is_empty(void) const{
+        return _batches.empty() and not _busy;
+    }
+
+    /*******************************************************************
+     * Worker: issue one batch per call
+     ******************************************************************/
+    void task_loop(void){
+        timed_command_batch_t batch;
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            //wait with a timeout so the task can be interrupted
+            if (not _not_empty.timed_wait(lock, to_time_dur(0.1), boost::bind(&timed_command_queue_impl::has_batches, this))){
+                return;
+            }
+            batch = _batches.front();
+            _batches.pop_front();
+            _busy = true;
+        }
+        _not_full.notify_one();
+
+        timed_command_event_t event;
+        event.id = batch.id;
+        event.time_spec = batch.time_spec;
+        try{
+            //the command time is shared device state: see run_exclusive()
+            boost::mutex::scoped_lock device_lock(_device_mutex);
+            if (_usrp->get_time_now(_mboard) > batch.time_spec){
+                event.event_code = timed_command_event_t::EVENT_CODE_LATE;
+            }
+            else{
+                this->issue(batch);
+                event.event_code = timed_command_event_t::EVENT_CODE_ISSUED;
+            }
+        }
+        catch(const std::exception &ex){
+            event.event_code = timed_command_event_t::EVENT_CODE_ERROR;
+            UHD_MSG(error) << boost::format("timed_command_queue: batch %d failed: %s") % batch.id % ex.what() << std::endl;
+        }
+        _tree->access<async_metadata_t>(_mb_path / "async_msg").set(event.to_async_metadata());
+
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _busy = false;
+        }
+        _empty.notify_all();
+    }
+
+    bool has_batches(void) const{
+        return not _batches.empty();
+    }
+
+    void issue(const timed_command_batch_t &batch){
+        const std::vector<timed_command_batch_t::timed_operation_t> &ops = batch.get_operations();
+        for (size_t i = 0; i < ops.size(); i++) ops[i](_usrp, batch.time_spec);
+    }
+
+    multi_usrp::sptr _usrp;
+    property_tree::sptr _tree;
+    fs_path _mb_path;
+    const size_t _capacity;
+    const size_t _mboard;
+    boost::mutex _mutex, _device_mutex;
+    boost::condition_variable _not_empty, _not_full, _empty;
+    std::deque<timed_command_batch_t> _batches;
+    bool _busy;
+    task::sptr _task;
+};
+
+/***********************************************************************
+ * The make function
+ **********************************************************************/
+timed_command_queue::~timed_command_queue(void){
+    /* NOP */
+}
+
+timed_command_queue::sptr timed_command_queue::make(multi_usrp::sptr usrp, const size_t capacity, const size_t mboard){
+    return sptr(new timed_command_queue_impl(usrp, capacity, mboard));
+}
@@ -16,6 +16,7 @@
 //
 
 #include "validate_subdev_spec.hpp"
+#include "publish_stream_stats.hpp"
 #define SRPH_DONT_CHECK_SEQUENCE
 #include "../../transport/super_recv_packet_handler.hpp"
 #define SSPH_DONT_PAD_TO_ONE
@@ -32,6 +33,7 @@
 #include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/make_shared.hpp>
+#include <algorithm>
 
 #define bmFR_RX_FORMAT_SHIFT_SHIFT 0
 #define bmFR_RX_FORMAT_WIDTH_SHIFT 4
@@ -248,7 +250,7 @@ void usrp1_impl::io_init(void){
     //create a new vandal thread to poll xerflow conditions
     _io_impl->vandal_task = task::make(boost::bind(
         &usrp1_impl::vandal_conquest_loop, this
-    ));
+    ), "usrp1_vandal");
 }
 
 void usrp1_impl::rx_stream_on_off(bool enb){
@@ -279,11 +281,6 @@ void usrp1_impl::vandal_conquest_loop(void){
     async_metadata.has_time_spec = true;
     async_metadata.event_code = async_metadata_t::EVENT_CODE_UNDERFLOW;
 
-    //initialize the inline metadata
-    rx_metadata_t inline_metadata;
-    inline_metadata.has_time_spec = true;
-    inline_metadata.error_code = rx_metadata_t::ERROR_CODE_OVERFLOW;
-
     //start the polling loop...
     try{ while (not boost::this_thread::interruption_requested()){
         boost::uint8_t underflow = 0, overflow = 0;
@@ -308,8 +305,7 @@ void usrp1_impl::vandal_conquest_loop(void){
             UHD_MSG(fastpath) << "U";
         }
         if (_rx_enabled and overflow){
-            inline_metadata.time_spec = _soft_time_ctrl->get_time();
-            _soft_time_ctrl->get_inline_queue().push_with_pop_on_full(inline_metadata);
+            _soft_time_ctrl->rx_overflow();
             UHD_MSG(fastpath) << "O";
         }
 
@@ -346,14 +342,26 @@ public:
         const double timeout,
         const bool one_packet
     ){
-        //interleave a "soft" inline message into the receive stream:
-        if (_stc->get_inline_queue().pop_with_haste(metadata)) return 0;
-
-        size_t num_samps_recvd = sph::recv_packet_handler::recv(
-            buffs, nsamps_per_buff, metadata, timeout, one_packet
-        );
-
-        return _stc->recv_post(metadata, num_samps_recvd);
+        const time_spec_t exit_time = time_spec_t::get_system_time() + time_spec_t(timeout);
+        while (true){
+            //interleave a "soft" inline message into the receive stream:
+            if (_stc->get_inline_queue().pop_with_haste(metadata)) return 0;
+
+            //receive up to the next burst boundary, the samples outside of bursts are discarded
+            bool keep = false;
+            const size_t num_samps = _stc->recv_pre(nsamps_per_buff, keep);
+            const double time_left = std::max(0.0, (exit_time - time_spec_t::get_system_time()).get_real_secs());
+            const size_t num_samps_recvd = sph::recv_packet_handler::recv(
+                buffs, num_samps, metadata, keep? timeout : time_left, one_packet
+            );
+
+            const size_t num_samps_kept = _stc->recv_post(metadata, num_samps_recvd, keep);
+            if (keep or metadata.error_code != rx_metadata_t::ERROR_CODE_NONE) return num_samps_kept;
+            if (time_left == 0.0){
+                metadata.error_code = rx_metadata_t::ERROR_CODE_TIMEOUT;
+                return 0;
+            }
+        }
     }
 
     void issue_stream_cmd(const stream_cmd_t &stream_cmd)
@@ -361,6 +369,11 @@ public:
         _stc->issue_stream_cmd(stream_cmd);
     }
 
+    stream_stats_t get_stats(void) const
+    {
+        return sph::recv_packet_handler::get_stats();
+    }
+
 private:
     size_t _max_num_samps;
     soft_time_ctrl::sptr _stc;
@@ -371,9 +384,13 @@ private:
  **********************************************************************/
 class usrp1_send_packet_streamer : public sph::send_packet_handler, public tx_streamer{
 public:
-    usrp1_send_packet_streamer(const size_t max_num_samps, soft_time_ctrl::sptr stc, boost::function<void(bool)> tx_enb_fcn){
+    usrp1_send_packet_streamer(
+        const size_t max_num_samps, const size_t bytes_per_cpu_item,
+        soft_time_ctrl::sptr stc, boost::function<void(bool)> tx_enb_fcn
+    ){
         _max_num_samps = max_num_samps;
         this->set_max_samples_per_packet(_max_num_samps);
+        _zeros.resize(max_num_samps*bytes_per_cpu_item);
         _stc = stc;
         _tx_enb_fcn = tx_enb_fcn;
     }
@@ -393,16 +410,32 @@ public:
         const double timeout_
     ){
         double timeout = timeout_; //rw copy
-        _stc->send_pre(metadata, timeout);
+        size_t num_pad_samps = _stc->send_pre(metadata, timeout);
 
         _tx_enb_fcn(true); //always enable (it will do the right thing)
+
+        //zeros up to the first sample of a timed burst
+        const std::vector<const void *> zero_buffs(this->size(), &_zeros.front());
+        const tx_streamer::buffs_type zeros(zero_buffs);
+        tx_metadata_t pad_metadata;
+        while (num_pad_samps != 0){
+            const size_t num_pad_sent = sph::send_packet_handler::send(
+                zeros, std::min(num_pad_samps, _max_num_samps), pad_metadata, timeout
+            );
+            _stc->send_post(num_pad_sent, false);
+            if (num_pad_sent == 0) return 0; //timeout
+            num_pad_samps -= num_pad_sent;
+        }
+
         size_t num_samps_sent = sph::send_packet_handler::send(
             buffs, nsamps_per_buff, metadata, timeout
         );
+        const bool end_of_burst = metadata.end_of_burst and num_samps_sent == nsamps_per_buff;
+        _stc->send_post(num_samps_sent, end_of_burst);
 
         //handle eob flag (commit the buffer, //disable the DACs)
         //check num samps sent to avoid flush on incomplete/timeout
-        if (metadata.end_of_burst and num_samps_sent == nsamps_per_buff){
+        if (end_of_burst){
             async_metadata_t metadata;
             metadata.channel = 0;
             metadata.has_time_spec = true;
@@ -421,8 +454,13 @@ public:
         return _stc->get_async_queue().pop_with_timed_wait(async_metadata, timeout);
     }
 
+    stream_stats_t get_stats(void) const{
+        return sph::send_packet_handler::get_stats();
+    }
+
 private:
     size_t _max_num_samps;
+    std::vector<char> _zeros;
     soft_time_ctrl::sptr _stc;
     boost::function<void(bool)> _tx_enb_fcn;
 };
@@ -448,6 +486,9 @@ void usrp1_impl::update_rx_subdev_spec(const uhd::usrp::subdev_spec_t &spec){
     bool s = this->disable_rx();
     _iface->poke32(FR_RX_MUX, calc_rx_mux(mapping));
     this->restore_rx(s);
+
+    //the channel to frontend mapping may have changed
+    this->update_rx_iq_corr();
 }
 
 void usrp1_impl::update_tx_subdev_spec(const uhd::usrp::subdev_spec_t &spec){
@@ -468,6 +509,9 @@ void usrp1_impl::update_tx_subdev_spec(const uhd::usrp::subdev_spec_t &spec){
     bool s = this->disable_tx();
     _iface->poke32(FR_TX_MUX, calc_tx_mux(mapping));
     this->restore_tx(s);
+
+    //the channel to frontend mapping may have changed
+    this->update_tx_iq_corr();
 }
 
 void usrp1_impl::update_tick_rate(const double rate){
@@ -511,6 +555,7 @@ double usrp1_impl::update_rx_samp_rate(size_t dspno, const double samp_rate){
         _iface->poke32(FR_RX_SAMPLE_RATE_DIV, div - 1);
         _iface->poke32(FR_DECIM_RATE, rate/div - 1);
         this->restore_rx(s);
+        _soft_time_ctrl->set_rx_rate(_master_clock_rate / rate);
 
         //update the streamer if created
         boost::shared_ptr<usrp1_recv_packet_streamer> my_streamer =
@@ -533,6 +578,7 @@ double usrp1_impl::update_tx_samp_rate(size_t dspno, const double samp_rate){
         _iface->poke32(FR_TX_SAMPLE_RATE_DIV, div - 1);
         _iface->poke32(FR_INTERP_RATE, rate/div - 1);
         this->restore_tx(s);
+        _soft_time_ctrl->set_tx_rate(_master_clock_rate / rate);
 
         //update the streamer if created
         boost::shared_ptr<usrp1_send_packet_streamer> my_streamer =
@@ -556,6 +602,35 @@ void usrp1_impl::update_rates(void){
     }
 }
 
+void usrp1_impl::update_rx_iq_corr(void){
+    boost::shared_ptr<usrp1_recv_packet_streamer> my_streamer =
+        boost::dynamic_pointer_cast<usrp1_recv_packet_streamer>(_rx_streamer.lock());
+    if (my_streamer.get() == NULL or not _rx_soft_fe_corr) return;
+
+    //the dc offset is removed in hardware, only correct the iq balance
+    for (size_t ch = 0; ch < _rx_subdev_spec.size(); ch++){
+        const fs_path rx_fe_path = fs_path("/mboards/0/rx_frontends") / _rx_subdev_spec[ch].db_name;
+        my_streamer->set_iq_correction(convert::iq_correction_t::make_rx(
+            _tree->access<std::complex<double> >(rx_fe_path / "iq_balance" / "value").get(),
+            std::complex<double>(0.0, 0.0)
+        ), ch);
+    }
+}
+
+void usrp1_impl::update_tx_iq_corr(void){
+    boost::shared_ptr<usrp1_send_packet_streamer> my_streamer =
+        boost::dynamic_pointer_cast<usrp1_send_packet_streamer>(_tx_streamer.lock());
+    if (my_streamer.get() == NULL or not _tx_soft_fe_corr) return;
+
+    for (size_t ch = 0; ch < _tx_subdev_spec.size(); ch++){
+        const fs_path tx_fe_path = fs_path("/mboards/0/tx_frontends") / _tx_subdev_spec[ch].db_name;
+        my_streamer->set_iq_correction(convert::iq_correction_t::make_tx(
+            _tree->access<std::complex<double> >(tx_fe_path / "iq_balance" / "value").get(),
+            _tree->access<std::complex<double> >(tx_fe_path / "dc_offset" / "value").get()
+        ), ch);
+    }
+}
+
 double usrp1_impl::update_rx_dsp_freq(const size_t dspno, const double freq_){
 
     //correct for outside of rate (wrap around)
@@ -652,6 +727,11 @@ rx_streamer::sptr usrp1_impl::get_rx_stream(const uhd::stream_args_t &args_){
     id.num_inputs = 1;
     id.output_format = args.cpu_format;
     id.num_outputs = args.channels.size();
+    _rx_soft_fe_corr = args.args.cast<bool>("soft_fe_corr", false);
+    if (_rx_soft_fe_corr and (args.cpu_format != "fc32" or args.otw_format != "sc16")){
+        throw uhd::value_error("USRP1 RX soft_fe_corr requires the fc32 cpu format and sc16 wire format");
+    }
+    if (_rx_soft_fe_corr) id.input_format += "_iqcorr";
     my_streamer->set_converter(id);
 
     //special scale factor change for sc8
@@ -661,9 +741,15 @@ rx_streamer::sptr usrp1_impl::get_rx_stream(const uhd::stream_args_t &args_){
     //save as weak ptr for update access
     _rx_streamer = my_streamer;
 
+    //load the frontend corrections into the converter
+    this->update_rx_iq_corr();
+
     //sets all tick and samp rates on this streamer
     this->update_rates();
 
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "rx", args.channels, std::vector<std::string>(), my_streamer->get_stats_block());
+
     return my_streamer;
 }
 
@@ -694,7 +780,8 @@ tx_streamer::sptr usrp1_impl::get_tx_stream(const uhd::stream_args_t &args_){
     //make the new streamer given the samples per packet
     boost::function<void(bool)> tx_fcn = boost::bind(&usrp1_impl::tx_stream_on_off, this, _1);
     boost::shared_ptr<usrp1_send_packet_streamer> my_streamer =
-        boost::make_shared<usrp1_send_packet_streamer>(spp, _soft_time_ctrl, tx_fcn);
+        boost::make_shared<usrp1_send_packet_streamer>(
+            spp, convert::get_bytes_per_item(args.cpu_format), _soft_time_ctrl, tx_fcn);
 
     //init some streamer stuff
     my_streamer->set_tick_rate(_master_clock_rate);
@@ -709,13 +796,24 @@ tx_streamer::sptr usrp1_impl::get_tx_stream(const uhd::stream_args_t &args_){
     id.num_inputs = args.channels.size();
     id.output_format = args.otw_format + "_item16_usrp1";
     id.num_outputs = 1;
+    _tx_soft_fe_corr = args.args.cast<bool>("soft_fe_corr", false);
+    if (_tx_soft_fe_corr and (args.cpu_format != "fc32" or args.otw_format != "sc16")){
+        throw uhd::value_error("USRP1 TX soft_fe_corr requires the fc32 cpu format and sc16 wire format");
+    }
+    if (_tx_soft_fe_corr) id.output_format += "_iqcorr";
     my_streamer->set_converter(id);
 
     //save as weak ptr for update access
     _tx_streamer = my_streamer;
 
+    //load the frontend corrections into the converter
+    this->update_tx_iq_corr();
+
     //sets all tick and samp rates on this streamer
     this->update_rates();
 
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "tx", args.channels, std::vector<std::string>(), my_streamer->get_stats_block());
+
     return my_streamer;
 }
@@ -17,9 +17,12 @@
 
 #include "soft_time_ctrl.hpp"
 #include <uhd/utils/tasks.hpp>
+#include <uhd/utils/msg.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/thread/condition_variable.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <algorithm>
+#include <deque>
 #include <iostream>
 
 using namespace uhd;
@@ -27,7 +30,14 @@ using namespace uhd::usrp;
 using namespace uhd::transport;
 namespace pt = boost::posix_time;
 
-static const time_spec_t TWIDDLE(0.0011);
+//! How long before a timed burst an idle stream is started
+static const time_spec_t STREAM_LEAD(0.02);
+
+//! The longest gap before a timed transmit burst that is filled with zeros
+static const time_spec_t MAX_TX_PAD(0.1);
+
+//! The number of stream commands that can wait for their time
+static const size_t CMD_QUEUE_DEPTH = 64;
 
 soft_time_ctrl::~soft_time_ctrl(void){
     /* NOP */
@@ -42,13 +52,21 @@ public:
     soft_time_ctrl_impl(const cb_fcn_type &stream_on_off):
         _nsamps_remaining(0),
         _stream_mode(stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS),
-        _cmd_queue(2),
+        _rx_active(false),
+        _rx_streaming(false),
+        _idle_check(false),
+        _rx_count(0),
+        _rx_rate(1.0),
+        _tx_streaming(false),
+        _tx_count(0),
+        _tx_rate(1.0),
+        _cmd_queue(CMD_QUEUE_DEPTH),
         _async_msg_queue(1000),
         _inline_msg_queue(1000),
         _stream_on_off(stream_on_off)
     {
         //synchronously spawn a new thread
-        _recv_cmd_task = task::make(boost::bind(&soft_time_ctrl_impl::recv_cmd_task, this));
+        _recv_cmd_task = task::make(boost::bind(&soft_time_ctrl_impl::recv_cmd_task, this), "usrp1_soft_time");
 
         //initialize the time to something
         this->set_time(time_spec_t(0.0));
@@ -81,10 +99,64 @@ public:
         cond.timed_wait(lock, pt::microseconds(long(seconds_to_sleep*1e6)));
     }
 
+    /*******************************************************************
+     * Sample counters:
+     * The anchor is the system time of the first sample of a stream.
+     * The device time of sample n is the anchor plus n samples.
+     ******************************************************************/
+    UHD_INLINE time_spec_t rx_sample_time(const boost::uint64_t n){
+        return _rx_anchor - _time_offset + time_spec_t::from_ticks(n, _rx_rate);
+    }
+
+    UHD_INLINE long long rx_sample_index(const time_spec_t &time){
+        return (time - (_rx_anchor - _time_offset)).to_ticks(_rx_rate);
+    }
+
+    UHD_INLINE time_spec_t tx_sample_time(const boost::uint64_t n){
+        return _tx_anchor - _time_offset + time_spec_t::from_ticks(n, _tx_rate);
+    }
+
+    //! Keep the time of the next sample when the rate changes
+    void set_rx_rate(const double rate){
+        boost::mutex::scoped_lock lock(_update_mutex);
+        _rx_anchor += time_spec_t::from_ticks(_rx_count, _rx_rate);
+        _rx_count = 0;
+        _rx_rate = rate;
+    }
+
+    void set_tx_rate(const double rate){
+        boost::mutex::scoped_lock lock(_update_mutex);
+        _tx_anchor += time_spec_t::from_ticks(_tx_count, _tx_rate);
+        _tx_count = 0;
+        _tx_rate = rate;
+    }
+
     /*******************************************************************
      * Receive control
      ******************************************************************/
-    size_t recv_post(rx_metadata_t &md, const size_t nsamps){
+    size_t recv_pre(const size_t nsamps, bool &keep){
+        boost::mutex::scoped_lock lock(_update_mutex);
+
+        //start the bursts whose first sample is next
+        while (not _rx_bursts.empty() and rx_sample_index(_rx_bursts.front().time_spec) <= (long long)(_rx_count)){
+            this->start_burst(_rx_bursts.front());
+            _rx_bursts.pop_front();
+        }
+
+        //stop at the next burst boundary
+        size_t num_samps = nsamps;
+        if (_rx_active and _stream_mode != stream_cmd_t::STREAM_MODE_START_CONTINUOUS){
+            num_samps = std::min(num_samps, _nsamps_remaining);
+        }
+        if (not _rx_bursts.empty()){
+            const long long next = rx_sample_index(_rx_bursts.front().time_spec) - (long long)(_rx_count);
+            num_samps = std::min(num_samps, size_t(next));
+        }
+        keep = _rx_active;
+        return num_samps;
+    }
+
+    size_t recv_post(rx_metadata_t &md, const size_t nsamps, const bool keep){
         boost::mutex::scoped_lock lock(_update_mutex);
 
         //Since it timed out on the receive, check for inline messages...
@@ -93,33 +165,41 @@ public:
             if (_inline_msg_queue.pop_with_haste(md)) return 0;
         }
 
-        //load the metadata with the expected time
+        //load the metadata with the time of the first sample
         md.has_time_spec = true;
-        md.time_spec = time_now();
+        md.time_spec = rx_sample_time(_rx_count);
+        _rx_count += nsamps;
+        if (not keep) return 0;
+
+        //a timed stop of a continuous stream ends the burst at its sample
+        if (_stream_mode == stream_cmd_t::STREAM_MODE_START_CONTINUOUS){
+            if (not _rx_bursts.empty()
+                and _rx_bursts.front().stream_mode == stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS
+                and rx_sample_index(_rx_bursts.front().time_spec) <= (long long)(_rx_count)
+            ) md.end_of_burst = true;
+            return nsamps;
+        }
 
-        //none of the stuff below matters in continuous streaming mode
-        if (_stream_mode == stream_cmd_t::STREAM_MODE_START_CONTINUOUS) return nsamps;
+        //update the consumed samples
+        _nsamps_remaining -= std::min(nsamps, _nsamps_remaining);
+        if (_nsamps_remaining != 0) return nsamps;
 
         //When to stop streaming:
         //The samples have been received and the stream mode is non-continuous.
-        //Rewrite the sample count to clip to the requested number of samples.
-        if (_nsamps_remaining <= nsamps) switch(_stream_mode){
-        case stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_MORE:{
+        //More is a broken chain unless the next burst starts with the next sample.
+        const bool chained = not _rx_bursts.empty()
+            and rx_sample_index(_rx_bursts.front().time_spec) <= (long long)(_rx_count);
+        if (_stream_mode == stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_MORE and not chained){
             rx_metadata_t metadata;
             metadata.has_time_spec = true;
-            metadata.time_spec = this->time_now();
+            metadata.time_spec = rx_sample_time(_rx_count);
             metadata.error_code = rx_metadata_t::ERROR_CODE_BROKEN_CHAIN;
             _inline_msg_queue.push_with_pop_on_full(metadata);
-        } //continue to next case...
-        case stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE:
-            md.end_of_burst = true;
-            this->issue_stream_cmd(stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
-            return _nsamps_remaining;
-        default: break;
         }
-
-        //update the consumed samples
-        _nsamps_remaining -= nsamps;
+        md.end_of_burst = _stream_mode == stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE or not chained;
+        _rx_active = false;
+        _stream_mode = stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS;
+        if (_rx_bursts.empty()) this->request_idle_check();
         return nsamps;
     }
 
@@ -127,34 +207,101 @@ public:
         _cmd_queue.push_with_wait(boost::make_shared<stream_cmd_t>(cmd));
     }
 
+    void rx_overflow(void){
+        boost::mutex::scoped_lock lock(_update_mutex);
+        rx_metadata_t metadata;
+        metadata.has_time_spec = true;
+        metadata.time_spec = time_now();
+        metadata.error_code = rx_metadata_t::ERROR_CODE_OVERFLOW;
+        _inline_msg_queue.push_with_pop_on_full(metadata);
+
+        //the samples lost are not counted, take the time up again from now
+        if (_rx_streaming){
+            _rx_anchor = time_spec_t::get_system_time() - time_spec_t::from_ticks(_rx_count, _rx_rate);
+        }
+    }
+
     void stream_on_off(bool enb){
         _stream_on_off(enb);
-        _nsamps_remaining = 0;
+        _rx_streaming = enb;
+        _rx_anchor = time_spec_t::get_system_time();
+        _rx_count = 0;
+    }
+
+    //! Begin to keep the samples of a burst (called with the mutex held)
+    void start_burst(const stream_cmd_t &cmd){
+        if (cmd.stream_mode == stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS){
+            _rx_active = false;
+            _nsamps_remaining = 0;
+            _stream_mode = cmd.stream_mode;
+            this->request_idle_check();
+            return;
+        }
+        _rx_active = true;
+        _nsamps_remaining += cmd.num_samps;
+        _stream_mode = cmd.stream_mode;
+    }
+
+    //! Ask the command task to stop an idle stream (called with the mutex held)
+    void request_idle_check(void){
+        //the flag is the request, the null command only wakes the task:
+        //when the queue is full, the task checks the flag after the next command
+        _idle_check = true;
+        _cmd_queue.push_with_haste(boost::shared_ptr<stream_cmd_t>());
     }
 
     /*******************************************************************
      * Transmit control
      ******************************************************************/
-    void send_pre(const tx_metadata_t &md, double &timeout){
-        if (not md.has_time_spec) return;
+    size_t send_pre(const tx_metadata_t &md, double &timeout){
+        if (not md.has_time_spec) return 0;
 
         boost::mutex::scoped_lock lock(_update_mutex);
 
-        time_spec_t time_at(md.time_spec - TWIDDLE);
+        //the samples sent ahead keep the stream going, else start it again;
+        //a burst far ahead also starts again, rather than waiting in zeros
+        if (
+            not _tx_streaming or tx_sample_time(_tx_count) < time_now() or
+            md.time_spec - tx_sample_time(_tx_count) > MAX_TX_PAD
+        ){
+            //handle late packets
+            if (md.time_spec < time_now()){
+                this->tx_late();
+                return 0;
+            }
+            const time_spec_t time_at(md.time_spec - STREAM_LEAD);
+            if (time_at > time_now()){
+                timeout -= (time_at - time_now()).get_real_secs();
+                sleep_until_time(lock, time_at);
+            }
+            _tx_streaming = true;
+            _tx_anchor = time_spec_t::get_system_time();
+            _tx_count = 0;
+        }
 
-        //handle late packets
-        if (time_at < time_now()){
-            async_metadata_t metadata;
-            metadata.channel = 0;
-            metadata.has_time_spec = true;
-            metadata.time_spec = this->time_now();
-            metadata.event_code = async_metadata_t::EVENT_CODE_TIME_ERROR;
-            _async_msg_queue.push_with_pop_on_full(metadata);
-            return;
+        //pad the gap up to the first sample of the burst
+        const long long pad = (md.time_spec - tx_sample_time(_tx_count)).to_ticks(_tx_rate);
+        if (pad < 0){
+            this->tx_late();
+            return 0;
         }
+        return size_t(pad);
+    }
 
-        timeout -= (time_at - time_now()).get_real_secs();
-        sleep_until_time(lock, time_at);
+    void send_post(const size_t nsamps, const bool end_of_burst){
+        boost::mutex::scoped_lock lock(_update_mutex);
+        _tx_count += nsamps;
+        if (end_of_burst) _tx_streaming = false; //the stream is flushed and disabled
+    }
+
+    //! Report a late transmit packet (called with the mutex held)
+    void tx_late(void){
+        async_metadata_t metadata;
+        metadata.channel = 0;
+        metadata.has_time_spec = true;
+        metadata.time_spec = this->time_now();
+        metadata.event_code = async_metadata_t::EVENT_CODE_TIME_ERROR;
+        _async_msg_queue.push_with_pop_on_full(metadata);
     }
 
     /*******************************************************************
@@ -163,44 +310,61 @@ public:
     void recv_cmd_handle_cmd(const stream_cmd_t &cmd){
         boost::mutex::scoped_lock lock(_update_mutex);
 
-        //handle the stream at time by sleeping
-        if (not cmd.stream_now){
-            time_spec_t time_at(cmd.time_spec - TWIDDLE);
-            if (time_at < time_now()){
-                rx_metadata_t metadata;
-                metadata.has_time_spec = true;
-                metadata.time_spec = this->time_now();
-                metadata.error_code = rx_metadata_t::ERROR_CODE_LATE_COMMAND;
-                _inline_msg_queue.push_with_pop_on_full(metadata);
-                this->issue_stream_cmd(stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
-                return;
-            }
-            else{
-                sleep_until_time(lock, time_at);
-            }
+        //a stop now ends everything at once
+        if (cmd.stream_now and cmd.stream_mode == stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS){
+            _rx_bursts.clear();
+            _rx_active = false;
+            _nsamps_remaining = 0;
+            _stream_mode = cmd.stream_mode;
+            if (_rx_streaming) stream_on_off(false);
+            return;
         }
 
-        //When to stop streaming:
-        //Stop streaming when the command is a stop and streaming.
-        if (cmd.stream_mode == stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS
-           and _stream_mode != stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS
-        ) stream_on_off(false);
-
-        //When to start streaming:
-        //Start streaming when the command is not a stop and not streaming.
-        if (cmd.stream_mode != stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS
-           and _stream_mode == stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS
-        ) stream_on_off(true);
-
-        //update the state
-        _nsamps_remaining += cmd.num_samps;
-        _stream_mode = cmd.stream_mode;
+        //nothing to stop on an idle stream
+        if (not _rx_streaming and cmd.stream_mode == stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS) return;
+
+        //start an idle stream shortly before the burst, the counter does the rest
+        if (not cmd.stream_now and not _rx_streaming){
+            if (cmd.time_spec < time_now()) return this->rx_late();
+            const time_spec_t time_at(cmd.time_spec - STREAM_LEAD);
+            if (time_at > time_now()) sleep_until_time(lock, time_at);
+        }
+        if (not _rx_streaming) stream_on_off(true);
+
+        //a burst is late when its first sample has been received
+        stream_cmd_t burst = cmd;
+        if (cmd.stream_now) burst.time_spec = rx_sample_time(_rx_count);
+        if (rx_sample_index(burst.time_spec) < (long long)(_rx_count)){
+            this->rx_late();
+            this->handle_idle_check();
+            return;
+        }
+        _rx_bursts.push_back(burst);
+    }
+
+    //! Report a late stream command (called with the mutex held)
+    void rx_late(void){
+        rx_metadata_t metadata;
+        metadata.has_time_spec = true;
+        metadata.time_spec = this->time_now();
+        metadata.error_code = rx_metadata_t::ERROR_CODE_LATE_COMMAND;
+        _inline_msg_queue.push_with_pop_on_full(metadata);
+    }
+
+    //! Stop the stream when no burst is running or waiting (called with the mutex held)
+    void handle_idle_check(void){
+        if (_rx_streaming and not _rx_active and _rx_bursts.empty()) stream_on_off(false);
     }
 
     void recv_cmd_task(void){ //task is looped
         boost::shared_ptr<stream_cmd_t> cmd;
         _cmd_queue.pop_with_wait(cmd);
-        recv_cmd_handle_cmd(*cmd);
+        if (cmd) recv_cmd_handle_cmd(*cmd);
+        boost::mutex::scoped_lock lock(_update_mutex);
+        if (_idle_check){
+            _idle_check = false;
+            this->handle_idle_check();
+        }
     }
 
     bounded_buffer<async_metadata_t> &get_async_queue(void){
@@ -220,6 +384,16 @@ private:
     size_t _nsamps_remaining;
     stream_cmd_t::stream_mode_t _stream_mode;
     time_spec_t _time_offset;
+    bool _rx_active, _rx_streaming;
+    bool _idle_check; //requested by the streamer, done by the command task
+    std::deque<stream_cmd_t> _rx_bursts; //waiting for their first sample
+    time_spec_t _rx_anchor;
+    boost::uint64_t _rx_count;
+    double _rx_rate;
+    bool _tx_streaming;
+    time_spec_t _tx_anchor;
+    boost::uint64_t _tx_count;
+    double _tx_rate;
     bounded_buffer<boost::shared_ptr<stream_cmd_t> > _cmd_queue;
     bounded_buffer<async_metadata_t> _async_msg_queue;
     bounded_buffer<rx_metadata_t> _inline_msg_queue;
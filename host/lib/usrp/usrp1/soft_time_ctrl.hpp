@@ -34,6 +34,11 @@ namespace uhd{ namespace usrp{
  * Soft time control uses the system time to emulate
  * timed transmits, timed receive commands, device time,
  * and inline and async error messages.
+ *
+ * The system time is only read when a stream starts. From there on
+ * the time of a sample follows from the number of samples streamed,
+ * so bursts start and stop at exact samples: receive discards the
+ * samples before a burst and transmit pads the gap with zeros.
  */
 class soft_time_ctrl : boost::noncopyable{
 public:
@@ -55,11 +60,32 @@ public:
     //! Get the current time
     virtual time_spec_t get_time(void) = 0;
 
-    //! Call after the internal recv function
-    virtual size_t recv_post(rx_metadata_t &md, const size_t nsamps) = 0;
+    //! Set the sample rates the sample counts are timed with
+    virtual void set_rx_rate(const double rate) = 0;
+    virtual void set_tx_rate(const double rate) = 0;
 
-    //! Call before the internal send function
-    virtual void send_pre(const tx_metadata_t &md, double &timeout) = 0;
+    /*!
+     * Call before the internal recv function.
+     * \param nsamps the number of samples asked for
+     * \param keep set to false when the samples are to be discarded
+     * \return the number of samples to receive, up to the next burst boundary
+     */
+    virtual size_t recv_pre(const size_t nsamps, bool &keep) = 0;
+
+    //! Call after the internal recv function, returns the samples to keep
+    virtual size_t recv_post(rx_metadata_t &md, const size_t nsamps, const bool keep) = 0;
+
+    /*!
+     * Call before the internal send function.
+     * \return the number of zero samples to send before the burst
+     */
+    virtual size_t send_pre(const tx_metadata_t &md, double &timeout) = 0;
+
+    //! Call after the internal send function, with the samples sent
+    virtual void send_post(const size_t nsamps, const bool end_of_burst) = 0;
+
+    //! Call on a receive overflow: queues the message, samples were lost
+    virtual void rx_overflow(void) = 0;
 
     //! Issue a stream command to receive
     virtual void issue_stream_cmd(const stream_cmd_t &cmd) = 0;
@@ -204,6 +204,7 @@ usrp1_impl::usrp1_impl(const device_addr_t &device_addr){
     // Initialize the properties tree
     ////////////////////////////////////////////////////////////////////
     _rx_dc_offset_shadow = 0;
+    _rx_soft_fe_corr = _tx_soft_fe_corr = false;
     _tree = property_tree::make();
     _tree->create<std::string>("/name").set("USRP1 Device");
     const fs_path mb_path = "/mboards/0";
@@ -294,6 +295,18 @@ usrp1_impl::usrp1_impl(const device_addr_t &device_addr){
         _tree->create<bool>(rx_fe_path / "dc_offset" / "enable")
             .subscribe(boost::bind(&usrp1_impl::set_enb_rx_dc_offset, this, db, _1))
             .set(true);
+
+        //no hardware for these, they are applied by the converters
+        _tree->create<std::complex<double> >(rx_fe_path / "iq_balance" / "value")
+            .subscribe(boost::bind(&usrp1_impl::update_rx_iq_corr, this))
+            .set(std::complex<double>(0.0, 0.0));
+        const fs_path tx_fe_path = mb_path / "tx_frontends" / db;
+        _tree->create<std::complex<double> >(tx_fe_path / "dc_offset" / "value")
+            .subscribe(boost::bind(&usrp1_impl::update_tx_iq_corr, this))
+            .set(std::complex<double>(0.0, 0.0));
+        _tree->create<std::complex<double> >(tx_fe_path / "iq_balance" / "value")
+            .subscribe(boost::bind(&usrp1_impl::update_tx_iq_corr, this))
+            .set(std::complex<double>(0.0, 0.0));
     }
 
     ////////////////////////////////////////////////////////////////////
@@ -343,6 +356,10 @@ usrp1_impl::usrp1_impl(const device_addr_t &device_addr){
         .publish(boost::bind(&soft_time_ctrl::get_time, _soft_time_ctrl))
         .subscribe(boost::bind(&soft_time_ctrl::set_time, _soft_time_ctrl, _1));
 
+    //host side messages for recv_async_msg()
+    _tree->create<async_metadata_t>(mb_path / "async_msg")
+        .subscribe(boost::bind(&bounded_buffer<async_metadata_t>::push_with_pop_on_full, &_soft_time_ctrl->get_async_queue(), _1));
+
     _tree->create<std::vector<std::string> >(mb_path / "clock_source/options").set(std::vector<std::string>(1, "internal"));
     _tree->create<std::vector<std::string> >(mb_path / "time_source/options").set(std::vector<std::string>(1, "none"));
     _tree->create<std::string>(mb_path / "clock_source/value").set("internal");
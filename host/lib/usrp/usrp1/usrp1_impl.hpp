@@ -122,6 +122,11 @@ private:
     void set_enb_rx_dc_offset(const std::string &db, const bool);
     std::complex<double> set_rx_dc_offset(const std::string &db, const std::complex<double> &);
 
+    //software frontend corrections applied in the converters
+    bool _rx_soft_fe_corr, _tx_soft_fe_corr;
+    void update_rx_iq_corr(void);
+    void update_tx_iq_corr(void);
+
     static uhd::usrp::dboard_iface::sptr make_dboard_iface(
         usrp1_iface::sptr,
         usrp1_codec_ctrl::sptr,
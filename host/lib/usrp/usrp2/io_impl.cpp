@@ -16,6 +16,7 @@
 //
 
 #include "validate_subdev_spec.hpp"
+#include "publish_stream_stats.hpp"
 #include "async_packet_handler.hpp"
 #include "../../transport/super_recv_packet_handler.hpp"
 #include "../../transport/super_send_packet_handler.hpp"
@@ -25,9 +26,9 @@
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/tasks.hpp>
+#include <uhd/utils/atomic.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/utils/byteswap.hpp>
-#include <uhd/utils/thread_priority.hpp>
 #include <uhd/transport/bounded_buffer.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/format.hpp>
@@ -61,8 +62,10 @@ static const size_t vrt_send_header_offset_words32 = 1;
 
 /***********************************************************************
  * flow control monitor for a single tx channel
- *  - the pirate thread calls update
+ *  - the async message handler calls update
  *  - the get send buffer calls check
+ * The ack is an atomic, so an update only takes the lock
+ * to wake a sender that waits on a full window.
  **********************************************************************/
 class flow_control_monitor{
 public:
@@ -81,7 +84,7 @@ public:
     //! Clear the monitor, Ex: when a streamer is created
     void clear(void){
         _last_seq_out = 0;
-        _last_seq_ack = 0;
+        _last_seq_ack.write(0);
     }
 
     /*!
@@ -99,10 +102,13 @@ public:
      * \return false on timeout
      */
     UHD_INLINE bool check_fc_condition(double timeout){
-        boost::mutex::scoped_lock lock(_fc_mutex);
         if (this->ready()) return true;
+        boost::mutex::scoped_lock lock(_fc_mutex);
+        _num_waiters.inc(); //a full barrier: the update sees it or we see the ack
         boost::this_thread::disable_interruption di; //disable because the wait can throw
-        return _fc_cond.timed_wait(lock, to_time_dur(timeout), _ready_fcn);
+        const bool ok = _fc_cond.timed_wait(lock, to_time_dur(timeout), _ready_fcn);
+        _num_waiters.dec();
+        return ok;
     }
 
     /*!
@@ -110,27 +116,31 @@ public:
      * \param seq the last sequence number to be ACK'd
      */
     UHD_INLINE void update_fc_condition(seq_type seq){
+        _last_seq_ack.write(seq);
+        //a fenced read: the ack is visible before the waiters are counted
+        if (_num_waiters.cas(0, 0) == 0) return;
         boost::mutex::scoped_lock lock(_fc_mutex);
-        _last_seq_ack = seq;
         lock.unlock();
         _fc_cond.notify_one();
     }
 
 private:
     bool ready(void){
-        return seq_type(_last_seq_out -_last_seq_ack) < _max_seqs_out;
+        return seq_type(_last_seq_out - _last_seq_ack.read()) < _max_seqs_out;
     }
 
     boost::mutex _fc_mutex;
     boost::condition _fc_cond;
-    seq_type _last_seq_out, _last_seq_ack;
+    seq_type _last_seq_out;
+    uhd::atomic_uint32_t _last_seq_ack;
+    uhd::atomic_uint32_t _num_waiters;
     const seq_type _max_seqs_out;
     boost::function<bool(void)> _ready_fcn;
 };
 
 /***********************************************************************
  * io impl details (internal to this file)
- * - pirate crew
+ * - async message handlers
  * - alignment buffer
  * - thread loop
  * - vrt packet handler states
@@ -146,7 +156,7 @@ struct usrp2_impl::io_impl{
 
     ~io_impl(void){
         //Manually deconstuct the tasks, since this was not happening automatically.
-        pirate_tasks.clear();
+        async_tasks.clear();
     }
 
     managed_send_buffer::sptr get_send_buff(size_t chan, double timeout){
@@ -168,63 +178,72 @@ struct usrp2_impl::io_impl{
     std::vector<zero_copy_if::sptr> tx_xports;
     std::vector<flow_control_monitor::sptr> fc_mons;
 
-    //methods and variables for the pirate crew
-    void recv_pirate_loop(zero_copy_if::sptr, size_t);
-    std::list<task::sptr> pirate_tasks;
+    //methods and variables for the async message handlers
+    bool handle_async_msg(zero_copy_if::sptr, size_t, double);
+    void handle_async_msgs(zero_copy_if::sptr, size_t);
+    std::list<task::sptr> async_tasks;
     bounded_buffer<async_metadata_t> async_msg_fifo;
     double tick_rate;
 };
 
 /***********************************************************************
- * Receive Pirate Loop
- * - while raiding, loot for message packet
+ * Async message handler
+ * - take a message packet off the transport
  * - update flow control condition count
  * - put async message packets into queue
  **********************************************************************/
-void usrp2_impl::io_impl::recv_pirate_loop(
-    zero_copy_if::sptr err_xport, size_t index
+bool usrp2_impl::io_impl::handle_async_msg(
+    zero_copy_if::sptr err_xport, size_t index, double timeout
 ){
-    set_thread_priority_safe();
+    managed_recv_buffer::sptr buff = err_xport->get_recv_buff(timeout);
+    if (not buff.get()) return false; //ignore timeout/error buffers
 
     //store a reference to the flow control monitor (offset by max dsps)
     flow_control_monitor &fc_mon = *(this->fc_mons[index]);
 
-    while (not boost::this_thread::interruption_requested()){
-        managed_recv_buffer::sptr buff = err_xport->get_recv_buff();
-        if (not buff.get()) continue; //ignore timeout/error buffers
-
-        try{
-            //extract the vrt header packet info
-            vrt::if_packet_info_t if_packet_info;
-            if_packet_info.num_packet_words32 = buff->size()/sizeof(boost::uint32_t);
-            const boost::uint32_t *vrt_hdr = buff->cast<const boost::uint32_t *>();
-            vrt::if_hdr_unpack_be(vrt_hdr, if_packet_info);
-
-            //handle a tx async report message
-            if (if_packet_info.sid == USRP2_TX_ASYNC_SID and if_packet_info.packet_type != vrt::if_packet_info_t::PACKET_TYPE_DATA){
-
-                //fill in the async metadata
-                async_metadata_t metadata;
-                load_metadata_from_buff(uhd::ntohx<boost::uint32_t>, metadata, if_packet_info, vrt_hdr, tick_rate, index);
-
-                //catch the flow control packets and react
-                if (metadata.event_code == 0){
-                    boost::uint32_t fc_word32 = (vrt_hdr + if_packet_info.num_header_words32)[1];
-                    fc_mon.update_fc_condition(uhd::ntohx(fc_word32));
-                    continue;
-                }
-                //else UHD_MSG(often) << "metadata.event_code " << metadata.event_code << std::endl;
-                async_msg_fifo.push_with_pop_on_full(metadata);
-
-                standard_async_msg_prints(metadata);
-            }
-            else{
-                //TODO unknown received packet, may want to print error...
+    try{
+        //extract the vrt header packet info
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.num_packet_words32 = buff->size()/sizeof(boost::uint32_t);
+        const boost::uint32_t *vrt_hdr = buff->cast<const boost::uint32_t *>();
+        vrt::if_hdr_unpack_be(vrt_hdr, if_packet_info);
+
+        //handle a tx async report message
+        if (if_packet_info.sid == USRP2_TX_ASYNC_SID and if_packet_info.packet_type != vrt::if_packet_info_t::PACKET_TYPE_DATA){
+
+            //fill in the async metadata
+            async_metadata_t metadata;
+            load_metadata_from_buff(uhd::ntohx<boost::uint32_t>, metadata, if_packet_info, vrt_hdr, tick_rate, index);
+
+            //catch the flow control packets and react
+            if (metadata.event_code == 0){
+                boost::uint32_t fc_word32 = (vrt_hdr + if_packet_info.num_header_words32)[1];
+                fc_mon.update_fc_condition(uhd::ntohx(fc_word32));
+                return true;
             }
-        }catch(const std::exception &e){
-            UHD_MSG(error) << "Error in recv pirate loop: " << e.what() << std::endl;
+            //else UHD_MSG(often) << "metadata.event_code " << metadata.event_code << std::endl;
+            async_msg_fifo.push_with_pop_on_full(metadata);
+
+            standard_async_msg_prints(metadata);
+        }
+        else{
+            //TODO unknown received packet, may want to print error...
         }
+    }catch(const std::exception &e){
+        UHD_MSG(error) << "Error in async message handler: " << e.what() << std::endl;
     }
+    return true;
+}
+
+/*!
+ * Handle the messages that are ready, called when the socket is readable.
+ * It runs on the event loop that carries the TX credit of every mboard,
+ * so it never waits: no control transactions and no blocking pushes here.
+ */
+void usrp2_impl::io_impl::handle_async_msgs(
+    zero_copy_if::sptr err_xport, size_t index
+){
+    while (this->handle_async_msg(err_xport, index, 0.0)){}
 }
 
 /***********************************************************************
@@ -249,14 +268,24 @@ void usrp2_impl::io_init(void){
         _mbc[mb].tx_streamers.resize(1/*known to be 1 dsp*/);
     }
 
-    //create a new pirate thread for each zc if (yarr!!)
+    //handle the async messages of each mboard,
+    //the sockets are watched by the shared event loop (no thread per mboard);
+    //the firmware lock renewal makes transactions, it has a thread of its own
     size_t index = 0;
     BOOST_FOREACH(const std::string &mb, _mbc.keys()){
-        //spawn a new pirate to plunder the recv booty
-        _io_impl->pirate_tasks.push_back(task::make(boost::bind(
-            &usrp2_impl::io_impl::recv_pirate_loop, _io_impl.get(),
-            _mbc[mb].tx_dsp_xport, index++
-        )));
+        zero_copy_if::sptr err_xport = _mbc[mb].tx_dsp_xport;
+        _io_impl->async_tasks.push_back((err_xport->get_recv_fd() >= 0)?
+            task::make_readable(err_xport->get_recv_fd(), boost::bind(
+                &usrp2_impl::io_impl::handle_async_msgs, _io_impl.get(), err_xport, index
+            ), "usrp2_async") :
+            task::make(boost::bind(
+                &usrp2_impl::io_impl::handle_async_msg, _io_impl.get(), err_xport, index, 0.1
+            ), "usrp2_async"));
+        index++;
+
+        //host side messages for recv_async_msg()
+        _tree->create<async_metadata_t>("/mboards/" + mb + "/async_msg")
+            .subscribe(boost::bind(&bounded_buffer<async_metadata_t>::push_with_pop_on_full, &_io_impl->async_msg_fifo, _1));
     }
 }
 
@@ -454,12 +483,14 @@ rx_streamer::sptr usrp2_impl::get_rx_stream(const uhd::stream_args_t &args_){
     my_streamer->set_converter(id);
 
     //bind callbacks for the handler
+    std::vector<std::string> stream_mboards; //the mboard of each channel, for the statistics
     for (size_t chan_i = 0; chan_i < args.channels.size(); chan_i++){
         const size_t chan = args.channels[chan_i];
         size_t num_chan_so_far = 0;
         BOOST_FOREACH(const std::string &mb, _mbc.keys()){
             num_chan_so_far += _mbc[mb].rx_chan_occ;
             if (chan < num_chan_so_far){
+                stream_mboards.push_back(mb);
                 const size_t dsp = chan + _mbc[mb].rx_chan_occ - num_chan_so_far;
                 _mbc[mb].rx_dsps[dsp]->set_nsamps_per_packet(spp); //seems to be a good place to set this
                 _mbc[mb].rx_dsps[dsp]->setup(args);
@@ -482,6 +513,9 @@ rx_streamer::sptr usrp2_impl::get_rx_stream(const uhd::stream_args_t &args_){
     //sets all tick and samp rates on this streamer
     this->update_rates();
 
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "rx", args.channels, stream_mboards, my_streamer->get_stats_block());
+
     return my_streamer;
 }
 
@@ -523,6 +557,7 @@ tx_streamer::sptr usrp2_impl::get_tx_stream(const uhd::stream_args_t &args_){
     my_streamer->set_converter(id);
 
     //bind callbacks for the handler
+    std::vector<std::string> stream_mboards; //the mboard of each channel, for the statistics
     for (size_t chan_i = 0; chan_i < args.channels.size(); chan_i++){
         const size_t chan = args.channels[chan_i];
         size_t num_chan_so_far = 0;
@@ -530,6 +565,7 @@ tx_streamer::sptr usrp2_impl::get_tx_stream(const uhd::stream_args_t &args_){
         BOOST_FOREACH(const std::string &mb, _mbc.keys()){
             num_chan_so_far += _mbc[mb].tx_chan_occ;
             if (chan < num_chan_so_far){
+                stream_mboards.push_back(mb);
                 const size_t dsp = chan + _mbc[mb].tx_chan_occ - num_chan_so_far;
                 if (not args.args.has_key("noclear")){
                     _io_impl->fc_mons[abs]->clear();
@@ -549,5 +585,8 @@ tx_streamer::sptr usrp2_impl::get_tx_stream(const uhd::stream_args_t &args_){
     //sets all tick and samp rates on this streamer
     this->update_rates();
 
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "tx", args.channels, stream_mboards, my_streamer->get_stats_block());
+
     return my_streamer;
 }
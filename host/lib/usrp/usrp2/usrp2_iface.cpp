@@ -98,7 +98,8 @@ public:
     void lock_device(bool lock){
         if (lock){
             this->pokefw(U2_FW_REG_LOCK_GPID, get_process_hash());
-            _lock_task = task::make(boost::bind(&usrp2_iface_impl::lock_task, this));
+            this->lock_task(); //lock now, then renew periodically
+            _lock_task = task::make_periodic(boost::bind(&usrp2_iface_impl::lock_task, this), 1.5, "usrp2_lock");
         }
         else{
             _lock_task.reset(); //shutdown the task
@@ -128,8 +129,6 @@ public:
     void lock_task(void){
         //re-lock in task
         this->pokefw(U2_FW_REG_LOCK_TIME, this->get_curr_time());
-        //sleep for a bit
-        boost::this_thread::sleep(boost::posix_time::milliseconds(1500));
     }
 
     boost::uint32_t get_curr_time(void){
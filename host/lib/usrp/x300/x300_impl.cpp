@@ -495,7 +495,8 @@ void x300_impl::setup_mb(const size_t mb_i, const uhd::device_addr_t &dev_addr)
                     BOOST_STRINGIZE(X300_FW_COMMS_UDP_PORT)));
     }
 
-    mb.claimer_task = uhd::task::make(boost::bind(&x300_impl::claimer_loop, this, mb.zpu_ctrl));
+    this->claimer_loop(mb.zpu_ctrl); //claim now, then renew periodically
+    mb.claimer_task = uhd::task::make_periodic(boost::bind(&x300_impl::claimer_loop, this, mb.zpu_ctrl), 1.0, "x300_claimer");
 
     //extract the FW path for the X300
     //and live load fw over ethernet link
@@ -656,6 +657,10 @@ void x300_impl::setup_mb(const size_t mb_i, const uhd::device_addr_t &dev_addr)
 
     _tree->create<time_spec_t>(mb_path / "time" / "cmd");
 
+    //host side messages for recv_async_msg()
+    _tree->create<async_metadata_t>(mb_path / "async_msg")
+        .subscribe(boost::bind(&async_md_type::push_with_pop_on_full, _async_md, _1));
+
     UHD_MSG(status) << "Radio 1x clock:" << (mb.clock->get_master_clock_rate()/1e6)
         << std::endl;
 
@@ -886,6 +891,8 @@ void x300_impl::setup_radio(const size_t mb_i, const std::string &slot_name)
     perif.ctrl->poke32(TOREG(SR_MISC_OUTS),  (1 << 1) | (1 << 0)); //out of reset + dac enable
 
     this->register_loopback_self_test(perif.ctrl);
+    _tree->create<time_histogram_t>(mb_path / "radio_ctrl" / slot_name / "rtt")
+        .publish(boost::bind(&radio_ctrl_core_3000::get_rtt_stats, perif.ctrl));
 
     perif.spi = spi_core_3000::make(perif.ctrl, TOREG(SR_SPI), RB32_SPI);
     perif.adc = x300_adc_ctrl::make(perif.spi, DB_ADC_SEN);
@@ -1534,7 +1541,6 @@ void x300_impl::claimer_loop(wb_iface::sptr iface)
         iface->poke32(SR_ADDR(X300_FW_SHMEM_BASE, X300_FW_SHMEM_CLAIM_TIME), time(NULL));
         iface->poke32(SR_ADDR(X300_FW_SHMEM_BASE, X300_FW_SHMEM_CLAIM_SRC), get_process_hash());
     }
-    boost::this_thread::sleep(boost::posix_time::milliseconds(1000)); //1 second
 }
 
 bool x300_impl::is_claimed(wb_iface::sptr iface)
@@ -18,6 +18,7 @@
 #include "x300_regs.hpp"
 #include "x300_impl.hpp"
 #include "validate_subdev_spec.hpp"
+#include "publish_stream_stats.hpp"
 #include "../../transport/super_recv_packet_handler.hpp"
 #include "../../transport/super_send_packet_handler.hpp"
 #include <uhd/transport/nirio_zero_copy.hpp>
@@ -25,6 +26,7 @@
 #include <uhd/transport/bounded_buffer.hpp>
 #include <boost/bind.hpp>
 #include <uhd/utils/tasks.hpp>
+#include <uhd/utils/atomic.hpp>
 #include <uhd/utils/log.hpp>
 #include <boost/foreach.hpp>
 #include <boost/make_shared.hpp>
@@ -230,13 +232,12 @@ struct x300_tx_fc_guts_t
     x300_tx_fc_guts_t(void):
         stream_channel(0),
         device_channel(0),
-        last_seq_out(0),
-        last_seq_ack(0),
         seq_queue(1){}
     size_t stream_channel;
     size_t device_channel;
-    size_t last_seq_out;
-    size_t last_seq_ack;
+    //written by the sending thread only, atomic for the credit reads of the statistics
+    uhd::atomic_uint32_t last_seq_out;
+    uhd::atomic_uint32_t last_seq_ack;
     bounded_buffer<size_t> seq_queue;
     boost::shared_ptr<x300_impl::async_md_type> async_queue;
     boost::shared_ptr<x300_impl::async_md_type> old_async_queue;
@@ -254,10 +255,11 @@ static size_t get_tx_flow_control_window(size_t frame_size, const device_addr_t&
     return window_in_pkts;
 }
 
-static void handle_tx_async_msgs(boost::shared_ptr<x300_tx_fc_guts_t> guts, zero_copy_if::sptr xport, bool big_endian, x300_clock_ctrl::sptr clock)
+//! Handle one async message, returns false when none arrived within the timeout
+static bool handle_tx_async_msg(boost::shared_ptr<x300_tx_fc_guts_t> guts, zero_copy_if::sptr xport, bool big_endian, x300_clock_ctrl::sptr clock, const double timeout)
 {
-    managed_recv_buffer::sptr buff = xport->get_recv_buff();
-    if (not buff) return;
+    managed_recv_buffer::sptr buff = xport->get_recv_buff(timeout);
+    if (not buff) return false;
 
     //extract packet info
     vrt::if_packet_info_t if_packet_info;
@@ -282,7 +284,7 @@ static void handle_tx_async_msgs(boost::shared_ptr<x300_tx_fc_guts_t> guts, zero
     catch(const std::exception &ex)
     {
         UHD_MSG(error) << "Error parsing async message packet: " << ex.what() << std::endl;
-        return;
+        return true;
     }
 
     //fill in the async metadata
@@ -307,6 +309,13 @@ static void handle_tx_async_msgs(boost::shared_ptr<x300_tx_fc_guts_t> guts, zero
         guts->old_async_queue->push_with_pop_on_full(metadata);
         standard_async_msg_prints(metadata);
     }
+    return true;
+}
+
+//! Handle all async messages that are ready, for the event loop
+static void handle_tx_async_msgs(boost::shared_ptr<x300_tx_fc_guts_t> guts, zero_copy_if::sptr xport, bool big_endian, x300_clock_ctrl::sptr clock)
+{
+    while (handle_tx_async_msg(guts, xport, big_endian, clock, 0.0)){}
 }
 
 static managed_send_buffer::sptr get_tx_buff_with_flowctrl(
@@ -318,20 +327,30 @@ static managed_send_buffer::sptr get_tx_buff_with_flowctrl(
 ){
     while (true)
     {
-        const size_t delta = (guts->last_seq_out & 0xfff) - (guts->last_seq_ack & 0xfff);
+        const size_t delta = (guts->last_seq_out.read() & 0xfff) - (guts->last_seq_ack.read() & 0xfff);
         if ((delta & 0xfff) <= fc_pkt_window) break;
 
-        const bool ok = guts->seq_queue.pop_with_timed_wait(guts->last_seq_ack, timeout);
+        size_t seq_ack;
+        const bool ok = guts->seq_queue.pop_with_timed_wait(seq_ack, timeout);
         if (not ok) return managed_send_buffer::sptr(); //timeout waiting for flow control
+        guts->last_seq_ack.write(boost::uint32_t(seq_ack));
     }
 
     managed_send_buffer::sptr buff = xport->get_send_buff(timeout);
     if (buff) {
-        guts->last_seq_out++; //update seq, this will actually be a send
+        guts->last_seq_out.write(guts->last_seq_out.read() + 1); //update seq, this will actually be a send
     }
     return buff;
 }
 
+static size_t get_tx_fc_credit(
+    boost::shared_ptr<x300_tx_fc_guts_t> guts,
+    size_t fc_pkt_window
+){
+    const size_t delta = ((guts->last_seq_out.read() & 0xfff) - (guts->last_seq_ack.read() & 0xfff)) & 0xfff;
+    return (delta <= fc_pkt_window)? fc_pkt_window + 1 - delta : 0;
+}
+
 /***********************************************************************
  * Async Data
  **********************************************************************/
@@ -358,6 +377,7 @@ rx_streamer::sptr x300_impl::get_rx_stream(const uhd::stream_args_t &args_)
     args.channels = args.channels.empty()? std::vector<size_t>(1, 0) : args.channels;
 
     boost::shared_ptr<sph::recv_packet_streamer> my_streamer;
+    std::vector<std::string> stream_mboards; //the mboard of each channel, for the statistics
     for (size_t stream_i = 0; stream_i < args.channels.size(); stream_i++)
     {
         // Find the mainboard and subdev that corresponds to channel args.channels[stream_i]
@@ -376,6 +396,7 @@ rx_streamer::sptr x300_impl::get_rx_stream(const uhd::stream_args_t &args_)
         // Find the DSP that corresponds to this mainboard and subdev
         UHD_ASSERT_THROW(mb_index < _mb.size());
         mboard_members_t &mb = _mb[mb_index];
+        stream_mboards.push_back(boost::lexical_cast<std::string>(mb_index));
         const std::vector<size_t> dsp_map = _tree->access<std::vector<size_t> >("/mboards/" + boost::lexical_cast<std::string>(mb_index) / "rx_chan_dsp_mapping")
                                             .get(); //.at(mb_chan);
         UHD_ASSERT_THROW(mb_chan < dsp_map.size());
@@ -487,6 +508,9 @@ rx_streamer::sptr x300_impl::get_rx_stream(const uhd::stream_args_t &args_)
         _tree->access<double>(mb_path / "rx_dsps" / boost::lexical_cast<std::string>(radio_index) / "rate" / "value").update();
     }
 
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "rx", args.channels, stream_mboards, my_streamer->get_stats_block());
+
     return my_streamer;
 }
 
@@ -541,6 +565,7 @@ tx_streamer::sptr x300_impl::get_tx_stream(const uhd::stream_args_t &args_)
     boost::shared_ptr<async_md_type> async_md(new async_md_type(1000/*messages deep*/));
 
     boost::shared_ptr<sph::send_packet_streamer> my_streamer;
+    std::vector<std::string> stream_mboards; //the mboard of each channel, for the statistics
     for (size_t stream_i = 0; stream_i < args.channels.size(); stream_i++)
     {
         // Find the mainboard and subdev that corresponds to channel args.channels[stream_i]
@@ -557,6 +582,7 @@ tx_streamer::sptr x300_impl::get_tx_stream(const uhd::stream_args_t &args_)
         }
         // Find the DSP that corresponds to this mainboard and subdev
         mboard_members_t &mb = _mb[mb_index];
+        stream_mboards.push_back(boost::lexical_cast<std::string>(mb_index));
 	const size_t radio_index = _tree->access<std::vector<size_t> >("/mboards/" + boost::lexical_cast<std::string>(mb_index) / "tx_chan_dsp_mapping")
                                             .get().at(mb_chan);
         radio_perifs_t &perif = mb.radio_perifs[radio_index];
@@ -614,7 +640,10 @@ tx_streamer::sptr x300_impl::get_tx_stream(const uhd::stream_args_t &args_)
         guts->device_channel = chan;
         guts->async_queue = async_md;
         guts->old_async_queue = _async_md;
-        task::sptr task = task::make(boost::bind(&handle_tx_async_msgs, guts, xport.recv, mb.if_pkt_is_big_endian, mb.clock));
+        //socket transports are watched by the event loop, the others get a thread
+        task::sptr task = (xport.recv->get_recv_fd() >= 0)?
+            task::make_readable(xport.recv->get_recv_fd(), boost::bind(&handle_tx_async_msgs, guts, xport.recv, mb.if_pkt_is_big_endian, mb.clock), "x300_tx_async") :
+            task::make(boost::bind(&handle_tx_async_msg, guts, xport.recv, mb.if_pkt_is_big_endian, mb.clock, 0.1), "x300_tx_async");
 
         //Give the streamer a functor to get the send buffer
         //get_tx_buff_with_flowctrl is static so bind has no lifetime issues
@@ -624,6 +653,9 @@ tx_streamer::sptr x300_impl::get_tx_stream(const uhd::stream_args_t &args_)
             stream_i,
             boost::bind(&get_tx_buff_with_flowctrl, task, guts, xport.send, fc_window, _1)
         );
+        my_streamer->set_xport_chan_fc_credit(
+            stream_i, boost::bind(&get_tx_fc_credit, guts, fc_window)
+        );
         //Give the streamer a functor handled received async messages
         my_streamer->set_async_receiver(
             boost::bind(&async_md_type::pop_with_timed_wait, async_md, _1, _2)
@@ -640,5 +672,8 @@ tx_streamer::sptr x300_impl::get_tx_stream(const uhd::stream_args_t &args_)
         _tree->access<double>(mb_path / "tx_dsps" / boost::lexical_cast<std::string>(radio_index) / "rate" / "value").update();
     }
 
+    //expose the streamer counters in the property tree
+    publish_stream_stats(_tree, "tx", args.channels, stream_mboards, my_streamer->get_stats_block());
+
     return my_streamer;
 }
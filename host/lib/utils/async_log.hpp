@@ -0,0 +1,68 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_UTILS_ASYNC_LOG_HPP
+#define INCLUDED_LIBUHD_UTILS_ASYNC_LOG_HPP
+
+#include <uhd/utils/log.hpp>
+#include <uhd/utils/msg.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <string>
+
+namespace uhd{ namespace _log{
+
+    /*!
+     * One message handed from a calling thread to the background writer.
+     * The calling thread only fills in the raw fields;
+     * the headers are formatted by the writer.
+     */
+    struct record_t{
+        enum kind_t{KIND_LOG, KIND_MSG} kind;
+        verbosity_t verbosity; //for KIND_LOG
+        uhd::msg::type_t type; //for KIND_MSG
+        boost::posix_time::ptime time; //universal time
+        std::string file;
+        unsigned int line;
+        std::string function;
+        std::string text;
+    };
+
+    /*!
+     * Queue a record for the background writer.
+     * Records go into a lock-free ring owned by the calling thread.
+     * \param record the record to copy into the ring
+     * \return false when the ring is full and the record was not queued
+     */
+    bool async_push(const record_t &record);
+
+}} //namespace uhd::_log
+
+namespace uhd{ namespace msg{
+
+    //! Deliver a message to the registered handler (called by the writer)
+    void deliver(const type_t type, const std::string &msg);
+
+    /*!
+     * Make the handler resources if they do not exist yet.
+     * The writer calls this before it registers its shutdown at exit,
+     * so the resources are destroyed after the shutdown.
+     */
+    void init_resources(void);
+
+}} //namespace uhd::msg
+
+#endif /* INCLUDED_LIBUHD_UTILS_ASYNC_LOG_HPP */
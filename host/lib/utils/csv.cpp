@@ -16,7 +16,12 @@
 //
 
 #include <uhd/utils/csv.hpp>
+#include <uhd/exception.hpp>
 #include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 using namespace uhd;
 
@@ -50,3 +55,93 @@ csv::rows_type csv::to_rows(std::istream &input){
     }
     return rows;
 }
+
+/***********************************************************************
+ * Numeric columns
+ **********************************************************************/
+static const size_t CSV_BLOCK_SIZE = 64*1024;
+
+static UHD_INLINE const char *skip_blanks(const char *p, const char *end){
+    while (p < end and (*p == ' ' or *p == '\t' or *p == '\r')) p++;
+    return p;
+}
+
+static void parse_numeric_line(
+    const char *p, const char *end, const size_t line_no,
+    csv::columns_type &columns
+){
+    p = skip_blanks(p, end);
+    if (p == end) return; //blank line
+
+    for (size_t col = 0; col < columns.size(); col++){
+        //strtod skips newlines, so check for an empty field first
+        p = skip_blanks(p, end);
+        if (p == end or *p == ',') throw uhd::value_error(str(boost::format(
+            "csv line %u: expected %u numeric columns") % line_no % columns.size()));
+
+        char *num_end;
+        const double value = std::strtod(p, &num_end);
+        const char *next = skip_blanks(num_end, end);
+        if (num_end == p or num_end > end or (next != end and *next != ',')){
+            throw uhd::value_error(str(boost::format(
+                "csv line %u column %u: not a number") % line_no % col));
+        }
+        columns[col].push_back(value);
+        p = next;
+        if (p != end) p++; //skip comma
+        else if (col + 1 != columns.size()) throw uhd::value_error(str(boost::format(
+            "csv line %u: expected %u numeric columns") % line_no % columns.size()));
+    }
+}
+
+csv::columns_type csv::to_columns(std::istream &input, const size_t num_cols){
+    csv::columns_type columns(num_cols);
+    std::vector<char> buff(CSV_BLOCK_SIZE + 1); //room for the null terminator
+    size_t fill = 0, line_no = 0;
+
+    bool done = false;
+    while (not done){
+        //grow the block when a single line does not fit
+        if (fill == buff.size() - 1) buff.resize(buff.size()*2);
+
+        input.read(&buff[fill], std::streamsize(buff.size() - 1 - fill));
+        fill += size_t(input.gcount());
+        done = not input;
+        buff[fill] = '\0'; //stops strtod on a final line without newline
+
+        //parse each complete line in the block
+        const char *begin = &buff[0];
+        const char *end = begin + fill;
+        while (begin != end){
+            const char *nl = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+            if (nl == NULL and not done) break; //partial line, wait for more data
+            if (nl == NULL) nl = end;
+            parse_numeric_line(begin, nl, ++line_no, columns);
+            begin = (nl == end)? end : nl + 1;
+        }
+
+        //move the partial line to the front of the block
+        fill = end - begin;
+        std::memmove(&buff[0], begin, fill);
+    }
+    return columns;
+}
+
+void csv::write_columns(std::ostream &output, const csv::columns_type &columns){
+    if (columns.empty()) return;
+    const size_t num_rows = columns.front().size();
+    BOOST_FOREACH(const std::vector<double> &column, columns){
+        if (column.size() != num_rows) throw uhd::value_error("csv columns must have the same length");
+    }
+
+    //format each row into one buffer, enough digits to round trip
+    std::vector<char> line(columns.size()*32);
+    for (size_t row = 0; row < num_rows; row++){
+        size_t len = 0;
+        for (size_t col = 0; col < columns.size(); col++){
+            len += std::sprintf(&line[len], (col == 0)? "%.17g" : ", %.17g", columns[col][row]);
+        }
+        line[len++] = '\n';
+        output.write(&line[0], std::streamsize(len));
+    }
+}
@@ -15,15 +15,23 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include "async_log.hpp"
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/static.hpp>
 #include <uhd/utils/paths.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <uhd/utils/atomic.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
 #include <boost/thread/locks.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/bind.hpp>
 #ifdef BOOST_MSVC
 //whoops! https://svn.boost.org/trac/boost/ticket/5287
 //enjoy this useless dummy class instead
@@ -37,44 +45,365 @@ namespace boost{ namespace interprocess{
 #else
 #include <boost/interprocess/sync/file_lock.hpp>
 #endif
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <cctype>
+#include <vector>
 
 namespace fs = boost::filesystem;
 namespace pt = boost::posix_time;
 namespace ip = boost::interprocess;
 
+static const size_t RING_SIZE = 512; //slots per thread, power of 2
+static const size_t MAX_RECORD_SLOTS = RING_SIZE/4; //longer texts are cut
+static const size_t SLOT_TEXT_SIZE = 112; //text bytes per slot, enough for most records
+static const size_t SLOT_FILE_SIZE = 96; //the end of the source path
+static const size_t SLOT_FUNCTION_SIZE = 80; //as much as the log header shows
+static const double WRITER_PERIOD = 0.01; //seconds between drains when idle
+
+/***********************************************************************
+ * Fixed-size ring slot
+ *
+ * The ring itself does not allocate: a record is copied into slots.
+ * (The text of a record is still built in a string by the caller.)
+ * The first slot of a record holds its fields; the text continues
+ * in as many of the following slots as it needs.
+ **********************************************************************/
+struct log_slot_t{
+    uhd::_log::record_t::kind_t kind;
+    uhd::_log::verbosity_t verbosity;
+    uhd::msg::type_t type;
+    pt::ptime time;
+    unsigned int line;
+    boost::uint16_t num_slots;
+    boost::uint16_t text_len;
+    char file[SLOT_FILE_SIZE];
+    char function[SLOT_FUNCTION_SIZE];
+    char text[SLOT_TEXT_SIZE];
+};
+
+//! Copy a string into a fixed field, keeping the end when it is too long
+static void copy_field(char *field, const size_t size, const std::string &str, const bool keep_end){
+    const size_t len = std::min(str.size(), size - 1);
+    const size_t start = keep_end? str.size() - len : 0;
+    std::memcpy(field, str.data() + start, len);
+    field[len] = '\0';
+}
+
+/***********************************************************************
+ * Per-thread record ring
+ *
+ * Single producer (the owning thread), single consumer (the writer).
+ * The producer only touches the head, the consumer only the tail.
+ **********************************************************************/
+class log_ring{
+public:
+    typedef boost::shared_ptr<log_ring> sptr;
+
+    log_ring(void): _slots(RING_SIZE), _dropped_reported(0){
+        _closed.write(0);
+    }
+
+    //! Copy a record into the ring; called by the owning thread
+    bool push(const uhd::_log::record_t &record){
+        const size_t num_slots = std::max<size_t>(1, std::min(
+            (record.text.size() + SLOT_TEXT_SIZE - 1)/SLOT_TEXT_SIZE, MAX_RECORD_SLOTS
+        ));
+        const boost::uint32_t head = _head.read();
+        if (head - _tail.read() + num_slots > RING_SIZE) return false;
+
+        log_slot_t &first = _slots[head & (RING_SIZE-1)];
+        first.kind = record.kind;
+        first.verbosity = record.verbosity;
+        first.type = record.type;
+        first.time = record.time;
+        first.line = record.line;
+        first.num_slots = boost::uint16_t(num_slots);
+        copy_field(first.file, SLOT_FILE_SIZE, record.file, true);
+        copy_field(first.function, SLOT_FUNCTION_SIZE, record.function, false);
+        for (size_t i = 0; i < num_slots; i++){
+            log_slot_t &slot = _slots[(head + i) & (RING_SIZE-1)];
+            const size_t offset = i*SLOT_TEXT_SIZE;
+            slot.text_len = boost::uint16_t((record.text.size() > offset)?
+                std::min(record.text.size() - offset, SLOT_TEXT_SIZE) : 0);
+            std::memcpy(slot.text, record.text.data() + offset, slot.text_len);
+        }
+        _head.write(head + boost::uint32_t(num_slots));
+        return true;
+    }
+
+    //! Count a record that did not fit; called by the owning thread
+    void drop(void){
+        _dropped.inc();
+    }
+
+    //! Copy the oldest record out of the ring; called by the writer
+    bool pop(uhd::_log::record_t &record){
+        const boost::uint32_t tail = _tail.read();
+        if (tail == _head.read()) return false;
+        const log_slot_t &first = _slots[tail & (RING_SIZE-1)];
+        record.kind = first.kind;
+        record.verbosity = first.verbosity;
+        record.type = first.type;
+        record.time = first.time;
+        record.line = first.line;
+        record.file = first.file;
+        record.function = first.function;
+        record.text.clear();
+        for (size_t i = 0; i < first.num_slots; i++){
+            const log_slot_t &slot = _slots[(tail + i) & (RING_SIZE-1)];
+            record.text.append(slot.text, slot.text_len);
+        }
+        _tail.write(tail + first.num_slots);
+        return true;
+    }
+
+    //! Get the number of records dropped since the last call; called by the writer
+    size_t get_new_drops(void){
+        const boost::uint32_t dropped = _dropped.read();
+        const size_t new_drops = dropped - _dropped_reported;
+        _dropped_reported = dropped;
+        return new_drops;
+    }
+
+    //! Mark the owning thread as gone
+    void close(void){
+        _closed.write(1);
+    }
+
+    bool is_closed(void){
+        return _closed.read() != 0;
+    }
+
+private:
+    std::vector<log_slot_t> _slots;
+    uhd::atomic_uint32_t _head, _tail, _dropped, _closed;
+    boost::uint32_t _dropped_reported;
+};
+
+/*!
+ * Thread local handle; closes the ring when the thread exits.
+ * It also keeps the records of the log objects that are still being
+ * written in this thread (nested when a log argument logs itself).
+ */
+struct log_ring_holder{
+    log_ring_holder(log_ring::sptr ring_): ring(ring_){}
+    ~log_ring_holder(void){ring->close();}
+    log_ring::sptr ring;
+    std::vector<uhd::_log::record_t> pending;
+};
+
 /***********************************************************************
  * Global resources for the logger
  **********************************************************************/
+//! get the relative file path from the host directory
+static std::string get_rel_file_path(const fs::path &file){
+    fs::path abs_path = file.parent_path();
+    fs::path rel_path = file.leaf();
+    while (not abs_path.empty() and abs_path.leaf() != "host"){
+        rel_path = abs_path.leaf() / rel_path;
+        abs_path = abs_path.parent_path();
+    }
+    return rel_path.string();
+}
+
 class log_resource_type{
 public:
-    uhd::_log::verbosity_t level;
-
     log_resource_type(void){
 
         //file lock pointer must be null
         _file_lock = NULL;
+        _shut_down.write(0);
 
         //set the default log level
-        level = uhd::_log::never;
+        uhd::_log::verbosity_t level = uhd::_log::never;
 
         //allow override from macro definition
         #ifdef UHD_LOG_LEVEL
-        _set_log_level(BOOST_STRINGIZE(UHD_LOG_LEVEL));
+        _set_log_level(level, BOOST_STRINGIZE(UHD_LOG_LEVEL));
         #endif
 
         //allow override from environment variable
         const char * log_level_env = std::getenv("UHD_LOG_LEVEL");
-        if (log_level_env != NULL) _set_log_level(log_level_env);
+        if (log_level_env != NULL) _set_log_level(level, log_level_env);
+
+        this->set_level(level);
+    }
+
+    //! The log level; application threads read it while the writer may change it
+    uhd::_log::verbosity_t get_level(void){
+        return uhd::_log::verbosity_t(BOOST_IPC_DETAIL::atomic_read32(&uhd::_log::log_level));
+    }
+
+    void set_level(const uhd::_log::verbosity_t level){
+        BOOST_IPC_DETAIL::atomic_write32(&uhd::_log::log_level, boost::uint32_t(level));
     }
 
     ~log_resource_type(void){
+        //normally shut down at exit already
+        this->shutdown();
+        //records queued while shutting down go to the file, the message handler may be gone
+        this->drain(false);
         boost::lock_guard<boost::mutex> lock(_mutex);
         _file_stream.close();
         if (_file_lock != NULL) delete _file_lock;
     }
 
+    /*!
+     * Queue a record for the writer.
+     * After shutdown, log records are written by the calling thread,
+     * and messages are refused so the caller delivers them itself.
+     */
+    bool push(const uhd::_log::record_t &record){
+        if (_shut_down.read() != 0){
+            if (record.kind == uhd::_log::record_t::KIND_MSG) return false;
+            std::string log_text;
+            format_record(record, log_text);
+            this->write_text(log_text);
+            return true;
+        }
+        return get_holder()->ring->push(record);
+    }
+
+    void drop(void){
+        get_holder()->ring->drop();
+    }
+
+    //! Start the record of a log object in the calling thread
+    uhd::_log::record_t &begin_record(void){
+        std::vector<uhd::_log::record_t> &pending = get_holder()->pending;
+        pending.push_back(uhd::_log::record_t());
+        return pending.back();
+    }
+
+    //! Queue the newest record started in the calling thread
+    void end_record(const std::string &text){
+        std::vector<uhd::_log::record_t> &pending = get_holder()->pending;
+        pending.back().text = text;
+        if (not this->push(pending.back())) this->drop();
+        pending.pop_back();
+    }
+
+    /*!
+     * Stop the writer and flush the queued records.
+     * This runs at exit, before the static objects that the writer
+     * delivers messages to are destroyed.
+     */
+    void shutdown(void){
+        if (_shut_down.read() != 0) return;
+        _shut_down.write(1);
+        _writer.reset();
+        this->drain(true);
+    }
+
+private:
+    log_ring_holder *get_holder(void){
+        log_ring_holder *holder = _local_ring.get();
+        if (holder == NULL){
+            holder = new log_ring_holder(this->make_ring());
+            _local_ring.reset(holder);
+        }
+        return holder;
+    }
+
+    //! register a ring for the calling thread, starting the writer on first use
+    log_ring::sptr make_ring(void){
+        log_ring::sptr ring(new log_ring());
+        boost::lock_guard<boost::mutex> lock(_rings_mutex);
+        _rings.push_back(ring);
+        if (not _writer and _shut_down.read() == 0){
+            _writer = uhd::task::make(boost::bind(&log_resource_type::writer_loop, this), "uhd_log");
+            uhd::msg::init_resources();
+            std::atexit(&shutdown_at_exit);
+        }
+        return ring;
+    }
+
+    static void shutdown_at_exit(void);
+
+    void writer_loop(void){
+        if (this->drain(true) == 0){
+            boost::this_thread::sleep(pt::microseconds(long(WRITER_PERIOD*1e6)));
+        }
+    }
+
+    /*!
+     * Pop all queued records, deliver messages and write log entries.
+     * Without deliver_msgs, messages are written to the log file instead.
+     */
+    size_t drain(const bool deliver_msgs){
+        std::vector<log_ring::sptr> rings;
+        {
+            boost::lock_guard<boost::mutex> lock(_rings_mutex);
+            rings = _rings;
+        }
+
+        size_t num_records = 0;
+        std::string log_text;
+        for (size_t i = 0; i < rings.size(); i++){
+            //check closed before popping so no record is left behind
+            const bool closed = rings[i]->is_closed();
+            while (rings[i]->pop(_record)){
+                num_records++;
+                if (_record.kind == uhd::_log::record_t::KIND_MSG and deliver_msgs){
+                    uhd::msg::deliver(_record.type, _record.text);
+                }
+                else format_record(_record, log_text);
+            }
+            const size_t drops = rings[i]->get_new_drops();
+            if (drops != 0 and this->get_level() != uhd::_log::never){
+                log_text += str(boost::format("\n-- %u log messages dropped (queue full)\n") % drops);
+            }
+            if (closed) remove_ring(rings[i]);
+        }
+
+        if (not log_text.empty()) this->write_text(log_text);
+        return num_records;
+    }
+
+    void write_text(const std::string &log_text){
+        try{
+            this->log_to_file(log_text);
+        }
+        catch(const std::exception &e){
+            /*!
+             * Critical behavior below.
+             * The following steps must happen in order to avoid a lock-up condition.
+             * This is because the message facility will call into the logging facility.
+             * Therefore we must disable the logger (level = never) before messaging.
+             */
+            this->set_level(uhd::_log::never);
+            UHD_MSG(error)
+                << "Logging failed: " << e.what() << std::endl
+                << "Logging has been disabled for this process" << std::endl
+            ;
+        }
+    }
+
+    static void format_record(const uhd::_log::record_t &record, std::string &out){
+        typedef boost::date_time::c_local_adjustor<pt::ptime> local_adj;
+        const std::string time = pt::to_simple_string(local_adj::utc_to_local(record.time));
+        const std::string header1 = str(boost::format("-- %s - level %d") % time % int(record.verbosity));
+        const std::string header2 = str(boost::format("-- %s") % record.function).substr(0, 80);
+        const std::string header3 = str(boost::format("-- %s:%u") % get_rel_file_path(record.file) % record.line);
+        const std::string border = std::string(std::max(std::max(header1.size(), header2.size()), header3.size()), '-');
+        out += "\n";
+        out += border + "\n";
+        out += header1 + "\n";
+        out += header2 + "\n";
+        out += header3 + "\n";
+        out += border + "\n";
+        out += record.text;
+        out += "\n";
+    }
+
+    void remove_ring(log_ring::sptr ring){
+        boost::lock_guard<boost::mutex> lock(_rings_mutex);
+        _rings.erase(std::remove(_rings.begin(), _rings.end(), ring), _rings.end());
+    }
+
     void log_to_file(const std::string &log_msg){
         boost::lock_guard<boost::mutex> lock(_mutex);
         if (_file_lock == NULL){
@@ -87,15 +416,14 @@ public:
         _file_lock->unlock();
     }
 
-private:
-    //! set the log level from a string that is either a digit or an enum name
-    void _set_log_level(const std::string &log_level_str){
+    //! parse the log level from a string that is either a digit or an enum name
+    static void _set_log_level(uhd::_log::verbosity_t &level, const std::string &log_level_str){
         const uhd::_log::verbosity_t log_level_num = uhd::_log::verbosity_t(log_level_str[0]-'0');
         if (std::isdigit(log_level_str[0]) and log_level_num >= uhd::_log::always and log_level_num <= uhd::_log::never){
-            this->level = log_level_num;
+            level = log_level_num;
             return;
         }
-        #define if_lls_equal(name) else if(log_level_str == #name) this->level = uhd::_log::name
+        #define if_lls_equal(name) else if(log_level_str == #name) level = uhd::_log::name
         if_lls_equal(always);
         if_lls_equal(often);
         if_lls_equal(regularly);
@@ -108,25 +436,35 @@ private:
     std::ofstream _file_stream;
     ip::file_lock *_file_lock;
     boost::mutex _mutex;
+
+    //per-thread rings and the writer that drains them:
+    boost::thread_specific_ptr<log_ring_holder> _local_ring;
+    std::vector<log_ring::sptr> _rings;
+    boost::mutex _rings_mutex;
+    uhd::_log::record_t _record; //writer scratch space
+    uhd::task::sptr _writer;
+    uhd::atomic_uint32_t _shut_down;
 };
 
+volatile boost::uint32_t uhd::_log::log_level = 0;
+
 UHD_SINGLETON_FCN(log_resource_type, log_rs);
 
-/***********************************************************************
- * The logger object implementation
- **********************************************************************/
-//! get the relative file path from the host directory
-static std::string get_rel_file_path(const fs::path &file){
-    fs::path abs_path = file.parent_path();
-    fs::path rel_path = file.leaf();
-    while (not abs_path.empty() and abs_path.leaf() != "host"){
-        rel_path = abs_path.leaf() / rel_path;
-        abs_path = abs_path.parent_path();
-    }
-    return rel_path.string();
+void log_resource_type::shutdown_at_exit(void){
+    log_rs().shutdown();
 }
 
+bool uhd::_log::async_push(const record_t &record){
+    return log_rs().push(record);
+}
 
+uhd::_log::verbosity_t uhd::_log::get_log_level(void){
+    return log_rs().get_level();
+}
+
+/***********************************************************************
+ * The logger object implementation
+ **********************************************************************/
 uhd::_log::log::log(
     const verbosity_t verbosity,
     const std::string &file,
@@ -134,21 +472,17 @@ uhd::_log::log::log(
     const std::string &function
     )
 {
-    _log_it = (verbosity >= log_rs().level);
+    _log_it = (verbosity >= log_rs().get_level());
     if (_log_it)
     {
-        const std::string time = pt::to_simple_string(pt::microsec_clock::local_time());
-        const std::string header1 = str(boost::format("-- %s - level %d") % time % int(verbosity));
-        const std::string header2 = str(boost::format("-- %s") % function).substr(0, 80);
-        const std::string header3 = str(boost::format("-- %s:%u") % get_rel_file_path(file) % line);
-        const std::string border = std::string(std::max(std::max(header1.size(), header2.size()), header3.size()), '-');
-        _ss << std::endl
-            << border << std::endl
-            << header1 << std::endl
-            << header2 << std::endl
-            << header3 << std::endl
-            << border << std::endl
-        ;
+        //only capture the raw fields here, the writer formats the headers
+        record_t &record = log_rs().begin_record();
+        record.kind = record_t::KIND_LOG;
+        record.verbosity = verbosity;
+        record.time = pt::microsec_clock::universal_time();
+        record.file = file;
+        record.line = line;
+        record.function = function;
     }
 }
 
@@ -157,21 +491,5 @@ uhd::_log::log::~log(void)
     if (not _log_it)
         return;
 
-    _ss << std::endl;
-    try{
-        log_rs().log_to_file(_ss.str());
-    }
-    catch(const std::exception &e){
-        /*!
-         * Critical behavior below.
-         * The following steps must happen in order to avoid a lock-up condition.
-         * This is because the message facility will call into the logging facility.
-         * Therefore we must disable the logger (level = never) before messaging.
-         */
-        log_rs().level = never;
-        UHD_MSG(error)
-            << "Logging failed: " << e.what() << std::endl
-            << "Logging has been disabled for this process" << std::endl
-        ;
-    }
+    log_rs().end_record(_ss.str());
 }
@@ -15,6 +15,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#include "async_log.hpp"
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/static.hpp>
@@ -73,11 +74,6 @@ UHD_SINGLETON_FCN(msg_resource_type, msg_rs);
 /***********************************************************************
  * Setup the message handlers
  **********************************************************************/
-void uhd::msg::register_handler(const handler_t &handler){
-    boost::mutex::scoped_lock lock(msg_rs().mutex);
-    msg_rs().handler = handler;
-}
-
 static void default_msg_handler(uhd::msg::type_t type, const std::string &msg){
     switch(type){
     case uhd::msg::fastpath:
@@ -101,10 +97,24 @@ static void default_msg_handler(uhd::msg::type_t type, const std::string &msg){
     }
 }
 
+void uhd::msg::register_handler(const handler_t &handler){
+    boost::mutex::scoped_lock lock(msg_rs().mutex);
+    msg_rs().handler = (handler == NULL)? &default_msg_handler : handler;
+}
+
 UHD_STATIC_BLOCK(msg_register_default_handler){
     uhd::msg::register_handler(&default_msg_handler);
 }
 
+void uhd::msg::init_resources(void){
+    msg_rs();
+}
+
+void uhd::msg::deliver(const type_t type, const std::string &msg){
+    boost::mutex::scoped_lock lock(msg_rs().mutex);
+    msg_rs().handler(type, msg);
+}
+
 /***********************************************************************
  * The message object implementation
  **********************************************************************/
@@ -119,8 +129,17 @@ uhd::msg::_msg::_msg(const type_t type){
 }
 
 uhd::msg::_msg::~_msg(void){
-    boost::mutex::scoped_lock lock(msg_rs().mutex);
-    msg_rs().handler(_impl->type, _impl->ss.str());
+    //fastpath messages come from streaming threads:
+    //hand them to the background writer instead of blocking on the handler
+    if (_impl->type == fastpath){
+        uhd::_log::record_t record;
+        record.kind = uhd::_log::record_t::KIND_MSG;
+        record.type = _impl->type;
+        record.text = _impl->ss.str();
+        if (uhd::_log::async_push(record)) return;
+        //the queue is full: deliver in this thread rather than lose it
+    }
+    uhd::msg::deliver(_impl->type, _impl->ss.str());
 }
 
 std::ostream & uhd::msg::_msg::operator()(void){
@@ -22,6 +22,9 @@
 #include <Windows.h>
 #else
 #include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #endif
 
 namespace uhd {
@@ -55,4 +58,49 @@ namespace uhd {
         boost::hash_combine(hash, uhd::get_host_id());
         return boost::uint32_t(hash);
     }
+
+#ifdef UHD_PLATFORM_WIN32
+    static double filetimes_to_secs(const FILETIME &kernel, const FILETIME &user) {
+        //FILETIME counts 100 ns intervals
+        ULARGE_INTEGER k, u;
+        k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+        u.LowPart = user.dwLowDateTime; u.HighPart = user.dwHighDateTime;
+        return double(k.QuadPart + u.QuadPart)*1e-7;
+    }
+#else
+    static double rusage_to_secs(const struct rusage &usage) {
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec*1e-6
+             + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec*1e-6;
+    }
+#endif
+
+    double get_thread_cpu_time() {
+#if defined(UHD_PLATFORM_WIN32)
+        FILETIME creation, exit, kernel, user;
+        if (not GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0.0;
+        return filetimes_to_secs(kernel, user);
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+        timespec ts;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0.0;
+        return ts.tv_sec + ts.tv_nsec*1e-9;
+#elif defined(RUSAGE_THREAD)
+        struct rusage usage;
+        if (getrusage(RUSAGE_THREAD, &usage) != 0) return 0.0;
+        return rusage_to_secs(usage);
+#else
+        return 0.0; //not available on this platform
+#endif
+    }
+
+    double get_process_cpu_time() {
+#ifdef UHD_PLATFORM_WIN32
+        FILETIME creation, exit, kernel, user;
+        if (not GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0.0;
+        return filetimes_to_secs(kernel, user);
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+        return rusage_to_secs(usage);
+#endif
+    }
 }
@@ -0,0 +1,294 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "reactor.hpp"
+#include <uhd/utils/thread_role.hpp>
+#include <uhd/utils/msg.hpp>
+#include <uhd/types/dict.hpp>
+#include <uhd/exception.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/foreach.hpp>
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
+
+#ifdef HAVE_EPOLL
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+using namespace uhd;
+
+reactor::~reactor(void){
+    /* NOP */
+}
+
+/***********************************************************************
+ * A registered handler
+ **********************************************************************/
+struct reactor_entry{
+    reactor_entry(void): id(0), fd(-1), registered(true){}
+
+    //! Held while the handler runs, recursive so a handler can drop its own registration
+    boost::recursive_mutex run_mutex;
+    reactor::handler_type handler; //guarded by run_mutex
+
+    size_t id;
+    int fd;
+    bool registered;  //guarded by the reactor mutex
+};
+
+typedef boost::shared_ptr<reactor_entry> entry_sptr;
+
+/***********************************************************************
+ * Reactor implementation
+ **********************************************************************/
+class reactor_impl : public reactor, public boost::enable_shared_from_this<reactor_impl>{
+public:
+    reactor_impl(void): _stopping(false), _next_id(1){
+        #ifdef HAVE_EPOLL
+        _epoll_fd = epoll_create(16);
+        if (_epoll_fd < 0) throw uhd::os_error("error in epoll_create");
+        _wake_fd = eventfd(0, EFD_NONBLOCK);
+        if (_wake_fd < 0) throw uhd::os_error("error in eventfd");
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = 0; //id zero is the wake up
+        epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _wake_fd, &event);
+        #endif
+    }
+
+    ~reactor_impl(void){
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _stopping = true;
+        }
+        this->wake();
+        BOOST_FOREACH(boost::shared_ptr<boost::thread> thread, _threads){
+            thread->join();
+        }
+        #ifdef HAVE_EPOLL
+        ::close(_wake_fd);
+        ::close(_epoll_fd);
+        #endif
+    }
+
+    void start(const size_t num_threads){
+        #ifdef HAVE_EPOLL
+        for (size_t i = 0; i < num_threads; i++){
+            _threads.push_back(boost::shared_ptr<boost::thread>(
+                new boost::thread(boost::bind(&reactor_impl::run, this))));
+        }
+        #else
+        (void)num_threads; //nothing to watch, no threads needed
+        #endif
+    }
+
+    registration_type add_readable(int fd, const handler_type &handler){
+        #ifdef HAVE_EPOLL
+        entry_sptr entry(new reactor_entry());
+        entry->fd = fd;
+        entry->handler = handler;
+        boost::mutex::scoped_lock lock(_mutex);
+        entry->id = _next_id++;
+        _fd_entries[entry->id] = entry;
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.u64 = entry->id;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0){
+            _fd_entries.pop(entry->id);
+            throw uhd::os_error("error in epoll_ctl adding fd " + boost::lexical_cast<std::string>(fd));
+        }
+        return this->make_registration(entry);
+        #else
+        (void)fd;
+        (void)handler;
+        throw uhd::not_implemented_error("reactor cannot watch file descriptors on this platform");
+        #endif
+    }
+
+    bool can_watch_fds(void) const{
+        #ifdef HAVE_EPOLL
+        return true;
+        #else
+        return false;
+        #endif
+    }
+
+    //! Stop the handler of an entry; waits for a running handler to return
+    void remove(entry_sptr entry){
+        {
+            boost::recursive_mutex::scoped_lock run_lock(entry->run_mutex);
+            entry->handler = handler_type(); //release what the handler holds
+        }
+        boost::mutex::scoped_lock lock(_mutex);
+        this->unregister(entry);
+    }
+
+private:
+    /*******************************************************************
+     * Registration handles
+     ******************************************************************/
+    struct registration{
+        registration(boost::shared_ptr<reactor_impl> reactor, entry_sptr entry):
+            reactor(reactor), entry(entry){}
+        ~registration(void){
+            reactor->remove(entry);
+        }
+        boost::shared_ptr<reactor_impl> reactor;
+        entry_sptr entry;
+    };
+
+    registration_type make_registration(entry_sptr entry){
+        return registration_type(new registration(this->shared_from_this(), entry));
+    }
+
+    //! Take an entry out of the loop (called with the mutex held)
+    void unregister(entry_sptr entry){
+        if (not entry->registered) return;
+        entry->registered = false;
+        _fd_entries.pop(entry->id);
+        #ifdef HAVE_EPOLL
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, entry->fd, NULL);
+        #endif
+    }
+
+    /*******************************************************************
+     * The loop
+     ******************************************************************/
+    #ifdef HAVE_EPOLL
+    void run(void){
+        apply_thread_role("uhd_reactor");
+        std::vector<entry_sptr> ready;
+        while (true){
+            {
+                boost::mutex::scoped_lock lock(_mutex);
+                if (_stopping) break;
+            }
+            this->wait(ready);
+            BOOST_FOREACH(const entry_sptr &entry, ready) this->dispatch(entry);
+            ready.clear();
+        }
+        //pass the stop on to the next thread
+        this->wake();
+    }
+
+    void wait(std::vector<entry_sptr> &ready){
+        epoll_event events[16];
+        const int num_events = epoll_wait(_epoll_fd, events, 16, -1);
+        if (num_events < 0 and errno != EINTR){
+            UHD_MSG(error) << "reactor: error in epoll_wait" << std::endl;
+            boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+        }
+        boost::mutex::scoped_lock lock(_mutex);
+        for (int i = 0; i < num_events; i++){
+            const size_t id = size_t(events[i].data.u64);
+            if (id == 0){
+                if (_stopping) continue; //leave it set for the other threads
+                boost::uint64_t count;
+                if (::read(_wake_fd, &count, sizeof(count)) < 0){/* already drained */}
+                continue;
+            }
+            if (_fd_entries.has_key(id)) ready.push_back(_fd_entries[id]);
+        }
+    }
+
+    void wake(void){
+        const boost::uint64_t one = 1;
+        if (::write(_wake_fd, &one, sizeof(one)) < 0){/* counter full, already awake */}
+    }
+
+    void rearm(const entry_sptr &entry){
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.u64 = entry->id;
+        epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, entry->fd, &event);
+    }
+
+    void dispatch(const entry_sptr &entry){
+        bool failed = false;
+        {
+            boost::recursive_mutex::scoped_lock run_lock(entry->run_mutex);
+            //a copy, so the handler may drop its own registration
+            const handler_type handler = entry->handler;
+            if (handler) try{
+                handler();
+            }
+            catch(const std::exception &e){
+                UHD_MSG(error)
+                    << "An unexpected exception was caught in a task loop." << std::endl
+                    << "The task loop will now exit, things may not work." << std::endl
+                    << e.what() << std::endl
+                ;
+                failed = true;
+            }
+        }
+
+        boost::mutex::scoped_lock lock(_mutex);
+        if (not entry->registered) return;
+        if (failed) return this->unregister(entry);
+        this->rearm(entry);
+    }
+    #else
+    void wake(void){
+        /* NOP: no threads */
+    }
+    #endif
+
+    boost::mutex _mutex;
+    bool _stopping;
+    size_t _next_id;
+    uhd::dict<size_t, entry_sptr> _fd_entries;
+    std::vector<boost::shared_ptr<boost::thread> > _threads;
+    #ifdef HAVE_EPOLL
+    int _epoll_fd;
+    int _wake_fd;
+    #endif
+};
+
+/***********************************************************************
+ * Factories
+ **********************************************************************/
+reactor::sptr reactor::make(const size_t num_threads){
+    boost::shared_ptr<reactor_impl> impl(new reactor_impl());
+    impl->start(std::max<size_t>(num_threads, 1));
+    return impl;
+}
+
+reactor::sptr reactor::get_shared(void){
+    static boost::mutex mutex;
+    boost::mutex::scoped_lock lock(mutex);
+    static reactor::sptr shared;
+    if (not shared){
+        const char *env = std::getenv("UHD_REACTOR_THREADS");
+        size_t num_threads = 1;
+        if (env != NULL) try{
+            num_threads = boost::lexical_cast<size_t>(env);
+        }
+        catch(const boost::bad_lexical_cast &){
+            UHD_MSG(warning) << "Ignoring UHD_REACTOR_THREADS=" << env << std::endl;
+        }
+        shared = make(num_threads);
+    }
+    return shared;
+}
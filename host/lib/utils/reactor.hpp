@@ -0,0 +1,77 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_UTILS_REACTOR_HPP
+#define INCLUDED_LIBUHD_UTILS_REACTOR_HPP
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+
+namespace uhd{
+
+/*!
+ * An event loop that runs async message handlers on a few shared threads.
+ *
+ * Handlers run when a file descriptor becomes readable. A handler never
+ * runs on two threads at once, and a descriptor is not watched while its
+ * handler runs, so a handler only has to drain what is ready. Handlers must not block for long: every other handler
+ * of the reactor waits for them.
+ */
+class reactor : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<reactor> sptr;
+    typedef boost::function<void(void)> handler_type;
+
+    /*!
+     * A registered handler; it runs until the registration is destroyed.
+     * Destruction waits for a running handler to return, unless it
+     * happens from within that handler.
+     */
+    typedef boost::shared_ptr<void> registration_type;
+
+    virtual ~reactor(void) = 0;
+
+    /*!
+     * Run the handler whenever the descriptor is readable.
+     * \throw uhd::not_implemented_error when the platform cannot watch descriptors
+     */
+    virtual registration_type add_readable(int fd, const handler_type &handler) = 0;
+
+    //! Can this reactor watch file descriptors?
+    virtual bool can_watch_fds(void) const = 0;
+
+    /*!
+     * Make a reactor with its own threads.
+     * The threads take the thread role "uhd_reactor". A platform that
+     * cannot watch descriptors gets no threads.
+     * The last reference must not be dropped from one of its handlers.
+     */
+    static sptr make(size_t num_threads);
+
+    /*!
+     * Get the reactor shared by the readable tasks of the process.
+     * It runs the flow control handlers of every streamer, so nothing
+     * that waits on a control transaction may be registered with it.
+     * The UHD_REACTOR_THREADS environment variable sets its thread count (default 1).
+     */
+    static sptr get_shared(void);
+};
+
+} //namespace uhd
+
+#endif /* INCLUDED_LIBUHD_UTILS_REACTOR_HPP */
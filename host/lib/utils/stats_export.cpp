@@ -0,0 +1,376 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/utils/stats_export.hpp>
+#include <uhd/utils/platform.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <uhd/utils/msg.hpp>
+#include <uhd/utils/safe_call.hpp>
+#include <uhd/types/stream_stats.hpp>
+#include <uhd/types/sensors.hpp>
+#include <uhd/exception.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cstring>
+
+using namespace uhd;
+namespace ipc = boost::interprocess;
+
+/***********************************************************************
+ * Segment layout
+ *
+ * One header followed by a fixed array of metrics.
+ * The writer increments seq before and after each update,
+ * so an odd value means an update is in progress.
+ **********************************************************************/
+static const boost::uint32_t STATS_MAGIC = 0x55484453; //"UHDS"
+static const boost::uint32_t STATS_VERSION = 1;
+static const size_t STATS_MAX_METRICS = 4096;
+static const size_t STATS_NAME_LEN = 120;
+
+struct stats_shm_metric_t{
+    double value;
+    char name[STATS_NAME_LEN];
+};
+
+struct stats_shm_t{
+    boost::uint32_t magic;
+    boost::uint32_t version;
+    volatile boost::uint32_t seq;
+    boost::uint32_t pid;
+    boost::uint32_t num_metrics;
+    boost::uint32_t num_dropped;
+    boost::uint64_t update_count;
+    double update_time;
+    stats_shm_metric_t metrics[STATS_MAX_METRICS];
+};
+
+//! How long a reader retries before it gives up on an update that never completes
+static const double STATS_READ_TIMEOUT = 1.0;
+
+static double get_unix_time(void){
+    const boost::posix_time::time_duration since_epoch =
+        boost::posix_time::microsec_clock::universal_time() - boost::posix_time::from_time_t(0);
+    return since_epoch.total_microseconds()/1e6;
+}
+
+/***********************************************************************
+ * Metric collection from a property tree
+ **********************************************************************/
+typedef std::vector<stats_metric_t> metrics_type;
+
+static void add_metric(metrics_type &metrics, const std::string &name, const double value){
+    stats_metric_t metric;
+    metric.name = name;
+    metric.value = value;
+    metrics.push_back(metric);
+}
+
+static void add_histogram(metrics_type &metrics, const std::string &name, const time_histogram_t &hist){
+    add_metric(metrics, name + "/count", double(hist.count));
+    add_metric(metrics, name + "/sum_secs", hist.total_secs);
+    //cumulative counts by upper edge; the last bin has no upper edge
+    boost::uint64_t accum = 0;
+    for (size_t i = 0; i < time_histogram_t::NUM_BINS-1; i++){
+        accum += hist.bins[i];
+        const double edge_us = time_histogram_t::get_bin_start(i+1)*1e6;
+        add_metric(metrics, str(boost::format("%s/le_%gus") % name % edge_us), double(accum));
+    }
+}
+
+static void add_stream_stats(metrics_type &metrics, const std::string &name, const stream_stats_t &stats){
+    add_metric(metrics, name + "/num_packets", double(stats.num_packets));
+    add_metric(metrics, name + "/num_bytes", double(stats.num_bytes));
+    add_metric(metrics, name + "/num_sequence_errors", double(stats.num_sequence_errors));
+    add_metric(metrics, name + "/num_overflows", double(stats.num_overflows));
+    add_metric(metrics, name + "/num_timeouts", double(stats.num_timeouts));
+    add_metric(metrics, name + "/num_buff_stalls", double(stats.num_buff_stalls));
+    add_histogram(metrics, name + "/buff_wait_time", stats.buff_wait_time);
+    add_histogram(metrics, name + "/convert_time", stats.convert_time);
+    add_histogram(metrics, name + "/header_time", stats.header_time);
+}
+
+static void add_sensors(metrics_type &metrics, const std::string &prefix, property_tree::sptr tree, const fs_path &path){
+    if (not tree->exists(path)) return;
+    BOOST_FOREACH(const std::string &name, tree->list(path)){
+        //GPSDO sensors are read over a slow serial link, do not poll them
+        if (boost::starts_with(name, "gps")) continue;
+        try{
+            const sensor_value_t sensor = tree->access<sensor_value_t>(path / name).get();
+            if (sensor.type == sensor_value_t::STRING) continue;
+            const double value = (sensor.type == sensor_value_t::BOOLEAN)?
+                (sensor.to_bool()? 1.0 : 0.0) : sensor.to_real();
+            add_metric(metrics, prefix + path / name, value);
+        }
+        catch(const std::exception &){
+            //a sensor that cannot be read now is left out of this update
+        }
+    }
+}
+
+static void collect_tree(metrics_type &metrics, const std::string &prefix, property_tree::sptr tree){
+    if (not tree->exists("/mboards")) return;
+    BOOST_FOREACH(const std::string &mb, tree->list("/mboards")){
+        const fs_path mb_path = fs_path("/mboards") / mb;
+
+        //streamer and transport counters
+        if (tree->exists(mb_path / "streamers")){
+            BOOST_FOREACH(const std::string &name, tree->list(mb_path / "streamers")){
+                const fs_path path = mb_path / "streamers" / name;
+                add_stream_stats(metrics, prefix + path, tree->access<stream_stats_t>(path / "stats").get());
+                if (not tree->exists(path / "xports")) continue;
+                BOOST_FOREACH(const std::string &xport, tree->list(path / "xports")){
+                    const fs_path xport_path = path / "xports" / xport;
+                    add_stream_stats(metrics, prefix + xport_path, tree->access<stream_stats_t>(xport_path / "stats").get());
+                    if (tree->exists(xport_path / "fc_credit")){
+                        add_metric(metrics, prefix + xport_path / "fc_credit", double(tree->access<size_t>(xport_path / "fc_credit").get()));
+                    }
+                }
+            }
+        }
+
+        //control round-trip times
+        if (tree->exists(mb_path / "radio_ctrl")){
+            BOOST_FOREACH(const std::string &name, tree->list(mb_path / "radio_ctrl")){
+                const fs_path path = mb_path / "radio_ctrl" / name / "rtt";
+                add_histogram(metrics, prefix + path, tree->access<time_histogram_t>(path).get());
+            }
+        }
+
+        //motherboard and frontend sensors
+        add_sensors(metrics, prefix, tree, mb_path / "sensors");
+        if (tree->exists(mb_path / "dboards")){
+            BOOST_FOREACH(const std::string &db, tree->list(mb_path / "dboards")){
+                static const char *fe_dirs[] = {"rx_frontends", "tx_frontends"};
+                for (size_t i = 0; i < 2; i++){
+                    const fs_path fe_root = mb_path / "dboards" / db / fe_dirs[i];
+                    if (not tree->exists(fe_root)) continue;
+                    BOOST_FOREACH(const std::string &fe, tree->list(fe_root)){
+                        add_sensors(metrics, prefix, tree, fe_root / fe / "sensors");
+                    }
+                }
+            }
+        }
+    }
+}
+
+/***********************************************************************
+ * Exporter implementation
+ **********************************************************************/
+stats_exporter::~stats_exporter(void){
+    /* NOP */
+}
+
+std::string stats_exporter::get_segment_name(const boost::uint32_t pid){
+    return str(boost::format("uhd_stats_%u") % pid);
+}
+
+class stats_exporter_impl : public stats_exporter{
+public:
+    stats_exporter_impl(void):
+        _pid(boost::uint32_t(uhd::get_process_id())),
+        _name(get_segment_name(_pid)),
+        _period(1.0),
+        _num_devices(0)
+    {
+        ipc::shared_memory_object::remove(_name.c_str());
+        _shm_obj = ipc::shared_memory_object(ipc::create_only, _name.c_str(), ipc::read_write);
+        _shm_obj.truncate(sizeof(stats_shm_t));
+        _region = ipc::mapped_region(_shm_obj, ipc::read_write);
+        _shm = static_cast<stats_shm_t *>(_region.get_address());
+        std::memset(_shm, 0, sizeof(stats_shm_t));
+        _shm->pid = _pid;
+        _shm->version = STATS_VERSION;
+        _shm->magic = STATS_MAGIC;
+
+        this->start_task(_period);
+    }
+
+    ~stats_exporter_impl(void){
+        UHD_SAFE_CALL(
+            _task.reset();
+            ipc::shared_memory_object::remove(_name.c_str());
+        )
+    }
+
+    std::string add_device(device::sptr dev){
+        boost::mutex::scoped_lock lock(_mutex);
+        const std::string prefix = "dev" + boost::lexical_cast<std::string>(_num_devices++);
+        _devices.push_back(device_entry_t(prefix, dev));
+        return prefix;
+    }
+
+    void set_period(const double period){
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _period = period;
+        }
+        this->start_task(period);
+    }
+
+    void update(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        this->write(this->collect());
+    }
+
+private:
+    typedef std::pair<std::string, boost::weak_ptr<device> > device_entry_t;
+
+    //! (Re)start the periodic update, never with the mutex held (the task takes it)
+    void start_task(const double period){
+        boost::mutex::scoped_lock lock(_task_mutex);
+        _task = task::make_periodic(boost::bind(&stats_exporter_impl::update, this), period, "uhd_stats");
+    }
+
+    //! Read the counters of all live devices (called with the mutex held)
+    metrics_type collect(void){
+        metrics_type metrics;
+        std::vector<device_entry_t> live;
+        BOOST_FOREACH(const device_entry_t &entry, _devices){
+            device::sptr dev = entry.second.lock();
+            if (not dev) continue;
+            live.push_back(entry);
+            try{
+                collect_tree(metrics, entry.first, dev->get_tree());
+            }
+            catch(const std::exception &ex){
+                UHD_MSG(warning) << "Statistics export for " << entry.first << " failed: " << ex.what() << std::endl;
+            }
+        }
+        _devices.swap(live);
+        return metrics;
+    }
+
+    //! Write the metrics under the sequence lock (called with the mutex held)
+    void write(const metrics_type &metrics){
+        const size_t num_metrics = std::min(metrics.size(), STATS_MAX_METRICS);
+
+        BOOST_IPC_DETAIL::atomic_inc32(&_shm->seq); //odd: update in progress
+        for (size_t i = 0; i < num_metrics; i++){
+            stats_shm_metric_t &out = _shm->metrics[i];
+            out.value = metrics[i].value;
+            const size_t len = std::min(metrics[i].name.size(), STATS_NAME_LEN-1);
+            std::memcpy(out.name, metrics[i].name.c_str(), len);
+            out.name[len] = '\0';
+        }
+        _shm->num_metrics = boost::uint32_t(num_metrics);
+        _shm->num_dropped = boost::uint32_t(metrics.size() - num_metrics);
+        _shm->update_count++;
+        _shm->update_time = get_unix_time();
+        BOOST_IPC_DETAIL::atomic_inc32(&_shm->seq); //even: update complete
+    }
+
+    const boost::uint32_t _pid;
+    const std::string _name;
+    ipc::shared_memory_object _shm_obj;
+    ipc::mapped_region _region;
+    stats_shm_t *_shm;
+    boost::mutex _mutex;
+    double _period;
+    size_t _num_devices;
+    std::vector<device_entry_t> _devices;
+    boost::mutex _task_mutex;
+    task::sptr _task;
+};
+
+stats_exporter::sptr stats_exporter::get(void){
+    static boost::mutex mutex;
+    static sptr exporter;
+    boost::mutex::scoped_lock lock(mutex);
+    if (not exporter) exporter.reset(new stats_exporter_impl());
+    return exporter;
+}
+
+/***********************************************************************
+ * Reader implementation
+ **********************************************************************/
+stats_reader::~stats_reader(void){
+    /* NOP */
+}
+
+class stats_reader_impl : public stats_reader{
+public:
+    stats_reader_impl(const std::string &segment_name){
+        try{
+            _shm_obj = ipc::shared_memory_object(ipc::open_only, segment_name.c_str(), ipc::read_only);
+            _region = ipc::mapped_region(_shm_obj, ipc::read_only);
+        }
+        catch(const ipc::interprocess_exception &ex){
+            throw uhd::io_error(str(boost::format("Cannot open statistics segment %s: %s") % segment_name % ex.what()));
+        }
+        if (_region.get_size() < sizeof(stats_shm_t)){
+            throw uhd::io_error(str(boost::format("Statistics segment %s is too small") % segment_name));
+        }
+        _shm = static_cast<const stats_shm_t *>(_region.get_address());
+        if (_shm->magic != STATS_MAGIC or _shm->version != STATS_VERSION){
+            throw uhd::io_error(str(boost::format("Statistics segment %s has an unknown format") % segment_name));
+        }
+    }
+
+    stats_snapshot_t read(void){
+        stats_snapshot_t snapshot;
+        const boost::system_time exit_time = boost::get_system_time() +
+            boost::posix_time::microseconds(long(STATS_READ_TIMEOUT*1e6));
+        while (true){
+            //an exporter that died in an update leaves the sequence odd for good
+            if (boost::get_system_time() > exit_time){
+                throw uhd::io_error("Statistics segment: no consistent snapshot, the exporter may have died during an update");
+            }
+            const boost::uint32_t seq = _shm->seq;
+            uhd::atomic_fence(); //the sequence is read before the metrics
+            if ((seq & 0x1) != 0){
+                boost::this_thread::yield();
+                continue;
+            }
+
+            snapshot.pid = _shm->pid;
+            snapshot.update_count = _shm->update_count;
+            snapshot.update_time = _shm->update_time;
+            snapshot.num_dropped = _shm->num_dropped;
+            const size_t num_metrics = std::min<size_t>(_shm->num_metrics, STATS_MAX_METRICS);
+            snapshot.metrics.resize(num_metrics);
+            for (size_t i = 0; i < num_metrics; i++){
+                const stats_shm_metric_t &in = _shm->metrics[i];
+                snapshot.metrics[i].value = in.value;
+                snapshot.metrics[i].name.assign(in.name, std::find(in.name, in.name + STATS_NAME_LEN, '\0'));
+            }
+
+            uhd::atomic_fence(); //the metrics are read before the sequence is checked
+            if (_shm->seq == seq) return snapshot;
+            boost::this_thread::yield();
+        }
+    }
+
+private:
+    ipc::shared_memory_object _shm_obj;
+    ipc::mapped_region _region;
+    const stats_shm_t *_shm;
+};
+
+stats_reader::sptr stats_reader::make(const std::string &segment_name){
+    return sptr(new stats_reader_impl(segment_name));
+}
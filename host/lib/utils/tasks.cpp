@@ -18,21 +18,31 @@
 #include <uhd/utils/tasks.hpp>
 #include <uhd/utils/msg_task.hpp>
 #include <uhd/utils/msg.hpp>
+#include <uhd/utils/thread_role.hpp>
+#include <uhd/utils/log.hpp>
+#include <uhd/exception.hpp>
+#include "reactor.hpp"
 #include <boost/thread/thread.hpp>
 #include <boost/thread/barrier.hpp>
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <vector>
+#ifdef UHD_PLATFORM_WIN32
+    #include <winsock2.h>
+#else
+    #include <sys/select.h>
+#endif
 
 using namespace uhd;
 
 class task_impl : public task{
 public:
 
-    task_impl(const task_fcn_type &task_fcn):
+    task_impl(const task_fcn_type &task_fcn, const std::string &role):
         _spawn_barrier(2)
     {
-        _thread_group.create_thread(boost::bind(&task_impl::task_loop, this, task_fcn));
+        _thread_group.create_thread(boost::bind(&task_impl::task_loop, this, task_fcn, role));
         _spawn_barrier.wait();
     }
 
@@ -44,9 +54,10 @@ public:
 
 private:
 
-    void task_loop(const task_fcn_type &task_fcn){
+    void task_loop(const task_fcn_type &task_fcn, const std::string &role){
         _running = true;
         _spawn_barrier.wait();
+        if (not role.empty()) apply_thread_role(role);
 
         try{
             while (_running){
@@ -80,7 +91,104 @@ private:
 };
 
 task::sptr task::make(const task_fcn_type &task_fcn){
-    return task::sptr(new task_impl(task_fcn));
+    return task::make(task_fcn, "");
+}
+
+task::sptr task::make(const task_fcn_type &task_fcn, const std::string &role){
+    return task::sptr(new task_impl(task_fcn, role));
+}
+
+/***********************************************************************
+ * Periodic tasks: a thread each, the calls may block
+ **********************************************************************/
+class periodic_task_impl : public task{
+public:
+    periodic_task_impl(const task_fcn_type &task_fcn, const double period, const std::string &role):
+        _thread(boost::bind(&periodic_task_impl::task_loop, task_fcn, period, role))
+    {
+        /* NOP */
+    }
+
+    ~periodic_task_impl(void){
+        _thread.interrupt();
+        //a call that drops its own task cannot wait for itself
+        if (_thread.get_id() == boost::this_thread::get_id()) _thread.detach();
+        else _thread.join();
+    }
+
+private:
+    //static: the loop owns its copy of the callback and outlives a detached task
+    static void task_loop(const task_fcn_type task_fcn, const double period, const std::string role){
+        if (not role.empty()) apply_thread_role(role);
+        const boost::posix_time::time_duration step = boost::posix_time::microseconds(long(period*1e6));
+        boost::system_time deadline = boost::get_system_time() + step;
+        try{
+            while (true){
+                boost::this_thread::sleep(deadline);
+                task_fcn();
+                //keep the period, but skip the deadlines that were missed
+                deadline = std::max(deadline + step, boost::get_system_time());
+            }
+        }
+        catch(const boost::thread_interrupted &){
+            //this is an ok way to exit the task loop
+        }
+        catch(const std::exception &e){
+            UHD_MSG(error)
+                << "An unexpected exception was caught in a task loop." << std::endl
+                << "The task loop will now exit, things may not work." << std::endl
+                << e.what() << std::endl
+            ;
+        }
+    }
+
+    boost::thread _thread;
+};
+
+task::sptr task::make_periodic(const task_fcn_type &task_fcn, const double period, const std::string &role){
+    if (period <= 0) throw uhd::value_error("task period must be positive");
+    return task::sptr(new periodic_task_impl(task_fcn, period, role));
+}
+
+/***********************************************************************
+ * Tasks on the shared event loop
+ **********************************************************************/
+class reactor_task_impl : public task{
+public:
+    reactor_task_impl(reactor::sptr reactor, reactor::registration_type registration):
+        _reactor(reactor), _registration(registration)
+    {
+        /* NOP */
+    }
+
+    ~reactor_task_impl(void){
+        _registration.reset(); //waits for a running call
+    }
+
+private:
+    reactor::sptr _reactor;
+    reactor::registration_type _registration;
+};
+
+//! Call the callback when the descriptor is readable, for the thread fallback
+static void wait_readable_then_call(const int fd, const task::task_fcn_type &task_fcn){
+    timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = 100000; //interruption point every 100 ms
+    fd_set rset;
+    FD_ZERO(&rset);
+    FD_SET(fd, &rset);
+    if (::select(fd+1, &rset, NULL, NULL, &tv) > 0) task_fcn();
+    boost::this_thread::interruption_point();
+}
+
+task::sptr task::make_readable(const int fd, const task_fcn_type &task_fcn, const std::string &role){
+    reactor::sptr reactor = reactor::get_shared();
+    if (not reactor->can_watch_fds()){
+        return task::make(boost::bind(&wait_readable_then_call, fd, task_fcn), role);
+    }
+    UHD_LOG << "task " << role << " on the event loop, fd " << fd << std::endl;
+    return task::sptr(new reactor_task_impl(reactor, reactor->add_readable(fd, task_fcn)));
 }
 
 msg_task::~msg_task(void){
@@ -96,10 +204,10 @@ msg_task::~msg_task(void){
 class msg_task_impl : public msg_task{
 public:
 
-    msg_task_impl(const task_fcn_type &task_fcn):
+    msg_task_impl(const task_fcn_type &task_fcn, const std::string &role):
         _spawn_barrier(2)
     {
-        _thread_group.create_thread(boost::bind(&msg_task_impl::task_loop, this, task_fcn));
+        _thread_group.create_thread(boost::bind(&msg_task_impl::task_loop, this, task_fcn, role));
         _spawn_barrier.wait();
     }
 
@@ -131,9 +239,10 @@ public:
 
 private:
 
-    void task_loop(const task_fcn_type &task_fcn){
+    void task_loop(const task_fcn_type &task_fcn, const std::string &role){
         _running = true;
         _spawn_barrier.wait();
+        if (not role.empty()) apply_thread_role(role);
 
         try{
             while (_running){
@@ -181,5 +290,9 @@ private:
 };
 
 msg_task::sptr msg_task::make(const task_fcn_type &task_fcn){
-    return msg_task::sptr(new msg_task_impl(task_fcn));
+    return msg_task::make(task_fcn, "");
+}
+
+msg_task::sptr msg_task::make(const task_fcn_type &task_fcn, const std::string &role){
+    return msg_task::sptr(new msg_task_impl(task_fcn, role));
 }
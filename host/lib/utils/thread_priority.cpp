@@ -47,10 +47,17 @@ static void check_priority_range(float priority){
     #include <pthread.h>
 
     void uhd::set_thread_priority(float priority, bool realtime){
+        //when realtime is not enabled, use sched other
+        set_thread_policy((realtime)? "rr" : "other", priority);
+    }
+
+    void uhd::set_thread_policy(const std::string &policy_name, float priority){
         check_priority_range(priority);
 
-        //when realtime is not enabled, use sched other
-        int policy = (realtime)? SCHED_RR : SCHED_OTHER;
+        int policy = SCHED_OTHER;
+        if (policy_name == "rr") policy = SCHED_RR;
+        else if (policy_name == "fifo") policy = SCHED_FIFO;
+        else if (policy_name != "other") throw uhd::value_error("unknown scheduling policy " + policy_name);
 
         //we cannot have below normal priority, set to zero
         if (priority < 0) priority = 0;
@@ -68,6 +75,44 @@ static void check_priority_range(float priority){
     }
 #endif /* HAVE_PTHREAD_SETSCHEDPARAM */
 
+/***********************************************************************
+ * Pthread API to set affinity and name
+ **********************************************************************/
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    #include <pthread.h>
+    #include <sched.h>
+
+    void uhd::set_thread_affinity(const std::vector<size_t> &cpus){
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (size_t i = 0; i < cpus.size(); i++){
+            if (cpus[i] >= CPU_SETSIZE) throw uhd::value_error(str(boost::format("CPU %u out of range") % cpus[i]));
+            CPU_SET(cpus[i], &cpu_set);
+        }
+        //an empty set means every CPU
+        if (cpus.empty()) for (size_t i = 0; i < CPU_SETSIZE; i++) CPU_SET(i, &cpu_set);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        if (ret != 0) throw uhd::os_error("error in pthread_setaffinity_np");
+    }
+#elif !defined(HAVE_WIN_SETTHREADPRIORITY)
+    void uhd::set_thread_affinity(const std::vector<size_t> &){
+        throw uhd::not_implemented_error("set thread affinity not implemented");
+    }
+#endif /* HAVE_PTHREAD_SETAFFINITY_NP */
+
+#ifdef HAVE_PTHREAD_SETNAME_NP
+    #include <pthread.h>
+
+    void uhd::set_thread_name(const std::string &name){
+        //the kernel limit is 16 bytes with the terminator
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+    }
+#else
+    void uhd::set_thread_name(const std::string &){
+        /* NOP */
+    }
+#endif /* HAVE_PTHREAD_SETNAME_NP */
+
 /***********************************************************************
  * Windows API to set priority
  **********************************************************************/
@@ -97,6 +142,26 @@ static void check_priority_range(float priority){
         if (SetThreadPriority(GetCurrentThread(), priorities[pri_index]) == 0)
             throw uhd::os_error("error in SetThreadPriority");
     }
+
+    void uhd::set_thread_policy(const std::string &policy_name, float priority){
+        if (policy_name != "other" and policy_name != "rr" and policy_name != "fifo")
+            throw uhd::value_error("unknown scheduling policy " + policy_name);
+        //windows has one realtime class for both policies
+        set_thread_priority(priority, policy_name != "other");
+    }
+
+    void uhd::set_thread_affinity(const std::vector<size_t> &cpus){
+        DWORD_PTR mask = 0;
+        for (size_t i = 0; i < cpus.size(); i++){
+            if (cpus[i] >= sizeof(mask)*8) throw uhd::value_error(str(boost::format("CPU %u out of range") % cpus[i]));
+            mask |= DWORD_PTR(1) << cpus[i];
+        }
+        //an empty set means every CPU the process may use
+        DWORD_PTR system_mask = 0;
+        if (cpus.empty()) GetProcessAffinityMask(GetCurrentProcess(), &mask, &system_mask);
+        if (SetThreadAffinityMask(GetCurrentThread(), mask) == 0)
+            throw uhd::os_error("error in SetThreadAffinityMask");
+    }
 #endif /* HAVE_WIN_SETTHREADPRIORITY */
 
 /***********************************************************************
@@ -107,4 +172,8 @@ static void check_priority_range(float priority){
         throw uhd::not_implemented_error("set thread priority not implemented");
     }
 
+    void uhd::set_thread_policy(const std::string &, float){
+        throw uhd::not_implemented_error("set thread policy not implemented");
+    }
+
 #endif /* HAVE_THREAD_PRIO_DUMMY */
@@ -0,0 +1,202 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/utils/thread_role.hpp>
+#include <uhd/utils/thread_priority.hpp>
+#include <uhd/utils/static.hpp>
+#include <uhd/utils/msg.hpp>
+#include <uhd/utils/log.hpp>
+#include <uhd/types/dict.hpp>
+#include <uhd/exception.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/format.hpp>
+#include <boost/foreach.hpp>
+#include <list>
+#include <utility>
+
+using namespace uhd;
+
+static const std::string KEY_PREFIX = "thread_";
+
+/***********************************************************************
+ * Role configuration
+ **********************************************************************/
+thread_role_config_t::thread_role_config_t(void):
+    priority(default_thread_priority)
+{
+    /* NOP */
+}
+
+bool thread_role_config_t::empty(void) const{
+    return cpus.empty() and policy.empty();
+}
+
+typedef uhd::dict<std::string, thread_role_config_t> role_configs_t;
+
+struct thread_role_registry_t{
+    boost::mutex mutex;
+    //set by the application
+    role_configs_t configs;
+    //set from device arguments while their thread_role_args live, newest last
+    std::list<std::pair<const thread_role_args *, role_configs_t> > layers;
+};
+
+UHD_SINGLETON_FCN(thread_role_registry_t, get_registry);
+
+static void check_config(const thread_role_config_t &config){
+    if (not config.policy.empty() and config.policy != "other" and config.policy != "rr" and config.policy != "fifo"){
+        throw uhd::value_error("unknown scheduling policy " + config.policy);
+    }
+    if (config.priority > +1.0 or config.priority < -1.0){
+        throw uhd::value_error("thread priority out of range [-1.0, +1.0]");
+    }
+}
+
+//! Find the configuration of exactly this role, call with the registry locked
+static bool find_config(const thread_role_registry_t &registry, const std::string &role, thread_role_config_t &config){
+    typedef std::list<std::pair<const thread_role_args *, role_configs_t> >::const_reverse_iterator layer_iter;
+    for (layer_iter it = registry.layers.rbegin(); it != registry.layers.rend(); ++it){
+        if (not it->second.has_key(role)) continue;
+        config = it->second[role];
+        return true;
+    }
+    if (not registry.configs.has_key(role)) return false;
+    config = registry.configs[role];
+    return true;
+}
+
+void uhd::set_thread_role_config(const std::string &role, const thread_role_config_t &config){
+    check_config(config);
+    thread_role_registry_t &registry = get_registry();
+    boost::mutex::scoped_lock lock(registry.mutex);
+    registry.configs[role] = config;
+}
+
+thread_role_config_t uhd::get_thread_role_config(const std::string &role){
+    thread_role_registry_t &registry = get_registry();
+    boost::mutex::scoped_lock lock(registry.mutex);
+    thread_role_config_t config;
+    if (find_config(registry, role, config)) return config;
+    if (find_config(registry, "default", config)) return config;
+    return thread_role_config_t();
+}
+
+/***********************************************************************
+ * Device arguments
+ **********************************************************************/
+//! Parse a CPU list like "1:3:5-7"
+static std::vector<size_t> to_cpu_list(const std::string &list){
+    std::vector<size_t> cpus;
+    std::vector<std::string> items;
+    boost::split(items, list, boost::is_any_of(":"), boost::token_compress_on);
+    BOOST_FOREACH(const std::string &item, items){
+        if (item.empty()) continue;
+        try{
+            const size_t dash = item.find('-');
+            if (dash == std::string::npos){
+                cpus.push_back(boost::lexical_cast<size_t>(item));
+                continue;
+            }
+            const size_t first = boost::lexical_cast<size_t>(item.substr(0, dash));
+            const size_t last = boost::lexical_cast<size_t>(item.substr(dash + 1));
+            if (last < first) throw uhd::value_error("bad CPU range " + item);
+            for (size_t cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        }
+        catch(const boost::bad_lexical_cast &){
+            throw uhd::value_error("bad CPU list " + list);
+        }
+    }
+    return cpus;
+}
+
+thread_role_args::~thread_role_args(void){
+    /* NOP */
+}
+
+class thread_role_args_impl : public thread_role_args{
+public:
+    thread_role_args_impl(const device_addr_t &args){
+        //collect the settings of each role first, so the keys may come in any order
+        role_configs_t configs;
+        BOOST_FOREACH(const std::string &key, args.keys()){
+            if (not boost::starts_with(key, KEY_PREFIX)) continue;
+            const std::string setting = key.substr(KEY_PREFIX.size());
+            const size_t pos = setting.rfind('_');
+            if (pos == std::string::npos or pos == 0) continue;
+            const std::string role = setting.substr(0, pos);
+            const std::string field = setting.substr(pos + 1);
+            if (field != "cpus" and field != "sched" and field != "prio") continue;
+
+            if (not configs.has_key(role)) configs[role] = get_thread_role_config(role);
+            thread_role_config_t &config = configs[role];
+            if (field == "cpus") config.cpus = to_cpu_list(args[key]);
+            if (field == "sched") config.policy = args[key];
+            if (field == "prio") try{
+                config.priority = boost::lexical_cast<float>(args[key]);
+            }
+            catch(const boost::bad_lexical_cast &){
+                throw uhd::value_error("bad thread priority " + args[key]);
+            }
+        }
+        BOOST_FOREACH(const std::string &role, configs.keys()){
+            check_config(configs[role]);
+        }
+
+        thread_role_registry_t &registry = get_registry();
+        boost::mutex::scoped_lock lock(registry.mutex);
+        registry.layers.push_back(std::make_pair(static_cast<const thread_role_args *>(this), configs));
+    }
+
+    ~thread_role_args_impl(void){
+        thread_role_registry_t &registry = get_registry();
+        boost::mutex::scoped_lock lock(registry.mutex);
+        typedef std::list<std::pair<const thread_role_args *, role_configs_t> >::iterator layer_iter;
+        for (layer_iter it = registry.layers.begin(); it != registry.layers.end(); ++it){
+            if (it->first != this) continue;
+            registry.layers.erase(it);
+            break;
+        }
+    }
+};
+
+thread_role_args::sptr thread_role_args::make(const device_addr_t &args){
+    return thread_role_args::sptr(new thread_role_args_impl(args));
+}
+
+/***********************************************************************
+ * Apply to the calling thread
+ **********************************************************************/
+void uhd::apply_thread_role(const std::string &role){
+    set_thread_name(role);
+    const thread_role_config_t config = get_thread_role_config(role);
+    if (config.empty()) return;
+
+    UHD_LOG << boost::format("thread role %s: %u cpus, policy %s, priority %f")
+        % role % config.cpus.size() % config.policy % config.priority << std::endl;
+    try{
+        if (not config.cpus.empty()) set_thread_affinity(config.cpus);
+        if (not config.policy.empty()) set_thread_policy(config.policy, config.priority);
+    }
+    catch(const std::exception &e){
+        UHD_MSG(warning) << boost::format(
+            "Unable to place the %s thread as configured.\n"
+            "%s\n"
+        ) % role % e.what();
+    }
+}
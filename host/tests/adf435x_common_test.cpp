@@ -0,0 +1,159 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "../lib/usrp/common/adf435x_common.hpp"
+#include <uhd/exception.hpp>
+#include <cmath>
+
+using namespace uhd;
+
+static const double REF_FREQ = 25e6;
+
+//the constraints of a WBX
+static adf435x_tuning_constraints make_constraints(const bool int_n){
+    adf435x_tuning_constraints constraints;
+    constraints.force_frac0 = int_n;
+    constraints.feedback_after_divider = false;
+    constraints.ref_doubler_threshold = 12.5e6;
+    constraints.pfd_freq_max = 25e6;
+    constraints.band_sel_freq_max = 100e3;
+    constraints.rf_divider_range = uhd::range_t(1, 16);
+    constraints.int_range = uhd::range_t(23, 4095);
+    return constraints;
+}
+
+static void check_settings_equal(const adf435x_tuning_settings &a, const adf435x_tuning_settings &b){
+    BOOST_CHECK_EQUAL(a.frac_12_bit, b.frac_12_bit);
+    BOOST_CHECK_EQUAL(a.int_16_bit, b.int_16_bit);
+    BOOST_CHECK_EQUAL(a.mod_12_bit, b.mod_12_bit);
+    BOOST_CHECK_EQUAL(a.r_counter_10_bit, b.r_counter_10_bit);
+    BOOST_CHECK_EQUAL(a.r_doubler_en, b.r_doubler_en);
+    BOOST_CHECK_EQUAL(a.r_divide_by_2_en, b.r_divide_by_2_en);
+    BOOST_CHECK_EQUAL(a.clock_divider_12_bit, b.clock_divider_12_bit);
+    BOOST_CHECK_EQUAL(a.band_select_clock_div, b.band_select_clock_div);
+    BOOST_CHECK_EQUAL(a.rf_divider, b.rf_divider);
+}
+
+/***********************************************************************
+ * Tuning plan memo
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_adf435x_plan_memo){
+    const adf435x_tuning_constraints frac_n = make_constraints(false);
+    const adf435x_tuning_constraints int_n = make_constraints(true);
+    const size_t num_plans = adf435x_num_plans();
+
+    double actual0 = 0.0, actual1 = 0.0;
+    const adf435x_tuning_settings settings0 = tune_adf435x_synth(1.2345e9, REF_FREQ, frac_n, actual0);
+    BOOST_CHECK_EQUAL(adf435x_num_plans(), num_plans + 1);
+    BOOST_CHECK(std::abs(actual0 - 1.2345e9) < 10e3);
+
+    //a revisit gets the same settings without a new plan
+    const adf435x_tuning_settings settings1 = tune_adf435x_synth(1.2345e9, REF_FREQ, frac_n, actual1);
+    BOOST_CHECK_EQUAL(adf435x_num_plans(), num_plans + 1);
+    BOOST_CHECK_EQUAL(actual0, actual1);
+    check_settings_equal(settings0, settings1);
+
+    //other constraints are another plan
+    double actual_int_n = 0.0;
+    const adf435x_tuning_settings settings_int_n = tune_adf435x_synth(1.2345e9, REF_FREQ, int_n, actual_int_n);
+    BOOST_CHECK_EQUAL(adf435x_num_plans(), num_plans + 2);
+    BOOST_CHECK_EQUAL(settings_int_n.frac_12_bit, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_adf435x_plan_memo_eviction){
+    const adf435x_tuning_constraints frac_n = make_constraints(false);
+
+    //tune until the memo is full and beyond
+    double actual = 0.0;
+    size_t max_num_plans = 0;
+    for (size_t i = 0; i < 10000; i++){
+        const size_t num_plans = adf435x_num_plans();
+        tune_adf435x_synth(500e6 + i*100e3, REF_FREQ, frac_n, actual);
+        //the memo never drops more than one plan at a time
+        BOOST_REQUIRE(adf435x_num_plans() + 1 >= num_plans);
+        max_num_plans = std::max(max_num_plans, adf435x_num_plans());
+    }
+    BOOST_CHECK(max_num_plans < 10000);
+    BOOST_CHECK_EQUAL(adf435x_num_plans(), max_num_plans);
+
+    //the recent plans are kept: a revisit adds nothing
+    tune_adf435x_synth(500e6 + 9999*100e3, REF_FREQ, frac_n, actual);
+    BOOST_CHECK_EQUAL(adf435x_num_plans(), max_num_plans);
+
+    //the oldest one was evicted, but tunes to the same settings again
+    double actual_again = 0.0;
+    double actual_first = 0.0;
+    tune_adf435x_synth(500e6, REF_FREQ, frac_n, actual_first);
+    tune_adf435x_synth(500e6, REF_FREQ, frac_n, actual_again);
+    BOOST_CHECK_EQUAL(actual_first, actual_again);
+    BOOST_CHECK(std::abs(actual_first - 500e6) < 10e3);
+}
+
+/***********************************************************************
+ * LO grid
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_adf435x_align_to_grid){
+    //no grid: the target is kept
+    BOOST_CHECK_EQUAL(adf435x_align_to_grid(device_addr_t(""), 1.2345678e9), 1.2345678e9);
+    BOOST_CHECK_EQUAL(adf435x_align_to_grid(device_addr_t("lo_grid=0"), 1.2345678e9), 1.2345678e9);
+    BOOST_CHECK_EQUAL(adf435x_align_to_grid(device_addr_t("lo_grid=-1e6"), 1.2345678e9), 1.2345678e9);
+
+    //to the nearest grid point
+    const device_addr_t tune_args("lo_grid=1e6");
+    BOOST_CHECK_CLOSE(adf435x_align_to_grid(tune_args, 1.2345678e9), 1.235e9, 1e-9);
+    BOOST_CHECK_CLOSE(adf435x_align_to_grid(tune_args, 1.2344e9), 1.234e9, 1e-9);
+    BOOST_CHECK_CLOSE(adf435x_align_to_grid(tune_args, 2.4e9), 2.4e9, 1e-9);
+}
+
+/***********************************************************************
+ * Register shadow
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_adf435x_reg_shadow){
+    adf435x_reg_shadow shadow;
+
+    //nothing known yet: everything is written
+    for (size_t addr = 0; addr < adf435x_reg_shadow::NUM_REGS; addr++){
+        BOOST_CHECK(shadow.needs_write(addr, 0));
+    }
+    BOOST_CHECK(shadow.needs_counter_reset(0, 0));
+
+    for (size_t addr = 0; addr < adf435x_reg_shadow::NUM_REGS; addr++){
+        shadow.written(addr, 0x100 + addr);
+    }
+
+    //same values are skipped, except register 0
+    BOOST_CHECK(shadow.needs_write(0, 0x100));
+    for (size_t addr = 1; addr < adf435x_reg_shadow::NUM_REGS; addr++){
+        BOOST_CHECK(not shadow.needs_write(addr, 0x100 + addr));
+        BOOST_CHECK(shadow.needs_write(addr, 0x200 + addr));
+    }
+
+    //the counters are reset when register 1 or 2 changes
+    BOOST_CHECK(not shadow.needs_counter_reset(0x101, 0x102));
+    BOOST_CHECK(shadow.needs_counter_reset(0x201, 0x102));
+    BOOST_CHECK(shadow.needs_counter_reset(0x101, 0x202));
+
+    //after an invalidate everything is written again
+    shadow.invalidate();
+    for (size_t addr = 0; addr < adf435x_reg_shadow::NUM_REGS; addr++){
+        BOOST_CHECK(shadow.needs_write(addr, 0x100 + addr));
+    }
+
+    BOOST_CHECK_THROW(shadow.needs_write(adf435x_reg_shadow::NUM_REGS, 0), uhd::assertion_error);
+    BOOST_CHECK_THROW(shadow.written(adf435x_reg_shadow::NUM_REGS, 0), uhd::assertion_error);
+}
@@ -16,13 +16,21 @@
 //
 
 #include <uhd/convert.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <uhd/utils/paths.hpp>
 #include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <boost/cstdint.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
 #include <complex>
 #include <vector>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 
 using namespace uhd;
@@ -415,3 +423,310 @@ BOOST_AUTO_TEST_CASE(test_convert_types_sc16_and_sc8){
         test_convert_types_sc16(nsamps, id, 256);
     }
 }
+
+/***********************************************************************
+ * Test conversion with IQ correction
+ **********************************************************************/
+static fc32_t apply_iq_corr(const convert::iq_correction_t &corr, const fc32_t &in){
+    return fc32_t(
+        float(corr.matrix[0]*in.real() + corr.matrix[1]*in.imag() + corr.offset.real()),
+        float(corr.matrix[2]*in.real() + corr.matrix[3]*in.imag() + corr.offset.imag())
+    );
+}
+
+static void test_convert_types_iq_corr(
+    size_t nsamps, const std::string &wire, const int prio
+){
+    const std::complex<double> iq_balance(0.05, -0.03), dc_offset(0.01, -0.02);
+
+    //fill the input samples (leave headroom for the correction)
+    std::vector<fc32_t> input(nsamps), output(nsamps);
+    BOOST_FOREACH(fc32_t &in, input) in = fc32_t(
+        ((std::rand()/float(RAND_MAX/2)) - 1)*0.5f,
+        ((std::rand()/float(RAND_MAX/2)) - 1)*0.5f
+    );
+    std::vector<boost::uint64_t> interm(nsamps);
+    std::vector<const void *> input0(1, &input[0]), input1(1, &interm[0]);
+    std::vector<void *> output0(1, &interm[0]), output1(1, &output[0]);
+
+    convert::id_type tx_id;
+    tx_id.input_format = "fc32";
+    tx_id.num_inputs = 1;
+    tx_id.output_format = wire;
+    tx_id.num_outputs = 1;
+    convert::id_type rx_id = tx_id;
+    std::swap(rx_id.input_format, rx_id.output_format);
+    convert::id_type tx_corr_id = tx_id, rx_corr_id = rx_id;
+    tx_corr_id.output_format += "_iqcorr";
+    rx_corr_id.input_format += "_iqcorr";
+
+    //corrected transmit, plain receive
+    const convert::iq_correction_t tx_corr = convert::iq_correction_t::make_tx(iq_balance, dc_offset);
+    convert::converter::sptr c0 = convert::get_converter(tx_corr_id, prio)();
+    c0->set_scalar(32767.);
+    c0->set_iq_correction(tx_corr);
+    c0->conv(input0, output0, nsamps);
+    convert::converter::sptr c1 = convert::get_converter(rx_id)();
+    c1->set_scalar(1/32767.);
+    c1->conv(input1, output1, nsamps);
+    for (size_t i = 0; i < nsamps; i++){
+        const fc32_t expected = apply_iq_corr(tx_corr, input[i]);
+        MY_CHECK_CLOSE(expected.real(), output[i].real(), float(1./(1 << 13)));
+        MY_CHECK_CLOSE(expected.imag(), output[i].imag(), float(1./(1 << 13)));
+    }
+
+    //plain transmit, corrected receive
+    const convert::iq_correction_t rx_corr = convert::iq_correction_t::make_rx(iq_balance, dc_offset);
+    convert::converter::sptr c2 = convert::get_converter(tx_id)();
+    c2->set_scalar(32767.);
+    c2->conv(input0, output0, nsamps);
+    convert::converter::sptr c3 = convert::get_converter(rx_corr_id, prio)();
+    c3->set_scalar(1/32767.);
+    c3->set_iq_correction(rx_corr);
+    c3->conv(input1, output1, nsamps);
+    for (size_t i = 0; i < nsamps; i++){
+        const fc32_t expected = apply_iq_corr(rx_corr, input[i]);
+        MY_CHECK_CLOSE(expected.real(), output[i].real(), float(1./(1 << 13)));
+        MY_CHECK_CLOSE(expected.imag(), output[i].imag(), float(1./(1 << 13)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_types_fc32_iq_corr){
+    //try various lengths to test edge cases, for generic and best prio
+    for (size_t nsamps = 1; nsamps < 16; nsamps++){
+        test_convert_types_iq_corr(nsamps, "sc16_item32_le", 0);
+        test_convert_types_iq_corr(nsamps, "sc16_item32_le", -1);
+        test_convert_types_iq_corr(nsamps, "sc16_item32_be", 0);
+        test_convert_types_iq_corr(nsamps, "sc16_item32_be", -1);
+    }
+
+    //plain converters do not implement the correction
+    convert::id_type id;
+    id.input_format = "fc32";
+    id.num_inputs = 1;
+    id.output_format = "sc16_item32_le";
+    id.num_outputs = 1;
+    BOOST_CHECK_THROW(
+        convert::get_converter(id)()->set_iq_correction(convert::iq_correction_t()),
+        uhd::not_implemented_error
+    );
+}
+
+static float expected_sc16(const float x){
+    return std::max(-32768.f, std::min(32767.f, x*32767.f));
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_types_fc32_iq_corr_full_scale){
+    //the generic and SIMD paths must saturate alike past full scale
+    const convert::iq_correction_t corr = convert::iq_correction_t::make_tx(
+        std::complex<double>(0.1, -0.2), std::complex<double>(0.05, -0.05));
+    const size_t nsamps = 64;
+    std::vector<fc32_t> input(nsamps);
+    for (size_t i = 0; i < nsamps; i++){
+        const float full[] = {1.f, -1.f, 1.5f, -1.5f};
+        input[i] = (i < 16)?
+            fc32_t(full[i%4], full[(i/4)%4]) :
+            fc32_t(((std::rand()/float(RAND_MAX/2)) - 1)*1.5f, ((std::rand()/float(RAND_MAX/2)) - 1)*1.5f);
+    }
+
+    const char *wires[] = {"sc16_item32_le", "sc16_item32_be"};
+    BOOST_FOREACH(const std::string wire, wires){
+        convert::id_type id;
+        id.input_format = "fc32";
+        id.num_inputs = 1;
+        id.output_format = wire + "_iqcorr";
+        id.num_outputs = 1;
+
+        std::vector<boost::uint32_t> generic(nsamps), best(nsamps);
+        std::vector<const void *> in(1, &input[0]);
+        std::vector<void *> out0(1, &generic[0]), out1(1, &best[0]);
+        convert::converter::sptr c0 = convert::get_converter(id, 0)();
+        convert::converter::sptr c1 = convert::get_converter(id, -1)();
+        c0->set_scalar(32767.);
+        c1->set_scalar(32767.);
+        c0->set_iq_correction(corr);
+        c1->set_iq_correction(corr);
+        c0->conv(in, out0, nsamps);
+        c1->conv(in, out1, nsamps);
+
+        //rounding may differ by one step, wrapping would not
+        for (size_t i = 0; i < nsamps*2; i++){
+            const boost::uint32_t g = (wire == "sc16_item32_be")? uhd::ntohx(generic[i/2]) : uhd::wtohx(generic[i/2]);
+            const boost::uint32_t b = (wire == "sc16_item32_be")? uhd::ntohx(best[i/2]) : uhd::wtohx(best[i/2]);
+            const int shift = (i%2 == 0)? 16 : 0;
+            const int gs = boost::int16_t(g >> shift), bs = boost::int16_t(b >> shift);
+            BOOST_CHECK_MESSAGE(std::abs(gs - bs) <= 1,
+                wire << " sample " << i/2 << ": generic " << gs << " best " << bs);
+            MY_CHECK_CLOSE(expected_sc16(i%2 == 0?
+                apply_iq_corr(corr, input[i/2]).real() : apply_iq_corr(corr, input[i/2]).imag()), float(gs), 1.5f);
+        }
+    }
+}
+
+static void toggle_iq_corr(convert::converter::sptr conv, const convert::iq_correction_t *corrs, volatile bool *running){
+    for (size_t i = 0; *running; i++) conv->set_iq_correction(corrs[i%2]);
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_types_fc32_iq_corr_concurrent){
+    //a correction set while converting applies to whole buffers only
+    convert::id_type id;
+    id.input_format = "sc16_item32_le_iqcorr";
+    id.num_inputs = 1;
+    id.output_format = "fc32";
+    id.num_outputs = 1;
+    const convert::iq_correction_t corrs[] = {
+        convert::iq_correction_t(),
+        convert::iq_correction_t::make_rx(std::complex<double>(0.1, -0.2), std::complex<double>(0.05, -0.05))
+    };
+
+    const size_t nsamps = 256;
+    std::vector<boost::uint32_t> input(nsamps, 0x20001000); //I = 0x1000, Q = 0x2000
+    std::vector<fc32_t> output(nsamps);
+    std::vector<const void *> in(1, &input[0]);
+    std::vector<void *> out(1, &output[0]);
+    convert::converter::sptr conv = convert::get_converter(id)();
+    conv->set_scalar(1/32767.);
+
+    //the output of each correction alone
+    fc32_t expected[2];
+    for (size_t i = 0; i < 2; i++){
+        conv->set_iq_correction(corrs[i]);
+        conv->conv(in, out, nsamps);
+        expected[i] = output[0];
+    }
+
+    //a torn copy of the coefficients would give neither
+    volatile bool running = true;
+    boost::thread toggler(boost::bind(&toggle_iq_corr, conv, corrs, &running));
+    for (size_t n = 0; n < 20000; n++){
+        conv->conv(in, out, nsamps);
+        if (output[0] != expected[0] and output[0] != expected[1]) BOOST_FAIL("IQ correction torn by an update");
+        for (size_t i = 1; i < nsamps; i++){
+            if (output[i] != output[0]) BOOST_FAIL("IQ correction changed within a buffer");
+        }
+    }
+    running = false;
+    toggler.join();
+}
+
+static void test_usrp1_iq_corr(const size_t width){
+    const size_t nsamps = 32;
+
+    //a different correction per channel, inputs up to past full scale
+    std::vector<convert::iq_correction_t> tx_corrs, rx_corrs;
+    std::vector<std::vector<fc32_t> > inputs(width, std::vector<fc32_t>(nsamps));
+    std::vector<std::vector<fc32_t> > outputs(width, std::vector<fc32_t>(nsamps));
+    std::vector<const void *> input0;
+    std::vector<void *> output1;
+    for (size_t w = 0; w < width; w++){
+        const std::complex<double> iq_balance(0.02*(w+1), -0.01*(w+1)), dc_offset(0.01*w, -0.01);
+        tx_corrs.push_back(convert::iq_correction_t::make_tx(iq_balance, dc_offset));
+        rx_corrs.push_back(convert::iq_correction_t::make_rx(iq_balance, dc_offset));
+        BOOST_FOREACH(fc32_t &in, inputs[w]) in = fc32_t(
+            ((std::rand()/float(RAND_MAX/2)) - 1)*1.2f,
+            ((std::rand()/float(RAND_MAX/2)) - 1)*1.2f
+        );
+        inputs[w][0] = fc32_t(1.f, -1.f);
+        input0.push_back(&inputs[w][0]);
+        output1.push_back(&outputs[w][0]);
+    }
+    std::vector<boost::int16_t> interm(nsamps*width*2);
+    std::vector<void *> output0(1, &interm[0]);
+    std::vector<const void *> input1(1, &interm[0]);
+
+    //corrected transmit: interleaved I/Q words per channel, saturated
+    convert::id_type tx_id;
+    tx_id.input_format = "fc32";
+    tx_id.num_inputs = width;
+    tx_id.output_format = "sc16_item16_usrp1_iqcorr";
+    tx_id.num_outputs = 1;
+    convert::converter::sptr c0 = convert::get_converter(tx_id)();
+    c0->set_scalar(32767.);
+    for (size_t w = 0; w < width; w++) c0->set_iq_correction(tx_corrs[w], w);
+    c0->conv(input0, output0, nsamps);
+    for (size_t i = 0; i < nsamps; i++){
+        for (size_t w = 0; w < width; w++){
+            const fc32_t expected = apply_iq_corr(tx_corrs[w], inputs[w][i]);
+            const size_t j = (i*width + w)*2;
+            MY_CHECK_CLOSE(expected_sc16(expected.real()), float(interm[j+0]), 1.5f);
+            MY_CHECK_CLOSE(expected_sc16(expected.imag()), float(interm[j+1]), 1.5f);
+        }
+    }
+
+    //corrected receive of the same words
+    convert::id_type rx_id;
+    rx_id.input_format = "sc16_item16_usrp1_iqcorr";
+    rx_id.num_inputs = 1;
+    rx_id.output_format = "fc32";
+    rx_id.num_outputs = width;
+    convert::converter::sptr c1 = convert::get_converter(rx_id)();
+    c1->set_scalar(1/32767.);
+    for (size_t w = 0; w < width; w++) c1->set_iq_correction(rx_corrs[w], w);
+    c1->conv(input1, output1, nsamps);
+    for (size_t i = 0; i < nsamps; i++){
+        for (size_t w = 0; w < width; w++){
+            const size_t j = (i*width + w)*2;
+            const fc32_t expected = apply_iq_corr(rx_corrs[w], fc32_t(interm[j+0]/32767.f, interm[j+1]/32767.f));
+            MY_CHECK_CLOSE(expected.real(), outputs[w][i].real(), float(1./(1 << 13)));
+            MY_CHECK_CLOSE(expected.imag(), outputs[w][i].imag(), float(1./(1 << 13)));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_types_usrp1_iq_corr){
+    test_usrp1_iq_corr(1);
+    test_usrp1_iq_corr(2);
+    test_usrp1_iq_corr(4);
+}
+
+/***********************************************************************
+ * Test converter autotuning
+ **********************************************************************/
+static void set_env(const std::string &name, const std::string &value){
+    #ifdef UHD_PLATFORM_WIN32
+    _putenv_s(name.c_str(), value.c_str());
+    #else
+    setenv(name.c_str(), value.c_str(), 1);
+    #endif
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_autotune){
+    //keep the choices out of the user's cache
+    namespace fs = boost::filesystem;
+    const fs::path cache_dir = fs::path(uhd::get_tmp_path()) / fs::unique_path("uhd_autotune_%%%%%%%%");
+    const fs::path cache_path = cache_dir / "convert_autotune.csv";
+    fs::create_directories(cache_dir);
+    set_env("UHD_CONVERT_AUTOTUNE_CACHE", cache_path.string());
+
+    convert::id_type id;
+    id.input_format = "sc16_item32_le";
+    id.num_inputs = 1;
+    id.output_format = "fc32";
+    id.num_outputs = 1;
+    const std::vector<convert::priority_type> prios = convert::get_converter_prios(id);
+    BOOST_REQUIRE(not prios.empty());
+
+    //the choice is one of the registered converters and it sticks
+    const convert::priority_type prio = convert::autotune_converter(id, 256);
+    BOOST_CHECK(std::count(prios.begin(), prios.end(), prio) == 1);
+    BOOST_CHECK_EQUAL(convert::autotune_converter(id, 256), prio);
+    BOOST_CHECK(convert::get_converter(id, prio));
+
+    //the choice went to the overridden cache file
+    {
+        std::ifstream cache_file(cache_path.string().c_str());
+        std::string row;
+        BOOST_CHECK(std::getline(cache_file, row));
+        BOOST_CHECK(row.find(",sc16_item32_le,1,fc32,1,256,") != std::string::npos);
+    }
+    fs::remove_all(cache_dir);
+
+    //the selected converter is the highest prio unless autotune is enabled
+    if (std::getenv("UHD_CONVERT_AUTOTUNE") == NULL){
+        BOOST_CHECK_EQUAL(convert::get_selected_prio(id), *std::max_element(prios.begin(), prios.end()));
+    }
+
+    id.output_format = "no_such_format";
+    BOOST_CHECK_THROW(convert::autotune_converter(id), uhd::key_error);
+    BOOST_CHECK_THROW(convert::get_selected_prio(id), uhd::key_error);
+}
@@ -0,0 +1,74 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/utils/csv.hpp>
+#include <uhd/exception.hpp>
+#include <sstream>
+
+using namespace uhd;
+
+BOOST_AUTO_TEST_CASE(test_csv_to_rows){
+    std::istringstream input("name, \"a,b\"\n1,2,3\n");
+    const csv::rows_type rows = csv::to_rows(input);
+    BOOST_REQUIRE_EQUAL(rows.size(), size_t(2));
+    BOOST_CHECK_EQUAL(rows[0].size(), size_t(2));
+    BOOST_CHECK_EQUAL(rows[0][1], " a,b");
+    BOOST_CHECK_EQUAL(rows[1].size(), size_t(3));
+}
+
+BOOST_AUTO_TEST_CASE(test_csv_to_columns){
+    std::istringstream input("1e9, 0.5, -0.25, 7\r\n\n 2e9 ,1,2\n3e9,-1,1e-3");
+    const csv::columns_type columns = csv::to_columns(input, 3);
+    BOOST_REQUIRE_EQUAL(columns.size(), size_t(3));
+    BOOST_REQUIRE_EQUAL(columns[0].size(), size_t(3));
+    BOOST_CHECK_EQUAL(columns[0][1], 2e9);
+    BOOST_CHECK_EQUAL(columns[1][0], 0.5);
+    BOOST_CHECK_EQUAL(columns[2][0], -0.25);
+    BOOST_CHECK_EQUAL(columns[2][2], 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(test_csv_to_columns_errors){
+    std::istringstream short_row("1,2\n3\n");
+    BOOST_CHECK_THROW(csv::to_columns(short_row, 2), uhd::value_error);
+    std::istringstream empty_field("1,,2\n");
+    BOOST_CHECK_THROW(csv::to_columns(empty_field, 3), uhd::value_error);
+    std::istringstream not_number("1,foo\n");
+    BOOST_CHECK_THROW(csv::to_columns(not_number, 2), uhd::value_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_csv_columns_loopback){
+    //enough rows to span several read blocks
+    csv::columns_type columns(3);
+    for (size_t i = 0; i < 20000; i++){
+        columns[0].push_back(50e6 + i*1.1e5);
+        columns[1].push_back(1.0/(i+3));
+        columns[2].push_back(-1.0/(i+7));
+    }
+
+    std::stringstream stream;
+    csv::write_columns(stream, columns);
+    const csv::columns_type result = csv::to_columns(stream, 3);
+    BOOST_REQUIRE_EQUAL(result.size(), columns.size());
+    for (size_t col = 0; col < columns.size(); col++){
+        BOOST_CHECK(result[col] == columns[col]);
+    }
+
+    csv::columns_type uneven(2);
+    uneven[0].push_back(1.0);
+    BOOST_CHECK_THROW(csv::write_columns(stream, uneven), uhd::value_error);
+}
@@ -0,0 +1,89 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/usrp/fe_cal_table.hpp>
+#include <uhd/exception.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using namespace uhd::usrp;
+
+static const double tolerance = 0.001;
+
+static std::vector<fe_cal_point_t> make_points(void){
+    std::vector<fe_cal_point_t> points;
+    //insert out of order, the table must sort them
+    const double freqs[] = {2e9, 1e9, 3e9};
+    for (size_t i = 0; i < 3; i++){
+        fe_cal_point_t point;
+        point.lo_freq = freqs[i];
+        point.corr_real = freqs[i]/1e9;
+        point.corr_imag = -freqs[i]/1e9;
+        points.push_back(point);
+    }
+    return points;
+}
+
+static void check_table(const fe_cal_table &table){
+    BOOST_REQUIRE_EQUAL(table.size(), size_t(3));
+    BOOST_CHECK_CLOSE(table[0].lo_freq, 1e9, tolerance);
+    BOOST_CHECK_CLOSE(table[2].lo_freq, 3e9, tolerance);
+
+    //exact points
+    BOOST_CHECK_CLOSE(table.get_correction(1e9).real(), 1.0, tolerance);
+    BOOST_CHECK_CLOSE(table.get_correction(2e9).imag(), -2.0, tolerance);
+
+    //interpolation
+    BOOST_CHECK_CLOSE(table.get_correction(1.5e9).real(), 1.5, tolerance);
+    BOOST_CHECK_CLOSE(table.get_correction(2.25e9).imag(), -2.25, tolerance);
+
+    //clipping
+    BOOST_CHECK_CLOSE(table.get_correction(0.5e9).real(), 1.0, tolerance);
+    BOOST_CHECK_CLOSE(table.get_correction(4e9).real(), 3.0, tolerance);
+}
+
+BOOST_AUTO_TEST_CASE(test_fe_cal_table_memory){
+    check_table(*fe_cal_table::make(make_points()));
+    BOOST_CHECK_THROW(fe_cal_table::make(std::vector<fe_cal_point_t>())->get_correction(1e9), uhd::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_fe_cal_table_file){
+    const boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    fe_cal_table::write(path.string(), make_points());
+    {
+        fe_cal_table::sptr table = fe_cal_table::load(path.string());
+        check_table(*table);
+    }
+
+    //a truncated file must be rejected
+    boost::filesystem::resize_file(path, boost::filesystem::file_size(path) - 1);
+    BOOST_CHECK_THROW(fe_cal_table::load(path.string()), uhd::io_error);
+
+    //a point count whose byte size wraps around must be rejected
+    fe_cal_table::write(path.string(), std::vector<fe_cal_point_t>());
+    {
+        const boost::uint64_t num_points = boost::uint64_t(1) << 61; //24*2^61 wraps to zero
+        std::fstream file(path.string().c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(16); //magic, version, point size
+        file.write(reinterpret_cast<const char *>(&num_points), sizeof(num_points));
+    }
+    BOOST_CHECK_THROW(fe_cal_table::load(path.string()), uhd::io_error);
+
+    boost::filesystem::remove(path);
+    BOOST_CHECK_THROW(fe_cal_table::load(path.string()), uhd::io_error);
+}
@@ -17,7 +17,10 @@
 
 #include <boost/test/unit_test.hpp>
 #include <uhd/utils/msg.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
 #include <iostream>
+#include <string>
 
 BOOST_AUTO_TEST_CASE(test_messages){
     std::cerr << "---begin print test ---" << std::endl;
@@ -38,3 +41,44 @@ BOOST_AUTO_TEST_CASE(test_messages){
     UHD_VAR(x);
     std::cerr << "---end print test ---" << std::endl;
 }
+
+static boost::mutex fastpath_mutex;
+static std::string fastpath_chars;
+
+static void fastpath_handler(uhd::msg::type_t type, const std::string &msg){
+    if (type != uhd::msg::fastpath) return;
+    boost::mutex::scoped_lock lock(fastpath_mutex);
+    fastpath_chars += msg;
+}
+
+static void fastpath_sender(void){
+    for (size_t i = 0; i < 2000; i++) UHD_MSG(fastpath) << "O";
+}
+
+//! Puts the default handler back when the test ends
+struct handler_restorer{
+    ~handler_restorer(void){
+        uhd::msg::register_handler(NULL);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_fastpath_messages){
+    handler_restorer restorer;
+    uhd::msg::register_handler(&fastpath_handler);
+
+    //fastpath messages are delivered in the background, none may be lost
+    boost::thread_group threads;
+    for (size_t i = 0; i < 4; i++) threads.create_thread(&fastpath_sender);
+    threads.join_all();
+
+    for (size_t i = 0; i < 100; i++){
+        {
+            boost::mutex::scoped_lock lock(fastpath_mutex);
+            if (fastpath_chars.size() == 4*2000) break;
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    boost::mutex::scoped_lock lock(fastpath_mutex);
+    BOOST_CHECK_EQUAL(fastpath_chars.size(), size_t(4*2000));
+    BOOST_CHECK_EQUAL(fastpath_chars.find_first_not_of('O'), std::string::npos);
+}
@@ -0,0 +1,158 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/device.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/types/stream_stats.hpp>
+#include <complex>
+#include <vector>
+
+using namespace uhd;
+
+/***********************************************************************
+ * Helpers
+ **********************************************************************/
+static device::sptr make_sim(const std::string &args){
+    //unthrottled so the tests run as fast as the host allows
+    return device::make(device_addr_t("type=sim,sim_throttle=0," + args));
+}
+
+static stream_stats_t get_rx_stats(device::sptr dev){
+    return dev->get_tree()->access<stream_stats_t>("/mboards/0/streamers/rx0/stats").get();
+}
+
+/***********************************************************************
+ * Tests
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_sim_find){
+    BOOST_CHECK_EQUAL(device::find(device_addr_t("type=sim")).size(), size_t(1));
+    //never found without asking for it
+    BOOST_CHECK_EQUAL(device::find(device_addr_t("type=nosuchdevice")).size(), size_t(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_rx_num_samps_and_done){
+    device::sptr dev = make_sim("");
+    rx_streamer::sptr rx_stream = dev->get_rx_stream(stream_args_t("fc32"));
+    const size_t spp = rx_stream->get_max_num_samps();
+    std::vector<std::complex<float> > buff(spp);
+
+    //whole packets and a partial last packet
+    const size_t num_samps[] = {spp*10, spp*10 + spp/2};
+    for (size_t i = 0; i < 2; i++){
+        stream_cmd_t cmd(stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE);
+        cmd.num_samps = num_samps[i];
+        cmd.stream_now = true;
+        rx_stream->issue_stream_cmd(cmd);
+
+        size_t num_recvd = 0;
+        rx_metadata_t md;
+        while (not md.end_of_burst){
+            const size_t n = rx_stream->recv(&buff.front(), buff.size(), md, 1.0);
+            BOOST_REQUIRE_EQUAL(md.error_code, rx_metadata_t::ERROR_CODE_NONE);
+            BOOST_CHECK(md.has_time_spec);
+            num_recvd += n;
+        }
+        BOOST_CHECK_EQUAL(num_recvd, cmd.num_samps);
+
+        //nothing more after the burst
+        rx_stream->recv(&buff.front(), buff.size(), md, 0.1);
+        BOOST_CHECK_EQUAL(md.error_code, rx_metadata_t::ERROR_CODE_TIMEOUT);
+    }
+
+    const stream_stats_t stats = get_rx_stats(dev);
+    BOOST_CHECK_EQUAL(stats.num_sequence_errors, boost::uint64_t(0));
+    BOOST_CHECK_EQUAL(stats.num_overflows, boost::uint64_t(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_rx_injected_errors){
+    device::sptr dev = make_sim("sim_overflow_period=20,sim_seq_error_period=30,sim_format=vrt");
+    rx_streamer::sptr rx_stream = dev->get_rx_stream(stream_args_t("sc16"));
+    std::vector<std::complex<short> > buff(rx_stream->get_max_num_samps());
+
+    stream_cmd_t cmd(stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    cmd.stream_now = true;
+    rx_stream->issue_stream_cmd(cmd);
+
+    size_t num_overflows = 0;
+    rx_metadata_t md;
+    for (size_t i = 0; i < 100; i++){
+        rx_stream->recv(&buff.front(), buff.size(), md, 1.0);
+        if (md.error_code == rx_metadata_t::ERROR_CODE_OVERFLOW) num_overflows++;
+        else BOOST_REQUIRE_EQUAL(md.error_code, rx_metadata_t::ERROR_CODE_NONE);
+    }
+    rx_stream->issue_stream_cmd(stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+    BOOST_CHECK(num_overflows > 0);
+
+    const stream_stats_t stats = get_rx_stats(dev);
+    BOOST_CHECK(stats.num_overflows > 0);
+    BOOST_CHECK(stats.num_sequence_errors > 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_tx_burst_ack){
+    device::sptr dev = make_sim("");
+    tx_streamer::sptr tx_stream = dev->get_tx_stream(stream_args_t("fc32"));
+    std::vector<std::complex<float> > buff(tx_stream->get_max_num_samps()*5);
+
+    tx_metadata_t md;
+    md.start_of_burst = true;
+    md.end_of_burst = true;
+    BOOST_CHECK_EQUAL(tx_stream->send(&buff.front(), buff.size(), md, 1.0), buff.size());
+
+    async_metadata_t async_md;
+    BOOST_REQUIRE(tx_stream->recv_async_msg(async_md, 1.0));
+    BOOST_CHECK_EQUAL(async_md.event_code, async_metadata_t::EVENT_CODE_BURST_ACK);
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_tx_late_packet){
+    device::sptr dev = make_sim("");
+    tx_streamer::sptr tx_stream = dev->get_tx_stream(stream_args_t("fc32"));
+    std::vector<std::complex<float> > buff(tx_stream->get_max_num_samps());
+
+    tx_metadata_t md;
+    md.start_of_burst = true;
+    md.end_of_burst = true;
+    md.has_time_spec = true;
+    md.time_spec = dev->get_tree()->access<time_spec_t>("/mboards/0/time/now").get() - time_spec_t(1.0);
+    tx_stream->send(&buff.front(), buff.size(), md, 1.0);
+
+    async_metadata_t async_md;
+    BOOST_REQUIRE(dev->recv_async_msg(async_md, 1.0));
+    BOOST_CHECK_EQUAL(async_md.event_code, async_metadata_t::EVENT_CODE_TIME_ERROR);
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_rx_throttled){
+    device::sptr dev = device::make(device_addr_t("type=sim"));
+    rx_streamer::sptr rx_stream = dev->get_rx_stream(stream_args_t("sc16"));
+    std::vector<std::complex<short> > buff(rx_stream->get_max_num_samps());
+    const double rate = dev->get_tree()->access<double>("/mboards/0/rx_dsps/0/rate/value").get();
+
+    stream_cmd_t cmd(stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE);
+    cmd.num_samps = size_t(rate/20);
+    cmd.stream_now = true;
+    const time_spec_t start = time_spec_t::get_system_time();
+    rx_stream->issue_stream_cmd(cmd);
+
+    rx_metadata_t md;
+    while (not md.end_of_burst){
+        rx_stream->recv(&buff.front(), buff.size(), md, 1.0);
+        BOOST_REQUIRE_EQUAL(md.error_code, rx_metadata_t::ERROR_CODE_NONE);
+    }
+
+    //the samples arrive no sooner than the device could capture them
+    BOOST_CHECK((time_spec_t::get_system_time() - start).get_real_secs() >= 0.045);
+}
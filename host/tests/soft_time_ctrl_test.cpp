@@ -0,0 +1,234 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "../lib/usrp/usrp1/soft_time_ctrl.hpp"
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <vector>
+#include <cmath>
+
+using namespace uhd;
+using namespace uhd::usrp;
+
+static const double RATE = 1e5;
+
+/***********************************************************************
+ * A mock of the device stream enable: records the calls
+ **********************************************************************/
+struct stream_switch_t{
+    boost::mutex mutex;
+    boost::condition_variable cond;
+    std::vector<bool> calls;
+
+    void stream_on_off(bool enb){
+        boost::mutex::scoped_lock lock(mutex);
+        calls.push_back(enb);
+        cond.notify_all();
+    }
+
+    //! Wait until the number of calls is reached
+    bool wait_for_calls(const size_t num_calls){
+        boost::mutex::scoped_lock lock(mutex);
+        while (calls.size() < num_calls){
+            if (not cond.timed_wait(lock, boost::posix_time::seconds(2))) return false;
+        }
+        return true;
+    }
+
+    size_t num_calls(void){
+        boost::mutex::scoped_lock lock(mutex);
+        return calls.size();
+    }
+};
+
+/***********************************************************************
+ * Receive like the usrp1 streamer, without samples
+ **********************************************************************/
+struct recv_result_t{
+    recv_result_t(void): nsamps(0), nsamps_kept(0), keep(false){}
+    size_t nsamps, nsamps_kept;
+    bool keep;
+    rx_metadata_t md;
+};
+
+static recv_result_t recv(soft_time_ctrl::sptr stc, const size_t nsamps){
+    recv_result_t result;
+    result.nsamps = stc->recv_pre(nsamps, result.keep);
+    result.md.error_code = rx_metadata_t::ERROR_CODE_NONE;
+    result.nsamps_kept = stc->recv_post(result.md, result.nsamps, result.keep);
+    return result;
+}
+
+static stream_cmd_t make_cmd(
+    const stream_cmd_t::stream_mode_t mode, const size_t num_samps = 0
+){
+    stream_cmd_t cmd(mode);
+    cmd.num_samps = num_samps;
+    cmd.stream_now = true;
+    return cmd;
+}
+
+static stream_cmd_t make_timed_cmd(
+    const stream_cmd_t::stream_mode_t mode, const time_spec_t &time_spec, const size_t num_samps = 0
+){
+    stream_cmd_t cmd = make_cmd(mode, num_samps);
+    cmd.stream_now = false;
+    cmd.time_spec = time_spec;
+    return cmd;
+}
+
+/***********************************************************************
+ * Tests
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_soft_time_ctrl_burst_boundaries){
+    stream_switch_t sw;
+    soft_time_ctrl::sptr stc = soft_time_ctrl::make(boost::bind(&stream_switch_t::stream_on_off, &sw, _1));
+    stc->set_rx_rate(RATE);
+
+    //the stream is started shortly before the burst
+    const time_spec_t burst_time = stc->get_time() + time_spec_t(0.1);
+    stc->issue_stream_cmd(make_timed_cmd(stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE, burst_time, 1000));
+    BOOST_REQUIRE(sw.wait_for_calls(1));
+    BOOST_CHECK(sw.calls[0]);
+
+    //the samples before the burst are dropped, the burst is cut out exactly
+    size_t nsamps_dropped = 0, nsamps_kept = 0;
+    time_spec_t first_time;
+    bool end_of_burst = false;
+    for (size_t i = 0; i < 10000 and not end_of_burst; i++){
+        const recv_result_t result = recv(stc, 300);
+        if (not result.keep){
+            BOOST_CHECK_EQUAL(result.nsamps_kept, size_t(0));
+            nsamps_dropped += result.nsamps;
+            continue;
+        }
+        if (nsamps_kept == 0) first_time = result.md.time_spec;
+        nsamps_kept += result.nsamps_kept;
+        end_of_burst = result.md.end_of_burst;
+    }
+    BOOST_CHECK(end_of_burst);
+    BOOST_CHECK_EQUAL(nsamps_kept, size_t(1000));
+    BOOST_CHECK(nsamps_dropped > 0);
+    BOOST_CHECK(std::abs((first_time - burst_time).get_real_secs()) <= 1.0/RATE);
+
+    //the idle stream is stopped after the burst
+    BOOST_REQUIRE(sw.wait_for_calls(2));
+    BOOST_CHECK(not sw.calls[1]);
+    BOOST_CHECK(not recv(stc, 300).keep);
+}
+
+BOOST_AUTO_TEST_CASE(test_soft_time_ctrl_late_commands){
+    stream_switch_t sw;
+    soft_time_ctrl::sptr stc = soft_time_ctrl::make(boost::bind(&stream_switch_t::stream_on_off, &sw, _1));
+    stc->set_rx_rate(RATE);
+    rx_metadata_t md;
+
+    //a command for the past does not start the stream
+    stc->issue_stream_cmd(make_timed_cmd(
+        stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE, stc->get_time() - time_spec_t(0.1), 1000
+    ));
+    BOOST_REQUIRE(stc->get_inline_queue().pop_with_timed_wait(md, 2.0));
+    BOOST_CHECK_EQUAL(md.error_code, rx_metadata_t::ERROR_CODE_LATE_COMMAND);
+    BOOST_CHECK_EQUAL(sw.num_calls(), size_t(0));
+
+    //a burst whose first sample was received already is late too
+    stc->issue_stream_cmd(make_cmd(stream_cmd_t::STREAM_MODE_START_CONTINUOUS));
+    BOOST_REQUIRE(sw.wait_for_calls(1));
+    const recv_result_t first = recv(stc, 10000);
+    BOOST_REQUIRE(first.keep);
+    BOOST_CHECK_EQUAL(first.nsamps_kept, size_t(10000));
+    stc->issue_stream_cmd(make_timed_cmd(
+        stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE,
+        first.md.time_spec + time_spec_t::from_ticks(5000, RATE), 1000
+    ));
+    BOOST_REQUIRE(stc->get_inline_queue().pop_with_timed_wait(md, 2.0));
+    BOOST_CHECK_EQUAL(md.error_code, rx_metadata_t::ERROR_CODE_LATE_COMMAND);
+
+    //the continuous stream goes on
+    BOOST_CHECK(recv(stc, 100).keep);
+    BOOST_CHECK_EQUAL(sw.num_calls(), size_t(1));
+}
+
+BOOST_AUTO_TEST_CASE(test_soft_time_ctrl_timed_stop){
+    stream_switch_t sw;
+    soft_time_ctrl::sptr stc = soft_time_ctrl::make(boost::bind(&stream_switch_t::stream_on_off, &sw, _1));
+    stc->set_rx_rate(RATE);
+
+    stc->issue_stream_cmd(make_cmd(stream_cmd_t::STREAM_MODE_START_CONTINUOUS));
+    BOOST_REQUIRE(sw.wait_for_calls(1));
+    const recv_result_t first = recv(stc, 1000);
+    BOOST_REQUIRE(first.keep);
+
+    //stop at sample 2500
+    stc->issue_stream_cmd(make_timed_cmd(
+        stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS,
+        first.md.time_spec + time_spec_t::from_ticks(2500, RATE)
+    ));
+
+    //wait for the command task to queue the stop: receive is cut at it
+    bool keep = false;
+    for (size_t i = 0; i < 1000 and stc->recv_pre(100000, keep) == 100000; i++){
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    BOOST_REQUIRE_EQUAL(stc->recv_pre(100000, keep), size_t(1500));
+
+    size_t nsamps_kept = first.nsamps_kept;
+    recv_result_t result = recv(stc, 1000);
+    BOOST_CHECK(not result.md.end_of_burst);
+    nsamps_kept += result.nsamps_kept;
+    result = recv(stc, 1000);
+    BOOST_CHECK(result.md.end_of_burst);
+    nsamps_kept += result.nsamps_kept;
+    BOOST_CHECK_EQUAL(nsamps_kept, size_t(2500));
+
+    //the samples after the stop are dropped and the stream is stopped
+    BOOST_CHECK(not recv(stc, 1000).keep);
+    BOOST_REQUIRE(sw.wait_for_calls(2));
+    BOOST_CHECK(not sw.calls[1]);
+}
+
+BOOST_AUTO_TEST_CASE(test_soft_time_ctrl_tx_pad){
+    stream_switch_t sw;
+    soft_time_ctrl::sptr stc = soft_time_ctrl::make(boost::bind(&stream_switch_t::stream_on_off, &sw, _1));
+    stc->set_tx_rate(RATE);
+    const size_t max_lead_pad = size_t(0.021*RATE);
+    double timeout = 1.0;
+
+    //an idle stream starts shortly before the burst
+    tx_metadata_t md;
+    md.has_time_spec = true;
+    md.time_spec = stc->get_time() + time_spec_t(0.05);
+    size_t pad = stc->send_pre(md, timeout);
+    BOOST_CHECK(pad <= max_lead_pad);
+    stc->send_post(pad + 1000, false);
+
+    //a burst soon after the samples sent is padded to its sample
+    md.time_spec += time_spec_t::from_ticks(1500, RATE);
+    pad = stc->send_pre(md, timeout);
+    BOOST_CHECK(pad >= 499 and pad <= 501);
+    stc->send_post(pad + 1000, false);
+
+    //a burst far ahead waits in the host and starts the stream again
+    md.time_spec = stc->get_time() + time_spec_t(0.5);
+    const time_spec_t start = time_spec_t::get_system_time();
+    pad = stc->send_pre(md, timeout);
+    BOOST_CHECK(pad <= max_lead_pad);
+    BOOST_CHECK((time_spec_t::get_system_time() - start).get_real_secs() > 0.4);
+}
@@ -249,6 +249,12 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_sequence_error){
         );
         BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
     }
+
+    //check the streamer counters
+    const uhd::stream_stats_t stats = handler.get_stats();
+    BOOST_CHECK_EQUAL(stats.num_packets, NUM_PKTS_TO_TEST - 1);
+    BOOST_CHECK_EQUAL(stats.num_sequence_errors, 1);
+    BOOST_CHECK_EQUAL(stats.num_timeouts, 3);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -341,6 +347,19 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_inline_message){
         );
         BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
     }
+
+    //check the streamer counters
+    const uhd::stream_stats_t stats = handler.get_stats();
+    BOOST_CHECK_EQUAL(stats.num_packets, NUM_PKTS_TO_TEST + 1);
+    BOOST_CHECK_EQUAL(stats.num_overflows, 1);
+    BOOST_CHECK_EQUAL(stats.num_sequence_errors, 0);
+    BOOST_CHECK_EQUAL(stats.num_timeouts, 3);
+    BOOST_CHECK_EQUAL(stats.num_buff_stalls, 3);
+    BOOST_CHECK_EQUAL(stats.buff_wait_time.count, 3);
+    BOOST_CHECK(stats.convert_time.count > 0);
+    //the header time is sampled: on some packets, not on each one
+    BOOST_CHECK(stats.header_time.count > 0);
+    BOOST_CHECK(stats.header_time.count < stats.num_packets);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -189,4 +189,11 @@ BOOST_AUTO_TEST_CASE(test_sph_send_one_channel_full_buffer_mode){
         BOOST_CHECK_EQUAL(ifpi.eob, i == NUM_PKTS_TO_TEST-1);
         num_accum_samps += ifpi.num_payload_words32;
     }
+
+    //check the streamer counters
+    const uhd::stream_stats_t stats = handler.get_stats();
+    BOOST_CHECK_EQUAL(stats.num_packets, NUM_PKTS_TO_TEST);
+    BOOST_CHECK_EQUAL(stats.num_timeouts, 0);
+    BOOST_CHECK(stats.num_bytes > NUM_PKTS_TO_TEST*20*sizeof(boost::uint32_t));
+    BOOST_CHECK(stats.header_time.count > 0);
 }
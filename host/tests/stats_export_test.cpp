@@ -0,0 +1,125 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/utils/stats_export.hpp>
+#include <uhd/utils/platform.hpp>
+#include <uhd/types/stream_stats.hpp>
+#include <uhd/types/sensors.hpp>
+#include <uhd/exception.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/foreach.hpp>
+#include <cstring>
+#include <map>
+
+using namespace uhd;
+
+/***********************************************************************
+ * A device that only has a property tree
+ **********************************************************************/
+class dummy_stats_device : public device{
+public:
+    dummy_stats_device(void){
+        _tree = property_tree::make();
+        stream_stats_t stats;
+        stats.num_packets = 100;
+        stats.num_overflows = 3;
+        stats.buff_wait_time.add(5e-6);
+        _tree->create<stream_stats_t>("/mboards/0/streamers/rx0/stats").set(stats);
+        _tree->create<stream_stats_t>("/mboards/0/streamers/rx0/xports/0/stats").set(stats);
+        _tree->create<size_t>("/mboards/0/streamers/rx0/xports/0/fc_credit").set(7);
+        time_histogram_t rtt;
+        rtt.add(50e-6);
+        _tree->create<time_histogram_t>("/mboards/0/radio_ctrl/0/rtt").set(rtt);
+        _tree->create<sensor_value_t>("/mboards/0/sensors/temp").set(sensor_value_t("temp", 42.5, "C"));
+        _tree->create<sensor_value_t>("/mboards/0/sensors/ref_locked").set(sensor_value_t("Ref", true, "locked", "unlocked"));
+        _tree->create<sensor_value_t>("/mboards/0/sensors/gps_time").set(sensor_value_t("GPS", 1, "s"));
+    }
+
+    rx_streamer::sptr get_rx_stream(const stream_args_t &){
+        throw uhd::not_implemented_error("get_rx_stream");
+    }
+
+    tx_streamer::sptr get_tx_stream(const stream_args_t &){
+        throw uhd::not_implemented_error("get_tx_stream");
+    }
+
+    bool recv_async_msg(async_metadata_t &, double){
+        return false;
+    }
+};
+
+static std::map<std::string, double> read_metrics(void){
+    stats_reader::sptr reader = stats_reader::make(
+        stats_exporter::get_segment_name(boost::uint32_t(uhd::get_process_id()))
+    );
+    std::map<std::string, double> metrics;
+    BOOST_FOREACH(const stats_metric_t &metric, reader->read().metrics){
+        metrics[metric.name] = metric.value;
+    }
+    return metrics;
+}
+
+/***********************************************************************
+ * Tests
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_stats_export_device){
+    stats_exporter::sptr exporter = stats_exporter::get();
+    device::sptr dev(new dummy_stats_device());
+    const std::string prefix = exporter->add_device(dev);
+    exporter->update();
+
+    std::map<std::string, double> metrics = read_metrics();
+    BOOST_CHECK_EQUAL(metrics[prefix + "/mboards/0/streamers/rx0/num_packets"], 100);
+    BOOST_CHECK_EQUAL(metrics[prefix + "/mboards/0/streamers/rx0/num_overflows"], 3);
+    BOOST_CHECK_EQUAL(metrics[prefix + "/mboards/0/streamers/rx0/buff_wait_time/count"], 1);
+    BOOST_CHECK_EQUAL(metrics[prefix + "/mboards/0/streamers/rx0/buff_wait_time/le_4us"], 0);
+    BOOST_CHECK_EQUAL(metrics[prefix + "/mboards/0/streamers/rx0/buff_wait_time/le_8us"], 1);
+    BOOST_CHECK_EQUAL(metrics[prefix + "/mboards/0/streamers/rx0/xports/0/num_packets"], 100);
+    BOOST_CHECK_EQUAL(metrics[prefix + "/mboards/0/streamers/rx0/xports/0/fc_credit"], 7);
+    BOOST_CHECK_EQUAL(metrics[prefix + "/mboards/0/radio_ctrl/0/rtt/count"], 1);
+    BOOST_CHECK_EQUAL(metrics[prefix + "/mboards/0/sensors/temp"], 42.5);
+    BOOST_CHECK_EQUAL(metrics[prefix + "/mboards/0/sensors/ref_locked"], 1);
+    BOOST_CHECK_EQUAL(metrics.count(prefix + "/mboards/0/sensors/gps_time"), 0);
+
+    //a destroyed device is dropped on the next update
+    dev.reset();
+    exporter->update();
+    metrics = read_metrics();
+    BOOST_CHECK_EQUAL(metrics.count(prefix + "/mboards/0/streamers/rx0/num_packets"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_stats_reader_missing_segment){
+    BOOST_CHECK_THROW(stats_reader::make("uhd_stats_does_not_exist"), uhd::io_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_stats_reader_stuck_update){
+    //a segment left in the middle of an update: magic, version 1, odd sequence
+    namespace ipc = boost::interprocess;
+    const char *name = "uhd_stats_test_stuck";
+    ipc::shared_memory_object::remove(name);
+    ipc::shared_memory_object shm_obj(ipc::create_only, name, ipc::read_write);
+    shm_obj.truncate(1 << 20);
+    ipc::mapped_region region(shm_obj, ipc::read_write);
+    const boost::uint32_t header[] = {0x55484453, 1, 1};
+    std::memcpy(region.get_address(), header, sizeof(header));
+
+    stats_reader::sptr reader = stats_reader::make(name);
+    BOOST_CHECK_THROW(reader->read(), uhd::io_error);
+    ipc::shared_memory_object::remove(name);
+}
@@ -0,0 +1,103 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#include <iostream>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+struct counter_t{
+    counter_t(void): count(0){}
+    void incr(void){
+        boost::mutex::scoped_lock lock(mutex);
+        count++;
+    }
+    size_t get(void){
+        boost::mutex::scoped_lock lock(mutex);
+        return count;
+    }
+    boost::mutex mutex;
+    size_t count;
+};
+
+static void sleep_ms(const long ms){
+    boost::this_thread::sleep(boost::posix_time::milliseconds(ms));
+}
+
+BOOST_AUTO_TEST_CASE(test_task_periodic){
+    counter_t counter;
+    uhd::task::sptr task = uhd::task::make_periodic(boost::bind(&counter_t::incr, &counter), 0.01, "test_periodic");
+    sleep_ms(200);
+    task.reset();
+    const size_t count = counter.get();
+    std::cout << "periodic calls in 200 ms: " << count << std::endl;
+    BOOST_CHECK(count >= 5);
+    BOOST_CHECK(count <= 25);
+
+    //no calls after the task is gone
+    sleep_ms(50);
+    BOOST_CHECK_EQUAL(counter.get(), count);
+}
+
+static uhd::task::sptr self_removing_task;
+
+static void remove_self(counter_t *counter){
+    counter->incr();
+    self_removing_task.reset();
+}
+
+BOOST_AUTO_TEST_CASE(test_task_periodic_remove_self){
+    counter_t counter;
+    self_removing_task = uhd::task::make_periodic(boost::bind(&remove_self, &counter), 0.01, "test_remove");
+    sleep_ms(100);
+    BOOST_CHECK_EQUAL(counter.get(), size_t(1));
+    BOOST_CHECK(not self_removing_task);
+}
+
+#ifndef _WIN32
+static void drain_pipe(int fd, counter_t *counter){
+    char buff[16];
+    if (::read(fd, buff, sizeof(buff)) > 0) counter->incr();
+}
+
+BOOST_AUTO_TEST_CASE(test_task_readable){
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(::pipe(fds), 0);
+    counter_t counter;
+    uhd::task::sptr task = uhd::task::make_readable(fds[0], boost::bind(&drain_pipe, fds[0], &counter), "test_readable");
+
+    sleep_ms(50);
+    BOOST_CHECK_EQUAL(counter.get(), size_t(0));
+    for (size_t i = 0; i < 3; i++){
+        BOOST_REQUIRE_EQUAL(::write(fds[1], "x", 1), 1);
+        sleep_ms(50);
+        BOOST_CHECK_EQUAL(counter.get(), i+1);
+    }
+
+    task.reset();
+    BOOST_REQUIRE_EQUAL(::write(fds[1], "x", 1), 1);
+    sleep_ms(50);
+    BOOST_CHECK_EQUAL(counter.get(), size_t(3));
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+#endif
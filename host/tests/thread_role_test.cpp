@@ -0,0 +1,113 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/utils/thread_role.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <uhd/exception.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+BOOST_AUTO_TEST_CASE(test_thread_role_args){
+    uhd::thread_role_args::sptr roles = uhd::thread_role_args::make(uhd::device_addr_t(
+        "type=x300,thread_test_async_cpus=0:2-4,thread_test_async_sched=fifo,thread_test_async_prio=0.75"
+    ));
+    const uhd::thread_role_config_t config = uhd::get_thread_role_config("test_async");
+    BOOST_REQUIRE_EQUAL(config.cpus.size(), size_t(4));
+    BOOST_CHECK_EQUAL(config.cpus[0], size_t(0));
+    BOOST_CHECK_EQUAL(config.cpus[3], size_t(4));
+    BOOST_CHECK_EQUAL(config.policy, "fifo");
+    BOOST_CHECK_CLOSE(config.priority, 0.75, 1e-3);
+
+    //other roles are untouched until a default is set
+    BOOST_CHECK(uhd::get_thread_role_config("test_other").empty());
+    uhd::thread_role_args::sptr defaults = uhd::thread_role_args::make(uhd::device_addr_t("thread_default_sched=other"));
+    BOOST_CHECK_EQUAL(uhd::get_thread_role_config("test_other").policy, "other");
+    BOOST_CHECK_EQUAL(uhd::get_thread_role_config("test_async").policy, "fifo");
+
+    //the arguments override the application until they are destroyed
+    uhd::thread_role_config_t app_config;
+    app_config.policy = "rr";
+    uhd::set_thread_role_config("test_async", app_config);
+    BOOST_CHECK_EQUAL(uhd::get_thread_role_config("test_async").policy, "fifo");
+    roles.reset();
+    BOOST_CHECK_EQUAL(uhd::get_thread_role_config("test_async").policy, "rr");
+    defaults.reset();
+    BOOST_CHECK(uhd::get_thread_role_config("test_other").empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_thread_role_bad_args){
+    BOOST_CHECK_THROW(uhd::thread_role_args::make(uhd::device_addr_t("thread_test_bad_cpus=1-x")), uhd::value_error);
+    BOOST_CHECK_THROW(uhd::thread_role_args::make(uhd::device_addr_t("thread_test_bad_sched=idle")), uhd::value_error);
+    BOOST_CHECK_THROW(uhd::thread_role_args::make(uhd::device_addr_t("thread_test_bad_prio=2")), uhd::value_error);
+    BOOST_CHECK(uhd::get_thread_role_config("test_bad").empty());
+}
+
+struct task_record_t{
+    task_record_t(void): num_calls(0), on_cpu0_only(false){}
+    boost::mutex mutex;
+    size_t num_calls;
+    std::string name;
+    bool on_cpu0_only;
+};
+
+static void task_body(task_record_t *record){
+    boost::mutex::scoped_lock lock(record->mutex);
+    if (record->num_calls++ == 0){
+        #ifdef __linux__
+        char name[16] = {};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        record->name = name;
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0){
+            record->on_cpu0_only = CPU_ISSET(0, &cpu_set) and CPU_COUNT(&cpu_set) == 1;
+        }
+        #endif
+    }
+    lock.unlock();
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+}
+
+BOOST_AUTO_TEST_CASE(test_thread_role_task){
+    //placement failures (no realtime privileges) only warn
+    uhd::thread_role_config_t config;
+    config.cpus.push_back(0);
+    config.policy = "other";
+    uhd::set_thread_role_config("test_task", config);
+    task_record_t record;
+    uhd::task::sptr task = uhd::task::make(boost::bind(&task_body, &record), "test_task");
+    boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    task.reset();
+
+    boost::mutex::scoped_lock lock(record.mutex);
+    BOOST_CHECK(record.num_calls > 0);
+    #ifdef __linux__
+    BOOST_CHECK_EQUAL(record.name, "test_task");
+    //the placement can only succeed when CPU 0 is available to the process
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0 and CPU_ISSET(0, &cpu_set)){
+        BOOST_CHECK(record.on_cpu0_only);
+    }
+    #endif
+}
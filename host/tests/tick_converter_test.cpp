@@ -0,0 +1,106 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "../lib/transport/tick_converter.hpp"
+#include <iostream>
+
+using uhd::time_spec_t;
+using uhd::transport::tick_converter;
+
+//device tick rates (master clock rates) seen in practice
+static const double tick_rates[] = {
+    64e6, 100e6, 200e6, 184.32e6, 61.44e6, 56e6, 52e6, 30.72e6
+};
+static const size_t num_tick_rates = sizeof(tick_rates)/sizeof(tick_rates[0]);
+
+//uptimes in seconds: zero, a day, a month, a year, a decade
+static const double uptimes[] = {0.0, 86400.0, 2.592e6, 3.1536e7, 3.1536e8};
+static const size_t num_uptimes = sizeof(uptimes)/sizeof(uptimes[0]);
+
+BOOST_AUTO_TEST_CASE(test_tick_converter_integer_ratio){
+    std::cout << "Testing tick converter integer decimation..." << std::endl;
+    tick_converter ticks;
+    ticks.set_tick_rate(200e6);
+
+    static const size_t decims[] = {1, 2, 3, 4, 5, 8, 10, 100, 256, 512};
+    for (size_t i = 0; i < sizeof(decims)/sizeof(decims[0]); i++){
+        ticks.set_samp_rate(200e6/decims[i]);
+        for (size_t n = 0; n < 100000; n += 997){
+            BOOST_CHECK_EQUAL(ticks.samps_to_ticks(n), (long long)(n*decims[i]));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_tick_converter_fractional_ratio){
+    std::cout << "Testing tick converter fractional ratio..." << std::endl;
+    tick_converter ticks;
+    ticks.set_tick_rate(30.72e6);
+    ticks.set_samp_rate(1e6); //30.72 ticks per sample
+
+    for (size_t n = 0; n < 100000; n += 17){
+        //round to the nearest tick, computed with integers
+        BOOST_CHECK_EQUAL(ticks.samps_to_ticks(n), (long long)((n*3072 + 50)/100));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_tick_converter_round_trip_long_uptime){
+    std::cout << "Testing tick converter round trip over long uptimes..." << std::endl;
+    tick_converter ticks;
+    for (size_t r = 0; r < num_tick_rates; r++){
+        ticks.set_tick_rate(tick_rates[r]);
+        for (size_t u = 0; u < num_uptimes; u++){
+            const long long base = (long long)(uptimes[u]*tick_rates[r]);
+            for (long long k = 0; k < 1000; k++){
+                const long long t = base + k;
+                BOOST_CHECK_EQUAL(ticks.to_ticks(ticks.to_time_spec(t)), t);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_tick_converter_ordering_long_uptime){
+    std::cout << "Testing tick converter ordering over long uptimes..." << std::endl;
+    tick_converter ticks;
+    for (size_t r = 0; r < num_tick_rates; r++){
+        ticks.set_tick_rate(tick_rates[r]);
+        for (size_t u = 0; u < num_uptimes; u++){
+            //adjacent ticks stay distinct and ordered once converted
+            const long long t = (long long)(uptimes[u]*tick_rates[r]);
+            BOOST_CHECK(ticks.to_time_spec(t) < ticks.to_time_spec(t + 1));
+            BOOST_CHECK(ticks.to_time_spec(t + 1) == ticks.to_time_spec(t + 1));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_tick_converter_fragments_long_uptime){
+    std::cout << "Testing tick converter fragment offsets over long uptimes..." << std::endl;
+    tick_converter ticks;
+    ticks.set_tick_rate(100e6);
+    ticks.set_samp_rate(100e6/4);
+
+    //a decade of uptime, then a long run of 363 sample fragments:
+    //each fragment time is exact, the offsets never accumulate error
+    const long long base = (long long)(uptimes[num_uptimes-1]*100e6);
+    long long offset = 0;
+    for (size_t i = 0; i < 100000; i++){
+        const size_t nsamps = i*363;
+        BOOST_CHECK_EQUAL(base + ticks.samps_to_ticks(nsamps), base + offset);
+        BOOST_CHECK_EQUAL(ticks.to_ticks(ticks.to_time_spec(base + ticks.samps_to_ticks(nsamps))), base + offset);
+        offset += 363*4;
+    }
+}
@@ -0,0 +1,246 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <boost/test/unit_test.hpp>
+#include <uhd/usrp/timed_command_queue.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/exception.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/bind.hpp>
+#include <vector>
+
+using namespace uhd;
+using namespace uhd::usrp;
+
+/***********************************************************************
+ * Helpers: the simulated device is the time source, its time is set
+ * by the tests; operations record their batch or wait on a gate.
+ **********************************************************************/
+static multi_usrp::sptr make_usrp(const double time_now){
+    multi_usrp::sptr usrp = multi_usrp::make(device_addr_t("type=sim,sim_throttle=0"));
+    usrp->set_time_now(time_spec_t(time_now));
+    return usrp;
+}
+
+static time_spec_t get_command_time(multi_usrp::sptr usrp){
+    return usrp->get_device()->get_tree()->access<time_spec_t>("/mboards/0/time/cmd").get();
+}
+
+struct recorder_t{
+    boost::mutex mutex;
+    std::vector<size_t> ids;
+    std::vector<time_spec_t> cmd_times;
+    void record(multi_usrp::sptr usrp, const size_t id){
+        boost::mutex::scoped_lock lock(mutex);
+        ids.push_back(id);
+        cmd_times.push_back(get_command_time(usrp));
+    }
+};
+
+struct gate_t{
+    gate_t(void): entered(false), opened(false){}
+    boost::mutex mutex;
+    boost::condition_variable cond;
+    bool entered, opened;
+    void wait(multi_usrp::sptr){
+        boost::mutex::scoped_lock lock(mutex);
+        entered = true;
+        cond.notify_all();
+        while (not opened) cond.wait(lock);
+    }
+    void wait_entered(void){
+        boost::mutex::scoped_lock lock(mutex);
+        while (not entered) cond.wait(lock);
+    }
+    void open(void){
+        boost::mutex::scoped_lock lock(mutex);
+        opened = true;
+        cond.notify_all();
+    }
+};
+
+//the events arrive with the other async messages of the device
+static bool recv_event(multi_usrp::sptr usrp, timed_command_event_t &event, const double timeout){
+    async_metadata_t async_metadata;
+    while (usrp->get_device()->recv_async_msg(async_metadata, timeout)){
+        if (event.from_async_metadata(async_metadata)) return true;
+    }
+    return false;
+}
+
+static void throw_op(multi_usrp::sptr){
+    throw uhd::runtime_error("operation failed");
+}
+
+static timed_command_batch_t make_batch(recorder_t &recorder, const double time, const size_t id){
+    timed_command_batch_t batch(time_spec_t(time), id);
+    batch.add_operation(boost::bind(&recorder_t::record, &recorder, _1, id));
+    return batch;
+}
+
+/***********************************************************************
+ * Tests
+ **********************************************************************/
+BOOST_AUTO_TEST_CASE(test_timed_command_queue_order){
+    multi_usrp::sptr usrp = make_usrp(1.0);
+    timed_command_queue::sptr queue = timed_command_queue::make(usrp, 16);
+    recorder_t recorder;
+    for (size_t i = 0; i < 10; i++){
+        BOOST_REQUIRE(queue->push(make_batch(recorder, 10.0 + i, i)));
+    }
+    BOOST_REQUIRE(queue->wait_for_empty(5.0));
+    BOOST_CHECK_EQUAL(queue->get_num_pending(), size_t(0));
+
+    //operations ran with their batch time and events came in push order
+    BOOST_REQUIRE_EQUAL(recorder.ids.size(), size_t(10));
+    for (size_t i = 0; i < 10; i++){
+        BOOST_CHECK_EQUAL(recorder.ids[i], i);
+        BOOST_CHECK_CLOSE(recorder.cmd_times[i].get_real_secs(), 10.0 + i, 1e-6);
+        timed_command_event_t event;
+        BOOST_REQUIRE(recv_event(usrp, event, 1.0));
+        BOOST_CHECK_EQUAL(event.id, i);
+        BOOST_CHECK_EQUAL(event.event_code, timed_command_event_t::EVENT_CODE_ISSUED);
+        BOOST_CHECK_CLOSE(event.time_spec.get_real_secs(), 10.0 + i, 1e-6);
+    }
+    timed_command_event_t event;
+    BOOST_CHECK(not recv_event(usrp, event, 0.0));
+
+    //the command time does not outlive the operations
+    BOOST_CHECK_EQUAL(get_command_time(usrp).get_real_secs(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_timed_command_event_async_metadata){
+    timed_command_event_t event;
+    event.id = 42;
+    event.time_spec = time_spec_t(3.5);
+    event.event_code = timed_command_event_t::EVENT_CODE_LATE;
+    const async_metadata_t async_metadata = event.to_async_metadata();
+    BOOST_CHECK_EQUAL(async_metadata.event_code, async_metadata_t::EVENT_CODE_USER_PAYLOAD);
+
+    timed_command_event_t decoded;
+    BOOST_REQUIRE(decoded.from_async_metadata(async_metadata));
+    BOOST_CHECK_EQUAL(decoded.id, size_t(42));
+    BOOST_CHECK_EQUAL(decoded.time_spec.get_real_secs(), 3.5);
+    BOOST_CHECK_EQUAL(decoded.event_code, timed_command_event_t::EVENT_CODE_LATE);
+
+    //other messages are not taken for events
+    async_metadata_t other = async_metadata;
+    other.event_code = async_metadata_t::EVENT_CODE_UNDERFLOW;
+    BOOST_CHECK(not decoded.from_async_metadata(other));
+    other = async_metadata;
+    other.user_payload[0] = 0;
+    BOOST_CHECK(not decoded.from_async_metadata(other));
+}
+
+BOOST_AUTO_TEST_CASE(test_timed_command_queue_late_and_error){
+    multi_usrp::sptr usrp = make_usrp(100.0);
+    timed_command_queue::sptr queue = timed_command_queue::make(usrp);
+    recorder_t recorder;
+
+    //the time source is already past this batch: dropped, not run
+    BOOST_REQUIRE(queue->push(make_batch(recorder, 50.0, 1)));
+    timed_command_batch_t failing(time_spec_t(200.0), 2);
+    failing.add_operation(&throw_op);
+    failing.add_operation(boost::bind(&recorder_t::record, &recorder, _1, 2));
+    BOOST_REQUIRE(queue->push(failing));
+    BOOST_REQUIRE(queue->wait_for_empty(5.0));
+
+    timed_command_event_t event;
+    BOOST_REQUIRE(recv_event(usrp, event, 1.0));
+    BOOST_CHECK_EQUAL(event.id, size_t(1));
+    BOOST_CHECK_EQUAL(event.event_code, timed_command_event_t::EVENT_CODE_LATE);
+    BOOST_REQUIRE(recv_event(usrp, event, 1.0));
+    BOOST_CHECK_EQUAL(event.id, size_t(2));
+    BOOST_CHECK_EQUAL(event.event_code, timed_command_event_t::EVENT_CODE_ERROR);
+
+    //neither ran its recorded operation, the failed one cleared its time
+    BOOST_CHECK(recorder.ids.empty());
+    BOOST_CHECK_EQUAL(get_command_time(usrp).get_real_secs(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_timed_command_queue_capacity_and_clear){
+    multi_usrp::sptr usrp = make_usrp(1.0);
+    timed_command_queue::sptr queue = timed_command_queue::make(usrp, 2);
+    BOOST_CHECK_EQUAL(queue->get_capacity(), size_t(2));
+    BOOST_CHECK_THROW(timed_command_queue::make(usrp, 0), uhd::value_error);
+    recorder_t recorder;
+
+    //hold the worker in the first batch
+    gate_t gate;
+    timed_command_batch_t blocking(time_spec_t(10.0), 0);
+    blocking.add_operation(boost::bind(&gate_t::wait, &gate, _1));
+    BOOST_REQUIRE(queue->push(blocking));
+    gate.wait_entered();
+
+    //two more fill the queue, the next one times out
+    BOOST_CHECK(queue->push(make_batch(recorder, 11.0, 1)));
+    BOOST_CHECK(queue->push(make_batch(recorder, 12.0, 2)));
+    BOOST_CHECK_EQUAL(queue->get_num_pending(), size_t(3));
+    BOOST_CHECK(not queue->push(make_batch(recorder, 13.0, 3), 0.05));
+    BOOST_CHECK(not queue->wait_for_empty(0.05));
+
+    //clear drops the queued batches, not the one being issued
+    queue->clear();
+    BOOST_CHECK_EQUAL(queue->get_num_pending(), size_t(1));
+    BOOST_CHECK(queue->push(make_batch(recorder, 14.0, 4), 0.0));
+    queue->clear();
+
+    gate.open();
+    BOOST_REQUIRE(queue->wait_for_empty(5.0));
+    BOOST_CHECK(recorder.ids.empty());
+
+    timed_command_event_t event;
+    BOOST_REQUIRE(recv_event(usrp, event, 1.0));
+    BOOST_CHECK_EQUAL(event.id, size_t(0));
+    BOOST_CHECK(not recv_event(usrp, event, 0.0));
+}
+
+static void run_exclusive_thread(timed_command_queue::sptr queue, recorder_t *recorder){
+    queue->run_exclusive(boost::bind(&recorder_t::record, recorder, _1, 99));
+}
+
+BOOST_AUTO_TEST_CASE(test_timed_command_queue_run_exclusive){
+    multi_usrp::sptr usrp = make_usrp(1.0);
+    timed_command_queue::sptr queue = timed_command_queue::make(usrp);
+    recorder_t recorder;
+
+    //hold the worker in a batch, with its command time set
+    gate_t gate;
+    timed_command_batch_t blocking(time_spec_t(10.0), 0);
+    blocking.add_operation(boost::bind(&gate_t::wait, &gate, _1));
+    BOOST_REQUIRE(queue->push(blocking));
+    gate.wait_entered();
+    BOOST_CHECK_CLOSE(get_command_time(usrp).get_real_secs(), 10.0, 1e-6);
+
+    //the exclusive operation waits for the batch
+    boost::thread runner(boost::bind(&run_exclusive_thread, queue, &recorder));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+    {
+        boost::mutex::scoped_lock lock(recorder.mutex);
+        BOOST_CHECK(recorder.ids.empty());
+    }
+
+    //and runs after it, without the batch's command time
+    gate.open();
+    runner.join();
+    BOOST_REQUIRE_EQUAL(recorder.ids.size(), size_t(1));
+    BOOST_CHECK_EQUAL(recorder.ids[0], size_t(99));
+    BOOST_CHECK_EQUAL(recorder.cmd_times[0].get_real_secs(), 0.0);
+    BOOST_REQUIRE(queue->wait_for_empty(5.0));
+}
@@ -0,0 +1,811 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/utils/csv.hpp>
+#include <uhd/version.hpp>
+#include <uhd/convert.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/transport/vrt_if_packet.hpp>
+#include <uhd/transport/bounded_buffer.hpp>
+#include <uhd/transport/buffer_pool.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <uhd/types/dict.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/config.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/format.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cmath>
+#include <map>
+#include <cstring>
+
+#ifdef UHD_PLATFORM_LINUX
+#include "../lib/transport/udp_tunnel.hpp"
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+namespace po = boost::program_options;
+using namespace uhd;
+
+/***********************************************************************
+ * Microbenchmarks of the host code that runs per packet or per sample:
+ * converters, packet headers, queues, buffers, time math, the property
+ * tree, dictionaries, csv files and the network mode tunnels (over the
+ * loopback interface). No device is needed.
+ *
+ * Every benchmark is calibrated to run for at least --min-time seconds,
+ * then timed --reps times; the median time per iteration is reported.
+ * Results can be written as JSON (--json) and compared against the JSON
+ * of an earlier run (--compare) to catch regressions between releases.
+ * The csv suite loads a small sweep by default; --csv-rows 200000 times
+ * a calibration file of several megabytes.
+ **********************************************************************/
+
+//! Runs the benchmark body for a number of iterations
+typedef boost::function<void(const size_t)> bench_fcn_type;
+
+struct bench_t{
+    std::string suite, name;
+    bench_fcn_type fcn;
+    double items_per_iter; //samples, packets or operations in one iteration
+    double bytes_per_iter; //bytes processed in one iteration (0 when not meaningful)
+};
+
+struct result_t{
+    std::string suite, name;
+    size_t iterations;
+    double ns_per_iter; //median over the repetitions
+    double ns_per_iter_min;
+    double items_per_sec;
+    double bytes_per_sec;
+};
+
+//! Results of the measured code end up here so they are not optimized out
+static volatile size_t sink;
+
+static bench_t make_bench(
+    const std::string &suite, const std::string &name,
+    const bench_fcn_type &fcn, const double items_per_iter = 1, const double bytes_per_iter = 0
+){
+    bench_t bench;
+    bench.suite = suite;
+    bench.name = name;
+    bench.fcn = fcn;
+    bench.items_per_iter = items_per_iter;
+    bench.bytes_per_iter = bytes_per_iter;
+    return bench;
+}
+
+/***********************************************************************
+ * Converters: every registered converter at every priority
+ **********************************************************************/
+static const size_t CONVERT_NUM_SAMPS = 2000; //about one packet
+
+struct convert_state_t{
+    convert::converter::sptr conv;
+    std::vector<std::vector<char> > in_mem, out_mem;
+    std::vector<const void *> ins;
+    std::vector<void *> outs;
+};
+
+static void bench_convert(const size_t num_iters, boost::shared_ptr<convert_state_t> state){
+    for (size_t i = 0; i < num_iters; i++){
+        state->conv->conv(state->ins, state->outs, CONVERT_NUM_SAMPS);
+    }
+    sink += size_t(state->out_mem.front().front());
+}
+
+static size_t get_bytes_per_item_or_zero(const std::string &format){
+    try{
+        return convert::get_bytes_per_item(format);
+    }
+    catch(const uhd::key_error &){
+        return 0;
+    }
+}
+
+static void add_convert_benches(std::vector<bench_t> &benches){
+    std::vector<bench_t> convert_benches;
+    BOOST_FOREACH(const convert::id_type &id, convert::get_converter_ids()){
+        BOOST_FOREACH(const convert::priority_type prio, convert::get_converter_prios(id)){
+            boost::shared_ptr<convert_state_t> state(new convert_state_t());
+            state->conv = convert::get_converter(id, prio)();
+            //floats are scaled to the integer range and integers to +/-1.0
+            const bool from_float = id.input_format[0] == 'f';
+            state->conv->set_scalar(from_float? 32767. : 1./32767.);
+
+            //sized for the largest item (fc64) so no format can overrun
+            state->in_mem.resize(id.num_inputs, std::vector<char>(CONVERT_NUM_SAMPS*16));
+            state->out_mem.resize(id.num_outputs, std::vector<char>(CONVERT_NUM_SAMPS*16));
+            for (size_t i = 0; i < id.num_inputs; i++) state->ins.push_back(&state->in_mem[i].front());
+            for (size_t i = 0; i < id.num_outputs; i++) state->outs.push_back(&state->out_mem[i].front());
+
+            const size_t bytes_per_samp =
+                id.num_inputs*get_bytes_per_item_or_zero(id.input_format) +
+                id.num_outputs*get_bytes_per_item_or_zero(id.output_format);
+            std::string name = id.input_format + " -> " + id.output_format;
+            if (id.num_inputs != 1 or id.num_outputs != 1){
+                name += str(boost::format(" (%u:%u)") % id.num_inputs % id.num_outputs);
+            }
+            name += str(boost::format(" prio %d") % prio);
+            convert_benches.push_back(make_bench(
+                "convert", name, boost::bind(&bench_convert, _1, state),
+                CONVERT_NUM_SAMPS, double(CONVERT_NUM_SAMPS*bytes_per_samp)
+            ));
+        }
+    }
+
+    //the registry order depends on static initialization, so sort by name
+    std::vector<std::pair<std::string, size_t> > order;
+    for (size_t i = 0; i < convert_benches.size(); i++){
+        order.push_back(std::make_pair(convert_benches[i].name, i));
+    }
+    std::sort(order.begin(), order.end());
+    for (size_t i = 0; i < order.size(); i++){
+        benches.push_back(convert_benches[order[i].second]);
+    }
+}
+
+/***********************************************************************
+ * VRT and CHDR packet headers
+ **********************************************************************/
+typedef void (*vrt_pack_type)(boost::uint32_t *, transport::vrt::if_packet_info_t &);
+typedef void (*vrt_unpack_type)(const boost::uint32_t *, transport::vrt::if_packet_info_t &);
+
+static transport::vrt::if_packet_info_t make_if_packet_info(const bool chdr){
+    transport::vrt::if_packet_info_t ifpi;
+    ifpi.link_type = chdr?
+        transport::vrt::if_packet_info_t::LINK_TYPE_CHDR :
+        transport::vrt::if_packet_info_t::LINK_TYPE_NONE;
+    ifpi.packet_type = transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 1996;
+    ifpi.num_payload_bytes = ifpi.num_payload_words32*sizeof(boost::uint32_t);
+    ifpi.has_sid = true;
+    ifpi.sid = 0x00a0;
+    ifpi.has_tsf = true;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = not chdr;
+    ifpi.tlr = 0;
+    return ifpi;
+}
+
+static void bench_vrt_pack(const size_t num_iters, const bool chdr, vrt_pack_type pack){
+    //room for the whole packet: the VRT trailer goes after the payload
+    std::vector<boost::uint32_t> buff(transport::vrt::max_if_hdr_words32 + 2000);
+    transport::vrt::if_packet_info_t ifpi = make_if_packet_info(chdr);
+    for (size_t i = 0; i < num_iters; i++){
+        ifpi.packet_count = i;
+        ifpi.tsf = i;
+        pack(&buff.front(), ifpi);
+    }
+    sink += buff.front();
+}
+
+static void bench_vrt_unpack(const size_t num_iters, const bool chdr, vrt_pack_type pack, vrt_unpack_type unpack){
+    //room for the whole packet: unpack checks the size against the header
+    std::vector<boost::uint32_t> buff(transport::vrt::max_if_hdr_words32 + 2000);
+    transport::vrt::if_packet_info_t ifpi = make_if_packet_info(chdr);
+    pack(&buff.front(), ifpi);
+    const size_t num_packet_words32 = ifpi.num_packet_words32;
+    for (size_t i = 0; i < num_iters; i++){
+        ifpi.num_packet_words32 = num_packet_words32;
+        unpack(&buff.front(), ifpi);
+    }
+    sink += size_t(ifpi.tsf);
+}
+
+static void add_vrt_benches(std::vector<bench_t> &benches){
+    using namespace transport::vrt;
+    benches.push_back(make_bench("vrt", "chdr pack le", boost::bind(&bench_vrt_pack, _1, true, &if_hdr_pack_le)));
+    benches.push_back(make_bench("vrt", "chdr unpack le", boost::bind(&bench_vrt_unpack, _1, true, &if_hdr_pack_le, &if_hdr_unpack_le)));
+    benches.push_back(make_bench("vrt", "chdr pack be", boost::bind(&bench_vrt_pack, _1, true, &if_hdr_pack_be)));
+    benches.push_back(make_bench("vrt", "chdr unpack be", boost::bind(&bench_vrt_unpack, _1, true, &if_hdr_pack_be, &if_hdr_unpack_be)));
+    benches.push_back(make_bench("vrt", "vrt pack le", boost::bind(&bench_vrt_pack, _1, false, &if_hdr_pack_le)));
+    benches.push_back(make_bench("vrt", "vrt unpack le", boost::bind(&bench_vrt_unpack, _1, false, &if_hdr_pack_le, &if_hdr_unpack_le)));
+    benches.push_back(make_bench("vrt", "vrt pack be", boost::bind(&bench_vrt_pack, _1, false, &if_hdr_pack_be)));
+    benches.push_back(make_bench("vrt", "vrt unpack be", boost::bind(&bench_vrt_unpack, _1, false, &if_hdr_pack_be, &if_hdr_unpack_be)));
+}
+
+/***********************************************************************
+ * Bounded buffer and buffer pool
+ **********************************************************************/
+static void bench_bounded_buffer_haste(const size_t num_iters){
+    transport::bounded_buffer<size_t> bb(64);
+    size_t elem = 0, sum = 0;
+    for (size_t i = 0; i < num_iters; i++){
+        bb.push_with_haste(i);
+        bb.pop_with_haste(elem);
+        sum += elem;
+    }
+    sink += sum;
+}
+
+static void bench_bounded_buffer_timed_wait(const size_t num_iters){
+    transport::bounded_buffer<size_t> bb(64);
+    size_t elem = 0, sum = 0;
+    for (size_t i = 0; i < num_iters; i++){
+        bb.push_with_timed_wait(i, 1.0);
+        bb.pop_with_timed_wait(elem, 1.0);
+        sum += elem;
+    }
+    sink += sum;
+}
+
+static void bounded_buffer_producer(transport::bounded_buffer<size_t> *bb, const size_t num_iters){
+    for (size_t i = 0; i < num_iters; i++) bb->push_with_wait(i);
+}
+
+static void bench_bounded_buffer_threaded(const size_t num_iters){
+    transport::bounded_buffer<size_t> bb(64);
+    boost::thread producer(boost::bind(&bounded_buffer_producer, &bb, num_iters));
+    size_t elem = 0, sum = 0;
+    for (size_t i = 0; i < num_iters; i++){
+        bb.pop_with_wait(elem);
+        sum += elem;
+    }
+    producer.join();
+    sink += sum;
+}
+
+static void bench_buffer_pool_make(const size_t num_iters){
+    for (size_t i = 0; i < num_iters; i++){
+        transport::buffer_pool::sptr pool = transport::buffer_pool::make(32, 8000);
+        sink += size_t(pool->at(0) != NULL);
+    }
+}
+
+static void bench_buffer_pool_at(const size_t num_iters, transport::buffer_pool::sptr pool){
+    size_t sum = 0;
+    for (size_t i = 0; i < num_iters; i++){
+        sum += size_t(pool->at(i % 32));
+    }
+    sink += sum;
+}
+
+static void add_buffer_benches(std::vector<bench_t> &benches){
+    benches.push_back(make_bench("bounded_buffer", "push+pop with haste", &bench_bounded_buffer_haste));
+    benches.push_back(make_bench("bounded_buffer", "push+pop with timed wait", &bench_bounded_buffer_timed_wait));
+    benches.push_back(make_bench("bounded_buffer", "producer thread handoff", &bench_bounded_buffer_threaded));
+    benches.push_back(make_bench("buffer_pool", "make 32x8000", &bench_buffer_pool_make));
+    benches.push_back(make_bench("buffer_pool", "at", boost::bind(&bench_buffer_pool_at, _1, transport::buffer_pool::make(32, 8000))));
+}
+
+/***********************************************************************
+ * Time spec math
+ **********************************************************************/
+static const double TICK_RATE = 200e6;
+
+static void bench_time_spec_add(const size_t num_iters){
+    time_spec_t t(1.5), delta(0.0001);
+    for (size_t i = 0; i < num_iters; i++) t += delta;
+    sink += size_t(t.get_full_secs());
+}
+
+static void bench_time_spec_compare(const size_t num_iters){
+    const time_spec_t a(1, 0.25), b(1, 0.5);
+    size_t count = 0;
+    for (size_t i = 0; i < num_iters; i++) count += ((i & 1)? a : b) < b;
+    sink += count;
+}
+
+static void bench_time_spec_to_ticks(const size_t num_iters){
+    time_spec_t t(1, 0.123456789);
+    long long sum = 0;
+    for (size_t i = 0; i < num_iters; i++) sum += t.to_ticks(TICK_RATE);
+    sink += size_t(sum);
+}
+
+static void bench_time_spec_from_ticks(const size_t num_iters){
+    double sum = 0;
+    for (size_t i = 0; i < num_iters; i++){
+        sum += time_spec_t::from_ticks((long long)(i)*1996, TICK_RATE).get_frac_secs();
+    }
+    sink += size_t(sum);
+}
+
+static void bench_time_spec_real_secs(const size_t num_iters){
+    time_spec_t t(1000, 0.5);
+    double sum = 0;
+    for (size_t i = 0; i < num_iters; i++) sum += t.get_real_secs();
+    sink += size_t(sum);
+}
+
+static void bench_time_spec_system_time(const size_t num_iters){
+    double sum = 0;
+    for (size_t i = 0; i < num_iters; i++) sum += time_spec_t::get_system_time().get_frac_secs();
+    sink += size_t(sum);
+}
+
+static void add_time_spec_benches(std::vector<bench_t> &benches){
+    benches.push_back(make_bench("time_spec", "operator+=", &bench_time_spec_add));
+    benches.push_back(make_bench("time_spec", "operator<", &bench_time_spec_compare));
+    benches.push_back(make_bench("time_spec", "to_ticks", &bench_time_spec_to_ticks));
+    benches.push_back(make_bench("time_spec", "from_ticks", &bench_time_spec_from_ticks));
+    benches.push_back(make_bench("time_spec", "get_real_secs", &bench_time_spec_real_secs));
+    benches.push_back(make_bench("time_spec", "get_system_time", &bench_time_spec_system_time));
+}
+
+/***********************************************************************
+ * Property tree and dictionaries
+ **********************************************************************/
+static const std::string FREQ_PATH = "/mboards/0/rx_dsps/0/freq/value";
+
+static double coerce_freq(const double freq){
+    return std::floor(freq/1e3)*1e3;
+}
+
+static void update_freq(const double freq){
+    sink += size_t(freq);
+}
+
+static property_tree::sptr make_bench_tree(void){
+    //a tree shaped like a device tree with a few branches
+    property_tree::sptr tree = property_tree::make();
+    for (size_t mb = 0; mb < 2; mb++){
+        for (size_t dsp = 0; dsp < 4; dsp++){
+            const fs_path dsp_path = str(boost::format("/mboards/%u/rx_dsps/%u") % mb % dsp);
+            tree->create<double>(dsp_path / "rate" / "value").set(1e6);
+            tree->create<double>(dsp_path / "freq" / "value")
+                .coerce(&coerce_freq)
+                .subscribe(&update_freq)
+                .set(0.0);
+        }
+    }
+    return tree;
+}
+
+static void bench_tree_get(const size_t num_iters, property_tree::sptr tree){
+    double sum = 0;
+    for (size_t i = 0; i < num_iters; i++) sum += tree->access<double>(FREQ_PATH).get();
+    sink += size_t(sum);
+}
+
+static void bench_tree_set(const size_t num_iters, property_tree::sptr tree){
+    for (size_t i = 0; i < num_iters; i++) tree->access<double>(FREQ_PATH).set(double(i));
+}
+
+static void bench_tree_cached_get(const size_t num_iters, property_tree::sptr tree){
+    property<double> &prop = tree->access<double>(FREQ_PATH);
+    double sum = 0;
+    for (size_t i = 0; i < num_iters; i++) sum += prop.get();
+    sink += size_t(sum);
+}
+
+static void bench_tree_exists(const size_t num_iters, property_tree::sptr tree){
+    size_t count = 0;
+    for (size_t i = 0; i < num_iters; i++) count += tree->exists(FREQ_PATH);
+    sink += count;
+}
+
+static device_addr_t make_bench_addr(void){
+    device_addr_t addr;
+    for (size_t i = 0; i < 10; i++){
+        addr[str(boost::format("key%u") % i)] = str(boost::format("value%u") % i);
+    }
+    return addr;
+}
+
+static void bench_dict_lookup(const size_t num_iters, const device_addr_t &addr){
+    static const std::string key = "key9";
+    size_t sum = 0;
+    for (size_t i = 0; i < num_iters; i++) sum += addr[key].size();
+    sink += sum;
+}
+
+static void bench_dict_has_key_miss(const size_t num_iters, const device_addr_t &addr){
+    static const std::string key = "missing";
+    size_t count = 0;
+    for (size_t i = 0; i < num_iters; i++) count += addr.has_key(key);
+    sink += count;
+}
+
+static void bench_dict_cast(const size_t num_iters, const device_addr_t &addr){
+    double sum = 0;
+    for (size_t i = 0; i < num_iters; i++) sum += addr.cast<double>("recv_frame_size", 8000);
+    sink += size_t(sum);
+}
+
+static void add_tree_benches(std::vector<bench_t> &benches){
+    property_tree::sptr tree = make_bench_tree();
+    benches.push_back(make_bench("property_tree", "access get", boost::bind(&bench_tree_get, _1, tree)));
+    benches.push_back(make_bench("property_tree", "access set (coerce+subscribe)", boost::bind(&bench_tree_set, _1, tree)));
+    benches.push_back(make_bench("property_tree", "cached property get", boost::bind(&bench_tree_cached_get, _1, tree)));
+    benches.push_back(make_bench("property_tree", "exists", boost::bind(&bench_tree_exists, _1, tree)));
+
+    const device_addr_t addr = make_bench_addr();
+    benches.push_back(make_bench("dict", "lookup (10 keys)", boost::bind(&bench_dict_lookup, _1, addr)));
+    benches.push_back(make_bench("dict", "has_key miss (10 keys)", boost::bind(&bench_dict_has_key_miss, _1, addr)));
+    benches.push_back(make_bench("dict", "device_addr cast", boost::bind(&bench_dict_cast, _1, addr)));
+}
+
+/***********************************************************************
+ * CSV: loading and storing calibration-style files
+ **********************************************************************/
+struct csv_state_t{
+    size_t num_rows;
+    csv::columns_type columns;
+    std::string text;
+};
+
+static boost::shared_ptr<csv_state_t> make_csv_state(const size_t num_rows){
+    //the data of a fine-grained frequency sweep
+    boost::shared_ptr<csv_state_t> state(new csv_state_t());
+    state->num_rows = num_rows;
+    state->columns.resize(5, std::vector<double>(num_rows));
+    for (size_t i = 0; i < num_rows; i++){
+        state->columns[0][i] = 50e6 + i*1e3;
+        state->columns[1][i] = 0.01*std::sin(i*1e-3);
+        state->columns[2][i] = 0.01*std::cos(i*1e-3);
+        state->columns[3][i] = -60.0 - (i % 100)*0.1;
+        state->columns[4][i] = 30.0 + (i % 10)*0.01;
+    }
+    std::ostringstream out;
+    csv::write_columns(out, state->columns);
+    state->text = out.str();
+    return state;
+}
+
+static void bench_csv_ostream(const size_t num_iters, boost::shared_ptr<csv_state_t> state){
+    const csv::columns_type &columns = state->columns;
+    for (size_t n = 0; n < num_iters; n++){
+        std::ostringstream out;
+        out.precision(17);
+        for (size_t i = 0; i < state->num_rows; i++){
+            out
+                << columns[0][i] << ", " << columns[1][i] << ", " << columns[2][i] << ", "
+                << columns[3][i] << ", " << columns[4][i] << "\n";
+        }
+        sink += out.str().size();
+    }
+}
+
+static void bench_csv_write_columns(const size_t num_iters, boost::shared_ptr<csv_state_t> state){
+    for (size_t n = 0; n < num_iters; n++){
+        std::ostringstream out;
+        csv::write_columns(out, state->columns);
+        sink += out.str().size();
+    }
+}
+
+static void bench_csv_to_rows_sscanf(const size_t num_iters, boost::shared_ptr<csv_state_t> state){
+    for (size_t n = 0; n < num_iters; n++){
+        std::istringstream in(state->text);
+        const csv::rows_type rows = csv::to_rows(in);
+        double sum = 0;
+        BOOST_FOREACH(const csv::row_type &row, rows){
+            double freq, real, imag;
+            std::sscanf(row[0].c_str(), "%lf", &freq);
+            std::sscanf(row[1].c_str(), "%lf", &real);
+            std::sscanf(row[2].c_str(), "%lf", &imag);
+            sum += freq + real + imag;
+        }
+        sink += size_t(sum);
+    }
+}
+
+static void bench_csv_to_columns(const size_t num_iters, boost::shared_ptr<csv_state_t> state){
+    for (size_t n = 0; n < num_iters; n++){
+        std::istringstream in(state->text);
+        sink += csv::to_columns(in, 3).front().size();
+    }
+}
+
+static void add_csv_benches(std::vector<bench_t> &benches, const size_t num_rows){
+    boost::shared_ptr<csv_state_t> state = make_csv_state(num_rows);
+    const double bytes = double(state->text.size());
+    benches.push_back(make_bench("csv", "write ostream", boost::bind(&bench_csv_ostream, _1, state), num_rows, bytes));
+    benches.push_back(make_bench("csv", "write_columns", boost::bind(&bench_csv_write_columns, _1, state), num_rows, bytes));
+    benches.push_back(make_bench("csv", "to_rows+sscanf", boost::bind(&bench_csv_to_rows_sscanf, _1, state), num_rows, bytes));
+    benches.push_back(make_bench("csv", "to_columns", boost::bind(&bench_csv_to_columns, _1, state), num_rows, bytes));
+}
+
+/***********************************************************************
+ * UDP tunnels of the E300 network mode, over the loopback interface
+ **********************************************************************/
+#ifdef UHD_PLATFORM_LINUX
+static const size_t TUNNEL_FRAME_SIZE = 1200; //the largest network mode data frame
+static const size_t TUNNEL_NUM_FRAMES = 64;
+
+class bench_mrb : public transport::managed_recv_buffer{
+public:
+    void release(void){/* NOP */}
+    sptr get_new(char *mem, const size_t len){return make(this, mem, len);}
+};
+
+class bench_msb : public transport::managed_send_buffer{
+public:
+    bench_msb(void): num_committed(NULL){}
+    void release(void){(*num_committed)++;}
+    sptr get_new(char *mem, const size_t len){return make(this, mem, len);}
+    size_t *num_committed;
+};
+
+//! A device whose frames are always ready: receive frames hold a packet, sent frames are counted
+class bench_frames_zero_copy : public transport::zero_copy_if{
+public:
+    bench_frames_zero_copy(void):
+        num_committed(0), _mem(TUNNEL_FRAME_SIZE, 'x'),
+        _mrbs(TUNNEL_NUM_FRAMES), _msbs(TUNNEL_NUM_FRAMES),
+        _recv_index(0), _send_index(0)
+    {
+        for (size_t i = 0; i < TUNNEL_NUM_FRAMES; i++) _msbs[i].num_committed = &num_committed;
+    }
+
+    transport::managed_recv_buffer::sptr get_recv_buff(double){
+        return _mrbs[_recv_index++ % TUNNEL_NUM_FRAMES].get_new(&_mem.front(), TUNNEL_FRAME_SIZE);
+    }
+    size_t get_num_recv_frames(void) const{return TUNNEL_NUM_FRAMES;}
+    size_t get_recv_frame_size(void) const{return TUNNEL_FRAME_SIZE;}
+
+    transport::managed_send_buffer::sptr get_send_buff(double){
+        return _msbs[_send_index++ % TUNNEL_NUM_FRAMES].get_new(&_mem.front(), TUNNEL_FRAME_SIZE);
+    }
+    size_t get_num_send_frames(void) const{return TUNNEL_NUM_FRAMES;}
+    size_t get_send_frame_size(void) const{return TUNNEL_FRAME_SIZE;}
+
+    size_t num_committed;
+
+private:
+    std::vector<char> _mem; //the packets are not looked at, they share the memory
+    std::vector<bench_mrb> _mrbs;
+    std::vector<bench_msb> _msbs;
+    size_t _recv_index, _send_index;
+};
+
+//! A UDP socket bound to a free port of the loopback interface
+struct bench_socket_t{
+    bench_socket_t(void){
+        fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) throw uhd::os_error("microbench: cannot open a UDP socket");
+        sockaddr_in sin;
+        std::memset(&sin, 0, sizeof(sin));
+        sin.sin_family = AF_INET;
+        sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        std::memset(&addr, 0, sizeof(addr));
+        std::memcpy(&addr, &sin, sizeof(sin));
+        len = sizeof(sin);
+        if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), len) != 0 or
+            ::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) != 0){
+            ::close(fd);
+            throw uhd::os_error("microbench: cannot bind a UDP socket");
+        }
+    }
+    ~bench_socket_t(void){::close(fd);}
+    int fd;
+    sockaddr_storage addr;
+    socklen_t len;
+};
+
+//! Both tunnels on one socket: the packets go out to the socket and come back in
+struct tunnel_state_t{
+    tunnel_state_t(const size_t burst):
+        device_impl(new bench_frames_zero_copy()), device(device_impl),
+        to_socket(device, sock.fd, to_endpoint, burst),
+        from_socket(sock.fd, device, from_endpoint, burst)
+    {
+        to_endpoint.update(sock.addr, sock.len);
+    }
+    bench_socket_t sock;
+    boost::shared_ptr<bench_frames_zero_copy> device_impl;
+    transport::zero_copy_if::sptr device;
+    transport::udp_tunnel_endpoint to_endpoint, from_endpoint;
+    transport::udp_tunnel_to_socket to_socket;
+    transport::udp_tunnel_from_socket from_socket;
+};
+
+static void bench_tunnel_round_trip(const size_t num_iters, boost::shared_ptr<tunnel_state_t> state){
+    bench_frames_zero_copy &device = *state->device_impl;
+    const size_t done = device.num_committed + num_iters;
+    while (device.num_committed < done){
+        state->to_socket.forward(0.0);
+        state->from_socket.forward(0.1);
+    }
+}
+
+static void add_tunnel_benches(std::vector<bench_t> &benches){
+    static const size_t bursts[] = {1, 8, 32};
+    BOOST_FOREACH(const size_t burst, bursts){
+        boost::shared_ptr<tunnel_state_t> state(new tunnel_state_t(burst));
+        benches.push_back(make_bench("udp_tunnel", str(boost::format("loopback round trip, burst %u") % burst),
+            boost::bind(&bench_tunnel_round_trip, _1, state), 1, TUNNEL_FRAME_SIZE));
+    }
+}
+#else
+static void add_tunnel_benches(std::vector<bench_t> &){
+    /* NOP: the tunnels need POSIX sockets */
+}
+#endif
+
+/***********************************************************************
+ * Timing
+ **********************************************************************/
+static double time_iters(const bench_fcn_type &fcn, const size_t num_iters){
+    const time_spec_t start = time_spec_t::get_system_time();
+    fcn(num_iters);
+    return (time_spec_t::get_system_time() - start).get_real_secs();
+}
+
+static result_t run_bench(const bench_t &bench, const double min_time, const size_t num_reps){
+    //calibrate the iteration count, which also warms up caches and allocators
+    size_t num_iters = 1;
+    while (time_iters(bench.fcn, num_iters) < min_time and num_iters < (size_t(1) << 30)){
+        num_iters *= 2;
+    }
+
+    std::vector<double> ns_per_iter;
+    for (size_t rep = 0; rep < num_reps; rep++){
+        ns_per_iter.push_back(time_iters(bench.fcn, num_iters)*1e9/num_iters);
+    }
+    std::sort(ns_per_iter.begin(), ns_per_iter.end());
+
+    result_t result;
+    result.suite = bench.suite;
+    result.name = bench.name;
+    result.iterations = num_iters;
+    result.ns_per_iter = ns_per_iter[ns_per_iter.size()/2];
+    result.ns_per_iter_min = ns_per_iter.front();
+    result.items_per_sec = bench.items_per_iter*1e9/result.ns_per_iter;
+    result.bytes_per_sec = bench.bytes_per_iter*1e9/result.ns_per_iter;
+    return result;
+}
+
+/***********************************************************************
+ * JSON results
+ **********************************************************************/
+static std::string json_escape(const std::string &in){
+    std::string out;
+    BOOST_FOREACH(const char ch, in){
+        if (ch == '"' or ch == '\\') out += '\\';
+        out += ch;
+    }
+    return out;
+}
+
+static void write_json(std::ostream &out, const std::vector<result_t> &results, const double min_time, const size_t num_reps){
+    out << "{" << std::endl;
+    out << boost::format("  \"uhd_version\": \"%s\",") % json_escape(get_version_string()) << std::endl;
+    out << boost::format("  \"min_time\": %g,") % min_time << std::endl;
+    out << boost::format("  \"reps\": %u,") % num_reps << std::endl;
+    out << "  \"benchmarks\": [" << std::endl;
+    for (size_t i = 0; i < results.size(); i++){
+        const result_t &r = results[i];
+        out << boost::format(
+            "    {\"suite\": \"%s\", \"name\": \"%s\", \"iterations\": %u, "
+            "\"ns_per_iter\": %.3f, \"ns_per_iter_min\": %.3f, "
+            "\"items_per_sec\": %.6g, \"bytes_per_sec\": %.6g}%s"
+        ) % json_escape(r.suite) % json_escape(r.name) % r.iterations
+          % r.ns_per_iter % r.ns_per_iter_min % r.items_per_sec % r.bytes_per_sec
+          % ((i + 1 == results.size())? "" : ",") << std::endl;
+    }
+    out << "  ]" << std::endl;
+    out << "}" << std::endl;
+}
+
+//! Compare against an earlier run, returns the number of regressions
+static size_t compare_json(std::ostream &report, const std::string &path, const std::vector<result_t> &results, const double threshold){
+    boost::property_tree::ptree baseline;
+    boost::property_tree::read_json(path, baseline);
+    std::map<std::string, double> baseline_ns;
+    BOOST_FOREACH(const boost::property_tree::ptree::value_type &bench, baseline.get_child("benchmarks")){
+        const std::string key = bench.second.get<std::string>("suite") + "/" + bench.second.get<std::string>("name");
+        baseline_ns[key] = bench.second.get<double>("ns_per_iter");
+    }
+
+    report << boost::format("Comparing with %s (%s), threshold %.1f%%")
+        % path % baseline.get<std::string>("uhd_version", "unknown") % threshold << std::endl;
+    size_t num_regressions = 0;
+    BOOST_FOREACH(const result_t &r, results){
+        const std::string key = r.suite + "/" + r.name;
+        if (baseline_ns.count(key) == 0 or baseline_ns[key] <= 0) continue;
+        const double change = 100.0*(r.ns_per_iter/baseline_ns[key] - 1.0);
+        if (change <= threshold) continue;
+        report << boost::format("  REGRESSION %-50s %10.1f ns -> %10.1f ns (%+.1f%%)")
+            % key % baseline_ns[key] % r.ns_per_iter % change << std::endl;
+        num_regressions++;
+    }
+    report << boost::format("%u regression(s)") % num_regressions << std::endl;
+    return num_regressions;
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    std::string filter, json_path, compare_path;
+    double min_time, threshold;
+    size_t num_reps, csv_rows;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("list", "list the benchmarks and exit")
+        ("filter", po::value<std::string>(&filter)->default_value(""), "only run benchmarks whose suite/name contains this string")
+        ("min-time", po::value<double>(&min_time)->default_value(0.05), "minimum time of one repetition (seconds)")
+        ("reps", po::value<size_t>(&num_reps)->default_value(5), "number of timed repetitions (the median is reported)")
+        ("json", po::value<std::string>(&json_path)->default_value(""), "write the results as JSON to this file (- for stdout)")
+        ("compare", po::value<std::string>(&compare_path)->default_value(""), "JSON of an earlier run to compare against")
+        ("threshold", po::value<double>(&threshold)->default_value(10.0), "slowdown in percent reported as a regression")
+        ("csv-rows", po::value<size_t>(&csv_rows)->default_value(1000), "rows of the csv benchmark file (200000 rows are about 18 MB)")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")){
+        std::cout << boost::format("UHD Microbenchmarks %s") % desc << std::endl;
+        return EXIT_SUCCESS;
+    }
+    if (num_reps == 0) num_reps = 1;
+
+    std::vector<bench_t> benches;
+    add_convert_benches(benches);
+    add_vrt_benches(benches);
+    add_buffer_benches(benches);
+    add_time_spec_benches(benches);
+    add_tree_benches(benches);
+    add_csv_benches(benches, std::max<size_t>(csv_rows, 1));
+    add_tunnel_benches(benches);
+
+    //the table goes to stderr when the JSON goes to stdout
+    const bool json_stdout = json_path == "-";
+    std::ostream &table = json_stdout? std::cerr : std::cout;
+
+    std::vector<result_t> results;
+    BOOST_FOREACH(const bench_t &bench, benches){
+        const std::string key = bench.suite + "/" + bench.name;
+        if (key.find(filter) == std::string::npos) continue;
+        if (vm.count("list")){
+            std::cout << key << std::endl;
+            continue;
+        }
+        const result_t r = run_bench(bench, min_time, num_reps);
+        table << boost::format("%-60s %12.1f ns %14.4g items/s") % key % r.ns_per_iter % r.items_per_sec;
+        if (r.bytes_per_sec > 0) table << boost::format(" %10.1f MB/s") % (r.bytes_per_sec/1e6);
+        table << std::endl;
+        results.push_back(r);
+    }
+    if (vm.count("list")) return EXIT_SUCCESS;
+
+    if (json_stdout){
+        write_json(std::cout, results, min_time, num_reps);
+    }
+    else if (not json_path.empty()){
+        std::ofstream out(json_path.c_str());
+        if (not out.is_open()) throw uhd::os_error("cannot open " + json_path);
+        write_json(out, results, min_time, num_reps);
+    }
+
+    if (not compare_path.empty()){
+        if (compare_json(table, compare_path, results, threshold) != 0) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
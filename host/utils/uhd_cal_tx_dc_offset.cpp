@@ -159,10 +159,14 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
         const double actual_rx_freq = usrp->get_rx_freq();
         const double bb_dc_freq = actual_tx_freq - actual_rx_freq;
 
-        //capture initial uncorrected value
+        //measure each capture in the background while the next one is taken
+        measure_pipeline pipeline(boost::bind(&compute_tone_dbrms, _1, bb_dc_freq/actual_rx_rate));
+
+        //capture initial uncorrected value (measured along with the first search grid)
         usrp->set_tx_dc_offset(std::complex<double>(0, 0));
         capture_samples(usrp, rx_stream, buff, nsamps);
-        const double initial_dc_dbrms = compute_tone_dbrms(buff, bb_dc_freq/actual_rx_rate);
+        pipeline.push(buff);
+        double initial_dc_dbrms = 0;
 
         //bounds and results from searching
         double dc_i_start = -.01, dc_i_stop = .01, dc_i_step;
@@ -174,24 +178,32 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
             dc_i_step = (dc_i_stop - dc_i_start)/(num_search_steps-1);
             dc_q_step = (dc_q_stop - dc_q_start)/(num_search_steps-1);
 
+            std::vector<std::complex<double> > corrections;
             for (double dc_i = dc_i_start; dc_i <= dc_i_stop + dc_i_step/2; dc_i += dc_i_step){
             for (double dc_q = dc_q_start; dc_q <= dc_q_stop + dc_q_step/2; dc_q += dc_q_step){
 
                 const std::complex<double> correction(dc_i, dc_q);
                 usrp->set_tx_dc_offset(correction);
 
-                //receive some samples
+                //receive some samples and measure them in the background
                 capture_samples(usrp, rx_stream, buff, nsamps);
+                pipeline.push(buff);
+                corrections.push_back(correction);
 
-                const double dc_dbrms = compute_tone_dbrms(buff, bb_dc_freq/actual_rx_rate);
+            }}
 
-                if (dc_dbrms < lowest_offset){
-                    lowest_offset = dc_dbrms;
-                    best_dc_i = dc_i;
-                    best_dc_q = dc_q;
+            //the grid measurements follow any earlier (initial) measurement
+            const std::vector<double> &dc_dbrms = pipeline.results();
+            const size_t first = dc_dbrms.size() - corrections.size();
+            if (i == 0) initial_dc_dbrms = dc_dbrms.front();
+            for (size_t j = 0; j < corrections.size(); j++){
+                if (dc_dbrms[first + j] < lowest_offset){
+                    lowest_offset = dc_dbrms[first + j];
+                    best_dc_i = corrections[j].real();
+                    best_dc_q = corrections[j].imag();
                 }
-
-            }}
+            }
+            pipeline.clear();
 
             //std::cout << "best_dc_i " << best_dc_i << std::endl;
             //std::cout << "best_dc_q " << best_dc_q << std::endl;
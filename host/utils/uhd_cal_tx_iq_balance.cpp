@@ -156,10 +156,14 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
         const double bb_tone_freq = actual_tx_freq + tx_wave_freq - actual_rx_freq;
         const double bb_imag_freq = actual_tx_freq - tx_wave_freq - actual_rx_freq;
 
-        //capture initial uncorrected value
+        //measure each capture in the background while the next one is taken
+        measure_pipeline pipeline(boost::bind(&compute_tone_suppression, _1, bb_tone_freq/actual_rx_rate, bb_imag_freq/actual_rx_rate));
+
+        //capture initial uncorrected value (measured along with the first search grid)
         usrp->set_tx_iq_balance(0.0);
         capture_samples(usrp, rx_stream, buff, nsamps);
-        const double initial_suppression = compute_tone_dbrms(buff, bb_tone_freq/actual_rx_rate) - compute_tone_dbrms(buff, bb_imag_freq/actual_rx_rate);
+        pipeline.push(buff);
+        double initial_suppression = 0;
 
         //bounds and results from searching
         std::complex<double> best_correction;
@@ -172,27 +176,34 @@ int UHD_SAFE_MAIN(int argc, char *argv[]){
             phase_corr_step = (phase_corr_stop - phase_corr_start)/(num_search_steps-1);
             ampl_corr_step = (ampl_corr_stop - ampl_corr_start)/(num_search_steps-1);
 
+            std::vector<std::complex<double> > corrections;
             for (double phase_corr = phase_corr_start; phase_corr <= phase_corr_stop + phase_corr_step/2; phase_corr += phase_corr_step){
             for (double ampl_corr = ampl_corr_start; ampl_corr <= ampl_corr_stop + ampl_corr_step/2; ampl_corr += ampl_corr_step){
 
                 const std::complex<double> correction(ampl_corr, phase_corr);
                 usrp->set_tx_iq_balance(correction);
 
-                //receive some samples
+                //receive some samples and measure them in the background
                 capture_samples(usrp, rx_stream, buff, nsamps);
+                pipeline.push(buff);
+                corrections.push_back(correction);
 
-                const double tone_dbrms = compute_tone_dbrms(buff, bb_tone_freq/actual_rx_rate);
-                const double imag_dbrms = compute_tone_dbrms(buff, bb_imag_freq/actual_rx_rate);
-                const double suppression = tone_dbrms - imag_dbrms;
+            }}
 
+            //the grid measurements follow any earlier (initial) measurement
+            const std::vector<double> &suppressions = pipeline.results();
+            const size_t first = suppressions.size() - corrections.size();
+            if (i == 0) initial_suppression = suppressions.front();
+            for (size_t j = 0; j < corrections.size(); j++){
+                const double suppression = suppressions[first + j];
                 if (suppression > best_suppression){
-                    best_correction = correction;
+                    best_correction = corrections[j];
                     best_suppression = suppression;
-                    best_phase_corr = phase_corr;
-                    best_ampl_corr = ampl_corr;
+                    best_phase_corr = corrections[j].imag();
+                    best_ampl_corr = corrections[j].real();
                 }
-
-            }}
+            }
+            pipeline.clear();
 
             //std::cout << "best_phase_corr " << best_phase_corr << std::endl;
             //std::cout << "best_ampl_corr " << best_ampl_corr << std::endl;
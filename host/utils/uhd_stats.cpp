@@ -0,0 +1,113 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/utils/stats_export.hpp>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <cctype>
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+//! Make a metric name a valid Prometheus metric name
+static std::string to_prometheus_name(const std::string &name){
+    std::string out = "uhd_";
+    BOOST_FOREACH(const char ch, name){
+        out += std::isalnum(ch)? ch : '_';
+    }
+    return out;
+}
+
+static void print_snapshot(const uhd::stats_snapshot_t &snapshot, const bool prometheus){
+    if (prometheus){
+        BOOST_FOREACH(const uhd::stats_metric_t &metric, snapshot.metrics){
+            std::cout << boost::format("%s{pid=\"%u\"} %.17g") % to_prometheus_name(metric.name) % snapshot.pid % metric.value << std::endl;
+        }
+        return;
+    }
+    std::cout << boost::format("# pid %u, update %u, time %f, %u dropped")
+        % snapshot.pid % snapshot.update_count % snapshot.update_time % snapshot.num_dropped << std::endl;
+    BOOST_FOREACH(const uhd::stats_metric_t &metric, snapshot.metrics){
+        std::cout << metric.name << " " << boost::format("%.17g") % metric.value << std::endl;
+    }
+}
+
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    std::string segment;
+    boost::uint32_t pid;
+    double interval;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("pid", po::value<boost::uint32_t>(&pid), "process ID of the exporting application")
+        ("segment", po::value<std::string>(&segment), "shared-memory segment name (overrides pid)")
+        ("interval", po::value<double>(&interval)->default_value(0.0), "repeat every interval seconds (0 to print once)")
+        ("prometheus", "print in the Prometheus text exposition format")
+    ;
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UHD Statistics %s") % desc << std::endl;
+        std::cout << std::endl
+            << "Reads the counters exported by a UHD application that was started" << std::endl
+            << "with the stats_export device argument or UHD_STATS_EXPORT set." << std::endl
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //without a target, list the segments that can be read
+    if (not vm.count("segment") and not vm.count("pid")){
+        const fs::path shm_dir("/dev/shm");
+        size_t num_found = 0;
+        if (fs::exists(shm_dir)){
+            for (fs::directory_iterator it(shm_dir); it != fs::directory_iterator(); ++it){
+                const std::string name = it->path().filename().string();
+                if (not boost::starts_with(name, "uhd_stats_")) continue;
+                std::cout << name << std::endl;
+                num_found++;
+            }
+        }
+        if (num_found == 0){
+            std::cerr << "No exported UHD statistics found, specify --pid or --segment" << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    if (not vm.count("segment")) segment = uhd::stats_exporter::get_segment_name(pid);
+
+    uhd::stats_reader::sptr reader = uhd::stats_reader::make(segment);
+    while (true){
+        print_snapshot(reader->read(), vm.count("prometheus") != 0);
+        if (interval <= 0.0) break;
+        std::cout << std::endl;
+        boost::this_thread::sleep(boost::posix_time::microseconds(long(interval*1e6)));
+    }
+
+    return EXIT_SUCCESS;
+}
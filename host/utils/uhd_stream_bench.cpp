@@ -0,0 +1,304 @@
+//
+// Copyright 2014 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/utils/platform.hpp>
+#include <uhd/utils/thread_priority.hpp>
+#include <uhd/utils/msg.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/convert.hpp>
+#include <uhd/exception.hpp>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+
+namespace po = boost::program_options;
+
+/***********************************************************************
+ * One point of the sweep
+ **********************************************************************/
+struct bench_point_t{
+    bench_point_t(void):
+        spp(0), num_frames(0), num_channels(1),
+        wall_secs(0), thread_cpu_secs(0), num_samps(0), num_errors(0)
+    {}
+
+    //the configuration (zero means the device default)
+    std::string direction;
+    std::string otw_format;
+    size_t spp;
+    size_t num_frames;
+    size_t num_channels;
+
+    //the results
+    std::string error;
+    double wall_secs;
+    double thread_cpu_secs;
+    unsigned long long num_samps;
+    unsigned long long num_errors;
+    uhd::stream_stats_t stats;
+
+    double get_samps_per_cpu_sec(void) const{
+        return (thread_cpu_secs > 0)? num_samps/thread_cpu_secs : 0;
+    }
+    double get_cpu_load(void) const{
+        return (wall_secs > 0)? thread_cpu_secs/wall_secs : 0;
+    }
+};
+
+//! Parse a comma separated list of sizes, an empty list gives one zero (the default)
+static std::vector<size_t> to_sizes(const std::string &list){
+    std::vector<size_t> sizes;
+    std::vector<std::string> tokens;
+    boost::split(tokens, list, boost::is_any_of(","), boost::token_compress_on);
+    BOOST_FOREACH(const std::string &token, tokens){
+        if (boost::trim_copy(token).empty()) continue;
+        sizes.push_back(boost::lexical_cast<size_t>(boost::trim_copy(token)));
+    }
+    if (sizes.empty()) sizes.push_back(0);
+    return sizes;
+}
+
+/***********************************************************************
+ * Streaming loops: run in the calling thread so its CPU time is the cost
+ **********************************************************************/
+static void run_rx(uhd::usrp::multi_usrp::sptr usrp, uhd::rx_streamer::sptr rx_stream, const std::string &cpu, const double duration, bench_point_t &point){
+    const size_t spp = rx_stream->get_max_num_samps();
+    std::vector<char> buff(spp*uhd::convert::get_bytes_per_item(cpu));
+    std::vector<void *> buffs(rx_stream->get_num_channels(), &buff.front());
+    uhd::rx_metadata_t md;
+
+    uhd::stream_cmd_t cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    cmd.stream_now = (buffs.size() == 1);
+    cmd.time_spec = usrp->get_time_now() + uhd::time_spec_t(0.05);
+
+    const double cpu_start = uhd::get_thread_cpu_time();
+    const uhd::time_spec_t start = uhd::time_spec_t::get_system_time();
+    rx_stream->issue_stream_cmd(cmd);
+    while ((uhd::time_spec_t::get_system_time() - start).get_real_secs() < duration){
+        point.num_samps += rx_stream->recv(buffs, spp, md, 1.0)*buffs.size();
+        if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE) point.num_errors++;
+    }
+    rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+    point.wall_secs = (uhd::time_spec_t::get_system_time() - start).get_real_secs();
+    point.thread_cpu_secs = uhd::get_thread_cpu_time() - cpu_start;
+    point.stats = rx_stream->get_stats(); //before the drain adds its timeout
+
+    //drain what is still in flight so the next point starts clean
+    while (rx_stream->recv(buffs, spp, md, 0.1) != 0){}
+}
+
+static void run_tx(uhd::usrp::multi_usrp::sptr usrp, uhd::tx_streamer::sptr tx_stream, const std::string &cpu, const double duration, bench_point_t &point){
+    const size_t spp = tx_stream->get_max_num_samps();
+    std::vector<char> buff(spp*uhd::convert::get_bytes_per_item(cpu));
+    std::vector<const void *> buffs(tx_stream->get_num_channels(), &buff.front());
+    uhd::tx_metadata_t md;
+    md.start_of_burst = true;
+    md.has_time_spec = (buffs.size() != 1);
+    md.time_spec = usrp->get_time_now() + uhd::time_spec_t(0.05);
+
+    const double cpu_start = uhd::get_thread_cpu_time();
+    const uhd::time_spec_t start = uhd::time_spec_t::get_system_time();
+    while ((uhd::time_spec_t::get_system_time() - start).get_real_secs() < duration){
+        const size_t num_sent = tx_stream->send(buffs, spp, md, 1.0);
+        if (num_sent != spp) point.num_errors++;
+        point.num_samps += num_sent*buffs.size();
+        md.start_of_burst = false;
+        md.has_time_spec = false;
+    }
+    md.end_of_burst = true;
+    tx_stream->send(buffs, 0, md);
+    point.wall_secs = (uhd::time_spec_t::get_system_time() - start).get_real_secs();
+    point.thread_cpu_secs = uhd::get_thread_cpu_time() - cpu_start;
+    point.stats = tx_stream->get_stats();
+
+    //wait for the burst to complete so the next point starts clean
+    uhd::async_metadata_t async_md;
+    while (tx_stream->recv_async_msg(async_md, 0.5)){
+        if (async_md.event_code == uhd::async_metadata_t::EVENT_CODE_BURST_ACK) break;
+    }
+}
+
+static void run_point(
+    const std::string &args, const double rate, const std::string &cpu,
+    const double duration, bench_point_t &point
+){
+    //the frame count is a device argument, so every point makes its own device
+    uhd::device_addr_t dev_addr(args);
+    if (point.num_frames != 0){
+        dev_addr["num_recv_frames"] = boost::lexical_cast<std::string>(point.num_frames);
+        dev_addr["num_send_frames"] = boost::lexical_cast<std::string>(point.num_frames);
+    }
+    uhd::usrp::multi_usrp::sptr usrp = uhd::usrp::multi_usrp::make(dev_addr);
+
+    uhd::stream_args_t stream_args(cpu, point.otw_format);
+    if (point.spp != 0) stream_args.args["spp"] = boost::lexical_cast<std::string>(point.spp);
+    for (size_t ch = 0; ch < point.num_channels; ch++) stream_args.channels.push_back(ch);
+
+    if (point.direction == "rx"){
+        if (point.num_channels > usrp->get_rx_num_channels()) throw uhd::value_error("not enough RX channels");
+        if (rate > 0) usrp->set_rx_rate(rate);
+        uhd::rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args);
+        point.spp = rx_stream->get_max_num_samps();
+        run_rx(usrp, rx_stream, cpu, duration, point);
+    }
+    else{
+        if (point.num_channels > usrp->get_tx_num_channels()) throw uhd::value_error("not enough TX channels");
+        if (rate > 0) usrp->set_tx_rate(rate);
+        uhd::tx_streamer::sptr tx_stream = usrp->get_tx_stream(stream_args);
+        point.spp = tx_stream->get_max_num_samps();
+        run_tx(usrp, tx_stream, cpu, duration, point);
+    }
+}
+
+/***********************************************************************
+ * Reports
+ **********************************************************************/
+static void print_table(std::ostream &out, const std::vector<bench_point_t> &points){
+    out << boost::format("%-3s %-5s %6s %7s %3s %9s %7s %9s %9s %9s %9s %s")
+        % "dir" % "otw" % "spp" % "frames" % "ch" % "Msps/cpu" % "load" % "wait s"
+        % "hdr us" % "conv us" % "errors" % "" << std::endl;
+    BOOST_FOREACH(const bench_point_t &point, points){
+        out << boost::format("%-3s %-5s %6u %7u %3u %9.3f %7.3f %9.4f %9.3f %9.3f %9u %s")
+            % point.direction % point.otw_format % point.spp % point.num_frames % point.num_channels
+            % (point.get_samps_per_cpu_sec()/1e6) % point.get_cpu_load()
+            % point.stats.buff_wait_time.total_secs
+            % (point.stats.header_time.get_mean()*1e6) % (point.stats.convert_time.get_mean()*1e6)
+            % (point.num_errors + point.stats.num_sequence_errors) % point.error << std::endl;
+    }
+}
+
+static void write_json(std::ostream &out, const std::string &args, const std::string &cpu, const double rate, const std::vector<bench_point_t> &points){
+    out << "{\n";
+    out << boost::format("  \"args\": \"%s\",\n") % args;
+    out << boost::format("  \"cpu_format\": \"%s\",\n") % cpu;
+    out << boost::format("  \"rate\": %f,\n") % rate;
+    out << "  \"points\": [";
+    for (size_t i = 0; i < points.size(); i++){
+        const bench_point_t &point = points[i];
+        out << ((i == 0)? "\n" : ",\n");
+        out << boost::format(
+            "    {\"direction\": \"%s\", \"otw_format\": \"%s\", \"spp\": %u, \"num_frames\": %u, \"num_channels\": %u, "
+            "\"error\": \"%s\", \"wall_secs\": %f, \"thread_cpu_secs\": %f, \"num_samps\": %u, \"num_errors\": %u, "
+            "\"samps_per_cpu_sec\": %f, \"num_packets\": %u, \"num_sequence_errors\": %u, \"num_overflows\": %u, "
+            "\"wait_secs\": %f, \"mean_header_secs\": %g, \"mean_convert_secs\": %g}"
+        ) % point.direction % point.otw_format % point.spp % point.num_frames % point.num_channels
+          % point.error % point.wall_secs % point.thread_cpu_secs % point.num_samps % point.num_errors
+          % point.get_samps_per_cpu_sec() % point.stats.num_packets
+          % point.stats.num_sequence_errors % point.stats.num_overflows
+          % point.stats.buff_wait_time.total_secs % point.stats.header_time.get_mean() % point.stats.convert_time.get_mean();
+    }
+    out << "\n  ]\n}" << std::endl;
+}
+
+//! Keep UHD messages off stdout when the report is written there
+static void stderr_msg_handler(uhd::msg::type_t type, const std::string &msg){
+    if (type == uhd::msg::fastpath) std::cerr << msg << std::flush;
+    else std::cerr << msg << std::endl;
+}
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    uhd::set_thread_priority_safe();
+
+    std::string args, cpu, dir, spp_list, frames_list, otw_list, channels_list, json_file;
+    double rate, duration;
+
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("args", po::value<std::string>(&args)->default_value(""), "device address args (type=sim runs without hardware)")
+        ("rate", po::value<double>(&rate)->default_value(0), "sample rate in sps (0 keeps the device default)")
+        ("duration", po::value<double>(&duration)->default_value(2.0), "streaming time per point in seconds")
+        ("cpu", po::value<std::string>(&cpu)->default_value("fc32"), "host sample format")
+        ("dir", po::value<std::string>(&dir)->default_value("rx"), "direction to measure: rx, tx or both")
+        ("spp", po::value<std::string>(&spp_list)->default_value(""), "comma separated samples per packet to sweep (empty: device default)")
+        ("frames", po::value<std::string>(&frames_list)->default_value(""), "comma separated num_recv_frames/num_send_frames to sweep")
+        ("otw", po::value<std::string>(&otw_list)->default_value("sc16"), "comma separated over-the-wire formats to sweep")
+        ("channels", po::value<std::string>(&channels_list)->default_value("1"), "comma separated channel counts to sweep")
+        ("json", po::value<std::string>(&json_file), "write a JSON report to this file (- for stdout)")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help") or (dir != "rx" and dir != "tx" and dir != "both")){
+        std::cout << boost::format("UHD Stream Bench %s") % desc << std::endl;
+        std::cout <<
+            "Measures the host CPU cost of streaming over a sweep of settings.\n"
+            "Every point creates the device, streams for the duration and reports\n"
+            "samples per CPU second of the streaming thread, the time spent waiting\n"
+            "on the transport and the mean header and conversion times.\n"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    //the table goes to stderr when the report is on stdout
+    const bool json_to_stdout = vm.count("json") and json_file == "-";
+    std::ostream &table = json_to_stdout? std::cerr : std::cout;
+    if (json_to_stdout) uhd::msg::register_handler(&stderr_msg_handler);
+
+    std::vector<std::string> dirs;
+    if (dir == "rx" or dir == "both") dirs.push_back("rx");
+    if (dir == "tx" or dir == "both") dirs.push_back("tx");
+    std::vector<std::string> otws;
+    boost::split(otws, otw_list, boost::is_any_of(","), boost::token_compress_on);
+
+    std::vector<bench_point_t> points;
+    BOOST_FOREACH(const std::string &direction, dirs){
+    BOOST_FOREACH(const std::string &otw, otws){
+    BOOST_FOREACH(const size_t num_channels, to_sizes(channels_list)){
+    BOOST_FOREACH(const size_t num_frames, to_sizes(frames_list)){
+    BOOST_FOREACH(const size_t spp, to_sizes(spp_list)){
+        bench_point_t point;
+        point.direction = direction;
+        point.otw_format = boost::trim_copy(otw);
+        point.spp = spp;
+        point.num_frames = num_frames;
+        point.num_channels = std::max<size_t>(num_channels, 1);
+        table << boost::format("Running %s otw=%s spp=%u frames=%u channels=%u...")
+            % point.direction % point.otw_format % point.spp % point.num_frames % point.num_channels << std::endl;
+        try{
+            run_point(args, rate, cpu, duration, point);
+        }
+        catch(const std::exception &e){
+            point.error = e.what();
+            boost::replace_all(point.error, "\"", "'");
+            boost::replace_all(point.error, "\n", " ");
+        }
+        points.push_back(point);
+    }}}}}
+
+    table << std::endl;
+    print_table(table, points);
+
+    if (json_to_stdout) write_json(std::cout, args, cpu, rate, points);
+    else if (vm.count("json")){
+        std::ofstream out(json_file.c_str());
+        if (not out.is_open()) throw std::runtime_error("cannot open the report file " + json_file);
+        write_json(out, args, cpu, rate, points);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -19,10 +19,18 @@
 #include <uhd/property_tree.hpp>
 #include <uhd/usrp/multi_usrp.hpp>
 #include <uhd/usrp/dboard_eeprom.hpp>
+#include <uhd/usrp/fe_cal_table.hpp>
 #include <uhd/utils/paths.hpp>
 #include <uhd/utils/algorithm.hpp>
+#include <uhd/utils/csv.hpp>
 #include <uhd/utils/msg.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/utility.hpp>
 #include <boost/format.hpp>
 #include <iostream>
 #include <vector>
@@ -153,20 +161,161 @@ private:
 /***********************************************************************
  * Compute power of a tone
  **********************************************************************/
+static const size_t tone_num_lanes = 4;
+
+struct tone_accum_t{
+    std::complex<double> phasor[tone_num_lanes];
+    std::complex<double> step; //rotation over tone_num_lanes samples
+    std::complex<double> sum[tone_num_lanes];
+
+    tone_accum_t(const double freq){ //freq is fractional
+        for (size_t j = 0; j < tone_num_lanes; j++){
+            phasor[j] = std::polar(1.0, -freq*tau*j);
+            sum[j] = 0;
+        }
+        step = std::polar(1.0, -freq*tau*tone_num_lanes);
+    }
+
+    //! Accumulate one block of tone_num_lanes samples
+    inline void update(const samp_type *samps){
+        for (size_t j = 0; j < tone_num_lanes; j++){
+            sum[j] += phasor[j] * std::complex<double>(samps[j]);
+            phasor[j] *= step;
+        }
+    }
+
+    //! Accumulate the leftover samples (less than tone_num_lanes)
+    inline void update_tail(const samp_type *samps, const size_t n){
+        for (size_t j = 0; j < n; j++){
+            sum[j] += phasor[j] * std::complex<double>(samps[j]);
+        }
+    }
+
+    inline double dbrms(const size_t nsamps) const{
+        std::complex<double> total = 0;
+        for (size_t j = 0; j < tone_num_lanes; j++) total += sum[j];
+        return 20*std::log10(std::abs(total/double(nsamps)));
+    }
+};
+
 static inline double compute_tone_dbrms(
     const std::vector<samp_type > &samples,
     const double freq //freq is fractional
 ){
     //shift the samples so the tone at freq is down at DC
-    //and average the samples to measure the DC component
-    samp_type average = 0;
-    for (size_t i = 0; i < samples.size(); i++){
-        average += samp_type(std::polar(1.0, -freq*tau*i)) * samples[i];
+    //and average the samples to measure the DC component;
+    //the shift is a rotating phasor per lane rather than a sin/cos per sample
+    tone_accum_t tone(freq);
+    const size_t nblocks = samples.size()/tone_num_lanes;
+    for (size_t i = 0; i < nblocks; i++){
+        tone.update(&samples[i*tone_num_lanes]);
     }
+    const size_t ntail = samples.size() - nblocks*tone_num_lanes;
+    if (ntail != 0) tone.update_tail(&samples[nblocks*tone_num_lanes], ntail);
+    return tone.dbrms(samples.size());
+}
 
-    return 20*std::log10(std::abs(average/float(samples.size())));
+/***********************************************************************
+ * Compute the suppression of the image tone relative to the tone
+ **********************************************************************/
+static inline double compute_tone_suppression(
+    const std::vector<samp_type > &samples,
+    const double tone_freq, //freqs are fractional
+    const double imag_freq
+){
+    //measure both tones in a single pass over the samples
+    tone_accum_t tone(tone_freq), imag(imag_freq);
+    const size_t nblocks = samples.size()/tone_num_lanes;
+    for (size_t i = 0; i < nblocks; i++){
+        tone.update(&samples[i*tone_num_lanes]);
+        imag.update(&samples[i*tone_num_lanes]);
+    }
+    const size_t ntail = samples.size() - nblocks*tone_num_lanes;
+    if (ntail != 0){
+        tone.update_tail(&samples[nblocks*tone_num_lanes], ntail);
+        imag.update_tail(&samples[nblocks*tone_num_lanes], ntail);
+    }
+    return tone.dbrms(samples.size()) - imag.dbrms(samples.size());
 }
 
+/***********************************************************************
+ * Measure captures in the background
+ *
+ * The search grid for one iteration is known up front, so the capture
+ * for the next grid point can proceed while the previous capture is
+ * being measured. A single worker thread takes the captures from a one
+ * deep queue, so one measurement is in flight at a time; results are
+ * returned in the order they were pushed.
+ **********************************************************************/
+class measure_pipeline : boost::noncopyable{
+public:
+    typedef boost::function<double(const std::vector<samp_type> &)> measure_fcn_t;
+
+    measure_pipeline(const measure_fcn_t &measure):
+        _measure(measure),
+        _pending(false),
+        _done(false)
+    {
+        _thread = boost::thread(boost::bind(&measure_pipeline::run, this));
+    }
+
+    ~measure_pipeline(void){
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _done = true;
+        }
+        _cond.notify_all();
+        _thread.join();
+    }
+
+    //! Measure the samples in buff; buff is swapped for an idle buffer
+    void push(std::vector<samp_type> &buff){
+        boost::mutex::scoped_lock lock(_mutex);
+        while (_pending) _cond.wait(lock);
+        _work.swap(buff);
+        _pending = true;
+        _cond.notify_all();
+    }
+
+    //! Wait for the measurements pushed so far and return them
+    const std::vector<double> &results(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        while (_pending) _cond.wait(lock);
+        return _results;
+    }
+
+    //! Wait for outstanding work and discard the results
+    void clear(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        while (_pending) _cond.wait(lock);
+        _results.clear();
+    }
+
+private:
+    //! The worker: measures each capture pushed until destruction
+    void run(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        while (true){
+            while (not _pending and not _done) _cond.wait(lock);
+            if (not _pending) return;
+            lock.unlock();
+            const double result = _measure(_work);
+            lock.lock();
+            _results.push_back(result);
+            _pending = false;
+            _cond.notify_all();
+        }
+    }
+
+    measure_fcn_t _measure;
+    std::vector<samp_type> _work;
+    std::vector<double> _results;
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+    bool _pending, _done;
+    boost::thread _thread;
+};
+
 /***********************************************************************
  * Write a dat file
  **********************************************************************/
@@ -223,17 +372,31 @@ static void store_results(
     cal_data << boost::format("DATA STARTS HERE\n");
     cal_data << "lo_frequency, correction_real, correction_imag, measured, delta\n";
 
+    uhd::csv::columns_type columns(5, std::vector<double>(results.size()));
     for (size_t i = 0; i < results.size(); i++){
-        cal_data
-            << results[i].freq << ", "
-            << results[i].real_corr << ", "
-            << results[i].imag_corr << ", "
-            << results[i].best << ", "
-            << results[i].delta << "\n"
-        ;
+        columns[0][i] = results[i].freq;
+        columns[1][i] = results[i].real_corr;
+        columns[2][i] = results[i].imag_corr;
+        columns[3][i] = results[i].best;
+        columns[4][i] = results[i].delta;
     }
+    uhd::csv::write_columns(cal_data, columns);
 
     std::cout << "wrote cal data to " << cal_data_path << std::endl;
+
+    //write the binary table used by the driver for fast lookups
+    std::vector<uhd::usrp::fe_cal_point_t> points(results.size());
+    for (size_t i = 0; i < results.size(); i++){
+        points[i].lo_freq = results[i].freq;
+        points[i].corr_real = results[i].real_corr;
+        points[i].corr_imag = results[i].imag_corr;
+    }
+    cal_data.close();
+    fs::path bin_path = cal_data_path;
+    bin_path.replace_extension(uhd::usrp::fe_cal_table::BIN_EXT);
+    uhd::usrp::fe_cal_table::write(bin_path.string(), points);
+
+    std::cout << "wrote cal table to " << bin_path << std::endl;
 }
 
 /***********************************************************************
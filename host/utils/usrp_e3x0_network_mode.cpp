@@ -48,6 +48,7 @@ int main(int argc, char *argv[])
     desc.add_options()
         ("help", "help message")
         ("fpga", po::value<std::string>(), "fpga image to load")
+        ("args", po::value<std::string>()->default_value(""), "server args, e.g. tunnel_burst=32,thread_e300_data_tunnel_cpus=1")
     ;
 
     po::variables_map vm;
@@ -59,7 +60,7 @@ int main(int argc, char *argv[])
         std::cout << boost::format("UHD E3x0 Network Mode %s") % desc << std::endl;
         return EXIT_FAILURE;
     }
-    uhd::device_addr_t args;
+    uhd::device_addr_t args(vm["args"].as<std::string>());
     if(vm.count("fpga")) {
         args["fpga"] = vm["fpga"].as<std::string>();
     }